@@ -0,0 +1,66 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "parser/syntax.hpp"
+#include "lexer/source_buffer.hpp"
+#include "lexer/yylex.hpp"
+#include "types/type_check.hpp"
+
+// Splits programs with tens of thousands of top-level bindings into dependency groups, as the type checker does, and
+// reports how long that takes.
+
+// Each binding uses the next one, and every tenth binding also uses the one nine before it, so that the chain is made
+// of groups of ten mutually recursive bindings.
+std::string bindings(size_t number) {
+    std::string source;
+    for (size_t i = 0; i < number; i++) {
+        source += "f" + std::to_string(i) + " x = ";
+        source += i + 1 < number ? "f" + std::to_string(i + 1) + " x" : "x";
+        if (i % 10 == 9) {
+            source += " + f" + std::to_string(i - 9) + " x";
+        }
+        source += "\n;";
+    }
+    return source + "main = f0 1\n";
+}
+
+bool run(size_t number) {
+    auto buffer = SourceBuffer::copy_string(bindings(number));
+    auto program = std::make_unique<Program>();
+    if (parse_program(*buffer, program.get()) != 0) {
+        std::cerr << number << " bindings: parse error." << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Symbol> names;
+    std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> free_variables;
+    for (const auto &[name, definition]: program->bindings) {
+        names.push_back(name);
+        free_variables[name] = find_free_variables(definition);
+    }
+    auto found = std::chrono::steady_clock::now();
+    std::vector<std::vector<Symbol>> groups = dependency_analysis(names, free_variables);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "  " << number << " bindings in " << groups.size() << " groups: "
+              << std::chrono::duration<double, std::milli>(found - start).count() << " ms finding free variables, "
+              << std::chrono::duration<double, std::milli>(end - found).count() << " ms finding groups" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "Dependency analysis of top-level bindings" << std::endl;
+    bool ok = true;
+    if (argc > 1) {
+        ok = run(std::strtoul(argv[1], nullptr, 10));
+    } else {
+        for (size_t number: {10000, 30000, 100000}) {
+            ok = run(number) && ok;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "parser/syntax.hpp"
+#include "prelude/prelude.hpp"
+#include "lexer/source_buffer.hpp"
+#include "lexer/yylex.hpp"
+#include "types/type_check.hpp"
+#include "stg/stg.hpp"
+
+// Translates functions that match on several values at once, choosing the value to test next first by the leftmost
+// column and then by the needed column heuristic, and reports the number of cases each is translated to and the size
+// of its translation in STG expressions, which is what the code generated for it grows with.
+
+// Alternatives that each match a constructor in one of two fields, taking turns between them.
+std::string alternating_columns(size_t number) {
+    std::string source = "data D = C0 Int | C1 Int\n;data T = T D D\n;f t = case t of { ";
+    for (size_t i = 0; i < number; i++) {
+        source += i % 2 == 0
+                ? "T (C0 " + std::to_string(i) + ") _ -> " + std::to_string(i) + " ; "
+                : "T _ (C0 " + std::to_string(i) + ") -> " + std::to_string(i) + " ; ";
+    }
+    return source + "_ -> 0 }\n;main = \"a\"\n";
+}
+
+// Alternatives that each need one of the first values and all need the last one, which decides most of them.
+std::string last_column_needed(size_t number) {
+    std::string arguments;
+    std::string tuple;
+    for (size_t i = 0; i < number; i++) {
+        arguments += " a" + std::to_string(i);
+        tuple += "a" + std::to_string(i) + ", ";
+    }
+    std::string source = "f" + arguments + " b = case (" + tuple + "b) of { ";
+    for (size_t i = 0; i < number; i++) {
+        source += "(";
+        for (size_t j = 0; j < number; j++) {
+            source += j == i ? "True, " : "_, ";
+        }
+        source += "False) -> " + std::to_string(i) + " ; ";
+    }
+    return source + "_ -> 0 }\n;main = \"a\"\n";
+}
+
+std::string merge() {
+    return "f xs ys = case (xs, ys) of { ([], zs) -> zs ; (zs, []) -> zs ; (a:as, b:bs) -> a : b : f as bs }\n"
+           ";main = \"a\"\n";
+}
+
+struct Size {
+    size_t cases = 0;
+    size_t expressions = 0;
+};
+
+Size size_of(const std::unique_ptr<STGProgram> &program) {
+    Size size;
+    std::vector<const STGExpression*> to_visit;
+    for (const auto &[_, lambda_form]: program->bindings) {
+        to_visit.push_back(lambda_form->expr.get());
+    }
+    while (!to_visit.empty()) {
+        const STGExpression *expr = to_visit.back();
+        to_visit.pop_back();
+        size.expressions++;
+        switch (expr->get_form()) {
+            case stgform::let:
+                for (const auto &[_, lambda_form]: static_cast<const STGLet*>(expr)->bindings) {
+                    to_visit.push_back(lambda_form->expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLet*>(expr)->expr.get());
+                break;
+            case stgform::letnoescape:
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->rhs.get());
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->expr.get());
+                break;
+            case stgform::literalcase:
+                size.cases++;
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->default_expr.get());
+                break;
+            case stgform::algebraiccase:
+                size.cases++;
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->default_expr.get());
+                break;
+            default:
+                break;
+        }
+    }
+    return size;
+}
+
+bool run(const std::string &name, const std::string &source) {
+    auto buffer = SourceBuffer::copy_string(source);
+    auto program = std::make_unique<Program>();
+    add_prelude(program.get());
+    if (parse_program(*buffer, program.get()) != 0) {
+        std::cerr << name << ": parse error." << std::endl;
+        return false;
+    }
+    try {
+        type_check(program, true);
+    } catch (const TypeError &e) {
+        std::cerr << name << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    std::cout << name << std::endl;
+    for (auto [heuristic, heuristic_name]: {
+            std::make_pair(ColumnHeuristic::leftmost, "leftmost column"),
+            std::make_pair(ColumnHeuristic::needed, "needed column")}) {
+        std::set<Symbol, SpellingOrder> used_external;
+        Size size = size_of(translate(program, {Symbol("f")}, {}, used_external, nullptr, heuristic));
+        std::cout << "  " << heuristic_name << ": " << size.cases << " cases, " << size.expressions << " STG expressions"
+                  << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t number = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 14;
+    std::cout << "Matches of " << number << " alternatives" << std::endl;
+
+    bool ok = run("alternating columns", alternating_columns(number));
+    // The prelude has tuples of up to fifteen components.
+    ok = run("last column needed", last_column_needed(std::min<size_t>(number, 14))) && ok;
+    ok = run("merge", merge()) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "parser/syntax.hpp"
+#include "prelude/prelude.hpp"
+#include "lexer/source_buffer.hpp"
+#include "lexer/yylex.hpp"
+#include "types/type_check.hpp"
+#include "stg/stg.hpp"
+#include "generation/generation.hpp"
+
+// Compiles programs containing very long literals, which parse to expressions nested as deeply as they are long, and
+// reports how long each phase of the compiler takes.
+
+std::string list_literal(size_t length) {
+    std::string source = "main = [";
+    for (size_t i = 0; i < length; i++) {
+        source += i == 0 ? "'a'" : ",'a'";
+    }
+    return source + "]\n";
+}
+
+std::string list_literal_in_function(size_t length) {
+    std::string source = "f c = [";
+    for (size_t i = 0; i < length; i++) {
+        source += i == 0 ? "c" : ",c";
+    }
+    return source + "]\n;main = f 'a'\n";
+}
+
+std::string string_literal_with_null_characters(size_t length) {
+    std::string source = "main = \"";
+    for (size_t i = 0; i < length; i++) {
+        source += "a\\NUL";
+    }
+    return source + "\"\n";
+}
+
+double time_phase(const std::function<void()> &phase) {
+    auto start = std::chrono::steady_clock::now();
+    phase();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool run(const std::string &name, const std::string &source) {
+    auto buffer = SourceBuffer::copy_string(source);
+    auto program = std::make_unique<Program>();
+    std::unique_ptr<STGProgram> translated;
+    std::ostringstream output;
+    int result = 0;
+
+    add_prelude(program.get());
+    double parse_time = time_phase([&]() { result = parse_program(*buffer, program.get()); });
+    if (result != 0) {
+        std::cerr << name << ": parse error." << std::endl;
+        return false;
+    }
+    double type_check_time;
+    try {
+        type_check_time = time_phase([&]() { type_check(program, true); });
+    } catch (const TypeError &e) {
+        std::cerr << name << ": " << e.what() << std::endl;
+        return false;
+    }
+    double translate_time = time_phase([&]() { translated = translate(program); });
+    double generate_time = time_phase([&]() { generate_target_code(translated, output); });
+    double destroy_time = time_phase([&]() {
+        translated.reset();
+        program.reset();
+    });
+
+    std::cout << name << std::endl;
+    std::cout << "  parse:      " << parse_time << " ms" << std::endl;
+    std::cout << "  type check: " << type_check_time << " ms" << std::endl;
+    std::cout << "  translate:  " << translate_time << " ms" << std::endl;
+    std::cout << "  generate:   " << generate_time << " ms (" << output.str().size() << " bytes)" << std::endl;
+    std::cout << "  destroy:    " << destroy_time << " ms" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t length = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::cout << "Literals of " << length << " elements" << std::endl;
+
+    bool ok = run("list literal", list_literal(length));
+    ok = run("list literal in a function", list_literal_in_function(length)) && ok;
+    ok = run("string literal with null characters", string_literal_with_null_characters(length)) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "parser/syntax.hpp"
+#include "prelude/prelude.hpp"
+#include "lexer/source_buffer.hpp"
+#include "lexer/yylex.hpp"
+#include "types/type_check.hpp"
+
+// Type checks programs made of long chains of bindings that all depend on each other, whose types are inferred
+// together and are unified along the length of the chain, and reports how long that takes. It also checks as many
+// bindings that do not depend on each other, which are inferred in parallel, to show how that scales with the cores.
+
+std::string chain_of_functions(size_t length) {
+    std::string source;
+    for (size_t i = 0; i < length; i++) {
+        source += "f" + std::to_string(i) + " x = f" + std::to_string((i + 1) % length) + " x\n;";
+    }
+    return source + "main = f0 'a'\n";
+}
+
+std::string chain_of_functions_swapping_arguments(size_t length) {
+    std::string source;
+    for (size_t i = 0; i < length; i++) {
+        source += "f" + std::to_string(i) + " x y = case x of { 'a' -> y ; _ -> f" +
+                  std::to_string((i + 1) % length) + " y x }\n;";
+    }
+    return source + "main = f0 'a' 'b' : []\n";
+}
+
+std::string chain_of_values(size_t length) {
+    std::string source;
+    for (size_t i = 0; i < length; i++) {
+        source += "v" + std::to_string(i) + " = case v" + std::to_string((i + 1) % length) + " of { [] -> v" +
+                  std::to_string((i + 2) % length) + " ; (c:cs) -> cs }\n;";
+    }
+    return source + "main = 'a' : v0\n";
+}
+
+// Bindings with full signatures, which are checked against them rather than inferred.
+std::string chain_of_signed_functions(size_t length) {
+    std::string source;
+    for (size_t i = 0; i < length; i++) {
+        source += "f" + std::to_string(i) + " :: (a -> b) -> [a] -> [b] -> [b]\n;";
+        source += "f" + std::to_string(i) + " g xs ys = case xs of { [] -> ys ; (z:zs) -> g z : f" +
+                  std::to_string((i + 1) % length) + " g zs ys }\n;";
+    }
+    return source + "main = f0 (\\c -> c) \"ab\" []\n";
+}
+
+// Each binding is its own group, and its literals and constructors make the same types as every other's.
+std::string independent_functions(size_t length) {
+    std::string source;
+    for (size_t i = 0; i < length; i++) {
+        source += "g" + std::to_string(i) + " x y = case x of { 0 -> y ; 1 -> 'a' : y ; _ -> case y of "
+                  "{ [] -> \"b\" ; (c:cs) -> c : 'c' : cs } }\n;";
+    }
+    return source + "main = g0 1 \"a\"\n";
+}
+
+bool run(const std::string &name, const std::string &source, bool check_for_main) {
+    auto buffer = SourceBuffer::copy_string(source);
+    auto program = std::make_unique<Program>();
+    add_prelude(program.get());
+    if (parse_program(*buffer, program.get()) != 0) {
+        std::cerr << name << ": parse error." << std::endl;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    try {
+        type_check(program, check_for_main);
+    } catch (const TypeError &e) {
+        std::cerr << name << ": " << e.what() << std::endl;
+        return false;
+    }
+    double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << time << " ms" << std::endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    size_t length = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    std::cout << "Chains of " << length << " mutually recursive bindings" << std::endl;
+
+    bool ok = run("functions", chain_of_functions(length), false);
+    ok = run("functions swapping their arguments", chain_of_functions_swapping_arguments(length), true) && ok;
+    ok = run("values", chain_of_values(length), true) && ok;
+    ok = run("functions with signatures", chain_of_signed_functions(length), true) && ok;
+    std::cout << length << " independent bindings on " << std::thread::hardware_concurrency() << " cores" << std::endl;
+    ok = run("independent functions", independent_functions(length), true) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,21 @@
+#include <cstdint>
+#include "arena/arena.hpp"
+
+void *Arena::allocate(size_t size, size_t alignment) {
+    size_t padding = -reinterpret_cast<uintptr_t>(next) & (alignment - 1);
+    if (next == nullptr || size + padding > static_cast<size_t>(end - next)) {
+        if (size + alignment > block_size / 4) {
+            // Large allocations get a block of their own, so the current block can still be used.
+            blocks.emplace_back(new char[size + alignment]);
+            char *start = blocks.back().get();
+            return start + (-reinterpret_cast<uintptr_t>(start) & (alignment - 1));
+        }
+        blocks.emplace_back(new char[block_size]);
+        next = blocks.back().get();
+        end = next + block_size;
+        padding = -reinterpret_cast<uintptr_t>(next) & (alignment - 1);
+    }
+    void *result = next + padding;
+    next += padding + size;
+    return result;
+}
@@ -0,0 +1,34 @@
+#ifndef PICOHASKELL_ARENA_HPP
+#define PICOHASKELL_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A bump allocator. Memory is handed out from large blocks and only released, all at once, when the arena is
+// destroyed.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+private:
+    static constexpr size_t block_size = 64 * 1024;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *next = nullptr;
+    char *end = nullptr;
+};
+
+// Base for classes whose objects are allocated from an arena. Deleting such an object only runs its destructor,
+// so owning pointers can still be used for them; the memory is reclaimed along with the arena.
+struct ArenaAllocated {
+    static void *operator new(size_t size, Arena &arena) { return arena.allocate(size); }
+    static void operator delete(void *, Arena &) {}
+    static void *operator new(size_t size) = delete;
+    static void operator delete(void *) {}
+};
+
+#endif //PICOHASKELL_ARENA_HPP
@@ -1,8 +1,12 @@
 #include <algorithm>
+#include <cctype>
+#include <iomanip>
 #include <sstream>
 #include "generation/generation.hpp"
+#include "statistics/statistics.hpp"
 
-std::string sanitise_name(std::string name) {
+std::string sanitise_name(const Symbol &symbol) {
+    std::string name = symbol.str();
     if (name == ".") {
         return ".compose";
     } else if (name == "+") {
@@ -49,10 +53,70 @@ std::string sanitise_name(std::string name) {
     return name;
 }
 
+std::string escape_string(const std::string &str) {
+    std::stringstream escaped;
+    for (const char &c: str) {
+        if (c == '"' || c == '\\') {
+            escaped << '\\' << c;
+        } else if (isprint(static_cast<unsigned char>(c))) {
+            escaped << c;
+        } else {
+            escaped << '\\' << std::oct << std::setw(3) << std::setfill('0') << (int) static_cast<unsigned char>(c);
+        }
+    }
+    return escaped.str();
+}
+
+// String literals are stored as null-terminated strings, and their closures point at the next character to unpack.
+// Entering one allocates a cons cell for that character on the heap, whose tail is a closure for the rest of the
+// string. Closures for string literals live in flash and are never updated, and neither are those for the rest of a
+// string, so entering the same one again allocates another cons cell.
+void generate_string_unpacking_code(
+        const std::map<Symbol, STGDataConstructor, SpellingOrder> &data_constructors,
+        std::ostream &output) {
+    output << ".align 4 @ info table for string literals" << std::endl;
+    output << ".word 0 @ evacuation code" << std::endl;
+    output << ".word 0 @ scavenge code" << std::endl;
+    output << ".thumb_func" << std::endl;
+    output << ".unpack_string_entry_code:" << std::endl;
+    output << "    LDR R6, [R4, #4] @ load address of the next character into R6" << std::endl;
+    output << "    LDRB R7, [R6] @ load the character into R7" << std::endl;
+    output << "    CMP R7, #0" << std::endl;
+    output << "    BEQ .unpack_string_end" << std::endl;
+    output << "    LDR R5, =.literal_standard_entry_code" << std::endl;
+    output << "    STR R5, [R2] @ allocate closure for the character" << std::endl;
+    output << "    STR R7, [R2, #4]" << std::endl;
+    output << "    ADD R6, #1" << std::endl;
+    output << "    LDR R5, =.unpack_string_entry_code" << std::endl;
+    output << "    STR R5, [R2, #8] @ allocate closure for the rest of the string" << std::endl;
+    output << "    STR R6, [R2, #12]" << std::endl;
+    output << "    LDR R5, =.Cons_standard_entry_code" << std::endl;
+    output << "    STR R5, [R2, #16] @ allocate cons cell" << std::endl;
+    output << "    STR R2, [R2, #20] @ head is the character closure" << std::endl;
+    output << "    MOV R6, R2" << std::endl;
+    output << "    ADD R6, #8" << std::endl;
+    output << "    STR R6, [R2, #24] @ tail is the closure for the rest of the string" << std::endl;
+    output << "    MOV R4, R2" << std::endl;
+    output << "    ADD R4, #16 @ put address of cons cell in Node register" << std::endl;
+    output << "    ADD R2, #28 @ bump heap pointer" << std::endl;
+    output << "    ADD R1, #4" << std::endl;
+    output << "    LDR R6, [R1] @ pop return address from B stack to R6" << std::endl;
+    output << "    MOVS R5, #" << data_constructors.at(Symbol(":")).tag << " @ put tag in R5" << std::endl;
+    output << "    BX R6 @ jump to return address" << std::endl;
+    output << ".unpack_string_end:" << std::endl;
+    output << "    LDR R4, =.Nil_closure @ put address of empty list in Node register" << std::endl;
+    output << "    ADD R1, #4" << std::endl;
+    output << "    LDR R6, [R1] @ pop return address from B stack to R6" << std::endl;
+    output << "    MOVS R5, #" << data_constructors.at(Symbol("[]")).tag << " @ put tag in R5" << std::endl;
+    output << "    BX R6 @ jump to return address" << std::endl;
+    output << ".ltorg" << std::endl;
+}
+
 void generate_standard_constructor_info_tables_and_closures(
-        const std::unique_ptr<STGProgram> &program,
+        const std::map<Symbol, STGDataConstructor, SpellingOrder> &data_constructors,
+        bool string_literals,
         std::ostream &output) {
-    for (const auto &[name, constructor]: program->data_constructors) {
+    for (const auto &[name, constructor]: data_constructors) {
         output << ".align 4 @ info table for " << name << std::endl;
         output << ".word 0 @ evacuation code" << std::endl;
         output << ".word 0 @ scavenge code" << std::endl;
@@ -78,10 +142,14 @@ void generate_standard_constructor_info_tables_and_closures(
     output << "    ADD R1, #4" << std::endl;
     output << "    LDR R6, [R1] @ pop return address from B stack to R6" << std::endl;
     output << "    BX R6 @ jump to return address" << std::endl;
+
+    if (string_literals) {
+        generate_string_unpacking_code(data_constructors, output);
+    }
 }
 
 void generate_info_table(
-        const std::string &name,
+        const Symbol &name,
         const std::unique_ptr<STGLambdaForm> &lambda_form,
         std::ostream &output) {
     output << ".align 4 @ info table for " << name << std::endl;
@@ -104,54 +172,84 @@ void generate_info_table(
     }
 }
 
-void generate_code_for_bindings(const std::unique_ptr<STGProgram> &program, std::ostream &output) {
-    std::stringstream data_section;
-
-    data_section << ".align 4" << std::endl;
-    data_section << ".data" << std::endl;
-
-    for (const auto &[name, lambda_form]: program->bindings) {
-        if (lambda_form->argument_variables.empty() && lambda_form->expr->get_form() == stgform::constructor) {
-            auto constructor = dynamic_cast<STGConstructor *>(lambda_form->expr.get());
-            if (constructor->arguments.empty()) {
-                output << sanitise_name(name) << "_closure = "
-                       << sanitise_name(constructor->constructor_name) << "_closure" << std::endl;
-            } else {
-                output << ".align 4" << std::endl;
-                output << sanitise_name(name) << "_closure:" << std::endl;
-                output << ".word " << sanitise_name(constructor->constructor_name)
-                       << "_standard_entry_code @ info pointer" << std::endl;
-                for (const std::string &arg: constructor->arguments) {
-                    output << ".word " << sanitise_name(arg) << "_closure @ arg" << std::endl;
-                }
-            }
-        } else if (lambda_form->argument_variables.empty() && lambda_form->expr->get_form() == stgform::literal){
-            auto literal = dynamic_cast<STGLiteral *>(lambda_form->expr.get());
+void generate_code_for_binding(
+        const Symbol &name,
+        const std::unique_ptr<STGLambdaForm> &lambda_form,
+        std::ostream &output,
+        std::ostream &data_section) {
+    if (lambda_form->argument_variables.empty() && lambda_form->expr->get_form() == stgform::constructor) {
+        auto constructor = static_cast<STGConstructor *>(lambda_form->expr.get());
+        if (constructor->arguments.empty()) {
+            output << sanitise_name(name) << "_closure = "
+                   << sanitise_name(constructor->constructor_name) << "_closure" << std::endl;
+        } else {
             output << ".align 4" << std::endl;
             output << sanitise_name(name) << "_closure:" << std::endl;
+            output << ".word " << sanitise_name(constructor->constructor_name)
+                   << "_standard_entry_code @ info pointer" << std::endl;
+            for (const Symbol &arg: constructor->arguments) {
+                output << ".word " << sanitise_name(arg) << "_closure @ arg" << std::endl;
+            }
+        }
+    } else if (lambda_form->argument_variables.empty() && lambda_form->expr->get_form() == stgform::literal){
+        auto literal = static_cast<STGLiteral *>(lambda_form->expr.get());
+        output << ".align 4" << std::endl;
+        output << sanitise_name(name) << "_closure:" << std::endl;
+        if (std::holds_alternative<std::string>(literal->value)) {
+            output << ".word .unpack_string_entry_code @ info pointer" << std::endl;
+            output << ".word " << sanitise_name(name) << "_string @ address of first character" << std::endl;
+            output << sanitise_name(name) << "_string:" << std::endl;
+            output << ".asciz \"" << escape_string(std::get<std::string>(literal->value)) << "\"" << std::endl;
+        } else {
             output << ".word .literal_standard_entry_code @ info pointer" << std::endl;
             if (std::holds_alternative<int>(literal->value)) {
                 output << ".word " << std::get<int>(literal->value) << std::endl;
             } else if (std::holds_alternative<char>(literal->value)) {
                 output << ".word " << ((int) std::get<char>(literal->value)) << std::endl;
             }
+        }
+    } else {
+        generate_info_table(name, lambda_form, output);
+        if (lambda_form->updatable) {
+            data_section << sanitise_name(name) << "_closure:" << std::endl;
+            data_section << ".word " << sanitise_name(name) << "_standard_entry_code @ info pointer" << std::endl;
+            data_section << ".word 0 @ empty word to hold indirection" << std::endl;
         } else {
-            generate_info_table(name, lambda_form, output);
-            if (lambda_form->updatable) {
-                data_section << sanitise_name(name) << "_closure:" << std::endl;
-                data_section << ".word " << sanitise_name(name) << "_standard_entry_code @ info pointer" << std::endl;
-                data_section << ".word 0 @ empty word to hold indirection" << std::endl;
-            } else {
-                output << sanitise_name(name) << "_closure:" << std::endl;
-                output << ".word " << sanitise_name(name) << "_standard_entry_code @ info pointer" << std::endl;
-            }
+            output << sanitise_name(name) << "_closure:" << std::endl;
+            output << ".word " << sanitise_name(name) << "_standard_entry_code @ info pointer" << std::endl;
         }
     }
+}
+
+void generate_code_for_bindings(
+        const std::unique_ptr<STGProgram> &program,
+        std::ostream &output,
+        CompileStatistics *statistics) {
+    std::stringstream data_section;
+
+    data_section << ".align 4" << std::endl;
+    data_section << ".data" << std::endl;
+
+    for (const auto &[name, lambda_form]: program->bindings) {
+        if (statistics == nullptr) {
+            generate_code_for_binding(name, lambda_form, output, data_section);
+            continue;
+        }
+        std::stringstream code;
+        std::streampos data_section_size = data_section.tellp();
+        generate_code_for_binding(name, lambda_form, code, data_section);
+        std::string text = code.str();
+        statistics->add_assembly(name, text.size() + static_cast<size_t>(data_section.tellp() - data_section_size));
+        output << text;
+    }
 
     output << data_section.str() << std::endl;
 }
 
-void generate_target_code(const std::unique_ptr<STGProgram> &program, std::ostream &output) {
+void generate_runtime_code(
+        const std::map<Symbol, STGDataConstructor, SpellingOrder> &data_constructors,
+        bool string_literals,
+        std::ostream &output) {
     output << ".thumb_func" << std::endl;
     output << ".global run" << std::endl;
     output << "run:" << std::endl;
@@ -203,6 +301,21 @@ void generate_target_code(const std::unique_ptr<STGProgram> &program, std::ostre
     output << "    MOV R11, R7" << std::endl;
     output << "    POP {R4, R5, R6, R7, PC} @ restore final registers and return" << std::endl;
     output << ".ltorg @ tell the assembler to stick a literal pool here" << std::endl;
-    generate_standard_constructor_info_tables_and_closures(program, output);
-    generate_code_for_bindings(program, output);
-};
+    generate_standard_constructor_info_tables_and_closures(data_constructors, string_literals, output);
+}
+
+void generate_module_code(
+        const std::unique_ptr<STGProgram> &program,
+        std::ostream &output,
+        CompileStatistics *statistics) {
+    output << ".text" << std::endl;
+    generate_code_for_bindings(program, output, statistics);
+}
+
+void generate_target_code(
+        const std::unique_ptr<STGProgram> &program,
+        std::ostream &output,
+        CompileStatistics *statistics) {
+    generate_runtime_code(program->data_constructors, program->string_literals, output);
+    generate_code_for_bindings(program, output, statistics);
+}
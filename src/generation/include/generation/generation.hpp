@@ -1,10 +1,28 @@
 #ifndef PICOHASKELL_GENERATION_HPP
 #define PICOHASKELL_GENERATION_HPP
 
+#include <map>
 #include <memory>
 #include <ostream>
 #include "stg/stg.hpp"
 
-void generate_target_code(const std::unique_ptr<STGProgram> &program, std::ostream &output);
+class CompileStatistics;
+
+// The number of bytes of code generated for each top-level binding is recorded in the statistics, if they are given.
+void generate_target_code(
+        const std::unique_ptr<STGProgram> &program,
+        std::ostream &output,
+        CompileStatistics *statistics = nullptr);
+// When modules are compiled separately, the code for each one is generated on its own, and the modules are linked by
+// putting it after the runtime code, which runs main and holds the data constructors used by any of them.
+void generate_module_code(
+        const std::unique_ptr<STGProgram> &program,
+        std::ostream &output,
+        CompileStatistics *statistics = nullptr);
+// The code that unpacks string literals is only generated for programs that have them.
+void generate_runtime_code(
+        const std::map<Symbol, STGDataConstructor, SpellingOrder> &data_constructors,
+        bool string_literals,
+        std::ostream &output);
 
 #endif //PICOHASKELL_GENERATION_HPP
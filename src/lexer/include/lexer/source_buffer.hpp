@@ -0,0 +1,31 @@
+#ifndef PICOHASKELL_SOURCE_BUFFER_HPP
+#define PICOHASKELL_SOURCE_BUFFER_HPP
+
+#include <cstdio>
+#include <memory>
+#include <string_view>
+
+// Holds the text of a source file, followed by the two null bytes flex needs to scan it in place.
+// STRING tokens are views into this buffer, so it must outlive them.
+class SourceBuffer {
+public:
+    static std::unique_ptr<SourceBuffer> map_file(const char *path);
+    static std::unique_ptr<SourceBuffer> read_stream(FILE *stream);
+    static std::unique_ptr<SourceBuffer> copy_string(std::string_view text);
+
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+    ~SourceBuffer();
+
+    char *data() const { return buffer; }
+    size_t size() const { return length; }
+
+private:
+    SourceBuffer(char *buffer, size_t length, size_t mapped_length):
+            buffer(buffer), length(length), mapped_length(mapped_length) {}
+    char * const buffer;
+    const size_t length;
+    const size_t mapped_length;
+};
+
+#endif //PICOHASKELL_SOURCE_BUFFER_HPP
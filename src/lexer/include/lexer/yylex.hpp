@@ -2,10 +2,13 @@
 #define PICOHASKELL_LEXER_HPP
 
 #include "parser/parser.hpp"
+#include "lexer/source_buffer.hpp"
 
-#define YY_DECL yy::parser::symbol_type yylex(yy::location &loc)
+#define YY_DECL yy::parser::symbol_type yylex(yyscan_t yyscanner, yy::location &loc)
 YY_DECL;
 
-void reset_start_condition();
+// Each call uses its own scanner and parser, so several programs can be parsed concurrently.
+int parse_program(SourceBuffer &source, Program *program);
+int parse_program(const char *input, Program *program);
 
 #endif //PICOHASKELL_LEXER_HPP
@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "lexer/source_buffer.hpp"
+
+std::unique_ptr<SourceBuffer> SourceBuffer::map_file(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_status{};
+    if (fstat(fd, &file_status) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    size_t length = file_status.st_size;
+
+    // Reserve zeroed memory with room for the two null bytes, then map the file over the start of it.
+    // The mapping is private and writable because flex writes into the buffer while it scans.
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t mapped_length = ((length + 2 + page_size - 1) / page_size) * page_size;
+    void *region = mmap(nullptr, mapped_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        close(fd);
+        return nullptr;
+    }
+    if (length > 0 &&
+        mmap(region, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(region, mapped_length);
+        close(fd);
+        return nullptr;
+    }
+    close(fd);
+
+    return std::unique_ptr<SourceBuffer>(new SourceBuffer(static_cast<char*>(region), length, mapped_length));
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::read_stream(FILE *stream) {
+    size_t capacity = 4096;
+    size_t length = 0;
+    char *buffer = static_cast<char*>(malloc(capacity));
+    while (buffer != nullptr) {
+        length += fread(buffer + length, 1, capacity - length - 2, stream);
+        if (length < capacity - 2) {
+            break;
+        }
+        capacity *= 2;
+        char *new_buffer = static_cast<char*>(realloc(buffer, capacity));
+        if (new_buffer == nullptr) {
+            free(buffer);
+        }
+        buffer = new_buffer;
+    }
+    if (buffer == nullptr || ferror(stream)) {
+        free(buffer);
+        return nullptr;
+    }
+    buffer[length] = '\0';
+    buffer[length + 1] = '\0';
+    return std::unique_ptr<SourceBuffer>(new SourceBuffer(buffer, length, 0));
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::copy_string(std::string_view text) {
+    char *buffer = static_cast<char*>(malloc(text.size() + 2));
+    if (buffer == nullptr) {
+        return nullptr;
+    }
+    memcpy(buffer, text.data(), text.size());
+    buffer[text.size()] = '\0';
+    buffer[text.size() + 1] = '\0';
+    return std::unique_ptr<SourceBuffer>(new SourceBuffer(buffer, text.size(), 0));
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped_length > 0) {
+        munmap(buffer, mapped_length);
+    } else {
+        free(buffer);
+    }
+}
@@ -1,26 +1,63 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
-#include "parser/location.hh"
+#include <cstring>
 #include "parser/syntax.hpp"
 #include "prelude/prelude.hpp"
-#include "parser/parser.hpp"
+#include "lexer/source_buffer.hpp"
 #include "lexer/yylex.hpp"
-#include "lexer/lexer.hpp"
 #include "types/type_check.hpp"
+#include "types/type_cache.hpp"
 #include "stg/stg.hpp"
+#include "stg/simplify.hpp"
+#include "stg/strictness.hpp"
+#include "stg/worker_wrapper.hpp"
 #include "generation/generation.hpp"
+#include "modules/modules.hpp"
+#include "statistics/statistics.hpp"
 
 void print_usage_message(std::ostream &s) {
-    s << "Usage: picohaskell [-i <input file>] [-o <output file>]" << std::endl;
+    s << "Usage: picohaskell [-i <input file>] [-o <output file>] [--type-cache <directory>] [--time-report]"
+      << " [--stats=json] [--no-simplify]" << std::endl;
     s << "If no input file is specified, stdin will be used." << std::endl;
     s << "If no output file is specified, stdout will be used." << std::endl;
+    s << "Imported modules are read from the directory of the input file, where their interfaces are kept." << std::endl;
+    s << "Names are not qualified by module and a module exports everything it defines, so no two modules of a program"
+      << " may define the same top-level name, type or data constructor, even one only used within its module."
+      << std::endl;
+    s << "With --type-cache, inferred types are kept in the directory and reused while the bindings they are for and"
+      << " everything those depend on are unchanged. How often they could be reused is written to stderr." << std::endl;
+    s << "With --time-report, the time taken and peak memory used by each phase, and what each top-level binding cost"
+      << " to infer and generate code for, are written to stderr. With --stats=json, they are written as JSON." << std::endl;
+    s << "With --no-simplify, the translated program is not simplified by inlining and eliminating known cases, nor are"
+      << " thunks it is certain to evaluate evaluated where they are bound, nor are functions of strict Int and Char"
+      << " arguments split into workers that take them unboxed, before code is generated for it." << std::endl;
+}
+
+void print_type_cache_statistics(const TypeCache *type_cache) {
+    if (type_cache != nullptr) {
+        std::cerr << "Type cache: " << type_cache->hits << " hits, " << type_cache->misses << " misses." << std::endl;
+    }
+}
+
+void print_statistics(const CompileStatistics *statistics, bool time_report, bool json_statistics) {
+    if (time_report) {
+        statistics->write_report(std::cerr);
+    }
+    if (json_statistics) {
+        statistics->write_json(std::cerr);
+    }
 }
 
 int main (int argc, char *argv[]) {
-    FILE *input = stdin;
+    std::unique_ptr<SourceBuffer> source;
+    std::string directory = ".";
     std::ofstream output_file;
     std::ostream *output = &std::cout;
+    std::unique_ptr<TypeCache> type_cache;
+    bool time_report = false;
+    bool json_statistics = false;
+    bool optimise = true;
 
     for (int i = 1; i < argc; ) {
         if (strcmp(argv[i], "-h") == 0) {
@@ -28,11 +65,15 @@ int main (int argc, char *argv[]) {
             return 0;
         } else if (strcmp(argv[i], "-i") == 0) {
             if (i+1 < argc) {
-                input = fopen(argv[i+1], "r");
-                if (input == NULL) {
+                source = SourceBuffer::map_file(argv[i+1]);
+                if (!source) {
                     std::cerr << "Could not open input file." << std::endl;
                     return 1;
                 }
+                std::string path = argv[i+1];
+                if (path.find('/') != std::string::npos) {
+                    directory = path.substr(0, path.rfind('/'));
+                }
                 i += 2;
             } else {
                 print_usage_message(std::cerr);
@@ -51,38 +92,96 @@ int main (int argc, char *argv[]) {
                 print_usage_message(std::cerr);
                 return 1;
             }
+        } else if (strcmp(argv[i], "--type-cache") == 0) {
+            if (i+1 < argc) {
+                type_cache = std::make_unique<TypeCache>(argv[i+1]);
+                i += 2;
+            } else {
+                print_usage_message(std::cerr);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--time-report") == 0) {
+            time_report = true;
+            i++;
+        } else if (strcmp(argv[i], "--stats=json") == 0) {
+            json_statistics = true;
+            i++;
+        } else if (strcmp(argv[i], "--no-simplify") == 0) {
+            optimise = false;
+            i++;
         } else {
             print_usage_message(std::cerr);
             return 1;
         }
     }
+    std::unique_ptr<CompileStatistics> statistics;
+    if (time_report || json_statistics) {
+        statistics = std::make_unique<CompileStatistics>();
+    }
+
+    if (!source) {
+        source = SourceBuffer::read_stream(stdin);
+        if (!source) {
+            std::cerr << "Could not read standard input." << std::endl;
+            return 1;
+        }
+    }
 
     std::unique_ptr<Program> program = std::make_unique<Program>();
-    add_prelude(program.get());
-    yy::location loc;
-    yyin = input;
-    YY_BUFFER_STATE buffer = yy_create_buffer(yyin, YY_BUF_SIZE);
-    yy_switch_to_buffer(buffer);
-    reset_start_condition();
-    yy::parser parse(loc, program.get());
-    parse.set_debug_level(false);
-    int result = parse();
-    yy_delete_buffer(buffer);
+    int result;
+    {
+        PhaseTimer timer(statistics.get(), "parse");
+        add_prelude(program.get());
+        result = parse_program(*source, program.get());
+    }
     if (result != 0) {
         std::cerr << "Parse error." << std::endl;
         return 1;
     }
+    if (!program->imports.empty()) {
+        try {
+            compile_modules(program, directory, *output, type_cache.get(), statistics.get(), optimise);
+        } catch (const ModuleError &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        print_type_cache_statistics(type_cache.get());
+        print_statistics(statistics.get(), time_report, json_statistics);
+        output_file.close();
+        return 0;
+    }
     try {
-        type_check(program, true);
+        PhaseTimer timer(statistics.get(), "type check");
+        type_check(program, true, type_cache.get(), statistics.get());
     } catch (const TypeError &e) {
         std::cerr << e.what() << std::endl;
         std::cerr << "Type inference failed." << std::endl;
         return 1;
     }
-    std::unique_ptr<STGProgram> translated = translate(program);
-    generate_target_code(translated, *output);
+    print_type_cache_statistics(type_cache.get());
+    std::unique_ptr<STGProgram> translated;
+    {
+        PhaseTimer timer(statistics.get(), "translate");
+        translated = translate(program, statistics.get());
+    }
+    if (optimise) {
+        {
+            PhaseTimer timer(statistics.get(), "simplify");
+            simplify(translated, program->module_name);
+        }
+        {
+            PhaseTimer timer(statistics.get(), "strictness");
+            evaluate_strict_thunks(translated);
+        }
+        PhaseTimer timer(statistics.get(), "worker/wrapper");
+        split_workers(translated, program->module_name);
+    }
+    {
+        PhaseTimer timer(statistics.get(), "generate");
+        generate_target_code(translated, *output, statistics.get());
+    }
+    print_statistics(statistics.get(), time_report, json_statistics);
 
     output_file.close();
-    fclose(input);
     return 0;
 }
@@ -0,0 +1,47 @@
+#ifndef PICOHASKELL_INTERFACE_HPP
+#define PICOHASKELL_INTERFACE_HPP
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser/syntax.hpp"
+#include "stg/stg.hpp"
+
+// What compiling a module leaves behind for the modules that import it and for linking, written next to its source
+// so that it need not be compiled again while neither it nor the exports of the modules it depends on change.
+struct ModuleInterface {
+    Symbol name;
+    std::vector<Symbol> imports;
+    uint64_t source_hash = 0;
+    // The export hashes of every module this one was compiled against, including those it imports indirectly.
+    std::map<Symbol, uint64_t, SpellingOrder> dependencies;
+    // Whether the module's code was optimised, which it must be again if the program is.
+    bool optimised = false;
+    // The type constructors, kinds and types the module defines and the number of arguments the STG translations of
+    // its bindings take, in the format import_exports reads. They are kept in that format, so that they can be
+    // compared by hash and are only decoded by the modules that import them.
+    std::string exports;
+    uint64_t export_hash = 0;
+    // Needed to link the program: the data constructors the module's code uses, the prelude bindings it refers to and
+    // whether it has string literals.
+    std::map<Symbol, STGDataConstructor, SpellingOrder> data_constructors;
+    std::set<Symbol, SpellingOrder> prelude_bindings;
+    bool string_literals = false;
+};
+
+uint64_t hash_bytes(std::string_view bytes);
+
+std::string write_exports(
+        const Program &program,
+        const std::vector<Symbol> &type_constructors,
+        const std::map<Symbol, size_t, SpellingOrder> &arities);
+// Adds the exports of another module to a program, which must not already define any of the same names.
+void import_exports(const ModuleInterface &interface, Program *program);
+
+std::string write_interface(const ModuleInterface &interface);
+ModuleInterface read_interface(std::string_view bytes);
+
+#endif //PICOHASKELL_INTERFACE_HPP
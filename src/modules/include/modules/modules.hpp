@@ -0,0 +1,42 @@
+#ifndef PICOHASKELL_MODULES_HPP
+#define PICOHASKELL_MODULES_HPP
+
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "parser/syntax.hpp"
+#include "types/type_cache.hpp"
+#include "statistics/statistics.hpp"
+
+class ModuleError : public std::runtime_error {
+public:
+    explicit ModuleError(const std::string &s): std::runtime_error(s) {}
+};
+
+// Which of the modules a program imports, directly or indirectly, had to be compiled and which were up to date.
+struct ModuleReport {
+    std::vector<Symbol> compiled;
+    std::vector<Symbol> up_to_date;
+};
+
+// Compiles the Main module of a program, which has been parsed after the prelude was added to it, together with the
+// modules it imports, and links them into target code. Module M is read from M.hs in directory, and its interface and
+// code are written next to it, to M.phi and M.phs. A module is only compiled again when its source or the exports of a
+// module it depends on have changed, or when it was last compiled with a different optimise, and modules that do not
+// depend on each other are compiled in parallel. The type cache and the statistics, if they are given, are used for
+// every module that is compiled. Names are not qualified by module and every module exports all that it defines, so the
+// top-level names, types and data constructors of the modules a program is made of must all be distinct. With
+// optimise, the program each module is translated to is simplified, the thunks it is certain to evaluate are evaluated
+// where they are bound, and its functions of strict Int and Char arguments are split into workers and wrappers, before
+// code is generated.
+ModuleReport compile_modules(
+        const std::unique_ptr<Program> &program,
+        const std::string &directory,
+        std::ostream &output,
+        TypeCache *type_cache = nullptr,
+        CompileStatistics *statistics = nullptr,
+        bool optimise = true);
+
+#endif //PICOHASKELL_MODULES_HPP
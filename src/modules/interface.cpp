@@ -0,0 +1,116 @@
+#include "modules/interface.hpp"
+#include "modules/modules.hpp"
+#include "prelude/snapshot.hpp"
+
+static const std::string_view interface_magic = "PHIFACE3";
+static const std::string_view exports_magic = "PHEXPORTS1";
+
+// FNV-1a, which is enough to notice that a source file or the exports of a module have changed.
+uint64_t hash_bytes(std::string_view bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char &c: bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string write_exports(
+        const Program &program,
+        const std::vector<Symbol> &type_constructors,
+        const std::map<Symbol, size_t, SpellingOrder> &arities) {
+    SnapshotWriter writer;
+    writer.write_number(type_constructors.size());
+    for (const Symbol &name: type_constructors) {
+        writer.write_type_constructor(program, name);
+        writer.write_kind(program.type_constructor_kinds.at(name));
+        for (const Symbol &data_constructor: program.type_constructors.at(name)->data_constructors) {
+            writer.write_type(program.types.at(data_constructor));
+        }
+    }
+
+    writer.write_number(arities.size());
+    for (const auto &[name, arity]: arities) {
+        writer.write_symbol(name);
+        writer.write_number(arity);
+        writer.write_type(program.types.at(name));
+    }
+    return writer.finish(exports_magic);
+}
+
+void import_exports(const ModuleInterface &interface, Program *program) {
+    SnapshotReader reader(interface.exports, program);
+    reader.start(exports_magic);
+    for (size_t i = reader.read_number(); i > 0; i--) {
+        Symbol name = reader.read_type_constructor();
+        program->type_constructor_kinds[name] = reader.read_kind();
+        for (const Symbol &data_constructor: program->type_constructors.at(name)->data_constructors) {
+            program->types[data_constructor] = std::shared_ptr<Type>(reader.read_type());
+        }
+    }
+
+    for (size_t i = reader.read_number(); i > 0; i--) {
+        Symbol name = reader.read_symbol();
+        if (program->types.count(name) > 0 || program->bindings.count(name) > 0) {
+            throw ModuleError(
+                    "Module " +
+                    interface.name.str() +
+                    " exports " +
+                    name.str() +
+                    ", which is already defined. The modules of a program must not define the same top-level names.");
+        }
+        program->imported_arities[name] = reader.read_number();
+        program->types[name] = std::shared_ptr<Type>(reader.read_type());
+    }
+}
+
+std::string write_interface(const ModuleInterface &interface) {
+    SnapshotWriter writer;
+    writer.write_symbol(interface.name);
+    writer.write_symbols(interface.imports);
+    writer.write_number(interface.source_hash);
+    writer.write_number(interface.optimised);
+    writer.write_number(interface.dependencies.size());
+    for (const auto &[name, hash]: interface.dependencies) {
+        writer.write_symbol(name);
+        writer.write_number(hash);
+    }
+    writer.write_bytes(interface.exports);
+    writer.write_number(interface.data_constructors.size());
+    for (const auto &[name, data_constructor]: interface.data_constructors) {
+        writer.write_symbol(name);
+        writer.write_number(data_constructor.tag);
+        writer.write_number(data_constructor.arity);
+        writer.write_number(data_constructor.number_of_siblings);
+    }
+    writer.write_symbols(std::vector<Symbol>(interface.prelude_bindings.begin(), interface.prelude_bindings.end()));
+    writer.write_number(interface.string_literals);
+    return writer.finish(interface_magic);
+}
+
+ModuleInterface read_interface(std::string_view bytes) {
+    SnapshotReader reader(bytes, nullptr);
+    reader.start(interface_magic);
+    ModuleInterface interface;
+    interface.name = reader.read_symbol();
+    interface.imports = reader.read_symbols();
+    interface.source_hash = reader.read_number();
+    interface.optimised = reader.read_number() != 0;
+    for (size_t i = reader.read_number(); i > 0; i--) {
+        Symbol name = reader.read_symbol();
+        interface.dependencies[name] = reader.read_number();
+    }
+    interface.exports = reader.read_bytes();
+    interface.export_hash = hash_bytes(interface.exports);
+    for (size_t i = reader.read_number(); i > 0; i--) {
+        Symbol name = reader.read_symbol();
+        size_t tag = reader.read_number();
+        size_t arity = reader.read_number();
+        size_t number_of_siblings = reader.read_number();
+        interface.data_constructors.emplace(name, STGDataConstructor(tag, arity, number_of_siblings));
+    }
+    std::vector<Symbol> prelude_bindings = reader.read_symbols();
+    interface.prelude_bindings.insert(prelude_bindings.begin(), prelude_bindings.end());
+    interface.string_literals = reader.read_number() != 0;
+    return interface;
+}
@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include "modules/modules.hpp"
+#include "modules/interface.hpp"
+#include "prelude/prelude.hpp"
+#include "prelude/snapshot.hpp"
+#include "lexer/yylex.hpp"
+#include "types/type_check.hpp"
+#include "stg/stg.hpp"
+#include "stg/simplify.hpp"
+#include "stg/strictness.hpp"
+#include "stg/worker_wrapper.hpp"
+#include "generation/generation.hpp"
+#include "statistics/statistics.hpp"
+
+struct Module {
+    Symbol name;
+    std::string path;
+    std::unique_ptr<SourceBuffer> source;
+    uint64_t source_hash = 0;
+    // Only parsed if the module has to be compiled, or if its imports cannot be taken from its last interface.
+    std::unique_ptr<Program> program;
+    std::optional<ModuleInterface> last_interface;
+    std::vector<Symbol> imports;
+    // Every module this one depends on, directly or indirectly, in the order they are compiled.
+    std::vector<Symbol> dependencies;
+    size_t level = 0;
+    std::optional<ModuleInterface> interface;
+    bool compiled = false;
+};
+
+// The names the prelude defines, which every module can use. Only the code for the prelude bindings that are used
+// anywhere in the program is generated, once, when the modules are linked.
+struct PreludeNames {
+    std::unordered_set<Symbol> type_constructors;
+    std::unordered_set<Symbol> bindings;
+};
+
+static std::optional<std::string> read_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+static void write_file(const std::string &path, const std::string &contents) {
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+    if (!file) {
+        throw ModuleError("Could not write " + path + ".");
+    }
+}
+
+static std::unique_ptr<Program> parse_module(Module &module) {
+    auto program = std::make_unique<Program>();
+    add_prelude(program.get());
+    try {
+        if (parse_program(*module.source, program.get()) != 0) {
+            throw ModuleError("Parse error in module " + module.name.str() + ".");
+        }
+    } catch (const ParseError &e) {
+        throw ModuleError("Module " + module.name.str() + ": " + e.what());
+    }
+    if (program->module_name != module.name) {
+        throw ModuleError(module.path + ".hs should define module " + module.name.str() + ".");
+    }
+    return program;
+}
+
+static std::unique_ptr<Module> load_module(const Symbol &name, const Symbol &importer, const std::string &directory) {
+    auto module = std::make_unique<Module>();
+    module->name = name;
+    module->path = directory + "/" + name.str();
+    module->source = SourceBuffer::map_file((module->path + ".hs").c_str());
+    if (!module->source) {
+        throw ModuleError(
+                "Module " +
+                importer.str() +
+                " imports " +
+                name.str() +
+                ", but " +
+                module->path +
+                ".hs could not be read.");
+    }
+    module->source_hash = hash_bytes(std::string_view(module->source->data(), module->source->size()));
+
+    // A missing or unreadable interface just means that the module has to be compiled.
+    std::optional<std::string> interface = read_file(module->path + ".phi");
+    if (interface) {
+        try {
+            module->last_interface = read_interface(*interface);
+        } catch (const SnapshotError &e) {
+            module->last_interface = std::nullopt;
+        }
+    }
+
+    if (module->last_interface &&
+        module->last_interface->name == name &&
+        module->last_interface->source_hash == module->source_hash) {
+        module->imports = module->last_interface->imports;
+    } else {
+        module->last_interface = std::nullopt;
+        module->program = parse_module(*module);
+        for (const auto &[_, imported]: module->program->imports) {
+            module->imports.push_back(imported);
+        }
+    }
+    return module;
+}
+
+// Loads the modules a module imports, and the modules they import in turn, depth first, so that each module comes
+// after the modules it depends on in order.
+static void load_imports(
+        const Symbol &importer,
+        const std::vector<Symbol> &imports,
+        const std::string &directory,
+        std::map<Symbol, std::unique_ptr<Module>, SpellingOrder> &modules,
+        std::vector<Symbol> &path,
+        std::vector<Symbol> &order) {
+    path.push_back(importer);
+    for (const Symbol &name: imports) {
+        auto on_path = std::find(path.begin(), path.end(), name);
+        if (on_path != path.end()) {
+            std::string cycle;
+            for (auto it = on_path; it != path.end(); it++) {
+                cycle += it->str() + " -> ";
+            }
+            throw ModuleError("Modules import each other in a cycle: " + cycle + name.str() + ".");
+        }
+        if (name == Symbol("Prelude")) {
+            throw ModuleError("Module " + importer.str() + " imports Prelude, which every module has already.");
+        }
+        if (modules.count(name) > 0) {
+            continue;
+        }
+        auto module = load_module(name, importer, directory);
+        std::vector<Symbol> module_imports = module->imports;
+        modules[name] = std::move(module);
+        load_imports(name, module_imports, directory, modules, path, order);
+        order.push_back(name);
+    }
+    path.pop_back();
+}
+
+static bool is_up_to_date(
+        const Module &module,
+        const std::map<Symbol, std::unique_ptr<Module>, SpellingOrder> &modules,
+        bool optimise) {
+    if (!module.last_interface ||
+            module.last_interface->optimised != optimise ||
+            module.last_interface->dependencies.size() != module.dependencies.size()) {
+        return false;
+    }
+    for (const Symbol &dependency: module.dependencies) {
+        auto recorded = module.last_interface->dependencies.find(dependency);
+        if (recorded == module.last_interface->dependencies.end() ||
+            recorded->second != modules.at(dependency)->interface->export_hash) {
+            return false;
+        }
+    }
+    return std::ifstream(module.path + ".phs").good();
+}
+
+// Compiles a module against the interfaces of the modules it depends on, returning the bindings it defines.
+static std::vector<Symbol> compile_module_program(
+        const std::unique_ptr<Program> &program,
+        const std::vector<Symbol> &dependencies,
+        const std::map<Symbol, std::unique_ptr<Module>, SpellingOrder> &modules,
+        const PreludeNames &prelude,
+        bool check_for_main,
+        TypeCache *type_cache,
+        CompileStatistics *statistics,
+        std::vector<Symbol> &type_constructors) {
+    for (const auto &[name, _]: program->type_constructors) {
+        if (prelude.type_constructors.count(name) == 0) {
+            type_constructors.push_back(name);
+        }
+    }
+    std::vector<Symbol> bindings;
+    for (const auto &[name, _]: program->bindings) {
+        if (prelude.bindings.count(name) == 0) {
+            bindings.push_back(name);
+        }
+    }
+    for (const Symbol &dependency: dependencies) {
+        import_exports(*modules.at(dependency)->interface, program.get());
+    }
+    PhaseTimer timer(statistics, "type check " + program->module_name.str());
+    type_check(program, check_for_main, type_cache, statistics);
+    return bindings;
+}
+
+static void compile_module(
+        Module &module,
+        const std::map<Symbol, std::unique_ptr<Module>, SpellingOrder> &modules,
+        const PreludeNames &prelude,
+        TypeCache *type_cache,
+        CompileStatistics *statistics,
+        bool optimise) {
+    if (is_up_to_date(module, modules, optimise)) {
+        module.interface = std::move(module.last_interface);
+        return;
+    }
+    if (!module.program) {
+        module.program = parse_module(module);
+    }
+
+    ModuleInterface interface;
+    interface.name = module.name;
+    interface.imports = module.imports;
+    interface.source_hash = module.source_hash;
+    interface.optimised = optimise;
+    for (const Symbol &dependency: module.dependencies) {
+        interface.dependencies[dependency] = modules.at(dependency)->interface->export_hash;
+    }
+
+    std::vector<Symbol> type_constructors;
+    std::vector<Symbol> bindings;
+    std::unique_ptr<STGProgram> translated;
+    try {
+        bindings = compile_module_program(
+                module.program,
+                module.dependencies,
+                modules,
+                prelude,
+                false,
+                type_cache,
+                statistics,
+                type_constructors);
+        {
+            PhaseTimer timer(statistics, "translate " + module.name.str());
+            translated = translate(module.program, bindings, prelude.bindings, interface.prelude_bindings, statistics);
+        }
+        if (optimise) {
+            {
+                PhaseTimer timer(statistics, "simplify " + module.name.str());
+                simplify(translated, module.name);
+            }
+            {
+                PhaseTimer timer(statistics, "strictness " + module.name.str());
+                evaluate_strict_thunks(translated);
+            }
+            PhaseTimer timer(statistics, "worker/wrapper " + module.name.str());
+            split_workers(translated, module.name);
+        }
+    } catch (const ParseError &e) {
+        throw ModuleError("Module " + module.name.str() + ": " + e.what());
+    } catch (const TypeError &e) {
+        throw ModuleError("Module " + module.name.str() + ": " + e.what());
+    }
+
+    std::map<Symbol, size_t, SpellingOrder> arities;
+    for (const Symbol &name: bindings) {
+        arities[name] = translated->bindings.at(name)->argument_variables.size();
+    }
+    interface.exports = write_exports(*module.program, type_constructors, arities);
+    interface.export_hash = hash_bytes(interface.exports);
+    for (const auto &[name, data_constructor]: translated->data_constructors) {
+        interface.data_constructors.emplace(name, data_constructor);
+    }
+    interface.string_literals = translated->string_literals;
+
+    // The code is written before the interface, so that an interface is never left describing code that is missing.
+    std::stringstream code;
+    {
+        PhaseTimer timer(statistics, "generate " + module.name.str());
+        generate_module_code(translated, code, statistics);
+    }
+    write_file(module.path + ".phs", code.str());
+    write_file(module.path + ".phi", write_interface(interface));
+    module.interface = std::move(interface);
+    module.compiled = true;
+}
+
+ModuleReport compile_modules(
+        const std::unique_ptr<Program> &program,
+        const std::string &directory,
+        std::ostream &output,
+        TypeCache *type_cache,
+        CompileStatistics *statistics,
+        bool optimise) {
+    auto prelude_program = std::make_unique<Program>();
+    add_prelude(prelude_program.get());
+    prelude_program->module_name = Symbol("Prelude");
+    PreludeNames prelude;
+    for (const auto &[name, _]: prelude_program->type_constructors) {
+        prelude.type_constructors.insert(name);
+    }
+    for (const auto &[name, _]: prelude_program->bindings) {
+        prelude.bindings.insert(name);
+    }
+
+    std::vector<Symbol> main_imports;
+    for (const auto &[_, imported]: program->imports) {
+        main_imports.push_back(imported);
+    }
+    std::map<Symbol, std::unique_ptr<Module>, SpellingOrder> modules;
+    std::vector<Symbol> order;
+    std::vector<Symbol> path;
+    load_imports(program->module_name, main_imports, directory, modules, path, order);
+
+    // A module's level is one more than the highest level of the modules it imports, so the modules on each level
+    // only depend on modules on lower levels and can be compiled at the same time.
+    std::vector<std::vector<Module*>> levels;
+    for (const Symbol &name: order) {
+        Module &module = *modules.at(name);
+        std::unordered_set<Symbol> dependencies;
+        for (const Symbol &imported: module.imports) {
+            const Module &dependency = *modules.at(imported);
+            module.level = std::max(module.level, dependency.level + 1);
+            dependencies.insert(imported);
+            dependencies.insert(dependency.dependencies.begin(), dependency.dependencies.end());
+        }
+        for (const Symbol &other: order) {
+            if (dependencies.count(other) > 0) {
+                module.dependencies.push_back(other);
+            }
+        }
+        if (levels.size() <= module.level) {
+            levels.resize(module.level + 1);
+        }
+        levels[module.level].push_back(&module);
+    }
+
+    for (const auto &level: levels) {
+        std::vector<std::exception_ptr> errors(level.size());
+        std::atomic<size_t> next = 0;
+        auto work = [&]() {
+            for (size_t i = next++; i < level.size(); i = next++) {
+                try {
+                    compile_module(*level[i], modules, prelude, type_cache, statistics, optimise);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        size_t number_of_threads = std::min<size_t>(level.size(), std::max(1u, std::thread::hardware_concurrency()));
+        for (size_t i = 1; i < number_of_threads; i++) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        for (const auto &error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    std::vector<Symbol> type_constructors;
+    std::set<Symbol, SpellingOrder> used_prelude_bindings;
+    std::unique_ptr<STGProgram> translated;
+    try {
+        compile_module_program(program, order, modules, prelude, true, type_cache, statistics, type_constructors);
+        {
+            PhaseTimer timer(statistics, "translate " + program->module_name.str());
+            translated = translate(program, {Symbol("main")}, prelude.bindings, used_prelude_bindings, statistics);
+        }
+        if (optimise) {
+            {
+                PhaseTimer timer(statistics, "simplify " + program->module_name.str());
+                simplify(translated, program->module_name);
+            }
+            {
+                PhaseTimer timer(statistics, "strictness " + program->module_name.str());
+                evaluate_strict_thunks(translated);
+            }
+            PhaseTimer timer(statistics, "worker/wrapper " + program->module_name.str());
+            split_workers(translated, program->module_name);
+        }
+    } catch (const TypeError &e) {
+        throw ModuleError("Module " + program->module_name.str() + ": " + e.what());
+    }
+
+    std::map<Symbol, STGDataConstructor, SpellingOrder> data_constructors = translated->data_constructors;
+    bool string_literals = translated->string_literals;
+    for (const Symbol &name: order) {
+        const ModuleInterface &interface = *modules.at(name)->interface;
+        used_prelude_bindings.insert(interface.prelude_bindings.begin(), interface.prelude_bindings.end());
+        data_constructors.insert(interface.data_constructors.begin(), interface.data_constructors.end());
+        string_literals = string_literals || interface.string_literals;
+    }
+    std::set<Symbol, SpellingOrder> unused;
+    PhaseTimer timer(statistics, "link");
+    std::unique_ptr<STGProgram> translated_prelude = translate(
+            prelude_program,
+            std::vector<Symbol>(used_prelude_bindings.begin(), used_prelude_bindings.end()),
+            {},
+            unused,
+            statistics);
+    if (optimise) {
+        simplify(translated_prelude, prelude_program->module_name);
+        evaluate_strict_thunks(translated_prelude);
+        split_workers(translated_prelude, prelude_program->module_name);
+    }
+    data_constructors.insert(translated_prelude->data_constructors.begin(), translated_prelude->data_constructors.end());
+    string_literals = string_literals || translated_prelude->string_literals;
+
+    ModuleReport report;
+    generate_runtime_code(data_constructors, string_literals, output);
+    generate_module_code(translated_prelude, output, statistics);
+    for (const Symbol &name: order) {
+        const Module &module = *modules.at(name);
+        std::optional<std::string> code = read_file(module.path + ".phs");
+        if (!code) {
+            throw ModuleError("Could not read " + module.path + ".phs.");
+        }
+        output << *code;
+        (module.compiled ? report.compiled : report.up_to_date).push_back(name);
+    }
+    generate_module_code(translated, output, statistics);
+    return report;
+}
@@ -3,10 +3,14 @@
 
 #include <utility>
 #include <map>
+#include <unordered_map>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <stdexcept>
 #include <variant>
+#include "arena/arena.hpp"
+#include "symbols/symbol.hpp"
 #include "types/types.hpp"
 
 enum class patternform {constructor, wild, literal, variable};
@@ -20,125 +24,121 @@ public:
 
 struct DConstructor {
     const int line;
-    const std::string name;
+    const Symbol name;
     std::vector<std::shared_ptr<Type>> types;
-    std::string type_constructor;
-    DConstructor(const int &line, std::string name, const std::vector<Type*> &types);
+    Symbol type_constructor;
+    DConstructor(const int &line, Symbol name, const std::vector<Type*> &types);
 };
 
 struct TConstructor {
-    const std::string name;
-    const std::vector<std::string> argument_variables;
-    const std::vector<std::string> data_constructors;
+    const Symbol name;
+    const std::vector<Symbol> argument_variables;
+    const std::vector<Symbol> data_constructors;
     const int line;
     TConstructor(
             const int &line,
-            std::string name,
-            const std::vector<std::string> &argument_variables,
-            const std::vector<std::string> &data_constructors):
+            Symbol name,
+            const std::vector<Symbol> &argument_variables,
+            const std::vector<Symbol> &data_constructors):
             line(line),
-            name(std::move(name)),
+            name(name),
             argument_variables(argument_variables),
             data_constructors(data_constructors) {}
 };
 
-struct Pattern {
+struct Pattern : public ArenaAllocated {
     const int line;
-    std::vector<std::string> as;
-    explicit Pattern(const int &line): line(line) {}
-    virtual patternform get_form() = 0;
+    std::vector<Symbol> as;
+    const patternform form;
+    // The type of the values the pattern matches, filled in by type checking. It is null for bindings whose types
+    // were loaded from a type cache rather than inferred.
+    std::shared_ptr<Type> type;
+    Pattern(const int &line, const patternform &form): line(line), form(form) {}
     virtual ~Pattern() = default;
+    patternform get_form() const { return form; }
 };
 
 struct ConstructorPattern : Pattern {
-    const std::string name;
+    const Symbol name;
     std::vector<std::unique_ptr<Pattern>> args;
-    ConstructorPattern(const int &line, std::string name, const std::vector<Pattern*> &args);
-    patternform get_form() override { return patternform::constructor; }
+    ConstructorPattern(const int &line, Symbol name, const std::vector<Pattern*> &args);
 };
 
 struct WildPattern : Pattern {
-    WildPattern(const int &line): Pattern(line) {}
-    patternform get_form() override { return patternform::wild; }
+    WildPattern(const int &line): Pattern(line, patternform::wild) {}
 };
 
 struct LiteralPattern : Pattern {
     const std::variant<int, char> value;
-    LiteralPattern(const int &line, int value): Pattern(line), value(value) {}
-    LiteralPattern(const int &line, char value): Pattern(line), value(value) {}
-    patternform get_form() override { return patternform::literal; }
+    LiteralPattern(const int &line, int value): Pattern(line, patternform::literal), value(value) {}
+    LiteralPattern(const int &line, char value): Pattern(line, patternform::literal), value(value) {}
 };
 
 struct VariablePattern : Pattern {
-    const std::string name;
-    VariablePattern(const int &line, std::string name): Pattern(line), name(std::move(name)) {}
-    patternform get_form() override { return patternform::variable; }
+    const Symbol name;
+    VariablePattern(const int &line, Symbol name): Pattern(line, patternform::variable), name(name) {}
 };
 
-struct Expression {
+struct Expression : public ArenaAllocated {
     const int line;
-    explicit Expression(const int &line): line(line) {}
-    virtual expform get_form() = 0;
+    const expform form;
+    // The type of the expression, filled in by type checking like the type of a pattern.
+    std::shared_ptr<Type> type;
+    Expression(const int &line, const expform &form): line(line), form(form) {}
     virtual ~Expression() = default;
+    expform get_form() const { return form; }
 };
 
 struct Variable : public Expression {
-    const std::string name;
-    Variable(const int &line, std::string name): Expression(line), name(std::move(name)) {}
-    expform get_form() override { return expform::variable; }
+    const Symbol name;
+    Variable(const int &line, Symbol name): Expression(line, expform::variable), name(name) {}
 };
 
 struct Constructor : public Expression {
-    const std::string name;
-    Constructor(const int &line, std::string name): Expression(line), name(std::move(name)) {}
-    expform get_form() override { return expform::constructor; }
+    const Symbol name;
+    Constructor(const int &line, Symbol name): Expression(line, expform::constructor), name(name) {}
 };
 
+// A string literal is kept packed as a single node; it stands for the list of its characters.
 struct Literal : public Expression {
-    const std::variant<int, char> value;
-    Literal(const int &line, const int &i): Expression(line), value(i) {}
-    Literal(const int &line, const char &c): Expression(line), value(c) {}
-    expform get_form() override { return expform::literal; }
+    const std::variant<int, char, std::string> value;
+    Literal(const int &line, const int &i): Expression(line, expform::literal), value(i) {}
+    Literal(const int &line, const char &c): Expression(line, expform::literal), value(c) {}
+    Literal(const int &line, std::string s): Expression(line, expform::literal), value(std::move(s)) {}
 };
 
 struct Abstraction : public Expression {
-    const std::vector<std::string> args;
+    const std::vector<Symbol> args;
     const std::unique_ptr<Expression> body;
     Abstraction(
             const int &line,
-            const std::vector<std::string> &args,
-            Expression * const &body): Expression(line), args(args), body(body) {}
-    expform get_form() override { return expform::abstraction; }
+            const std::vector<Symbol> &args,
+            Expression * const &body): Expression(line, expform::abstraction), args(args), body(body) {}
 };
 
 struct Application : public Expression {
-    const std::unique_ptr<Expression> left;
-    const std::unique_ptr<Expression> right;
-    Application(
-            const int &line,
-            Expression * const &left,
-            Expression * const &right): Expression(line), left(left), right(right) {}
-    expform get_form() override { return expform::application; }
+    const std::unique_ptr<Expression> function;
+    std::vector<std::unique_ptr<Expression>> arguments;
+    Application(const int &line, Expression * const &function, const std::vector<Expression*> &arguments);
+    ~Application() override;
 };
 
 struct Case : public Expression {
     const std::unique_ptr<Expression> exp;
     std::vector<std::pair<std::unique_ptr<Pattern>, std::unique_ptr<Expression>>> alts;
     Case(const int &line, Expression * const &exp, const std::vector<std::pair<Pattern*, Expression*>> &alts);
-    expform get_form() override { return expform::cAsE; }
 };
 
 struct Let : public Expression {
-    std::map<std::string, std::unique_ptr<Expression>> bindings;
-    std::map<std::string, std::shared_ptr<Type>> type_signatures;
+    std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> bindings;
+    std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> type_signatures;
     const std::unique_ptr<Expression> e;
     Let(
             const int &line,
-            const std::map<std::string, Expression*> &bindings,
-            const std::map<std::string, Type*> &type_signatures,
+            const std::map<Symbol, Expression*, SpellingOrder> &bindings,
+            const std::map<Symbol, Type*, SpellingOrder> &type_signatures,
             Expression * const &e
             );
-    expform get_form() override { return expform::let; }
 };
 
 struct BuiltInOp : public Expression {
@@ -149,42 +149,54 @@ struct BuiltInOp : public Expression {
             const int &line,
             Expression * const &left,
             Expression * const &right,
-            const builtinop &op): Expression(line), left(left), right(right), op(op) {}
-    expform get_form() override { return expform::builtinop; }
+            const builtinop &op): Expression(line, expform::builtinop), left(left), right(right), op(op) {}
 };
 
 struct Program {
-    std::map<std::string, std::unique_ptr<TConstructor>> type_constructors;
-    std::map<std::string, std::unique_ptr<DConstructor>> data_constructors;
-    std::map<std::string, size_t> data_constructor_arities;
-    std::map<std::string, std::unique_ptr<Expression>> bindings;
-    std::map<std::string, std::shared_ptr<Type>> type_signatures;
-    void add_type_signature(const int &line, const std::string &name, Type* const &t);
+    // Owns the memory of every node in the program, so it is declared first and destroyed last.
+    Arena arena;
+    std::map<Symbol, std::unique_ptr<TConstructor>, SpellingOrder> type_constructors;
+    std::map<Symbol, std::unique_ptr<DConstructor>, SpellingOrder> data_constructors;
+    std::unordered_map<Symbol, size_t> data_constructor_arities;
+    std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> bindings;
+    std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> type_signatures;
+    // Filled in by type_check. Names that already have an entry, such as those of a prelude loaded from a snapshot,
+    // are taken to be checked and are not inferred again.
+    std::unordered_map<Symbol, std::shared_ptr<Kind>> type_constructor_kinds;
+    std::unordered_map<Symbol, std::shared_ptr<Type>> types;
+    // The module the program was parsed from and the modules it imports, with the lines of the imports. The bindings
+    // of imported modules are compiled separately, so only their types, in types, and the number of arguments their
+    // STG translations take are loaded.
+    Symbol module_name = Symbol("Main");
+    std::vector<std::pair<int, Symbol>> imports;
+    std::unordered_map<Symbol, size_t> imported_arities;
+    void add_type_signature(const int &line, const Symbol &name, Type* const &t);
     void add_type_constructor(
             const int &line,
-            const std::string &name,
-            const std::vector<std::string> &argument_variables,
+            const Symbol &name,
+            const std::vector<Symbol> &argument_variables,
             const std::vector<DConstructor*> &new_data_constructors);
-    void add_variable(const int &line, const std::string &name, Expression * const &exp);
+    void add_variable(const int &line, const Symbol &name, Expression * const &exp);
     void add_named_function(
             const int &line,
-            const std::string &name,
-            const std::vector<std::string> &args,
+            const Symbol &name,
+            const std::vector<Symbol> &args,
             Expression * const &body);
 };
 
-typedef std::vector<std::pair<std::string, Type*>> typesigs;
-typedef std::vector<std::tuple<std::string, std::vector<std::string>, Expression*>> funcs;
-typedef std::vector<std::pair<std::string, Expression*>> vars;
+typedef std::vector<std::pair<Symbol, Type*>> typesigs;
+typedef std::vector<std::tuple<Symbol, std::vector<Symbol>, Expression*>> funcs;
+typedef std::vector<std::pair<Symbol, Expression*>> vars;
 typedef std::tuple<typesigs, funcs, vars> declist;
 
-Expression *make_if_expression(const int &line, Expression* const &e1, Expression* const &e2, Expression* const &e3);
-Expression *make_string_expression(const int &line, const std::string &str);
-Expression *make_list_expression(const int &line, const std::vector<Expression*> &elements);
-Expression *make_tuple_expression(const int &line, const std::vector<Expression*> &elements);
-Expression *make_let_expression(const int &line, const declist &decls, Expression* const &e);
-Pattern *make_string_pattern(const int &line, const std::string &str);
-Pattern *make_list_pattern(const int &line, const std::vector<Pattern*> &elements);
-Pattern *make_tuple_pattern(const int &line, const std::vector<Pattern*> &elements);
+Expression *make_application_expression(Arena &arena, const int &line, Expression* const &f, Expression* const &e);
+Expression *make_if_expression(Arena &arena, const int &line, Expression* const &e1, Expression* const &e2, Expression* const &e3);
+Expression *make_string_expression(Arena &arena, const int &line, std::string_view str);
+Expression *make_list_expression(Arena &arena, const int &line, const std::vector<Expression*> &elements);
+Expression *make_tuple_expression(Arena &arena, const int &line, const std::vector<Expression*> &elements);
+Expression *make_let_expression(Arena &arena, const int &line, const declist &decls, Expression* const &e);
+Pattern *make_string_pattern(Arena &arena, const int &line, std::string_view str);
+Pattern *make_list_pattern(Arena &arena, const int &line, const std::vector<Pattern*> &elements);
+Pattern *make_tuple_pattern(Arena &arena, const int &line, const std::vector<Pattern*> &elements);
 
 #endif //PICOHASKELL_SYNTAX_HPP
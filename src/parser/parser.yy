@@ -7,11 +7,18 @@
 %define parse.assert
 %code requires {
     #include <string>
+    #include <string_view>
     #include <memory>
+    #include "symbols/symbol.hpp"
     #include "parser/syntax.hpp"
     #include "types/types.hpp"
+
+    #ifndef YY_TYPEDEF_YY_SCANNER_T
+    #define YY_TYPEDEF_YY_SCANNER_T
+    typedef void *yyscan_t;
+    #endif
 }
-%param { yy::location &loc }
+%param { yyscan_t scanner } { yy::location &loc }
 %parse-param { Program *program }
 %locations
 %define parse.trace
@@ -82,7 +89,8 @@
     DOT            "."
     APPEND         "++"
 ;
-%token <std::string> VARID CONID STRING
+%token <Symbol> VARID CONID
+%token <std::string_view> STRING
 %token <int> INTEGER
 %token <double> FLOAT
 %token <char> CHAR
@@ -95,18 +103,18 @@
 %left "*" "/"
 %right "."
 
-%nterm <std::string> var gcon
-%nterm <std::vector<std::string>> vars tyvars
+%nterm <Symbol> var gcon
+%nterm <std::vector<Symbol>> vars tyvars
 %nterm <Type*> ctype btype atype gtycon
 %nterm <std::vector<Type*>> types atypes
 %nterm <int> commas
-%nterm <std::pair<std::string, std::vector<std::string>>> simpletype
+%nterm <std::pair<Symbol, std::vector<Symbol>>> simpletype
 %nterm <std::vector<DConstructor*>> constrs
 %nterm <DConstructor*> constr
 %nterm <Expression*> exp infixexp lexp fexp aexp
-%nterm <std::pair<std::string, Expression*>> vardecl
-%nterm <std::tuple<std::string, std::vector<std::string>, Expression*>> fundecl
-%nterm <std::pair<std::string, Type*>> typesig
+%nterm <std::pair<Symbol, Expression*>> vardecl
+%nterm <std::tuple<Symbol, std::vector<Symbol>, Expression*>> fundecl
+%nterm <std::pair<Symbol, Type*>> typesig
 %nterm <std::vector<Expression*>> explist
 %nterm <declist> decls
 %nterm <Pattern*> pat lpat apat
@@ -115,7 +123,25 @@
 %nterm <std::vector<std::pair<Pattern*, Expression*>>> alts
 
 %%
-%start topdecls;
+%start module;
+
+module:
+    "module" CONID "where" "{" body "}" { program->module_name = $2; }
+  | body
+  ;
+
+body:
+    topdecls
+  | impdecls
+  | impdecls ";" topdecls
+  ;
+
+impdecls:
+    impdecl
+  | impdecls ";" impdecl
+  ;
+
+impdecl: "import" CONID { program->imports.emplace_back(@1.begin.line, $2); };
 
 topdecls:
     topdecl
@@ -135,9 +161,9 @@ decls:
   | typesig           { $$ = std::make_tuple<typesigs, funcs, vars>({$1}, {}, {}); }
   | fundecl           { $$ = std::make_tuple<typesigs, funcs, vars>({}, {$1}, {}); }
   | vardecl           { $$ = std::make_tuple<typesigs, funcs, vars>({}, {}, {$1}); }
-  | decls ";" typesig { $$ = $1; std::get<0>($$).push_back($3); }
-  | decls ";" fundecl { $$ = $1; std::get<1>($$).push_back($3); }
-  | decls ";" vardecl { $$ = $1; std::get<2>($$).push_back($3); }
+  | decls ";" typesig { $$ = std::move($1); std::get<0>($$).push_back($3); }
+  | decls ";" fundecl { $$ = std::move($1); std::get<1>($$).push_back($3); }
+  | decls ";" vardecl { $$ = std::move($1); std::get<2>($$).push_back($3); }
 
 typesig: var "::" ctype   { $$ = std::make_pair($1, $3); };
 fundecl: var vars "=" exp { $$ = std::make_tuple($1, $2, $4); };
@@ -148,63 +174,63 @@ exp:
   ;
 
 infixexp:
-    infixexp "+" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "+"), $1), $3); }
-  | infixexp "-" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "-"), $1), $3); }
-  | "-" infixexp            { $$ = new BuiltInOp(@1.begin.line, nullptr, $2, builtinop::negate); }
-  | infixexp "*" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "*"), $1), $3); }
-  | infixexp "/" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "/"), $1), $3); }
-  | infixexp "==" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "=="), $1), $3); }
-  | infixexp "==." infixexp { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "==."), $1), $3); }
-  | infixexp "/=" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "/="), $1), $3); }
-  | infixexp "/=." infixexp { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "/=."), $1), $3); }
-  | infixexp "<" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "<"), $1), $3); }
-  | infixexp "<=" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "<="), $1), $3); }
-  | infixexp ">" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, ">"), $1), $3); }
-  | infixexp ">=" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, ">="), $1), $3); }
-  | infixexp "&&" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "&&"), $1), $3); }
-  | infixexp "||" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "||"), $1), $3); }
-  | infixexp "." infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "."), $1), $3); }
-  | infixexp ":" infixexp   { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Constructor(@2.begin.line, ":"), $1), $3); }
-  | infixexp "++" infixexp  { $$ = new Application(@2.begin.line, new Application(@2.begin.line, new Variable(@2.begin.line, "++"), $1), $3); }
+    infixexp "+" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("+")), {$1, $3}); }
+  | infixexp "-" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("-")), {$1, $3}); }
+  | "-" infixexp            { $$ = new (program->arena) BuiltInOp(@1.begin.line, nullptr, $2, builtinop::negate); }
+  | infixexp "*" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("*")), {$1, $3}); }
+  | infixexp "/" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("/")), {$1, $3}); }
+  | infixexp "==" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("==")), {$1, $3}); }
+  | infixexp "==." infixexp { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("==.")), {$1, $3}); }
+  | infixexp "/=" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("/=")), {$1, $3}); }
+  | infixexp "/=." infixexp { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("/=.")), {$1, $3}); }
+  | infixexp "<" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("<")), {$1, $3}); }
+  | infixexp "<=" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("<=")), {$1, $3}); }
+  | infixexp ">" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol(">")), {$1, $3}); }
+  | infixexp ">=" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol(">=")), {$1, $3}); }
+  | infixexp "&&" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("&&")), {$1, $3}); }
+  | infixexp "||" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("||")), {$1, $3}); }
+  | infixexp "." infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol(".")), {$1, $3}); }
+  | infixexp ":" infixexp   { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Constructor(@2.begin.line, Symbol(":")), {$1, $3}); }
+  | infixexp "++" infixexp  { $$ = new (program->arena) Application(@2.begin.line, new (program->arena) Variable(@2.begin.line, Symbol("++")), {$1, $3}); }
   | lexp                    { $$ = $1; }
   ;
 
 lexp:
     fexp                                                     { $$ = $1; }
-  | "\\" vars "->" exp                                       { $$ = new Abstraction(@1.begin.line, $2, $4); }
-  | "if" exp optsemicolon "then" exp optsemicolon "else" exp { $$ = make_if_expression(@1.begin.line, $2, $5, $8); }
-  | "let" "{" decls "}" "in" exp                             { $$ = make_let_expression(@1.begin.line, $3, $6); }
-  | "case" exp "of" "{" alts "}"                             { $$ = new Case(@1.begin.line, $2, $5); }
+  | "\\" vars "->" exp                                       { $$ = new (program->arena) Abstraction(@1.begin.line, $2, $4); }
+  | "if" exp optsemicolon "then" exp optsemicolon "else" exp { $$ = make_if_expression(program->arena, @1.begin.line, $2, $5, $8); }
+  | "let" "{" decls "}" "in" exp                             { $$ = make_let_expression(program->arena, @1.begin.line, $3, $6); }
+  | "case" exp "of" "{" alts "}"                             { $$ = new (program->arena) Case(@1.begin.line, $2, $5); }
   ;
 
 fexp:
-    fexp aexp { $$ = new Application(@2.begin.line, $1, $2); }
+    fexp aexp { $$ = make_application_expression(program->arena, @2.begin.line, $1, $2); }
   | aexp      { $$ = $1; }
   ;
 
 aexp:
-    var                     { $$ = new Variable(@1.begin.line, $1); }
-  | INTEGER                 { $$ = new Literal(@1.begin.line, $1); }
-  | STRING                  { $$ = make_string_expression(@1.begin.line, $1); }
-  | CHAR                    { $$ = new Literal(@1.begin.line, $1); }
-  | gcon                    { $$ = new Constructor(@1.begin.line, $1); }
-  | "[" explist "]"         { $$ = make_list_expression(@1.begin.line, $2); }
-  | "(" explist "," exp ")" { $2.push_back($4); $$ = make_tuple_expression(@1.begin.line, $2); }
+    var                     { $$ = new (program->arena) Variable(@1.begin.line, $1); }
+  | INTEGER                 { $$ = new (program->arena) Literal(@1.begin.line, $1); }
+  | STRING                  { $$ = make_string_expression(program->arena, @1.begin.line, $1); }
+  | CHAR                    { $$ = new (program->arena) Literal(@1.begin.line, $1); }
+  | gcon                    { $$ = new (program->arena) Constructor(@1.begin.line, $1); }
+  | "[" explist "]"         { $$ = make_list_expression(program->arena, @1.begin.line, $2); }
+  | "(" explist "," exp ")" { $2.push_back($4); $$ = make_tuple_expression(program->arena, @1.begin.line, $2); }
   | "(" exp ")"             { $$ = $2; }
   ;
 
 explist:
     exp             { $$ = {$1}; }
-  | explist "," exp { $$ = $1; $$.push_back($3); }
+  | explist "," exp { $$ = std::move($1); $$.push_back($3); }
 
 vars:
     var      { $$ = {$1}; }
-  | vars var { $$ = $1; $$.push_back($2); }
+  | vars var { $$ = std::move($1); $$.push_back($2); }
   ;
 
 constrs:
     constr             { $$ = {$1}; }
-  | constrs "|" constr { $$ = $1; $$.push_back($3); }
+  | constrs "|" constr { $$ = std::move($1); $$.push_back($3); }
 
 constr:
     CONID        { $$ = new DConstructor(@1.begin.line, $1, {}); }
@@ -212,47 +238,47 @@ constr:
 
 atypes:
     atype        { $$ = {$1}; }
-  | atypes atype { $$ = $1; $$.push_back($2); }
+  | atypes atype { $$ = std::move($1); $$.push_back($2); }
 
 simpletype:
     CONID tyvars { $$ = std::make_pair($1, $2); }
-  | CONID        { $$ = std::make_pair($1, std::vector<std::string>()); }
+  | CONID        { $$ = std::make_pair($1, std::vector<Symbol>()); }
   ;
 
 tyvars:
     VARID        { $$ = {$1}; }
-  | tyvars VARID { $$ = $1; $$.push_back($2); }
+  | tyvars VARID { $$ = std::move($1); $$.push_back($2); }
   ;
 
 ctype:
     btype            { $$ = $1; }
-  | btype "->" ctype { $$ = make_function_type($1, $3); }
+  | btype "->" ctype { $$ = make_function_type(program->arena, $1, $3); }
   ;
 
 btype:
     atype       { $$ = $1; }
-  | btype atype { $$ = new TypeApplication($1, $2); }
+  | btype atype { $$ = new (program->arena) TypeApplication($1, $2); }
   ;
 
 atype:
    gtycon        { $$ = $1; }
- | VARID         { $$ = new UniversallyQuantifiedVariable($1); }
- | "(" types ")" { $$ = make_tuple_type($2); }
- | "[" ctype "]" { $$ = make_list_type($2); }
+ | VARID         { $$ = new (program->arena) UniversallyQuantifiedVariable($1); }
+ | "(" types ")" { $$ = make_tuple_type(program->arena, $2); }
+ | "[" ctype "]" { $$ = make_list_type(program->arena, $2); }
  | "(" ctype ")" { $$ = $2; }
  ;
 
 types:
     ctype "," ctype  { $$ = {$1, $3}; }
-  | types "," ctype  { $$ = $1; $$.push_back($3); }
+  | types "," ctype  { $$ = std::move($1); $$.push_back($3); }
   ;
 
 gtycon:
-    CONID          { $$ = new TypeConstructor($1); }
-  | "(" ")"        { $$ = new TypeConstructor("()"); }
-  | "[" "]"        { $$ = new TypeConstructor("[]"); }
-  | "(" "->" ")"   { $$ = new TypeConstructor("->"); }
-  | "(" commas ")" { $$ = new TypeConstructor("(" + std::string($2, ',') + ")"); }
+    CONID          { $$ = new (program->arena) TypeConstructor($1); }
+  | "(" ")"        { $$ = new (program->arena) TypeConstructor(Symbol("()")); }
+  | "[" "]"        { $$ = new (program->arena) TypeConstructor(Symbol("[]")); }
+  | "(" "->" ")"   { $$ = new (program->arena) TypeConstructor(Symbol("->")); }
+  | "(" commas ")" { $$ = new (program->arena) TypeConstructor("(" + std::string($2, ',') + ")"); }
   ;
 
 commas:
@@ -262,72 +288,72 @@ commas:
 
 
 gcon:
-    "(" ")"        { $$ = "()"; }
-  | "[" "]"        { $$ = "[]"; }
+    "(" ")"        { $$ = Symbol("()"); }
+  | "[" "]"        { $$ = Symbol("[]"); }
   | "(" commas ")" { $$ = "(" + std::string($2, ',') + ")"; }
-  | "(" ":" ")"    { $$ = ":"; }
+  | "(" ":" ")"    { $$ = Symbol(":"); }
   | CONID          { $$ = $1; }
   ;
 
 alts:
     alt          { $$ = {$1}; }
-  | alts ";" alt { $$ = $1; $$.push_back($3); }
+  | alts ";" alt { $$ = std::move($1); $$.push_back($3); }
   ;
 
 alt: pat "->" exp { $$ = std::make_pair($1, $3); };
 
 pat:
-    lpat ":" pat { $$ = new ConstructorPattern(@1.begin.line, ":", std::vector<Pattern*>{$1, $3}); }
+    lpat ":" pat { $$ = new (program->arena) ConstructorPattern(@1.begin.line, Symbol(":"), std::vector<Pattern*>{$1, $3}); }
   | lpat         { $$ = $1; }
   ;
 
 lpat:
     apat        { $$ = $1; }
-  | "-" INTEGER { $$ = new LiteralPattern(@1.begin.line, -$2); }
-  | gcon apats  { $$ = new ConstructorPattern(@1.begin.line, $1, $2); }
+  | "-" INTEGER { $$ = new (program->arena) LiteralPattern(@1.begin.line, -$2); }
+  | gcon apats  { $$ = new (program->arena) ConstructorPattern(@1.begin.line, $1, $2); }
   ;
 
 apat:
     var "@" apat       { $$ = $3; $$->as.push_back($1); }
-  | var                { $$ = new VariablePattern(@1.begin.line, $1); }
-  | gcon                 { $$ = new ConstructorPattern(@1.begin.line, $1, std::vector<Pattern*>{}); }
-  | INTEGER              { $$ = new LiteralPattern(@1.begin.line, $1); }
-  | STRING               { $$ = make_string_pattern(@1.begin.line, $1); }
-  | CHAR                 { $$ = new LiteralPattern(@1.begin.line, $1); }
-  | "_"                  { $$ = new WildPattern(@1.begin.line); }
+  | var                { $$ = new (program->arena) VariablePattern(@1.begin.line, $1); }
+  | gcon                 { $$ = new (program->arena) ConstructorPattern(@1.begin.line, $1, std::vector<Pattern*>{}); }
+  | INTEGER              { $$ = new (program->arena) LiteralPattern(@1.begin.line, $1); }
+  | STRING               { $$ = make_string_pattern(program->arena, @1.begin.line, $1); }
+  | CHAR                 { $$ = new (program->arena) LiteralPattern(@1.begin.line, $1); }
+  | "_"                  { $$ = new (program->arena) WildPattern(@1.begin.line); }
   | "(" pat ")"          { $$ = $2; }
-  | "(" pats "," pat ")" { $2.push_back($4); $$ = make_tuple_pattern(@1.begin.line, $2); }
-  | "[" pats "]"         { $$ = make_list_pattern(@1.begin.line, $2); }
+  | "(" pats "," pat ")" { $2.push_back($4); $$ = make_tuple_pattern(program->arena, @1.begin.line, $2); }
+  | "[" pats "]"         { $$ = make_list_pattern(program->arena, @1.begin.line, $2); }
   ;
 
 apats:
     apat       { $$ = {$1}; }
-  | apats apat { $$ = $1; $$.push_back($2); }
+  | apats apat { $$ = std::move($1); $$.push_back($2); }
   ;
 
 pats:
     pat          { $$ = {$1}; }
-  | pats "," pat { $$ = $1; $$.push_back($3); }
+  | pats "," pat { $$ = std::move($1); $$.push_back($3); }
   ;
 
 var:
     VARID         { $$ = $1; }
-  | "(" "." ")"   { $$ = "."; }
-  | "(" "+" ")"   { $$ = "+"; }
-  | "(" "-" ")"   { $$ = "-"; }
-  | "(" "*" ")"   { $$ = "*"; }
-  | "(" "/" ")"   { $$ = "/"; }
-  | "(" "==" ")"  { $$ = "=="; }
-  | "(" "==." ")" { $$ = "==."; }
-  | "(" "/=" ")"  { $$ = "/="; }
-  | "(" "/=." ")" { $$ = "/=."; }
-  | "(" "<" ")"   { $$ = "<"; }
-  | "(" "<=" ")"  { $$ = "<="; }
-  | "(" ">" ")"   { $$ = ">"; }
-  | "(" ">=" ")"  { $$ = ">="; }
-  | "(" "&&" ")"  { $$ = "&&"; }
-  | "(" "||" ")"  { $$ = "||"; }
-  | "(" "++" ")"  { $$ = "++"; }
+  | "(" "." ")"   { $$ = Symbol("."); }
+  | "(" "+" ")"   { $$ = Symbol("+"); }
+  | "(" "-" ")"   { $$ = Symbol("-"); }
+  | "(" "*" ")"   { $$ = Symbol("*"); }
+  | "(" "/" ")"   { $$ = Symbol("/"); }
+  | "(" "==" ")"  { $$ = Symbol("=="); }
+  | "(" "==." ")" { $$ = Symbol("==."); }
+  | "(" "/=" ")"  { $$ = Symbol("/="); }
+  | "(" "/=." ")" { $$ = Symbol("/=."); }
+  | "(" "<" ")"   { $$ = Symbol("<"); }
+  | "(" "<=" ")"  { $$ = Symbol("<="); }
+  | "(" ">" ")"   { $$ = Symbol(">"); }
+  | "(" ">=" ")"  { $$ = Symbol(">="); }
+  | "(" "&&" ")"  { $$ = Symbol("&&"); }
+  | "(" "||" ")"  { $$ = Symbol("||"); }
+  | "(" "++" ")"  { $$ = Symbol("++"); }
   ;
 
 optsemicolon: %empty | ";";
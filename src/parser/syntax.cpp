@@ -3,8 +3,8 @@
 
 DConstructor::DConstructor(
         const int &line,
-        std::string name,
-        const std::vector<Type*> &types): line(line), name(std::move(name)) {
+        Symbol name,
+        const std::vector<Type*> &types): line(line), name(name) {
     for (const auto &type: types) {
         this->types.emplace_back(type);
     }
@@ -12,17 +12,46 @@ DConstructor::DConstructor(
 
 ConstructorPattern::ConstructorPattern(
         const int &line,
-        std::string name,
-        const std::vector<Pattern *> &args): Pattern(line), name(std::move(name)) {
+        Symbol name,
+        const std::vector<Pattern *> &args): Pattern(line, patternform::constructor), name(name) {
     for (const auto &arg: args) {
         this->args.emplace_back(arg);
     }
 }
 
+Application::Application(
+        const int &line,
+        Expression * const &function,
+        const std::vector<Expression*> &arguments): Expression(line, expform::application), function(function) {
+    for (const auto &argument: arguments) {
+        this->arguments.emplace_back(argument);
+    }
+}
+
+Application::~Application() {
+    // List literals nest an application in the last argument of another, so nested applications are detached
+    // and destroyed one at a time rather than recursively.
+    std::vector<std::unique_ptr<Expression>> nested;
+    for (auto &argument: arguments) {
+        if (argument && argument->get_form() == expform::application) {
+            nested.push_back(std::move(argument));
+        }
+    }
+    while (!nested.empty()) {
+        std::unique_ptr<Expression> expression = std::move(nested.back());
+        nested.pop_back();
+        for (auto &argument: static_cast<Application*>(expression.get())->arguments) {
+            if (argument && argument->get_form() == expform::application) {
+                nested.push_back(std::move(argument));
+            }
+        }
+    }
+}
+
 Case::Case(
         const int &line,
         Expression * const &exp,
-        const std::vector<std::pair<Pattern*, Expression*>> &alts): Expression(line), exp(exp) {
+        const std::vector<std::pair<Pattern*, Expression*>> &alts): Expression(line, expform::cAsE), exp(exp) {
     for (const auto &alt: alts) {
         this->alts.emplace_back(alt.first, alt.second);
     }
@@ -30,9 +59,9 @@ Case::Case(
 
 Let::Let(
         const int &line,
-        const std::map<std::string, Expression*> &bindings,
-        const std::map<std::string, Type*> &type_signatures,
-        Expression * const &e): Expression(line), e(e) {
+        const std::map<Symbol, Expression*, SpellingOrder> &bindings,
+        const std::map<Symbol, Type*, SpellingOrder> &type_signatures,
+        Expression * const &e): Expression(line, expform::let), e(e) {
     for (auto const &[name, exp] : bindings) {
         this->bindings.emplace(name, exp);
     }
@@ -41,7 +70,7 @@ Let::Let(
     }
 }
 
-void Program::add_type_signature(const int &line, const std::string &name, Type* const &t) {
+void Program::add_type_signature(const int &line, const Symbol &name, Type* const &t) {
     if (type_signatures.count(name) > 0) {
         throw ParseError(
                 "Line " +
@@ -53,11 +82,11 @@ void Program::add_type_signature(const int &line, const std::string &name, Type*
 
 void Program::add_type_constructor(
         const int &line,
-        const std::string &name,
-        const std::vector<std::string> &argument_variables,
+        const Symbol &name,
+        const std::vector<Symbol> &argument_variables,
         const std::vector<DConstructor*> &new_data_constructors) {
 
-    std::vector<std::string> data_constructor_names;
+    std::vector<Symbol> data_constructor_names;
     for (const auto& constructor: new_data_constructors) {
         constructor->type_constructor = name;
         if (data_constructors.count(constructor->name) > 0) {
@@ -65,7 +94,7 @@ void Program::add_type_constructor(
                     "Line " +
                     std::to_string(constructor->line) +
                     ": data constructor called " +
-                    constructor->name +
+                    constructor->name.str() +
                     " already exists.");
         }
         data_constructor_names.push_back(constructor->name);
@@ -73,7 +102,7 @@ void Program::add_type_constructor(
         data_constructors.emplace(constructor->name, constructor);
     }
 
-    if (std::set<std::string>(argument_variables.begin(), argument_variables.end()).size() < argument_variables.size()) {
+    if (std::set<Symbol>(argument_variables.begin(), argument_variables.end()).size() < argument_variables.size()) {
         throw ParseError(
                 "Line " +
                 std::to_string(line) +
@@ -86,92 +115,99 @@ void Program::add_type_constructor(
                 "Line " +
                 std::to_string(type_constructor->line) +
                 ": type constructor called " +
-                type_constructor->name +
+                type_constructor->name.str() +
                 " already exists.");
     }
     type_constructors[type_constructor->name] = std::move(type_constructor);
 }
 
-void Program::add_variable(const int &line, const std::string &name, Expression * const &exp) {
+void Program::add_variable(const int &line, const Symbol &name, Expression * const &exp) {
     if (bindings.count(name) > 0) {
         throw ParseError(
                 "Line " +
                 std::to_string(line) +
                 ": multiple bindings to the name " +
-                name +
+                name.str() +
                 ".");
     }
     bindings.emplace(name, exp);
 }
 
-void Program::add_named_function(const int &line, const std::string &name, const std::vector<std::string> &args,
+void Program::add_named_function(const int &line, const Symbol &name, const std::vector<Symbol> &args,
                                  Expression * const &body) {
     if (bindings.count(name) > 0) {
         throw ParseError(
                 "Line " +
                 std::to_string(line) +
                 ": multiple bindings to the name " +
-                name +
+                name.str() +
                 ".");
     }
-    bindings[name] = std::make_unique<Abstraction>(line, args, body);
+    bindings[name] = std::unique_ptr<Expression>(new (arena) Abstraction(line, args, body));
+}
+
+Expression *make_application_expression(Arena &arena, const int &line, Expression * const &f, Expression * const &e) {
+    // Applications are kept flat, so further arguments are added to the application they are applied to.
+    if (f->get_form() == expform::application) {
+        static_cast<Application*>(f)->arguments.emplace_back(e);
+        return f;
+    }
+    return new (arena) Application(line, f, {e});
 }
 
 Expression *make_if_expression(
+        Arena &arena,
         const int &line,
         Expression * const &e1,
         Expression * const &e2,
         Expression * const &e3) {
-    const auto t = new ConstructorPattern(line, "True", std::vector<Pattern*>());
-    const auto f = new ConstructorPattern(line, "False", std::vector<Pattern*>());
+    const auto t = new (arena) ConstructorPattern(line, Symbol("True"), std::vector<Pattern*>());
+    const auto f = new (arena) ConstructorPattern(line, Symbol("False"), std::vector<Pattern*>());
     const auto alt1 = std::make_pair(t, e2);
     const auto alt2 = std::make_pair(f, e3);
     const std::vector<std::pair<Pattern*, Expression*>> alts = {alt1, alt2};
-    return new Case(line, e1, alts);
+    return new (arena) Case(line, e1, alts);
 }
 
-Expression *make_string_expression(const int &line, const std::string &str) {
-    Expression *list = new Constructor(line, "[]");
+Expression *make_string_expression(Arena &arena, const int &line, std::string_view str) {
+    // Strings are emitted as null-terminated data, so only those containing a null character are expanded here.
+    if (str.find('\0') == std::string_view::npos) {
+        return new (arena) Literal(line, std::string(str));
+    }
+
+    const Symbol cons(":");
+    Expression *list = new (arena) Constructor(line, Symbol("[]"));
     for (int i = str.size() - 1; i >= 0; i--) {
-        list = new Application(
+        list = new (arena) Application(
                 line,
-                new Application(
-                        line,
-                        new Constructor(line, ":"),
-                        new Literal(line, str[i])),
-                list);
+                new (arena) Constructor(line, cons),
+                {new (arena) Literal(line, str[i]), list});
     }
     return list;
 }
 
-Expression *make_list_expression(const int &line, const std::vector<Expression*> &elements) {
-    Expression *list = new Constructor(line, "[]");
+Expression *make_list_expression(Arena &arena, const int &line, const std::vector<Expression*> &elements) {
+    const Symbol cons(":");
+    Expression *list = new (arena) Constructor(line, Symbol("[]"));
     for (int i = elements.size() - 1; i >= 0; i--) {
-        list = new Application(
+        list = new (arena) Application(
                 line,
-                new Application(
-                        line,
-                        new Constructor(line, ":"),
-                        elements[i]),
-                list);
+                new (arena) Constructor(line, cons),
+                {elements[i], list});
     }
     return list;
 }
 
-Expression *make_tuple_expression(const int &line, const std::vector<Expression*> &elements) {
-    Expression *tuple = new Constructor(
+Expression *make_tuple_expression(Arena &arena, const int &line, const std::vector<Expression*> &elements) {
+    Expression *constructor = new (arena) Constructor(
             line,
             "(" + std::string(elements.size() - 1, ',') + ")");
-
-    for (const auto &e: elements) {
-        tuple = new Application(line, tuple, e);
-    }
-    return tuple;
+    return new (arena) Application(line, constructor, elements);
 }
 
-Expression *make_let_expression(const int &line, const declist &decls, Expression* const &e) {
-    std::map<std::string, Expression*> bindings;
-    std::map<std::string, Type*> type_signatures;
+Expression *make_let_expression(Arena &arena, const int &line, const declist &decls, Expression* const &e) {
+    std::map<Symbol, Expression*, SpellingOrder> bindings;
+    std::map<Symbol, Type*, SpellingOrder> type_signatures;
 
     for (const auto &function: std::get<1>(decls)) {
         if (bindings.count(std::get<0>(function)) > 0) {
@@ -179,10 +215,10 @@ Expression *make_let_expression(const int &line, const declist &decls, Expressio
                     "Line " +
                     std::to_string(line) +
                     ": multiple bindings to the name " +
-                    std::get<0>(function) +
+                    std::get<0>(function).str() +
                     ".");
         }
-        bindings[std::get<0>(function)] = new Abstraction(line, std::get<1>(function), std::get<2>(function));
+        bindings[std::get<0>(function)] = new (arena) Abstraction(line, std::get<1>(function), std::get<2>(function));
     }
 
     for (const auto &variable: std::get<2>(decls)) {
@@ -191,7 +227,7 @@ Expression *make_let_expression(const int &line, const declist &decls, Expressio
                     "Line " +
                     std::to_string(line) +
                     ": multiple bindings to the name " +
-                    variable.first +
+                    variable.first.str() +
                     ".");
         }
         bindings[variable.first] = variable.second;
@@ -203,38 +239,40 @@ Expression *make_let_expression(const int &line, const declist &decls, Expressio
                     "Line " +
                     std::to_string(line) +
                     ": multiple type signatures for the same name " +
-                    "(" + signature.first + ")" +
+                    "(" + signature.first.str() + ")" +
                     "are not allowed.");
         }
 
         type_signatures[signature.first] = signature.second;
     }
 
-    return new Let(line, bindings, type_signatures, e);
+    return new (arena) Let(line, bindings, type_signatures, e);
 }
 
-Pattern *make_string_pattern(const int &line, const std::string &str) {
-    Pattern *list = new ConstructorPattern(line, "[]", {});
+Pattern *make_string_pattern(Arena &arena, const int &line, std::string_view str) {
+    const Symbol cons(":");
+    Pattern *list = new (arena) ConstructorPattern(line, Symbol("[]"), {});
     for (int i = str.size() - 1; i >= 0; i--) {
-        list = new ConstructorPattern(
+        list = new (arena) ConstructorPattern(
                 line,
-                ":",
-                {new LiteralPattern(line, str[i]), list});
+                cons,
+                {new (arena) LiteralPattern(line, str[i]), list});
     }
     return list;
 }
 
-Pattern *make_list_pattern(const int &line, const std::vector<Pattern*> &elements) {
-    Pattern *list = new ConstructorPattern(line, "[]", {});
+Pattern *make_list_pattern(Arena &arena, const int &line, const std::vector<Pattern*> &elements) {
+    const Symbol cons(":");
+    Pattern *list = new (arena) ConstructorPattern(line, Symbol("[]"), {});
     for (int i = elements.size() - 1; i >= 0; i--) {
-        list = new ConstructorPattern(
+        list = new (arena) ConstructorPattern(
                 line,
-                ":",
+                cons,
                 {elements[i], list});
     }
     return list;
 }
 
-Pattern *make_tuple_pattern(const int &line, const std::vector<Pattern*> &elements) {
-    return new ConstructorPattern(line, "(" + std::string(elements.size() - 1, ',') + ")", elements);
+Pattern *make_tuple_pattern(Arena &arena, const int &line, const std::vector<Pattern*> &elements) {
+    return new (arena) ConstructorPattern(line, "(" + std::string(elements.size() - 1, ',') + ")", elements);
 }
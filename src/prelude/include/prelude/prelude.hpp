@@ -1,8 +1,16 @@
 #ifndef PICOHASKELL_PRELUDE_HPP
 #define PICOHASKELL_PRELUDE_HPP
 
+#include <cstddef>
 #include "parser/syntax.hpp"
 
+// Loads the prelude from the snapshot built into the compiler, already parsed and type checked.
 void add_prelude(Program *program);
+// Parses the prelude from its source. This is how the snapshot is made, and the result has not been type checked.
+void add_prelude_source(Program *program);
+
+// Generated at build time by prelude_snapshot_generator.
+extern const unsigned char prelude_snapshot[];
+extern const size_t prelude_snapshot_size;
 
 #endif //PICOHASKELL_PRELUDE_HPP
@@ -0,0 +1,76 @@
+#ifndef PICOHASKELL_SNAPSHOT_HPP
+#define PICOHASKELL_SNAPSHOT_HPP
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "parser/syntax.hpp"
+
+class SnapshotError : public std::runtime_error {
+public:
+    explicit SnapshotError(const std::string &s): std::runtime_error(s) {}
+};
+
+// Serialises a parsed and type-checked program, including the kinds and types that type_check recorded in it, so
+// that it can be loaded again without being lexed, parsed or checked.
+std::string write_snapshot(const Program &program);
+void read_snapshot(std::string_view snapshot, Program *program);
+
+// The encoding snapshots are written in, which module interfaces use as well. Everything written is appended to the
+// data, and finish puts the given magic string and the table of the symbols used in front of it.
+class SnapshotWriter {
+public:
+    std::string write(const Program &program);
+    std::string finish(std::string_view magic);
+
+    void write_number(size_t n) { write_number(data, n); }
+    void write_integer(int i);
+    void write_bytes(std::string_view bytes);
+    void write_symbol(const Symbol &symbol);
+    void write_symbols(const std::vector<Symbol> &symbols);
+    void write_type(std::shared_ptr<Type> type);
+    void write_kind(const std::shared_ptr<Kind> &kind);
+    void write_type_constructor(const Program &program, const Symbol &name);
+
+private:
+    std::string data;
+    std::vector<Symbol> symbols;
+    std::unordered_map<Symbol, size_t> symbol_indices;
+
+    static void write_number(std::string &output, size_t n);
+    void write_pattern(const std::unique_ptr<Pattern> &pattern);
+    void write_expression(const std::unique_ptr<Expression> &expression);
+};
+
+// Reads what a SnapshotWriter wrote, once start has checked the magic string and read the symbol table. Types are
+// allocated in the program's arena, and type constructors are added to the program as they are read.
+class SnapshotReader {
+public:
+    SnapshotReader(std::string_view snapshot, Program *program): snapshot(snapshot), program(program) {}
+    void read();
+    void start(std::string_view magic);
+
+    uint8_t read_byte();
+    size_t read_number();
+    int read_integer();
+    std::string_view read_bytes(size_t length);
+    std::string_view read_bytes() { return read_bytes(read_number()); }
+    Symbol read_symbol();
+    std::vector<Symbol> read_symbols();
+    Type *read_type();
+    std::shared_ptr<Kind> read_kind();
+    Symbol read_type_constructor();
+
+private:
+    std::string_view snapshot;
+    size_t position = 0;
+    Program *program;
+    std::vector<Symbol> symbols;
+
+    Pattern *read_pattern();
+    Expression *read_expression();
+};
+
+#endif //PICOHASKELL_SNAPSHOT_HPP
@@ -0,0 +1,9 @@
+#include <string_view>
+#include "prelude/prelude.hpp"
+#include "prelude/snapshot.hpp"
+
+void add_prelude(Program *program) {
+    read_snapshot(
+            std::string_view(reinterpret_cast<const char*>(prelude_snapshot), prelude_snapshot_size),
+            program);
+}
@@ -1,6 +1,5 @@
 #include "prelude/prelude.hpp"
 #include "lexer/yylex.hpp"
-#include "lexer/lexer.hpp"
 
 const char *prelude = R"##(
 data Bool = True | False
@@ -40,47 +39,48 @@ data Bool = True | False
 --case_error = error "Non-exhaustive patterns in case"
 )##";
 
-void bind_built_in_op(Program *program, const std::string &function_name, builtinop op) {
+void bind_built_in_op(Program *program, const Symbol &function_name, builtinop op) {
     program->add_named_function(
             0,
             function_name,
-            {"a", "b"},
-            new BuiltInOp(
+            {Symbol("a"), Symbol("b")},
+            new (program->arena) BuiltInOp(
                     0,
-                    new Variable(0, "a"),
-                    new Variable(0, "b"),
+                    new (program->arena) Variable(0, Symbol("a")),
+                    new (program->arena) Variable(0, Symbol("b")),
                     op));
 }
 
-void add_prelude(Program *program) {
-    program->add_type_constructor(0, "Int", {}, {});
-    program->add_type_constructor(0, "Char", {}, {});
-    program->add_type_constructor(0, "->", {"a", "b"}, {});
+void add_prelude_source(Program *program) {
+    program->add_type_constructor(0, Symbol("Int"), {}, {});
+    program->add_type_constructor(0, Symbol("Char"), {}, {});
+    program->add_type_constructor(0, Symbol("->"), {Symbol("a"), Symbol("b")}, {});
     program->add_type_constructor(
             0,
-            "()",
+            Symbol("()"),
             {},
-            {new DConstructor(0, "()", {})});
+            {new DConstructor(0, Symbol("()"), {})});
     program->add_type_constructor(
             0,
-            "[]",
-            {"a"},
+            Symbol("[]"),
+            {Symbol("a")},
             {
-                    new DConstructor(0, "[]", {}),
+                    new DConstructor(0, Symbol("[]"), {}),
                     new DConstructor(
                             0,
-                            ":",
+                            Symbol(":"),
                             {
-                                    new UniversallyQuantifiedVariable("a"),
-                                    new TypeApplication(new TypeConstructor("[]"),
-                                                        new UniversallyQuantifiedVariable("a"))})});
+                                    new (program->arena) UniversallyQuantifiedVariable(Symbol("a")),
+                                    new (program->arena) TypeApplication(
+                                            new (program->arena) TypeConstructor(Symbol("[]")),
+                                            new (program->arena) UniversallyQuantifiedVariable(Symbol("a")))})});
     for (int i = 1; i < 15; i++) {
-        const std::string name = "(" + std::string(i, ',') + ")";
-        std::vector<std::string> argument_variables;
+        const Symbol name("(" + std::string(i, ',') + ")");
+        std::vector<Symbol> argument_variables;
         std::vector<Type*> types;
         for (int j = 0; j < i+1; j++) {
             argument_variables.push_back(std::to_string(j));
-            types.push_back(new UniversallyQuantifiedVariable(std::to_string(j)));
+            types.push_back(new (program->arena) UniversallyQuantifiedVariable(std::to_string(j)));
         }
         program->add_type_constructor(
                 0,
@@ -100,11 +100,5 @@ void add_prelude(Program *program) {
     //bind_built_in_op(program, ">", builtinop::gt);
     //bind_built_in_op(program, ">=", builtinop::gte);
 
-    yy::location loc;
-    YY_BUFFER_STATE buffer = yy_scan_string(prelude);
-    yy_switch_to_buffer(buffer);
-    reset_start_condition();
-    yy::parser parse(loc, program);
-    parse();
-    yy_delete_buffer(buffer);
+    parse_program(prelude, program);
 }
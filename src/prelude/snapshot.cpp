@@ -0,0 +1,483 @@
+#include <unordered_map>
+#include <vector>
+#include "prelude/snapshot.hpp"
+
+// A snapshot starts with a magic string and the table of every symbol it uses, which the rest refers to by index.
+// Numbers are written as variable-length integers, and signed ones are zigzag encoded first.
+static const std::string_view snapshot_magic = "PHSNAP1";
+
+void SnapshotWriter::write_number(std::string &output, size_t n) {
+    while (n >= 0x80) {
+        output += static_cast<char>((n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+    output += static_cast<char>(n);
+}
+
+void SnapshotWriter::write_integer(int i) {
+    write_number((static_cast<uint32_t>(i) << 1) ^ static_cast<uint32_t>(i >> 31));
+}
+
+void SnapshotWriter::write_symbol(const Symbol &symbol) {
+    auto [it, inserted] = symbol_indices.emplace(symbol, symbols.size());
+    if (inserted) {
+        symbols.push_back(symbol);
+    }
+    write_number(it->second);
+}
+
+void SnapshotWriter::write_symbols(const std::vector<Symbol> &symbols) {
+    write_number(symbols.size());
+    for (const Symbol &symbol: symbols) {
+        write_symbol(symbol);
+    }
+}
+
+void SnapshotWriter::write_type(std::shared_ptr<Type> type) {
+    while (type->get_form() == typeform::variable && static_cast<TypeVariable*>(type.get())->bound_to != nullptr) {
+        type = static_cast<TypeVariable*>(type.get())->bound_to;
+    }
+    data += static_cast<char>(type->get_form());
+    switch(type->get_form()) {
+        case typeform::variable:
+            throw SnapshotError("Cannot write a type that has not been fully inferred.");
+        case typeform::universallyquantifiedvariable:
+            write_symbol(static_cast<UniversallyQuantifiedVariable*>(type.get())->id);
+            break;
+        case typeform::constructor:
+            write_symbol(static_cast<TypeConstructor*>(type.get())->id);
+            break;
+        case typeform::application:
+            write_type(static_cast<TypeApplication*>(type.get())->left);
+            write_type(static_cast<TypeApplication*>(type.get())->right);
+            break;
+    }
+}
+
+void SnapshotWriter::write_kind(const std::shared_ptr<Kind> &kind) {
+    data += static_cast<char>(kind->get_form());
+    switch(kind->get_form()) {
+        case kindform::variable:
+            throw SnapshotError("Cannot write a kind that has not been fully inferred.");
+        case kindform::star:
+            break;
+        case kindform::arrow:
+            write_kind(static_cast<ArrowKind*>(kind.get())->left);
+            write_kind(static_cast<ArrowKind*>(kind.get())->right);
+            break;
+    }
+}
+
+void SnapshotWriter::write_pattern(const std::unique_ptr<Pattern> &pattern) {
+    data += static_cast<char>(pattern->get_form());
+    write_integer(pattern->line);
+    write_symbols(pattern->as);
+    switch(pattern->get_form()) {
+        case patternform::constructor: {
+            auto constructor = static_cast<ConstructorPattern*>(pattern.get());
+            write_symbol(constructor->name);
+            write_number(constructor->args.size());
+            for (const auto &arg: constructor->args) {
+                write_pattern(arg);
+            }
+            break;
+        }
+        case patternform::wild:
+            break;
+        case patternform::literal: {
+            auto value = static_cast<LiteralPattern*>(pattern.get())->value;
+            data += static_cast<char>(value.index());
+            write_integer(std::holds_alternative<int>(value) ? std::get<int>(value) : std::get<char>(value));
+            break;
+        }
+        case patternform::variable:
+            write_symbol(static_cast<VariablePattern*>(pattern.get())->name);
+            break;
+    }
+}
+
+void SnapshotWriter::write_expression(const std::unique_ptr<Expression> &expression) {
+    data += static_cast<char>(expression->get_form());
+    write_integer(expression->line);
+    switch(expression->get_form()) {
+        case expform::variable:
+            write_symbol(static_cast<Variable*>(expression.get())->name);
+            break;
+        case expform::constructor:
+            write_symbol(static_cast<Constructor*>(expression.get())->name);
+            break;
+        case expform::literal: {
+            const auto &value = static_cast<Literal*>(expression.get())->value;
+            data += static_cast<char>(value.index());
+            if (std::holds_alternative<int>(value)) {
+                write_integer(std::get<int>(value));
+            } else if (std::holds_alternative<char>(value)) {
+                write_integer(std::get<char>(value));
+            } else {
+                write_number(std::get<std::string>(value).size());
+                data += std::get<std::string>(value);
+            }
+            break;
+        }
+        case expform::abstraction:
+            write_symbols(static_cast<Abstraction*>(expression.get())->args);
+            write_expression(static_cast<Abstraction*>(expression.get())->body);
+            break;
+        case expform::application: {
+            auto application = static_cast<Application*>(expression.get());
+            write_expression(application->function);
+            write_number(application->arguments.size());
+            for (const auto &argument: application->arguments) {
+                write_expression(argument);
+            }
+            break;
+        }
+        case expform::cAsE: {
+            auto cAsE = static_cast<Case*>(expression.get());
+            write_expression(cAsE->exp);
+            write_number(cAsE->alts.size());
+            for (const auto &[pattern, e]: cAsE->alts) {
+                write_pattern(pattern);
+                write_expression(e);
+            }
+            break;
+        }
+        case expform::let: {
+            auto let = static_cast<Let*>(expression.get());
+            write_number(let->bindings.size());
+            for (const auto &[name, e]: let->bindings) {
+                write_symbol(name);
+                write_expression(e);
+            }
+            write_number(let->type_signatures.size());
+            for (const auto &[name, type]: let->type_signatures) {
+                write_symbol(name);
+                write_type(type);
+            }
+            write_expression(let->e);
+            break;
+        }
+        case expform::builtinop: {
+            auto op = static_cast<BuiltInOp*>(expression.get());
+            data += static_cast<char>(op->op);
+            if (op->op != builtinop::negate) {
+                write_expression(op->left);
+            }
+            write_expression(op->right);
+            break;
+        }
+    }
+}
+
+void SnapshotWriter::write_bytes(std::string_view bytes) {
+    write_number(bytes.size());
+    data += bytes;
+}
+
+void SnapshotWriter::write_type_constructor(const Program &program, const Symbol &name) {
+    const auto &type_constructor = program.type_constructors.at(name);
+    write_integer(type_constructor->line);
+    write_symbol(name);
+    write_symbols(type_constructor->argument_variables);
+    write_number(type_constructor->data_constructors.size());
+    for (const Symbol &data_constructor_name: type_constructor->data_constructors) {
+        const auto &data_constructor = program.data_constructors.at(data_constructor_name);
+        write_integer(data_constructor->line);
+        write_symbol(data_constructor_name);
+        write_number(data_constructor->types.size());
+        for (const auto &type: data_constructor->types) {
+            write_type(type);
+        }
+    }
+}
+
+std::string SnapshotWriter::write(const Program &program) {
+    write_number(program.type_constructors.size());
+    for (const auto &[name, _]: program.type_constructors) {
+        write_type_constructor(program, name);
+    }
+
+    write_number(program.bindings.size());
+    for (const auto &[name, expression]: program.bindings) {
+        write_symbol(name);
+        write_expression(expression);
+    }
+
+    write_number(program.type_signatures.size());
+    for (const auto &[name, type]: program.type_signatures) {
+        write_symbol(name);
+        write_type(type);
+    }
+
+    // The kinds and types are written in name order, so that the same program always gives the same snapshot.
+    write_number(program.type_constructor_kinds.size());
+    for (const auto &[name, kind]: std::map<Symbol, std::shared_ptr<Kind>, SpellingOrder>(
+            program.type_constructor_kinds.begin(),
+            program.type_constructor_kinds.end())) {
+        write_symbol(name);
+        write_kind(kind);
+    }
+
+    write_number(program.types.size());
+    std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> types(program.types.begin(), program.types.end());
+    for (const auto &[name, type]: types) {
+        write_symbol(name);
+        write_type(type);
+    }
+
+    return finish(snapshot_magic);
+}
+
+std::string SnapshotWriter::finish(std::string_view magic) {
+    std::string snapshot(magic);
+    write_number(snapshot, symbols.size());
+    for (const Symbol &symbol: symbols) {
+        write_number(snapshot, symbol.str().size());
+        snapshot += symbol.str();
+    }
+    return snapshot + data;
+}
+
+std::string write_snapshot(const Program &program) {
+    return SnapshotWriter().write(program);
+}
+
+uint8_t SnapshotReader::read_byte() {
+    if (position >= snapshot.size()) {
+        throw SnapshotError("Snapshot ends unexpectedly.");
+    }
+    return static_cast<uint8_t>(snapshot[position++]);
+}
+
+size_t SnapshotReader::read_number() {
+    size_t n = 0;
+    for (unsigned int shift = 0; ; shift += 7) {
+        uint8_t byte = read_byte();
+        n |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return n;
+        }
+    }
+}
+
+int SnapshotReader::read_integer() {
+    size_t n = read_number();
+    return static_cast<int>(static_cast<uint32_t>(n >> 1) ^ (~static_cast<uint32_t>(n & 1) + 1));
+}
+
+std::string_view SnapshotReader::read_bytes(size_t length) {
+    if (length > snapshot.size() - position) {
+        throw SnapshotError("Snapshot ends unexpectedly.");
+    }
+    std::string_view bytes = snapshot.substr(position, length);
+    position += length;
+    return bytes;
+}
+
+Symbol SnapshotReader::read_symbol() {
+    size_t index = read_number();
+    if (index >= symbols.size()) {
+        throw SnapshotError("Snapshot refers to an unknown symbol.");
+    }
+    return symbols[index];
+}
+
+std::vector<Symbol> SnapshotReader::read_symbols() {
+    std::vector<Symbol> result(read_number());
+    for (auto &symbol: result) {
+        symbol = read_symbol();
+    }
+    return result;
+}
+
+Type *SnapshotReader::read_type() {
+    switch(static_cast<typeform>(read_byte())) {
+        case typeform::universallyquantifiedvariable:
+            return new (program->arena) UniversallyQuantifiedVariable(read_symbol());
+        case typeform::constructor:
+            return new (program->arena) TypeConstructor(read_symbol());
+        case typeform::application: {
+            Type *left = read_type();
+            Type *right = read_type();
+            return new (program->arena) TypeApplication(left, right);
+        }
+        default:
+            throw SnapshotError("Snapshot contains an invalid type.");
+    }
+}
+
+std::shared_ptr<Kind> SnapshotReader::read_kind() {
+    switch(static_cast<kindform>(read_byte())) {
+        case kindform::star:
+            return std::make_shared<StarKind>();
+        case kindform::arrow: {
+            std::shared_ptr<Kind> left = read_kind();
+            std::shared_ptr<Kind> right = read_kind();
+            return std::make_shared<ArrowKind>(left, right);
+        }
+        default:
+            throw SnapshotError("Snapshot contains an invalid kind.");
+    }
+}
+
+Pattern *SnapshotReader::read_pattern() {
+    auto form = static_cast<patternform>(read_byte());
+    int line = read_integer();
+    std::vector<Symbol> as = read_symbols();
+    Pattern *pattern;
+    switch(form) {
+        case patternform::constructor: {
+            Symbol name = read_symbol();
+            std::vector<Pattern*> args(read_number());
+            for (auto &arg: args) {
+                arg = read_pattern();
+            }
+            pattern = new (program->arena) ConstructorPattern(line, name, args);
+            break;
+        }
+        case patternform::wild:
+            pattern = new (program->arena) WildPattern(line);
+            break;
+        case patternform::literal: {
+            uint8_t index = read_byte();
+            int value = read_integer();
+            if (index == 0) {
+                pattern = new (program->arena) LiteralPattern(line, value);
+            } else {
+                pattern = new (program->arena) LiteralPattern(line, static_cast<char>(value));
+            }
+            break;
+        }
+        case patternform::variable:
+            pattern = new (program->arena) VariablePattern(line, read_symbol());
+            break;
+        default:
+            throw SnapshotError("Snapshot contains an invalid pattern.");
+    }
+    pattern->as = as;
+    return pattern;
+}
+
+Expression *SnapshotReader::read_expression() {
+    auto form = static_cast<expform>(read_byte());
+    int line = read_integer();
+    switch(form) {
+        case expform::variable:
+            return new (program->arena) Variable(line, read_symbol());
+        case expform::constructor:
+            return new (program->arena) Constructor(line, read_symbol());
+        case expform::literal: {
+            uint8_t index = read_byte();
+            if (index == 0) {
+                return new (program->arena) Literal(line, read_integer());
+            } else if (index == 1) {
+                return new (program->arena) Literal(line, static_cast<char>(read_integer()));
+            }
+            size_t length = read_number();
+            return new (program->arena) Literal(line, std::string(read_bytes(length)));
+        }
+        case expform::abstraction: {
+            std::vector<Symbol> args = read_symbols();
+            return new (program->arena) Abstraction(line, args, read_expression());
+        }
+        case expform::application: {
+            Expression *function = read_expression();
+            std::vector<Expression*> arguments(read_number());
+            for (auto &argument: arguments) {
+                argument = read_expression();
+            }
+            return new (program->arena) Application(line, function, arguments);
+        }
+        case expform::cAsE: {
+            Expression *exp = read_expression();
+            std::vector<std::pair<Pattern*, Expression*>> alts(read_number());
+            for (auto &[pattern, e]: alts) {
+                pattern = read_pattern();
+                e = read_expression();
+            }
+            return new (program->arena) Case(line, exp, alts);
+        }
+        case expform::let: {
+            std::map<Symbol, Expression*, SpellingOrder> bindings;
+            for (size_t i = read_number(); i > 0; i--) {
+                Symbol name = read_symbol();
+                bindings[name] = read_expression();
+            }
+            std::map<Symbol, Type*, SpellingOrder> type_signatures;
+            for (size_t i = read_number(); i > 0; i--) {
+                Symbol name = read_symbol();
+                type_signatures[name] = read_type();
+            }
+            return new (program->arena) Let(line, bindings, type_signatures, read_expression());
+        }
+        case expform::builtinop: {
+            auto op = static_cast<builtinop>(read_byte());
+            Expression *left = op != builtinop::negate ? read_expression() : nullptr;
+            return new (program->arena) BuiltInOp(line, left, read_expression(), op);
+        }
+        default:
+            throw SnapshotError("Snapshot contains an invalid expression.");
+    }
+}
+
+void SnapshotReader::start(std::string_view magic) {
+    if (read_bytes(magic.size()) != magic) {
+        throw SnapshotError("Not a snapshot, or a snapshot from another version.");
+    }
+    symbols.resize(read_number());
+    for (auto &symbol: symbols) {
+        size_t length = read_number();
+        symbol = Symbol(read_bytes(length));
+    }
+}
+
+Symbol SnapshotReader::read_type_constructor() {
+    int line = read_integer();
+    Symbol name = read_symbol();
+    std::vector<Symbol> argument_variables = read_symbols();
+    std::vector<DConstructor*> data_constructors(read_number());
+    for (auto &data_constructor: data_constructors) {
+        int data_constructor_line = read_integer();
+        Symbol data_constructor_name = read_symbol();
+        std::vector<Type*> types(read_number());
+        for (auto &type: types) {
+            type = read_type();
+        }
+        data_constructor = new DConstructor(data_constructor_line, data_constructor_name, types);
+    }
+    program->add_type_constructor(line, name, argument_variables, data_constructors);
+    return name;
+}
+
+void SnapshotReader::read() {
+    start(snapshot_magic);
+
+    for (size_t i = read_number(); i > 0; i--) {
+        read_type_constructor();
+    }
+
+    for (size_t i = read_number(); i > 0; i--) {
+        Symbol name = read_symbol();
+        Expression *expression = read_expression();
+        program->add_variable(expression->line, name, expression);
+    }
+
+    for (size_t i = read_number(); i > 0; i--) {
+        Symbol name = read_symbol();
+        program->add_type_signature(0, name, read_type());
+    }
+
+    for (size_t i = read_number(); i > 0; i--) {
+        Symbol name = read_symbol();
+        program->type_constructor_kinds[name] = read_kind();
+    }
+
+    for (size_t i = read_number(); i > 0; i--) {
+        Symbol name = read_symbol();
+        program->types[name] = std::shared_ptr<Type>(read_type());
+    }
+}
+
+void read_snapshot(std::string_view snapshot, Program *program) {
+    SnapshotReader(snapshot, program).read();
+}
@@ -0,0 +1,42 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include "prelude/prelude.hpp"
+#include "prelude/snapshot.hpp"
+#include "types/type_check.hpp"
+
+// Parses and type checks the prelude, and writes its snapshot as a C++ source file defining prelude_snapshot.
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: prelude_snapshot_generator <output file>" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    std::string snapshot;
+    try {
+        add_prelude_source(program.get());
+        type_check(program, false);
+        snapshot = write_snapshot(*program);
+    } catch (const std::runtime_error &e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Could not make the prelude snapshot." << std::endl;
+        return 1;
+    }
+
+    std::ofstream output(argv[1]);
+    if (!output) {
+        std::cerr << "Could not open output file." << std::endl;
+        return 1;
+    }
+    output << "#include \"prelude/prelude.hpp\"" << std::endl << std::endl;
+    output << "const unsigned char prelude_snapshot[] = {";
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        output << (i % 16 == 0 ? "\n        " : " ") << static_cast<unsigned int>(static_cast<unsigned char>(snapshot[i]))
+               << ",";
+    }
+    output << "\n};" << std::endl;
+    output << "const size_t prelude_snapshot_size = " << snapshot.size() << ";" << std::endl;
+    return output ? 0 : 1;
+}
@@ -0,0 +1,93 @@
+#ifndef PICOHASKELL_STATISTICS_HPP
+#define PICOHASKELL_STATISTICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "symbols/symbol.hpp"
+
+// The work type inference has done on the current thread, counted as it goes so that it can be attributed to the
+// binding being inferred.
+struct InferenceCounters {
+    size_t unifications = 0;
+    size_t type_variables = 0;
+};
+
+inline thread_local InferenceCounters inference_counters;
+
+struct PhaseStatistics {
+    std::string name;
+    double milliseconds;
+    // The largest resident set size of the compiler so far, when the phase ended.
+    long peak_rss_kilobytes;
+};
+
+struct BindingStatistics {
+    double inference_milliseconds = 0;
+    size_t unifications = 0;
+    size_t type_variables = 0;
+    size_t closures = 0;
+    size_t assembly_bytes = 0;
+};
+
+// How long each phase of compiling a program took and what each top-level binding cost, collected for --time-report
+// and --stats=json. Modules and binding groups are compiled on several threads at once, so everything is recorded
+// under a lock.
+class CompileStatistics {
+public:
+    void add_phase(const std::string &name, double milliseconds);
+    void add_inference(const Symbol &binding, double milliseconds, const InferenceCounters &counters);
+    // The closures and code of a top-level binding include those of the definitions lifted out of it to the top
+    // level when it was translated to STG.
+    void add_lifted_definitions(const Symbol &binding, const std::vector<Symbol> &lifted);
+    void add_closures(const Symbol &top_level_name, size_t closures);
+    void add_assembly(const Symbol &top_level_name, size_t bytes);
+
+    void write_report(std::ostream &output) const;
+    void write_json(std::ostream &output) const;
+
+    std::vector<PhaseStatistics> phases;
+    std::map<Symbol, BindingStatistics, SpellingOrder> bindings;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<Symbol, Symbol> lifted_from;
+
+    BindingStatistics &binding_of(const Symbol &top_level_name);
+};
+
+// Records the time from its construction to its destruction as a phase, if there are statistics to record it in.
+class PhaseTimer {
+public:
+    PhaseTimer(CompileStatistics *statistics, std::string name);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    CompileStatistics *statistics;
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Attributes the time and the inference work done on the current thread while it exists to a binding.
+class InferenceTimer {
+public:
+    InferenceTimer(CompileStatistics *statistics, Symbol binding);
+    ~InferenceTimer();
+    InferenceTimer(const InferenceTimer &) = delete;
+    InferenceTimer &operator=(const InferenceTimer &) = delete;
+
+private:
+    CompileStatistics *statistics;
+    Symbol binding;
+    InferenceCounters counters;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif //PICOHASKELL_STATISTICS_HPP
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sys/resource.h>
+#include "statistics/statistics.hpp"
+
+static long peak_rss_kilobytes() {
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static std::string json_string(const std::string &str) {
+    std::string escaped = "\"";
+    for (char c: str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "\\u%04x", c);
+            escaped += hex;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped + "\"";
+}
+
+void CompileStatistics::add_phase(const std::string &name, double milliseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    phases.push_back({name, milliseconds, peak_rss_kilobytes()});
+}
+
+void CompileStatistics::add_inference(const Symbol &binding, double milliseconds, const InferenceCounters &counters) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BindingStatistics &statistics = bindings[binding];
+    statistics.inference_milliseconds += milliseconds;
+    statistics.unifications += counters.unifications;
+    statistics.type_variables += counters.type_variables;
+}
+
+void CompileStatistics::add_lifted_definitions(const Symbol &binding, const std::vector<Symbol> &lifted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const Symbol &name: lifted) {
+        lifted_from[name] = binding;
+    }
+}
+
+BindingStatistics &CompileStatistics::binding_of(const Symbol &top_level_name) {
+    auto found = lifted_from.find(top_level_name);
+    return bindings[found != lifted_from.end() ? found->second : top_level_name];
+}
+
+void CompileStatistics::add_closures(const Symbol &top_level_name, size_t closures) {
+    std::lock_guard<std::mutex> lock(mutex);
+    binding_of(top_level_name).closures += closures;
+}
+
+void CompileStatistics::add_assembly(const Symbol &top_level_name, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    binding_of(top_level_name).assembly_bytes += bytes;
+}
+
+void CompileStatistics::write_report(std::ostream &output) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ios_base::fmtflags flags = output.flags();
+    std::streamsize precision = output.precision();
+    output << std::fixed << std::setprecision(3);
+    output << std::left << std::setw(32) << "Phase" << std::right << std::setw(14) << "Time (ms)"
+           << std::setw(18) << "Peak RSS (KiB)" << std::endl;
+    for (const auto &phase: phases) {
+        output << std::left << std::setw(32) << phase.name << std::right << std::setw(14) << phase.milliseconds
+               << std::setw(18) << phase.peak_rss_kilobytes << std::endl;
+    }
+
+    // The most expensive bindings to infer come first.
+    std::vector<std::pair<Symbol, BindingStatistics>> sorted(bindings.begin(), bindings.end());
+    std::stable_sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.second.inference_milliseconds > b.second.inference_milliseconds;
+    });
+    output << std::endl << std::left << std::setw(32) << "Binding" << std::right << std::setw(16) << "Inference (ms)"
+           << std::setw(14) << "Unifications" << std::setw(16) << "Type variables" << std::setw(10) << "Closures"
+           << std::setw(16) << "Assembly bytes" << std::endl;
+    for (const auto &[name, binding]: sorted) {
+        output << std::left << std::setw(32) << name.str() << std::right << std::setw(16)
+               << binding.inference_milliseconds << std::setw(14) << binding.unifications << std::setw(16)
+               << binding.type_variables << std::setw(10) << binding.closures << std::setw(16)
+               << binding.assembly_bytes << std::endl;
+    }
+    output.flags(flags);
+    output.precision(precision);
+}
+
+void CompileStatistics::write_json(std::ostream &output) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    output << "{\"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        output << (i > 0 ? ", " : "") << "{\"name\": " << json_string(phases[i].name)
+               << ", \"milliseconds\": " << phases[i].milliseconds
+               << ", \"peak_rss_kilobytes\": " << phases[i].peak_rss_kilobytes << "}";
+    }
+    output << "], \"bindings\": {";
+    bool first = true;
+    for (const auto &[name, binding]: bindings) {
+        output << (first ? "" : ", ") << json_string(name.str()) << ": {"
+               << "\"inference_milliseconds\": " << binding.inference_milliseconds
+               << ", \"unifications\": " << binding.unifications
+               << ", \"type_variables\": " << binding.type_variables
+               << ", \"closures\": " << binding.closures
+               << ", \"assembly_bytes\": " << binding.assembly_bytes << "}";
+        first = false;
+    }
+    output << "}}" << std::endl;
+}
+
+PhaseTimer::PhaseTimer(CompileStatistics *statistics, std::string name):
+        statistics(statistics),
+        name(std::move(name)),
+        start(std::chrono::steady_clock::now()) {}
+
+PhaseTimer::~PhaseTimer() {
+    if (statistics != nullptr) {
+        statistics->add_phase(
+                name,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+InferenceTimer::InferenceTimer(CompileStatistics *statistics, Symbol binding):
+        statistics(statistics),
+        binding(binding),
+        counters(inference_counters),
+        start(std::chrono::steady_clock::now()) {}
+
+InferenceTimer::~InferenceTimer() {
+    if (statistics != nullptr) {
+        statistics->add_inference(
+                binding,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                {
+                        inference_counters.unifications - counters.unifications,
+                        inference_counters.type_variables - counters.type_variables});
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef PICOHASKELL_SIMPLIFY_HPP
+#define PICOHASKELL_SIMPLIFY_HPP
+
+#include <cstddef>
+#include <memory>
+#include "stg/stg.hpp"
+
+// Rewrites the bindings of a translated program into cheaper equivalents, repeating until nothing changes:
+// - saturated calls of functions that are not recursive are inlined, binding their arguments to the parameters, when the
+//   function is at most inlining_threshold expressions and lambda forms in size or is a local function used only once;
+// - partial applications of such functions bound by a let become functions that take the missing arguments;
+// - a case of a variable known to be bound to a constructor or a literal, by a let, by an enclosing case or as a
+//   top-level binding, is replaced by the alternative it selects;
+// - let bindings that are not used are dropped, and those that only rename another variable are substituted;
+// - a thunk that is only used as the value scrutinised by the case the let ends in is evaluated there instead, without
+//   being allocated.
+// The free variables of the lambda forms are recomputed afterwards. Fresh names are prefixed with the module name, as
+// those made by translation are.
+void simplify(const std::unique_ptr<STGProgram> &program, const Symbol &module_name, size_t inlining_threshold = 20);
+
+#endif //PICOHASKELL_SIMPLIFY_HPP
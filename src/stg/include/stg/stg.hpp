@@ -5,11 +5,13 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
+#include <unordered_set>
 #include <memory>
 #include <variant>
 #include "parser/syntax.hpp"
 
-enum class stgform {let, literal, variable, application, constructor, literalcase, algebraiccase, primitiveop};
+enum class stgform {let, letnoescape, literal, variable, application, constructor, literalcase, algebraiccase, primitiveop};
 
 struct STGDataConstructor {
     const size_t tag;
@@ -22,18 +24,34 @@ struct STGDataConstructor {
 };
 
 struct STGExpression {
-    virtual stgform get_form() = 0;
+    const stgform form;
+    explicit STGExpression(const stgform &form): form(form) {}
     virtual ~STGExpression() = default;
+    stgform get_form() const { return form; }
 };
 
 struct STGLambdaForm {
-    std::set<std::string> free_variables;
-    const std::vector<std::string> argument_variables;
+    std::set<Symbol, SpellingOrder> free_variables;
+    const std::vector<Symbol> argument_variables;
     bool updatable;
     std::unique_ptr<STGExpression> expr;
+    // The type of the value the lambda form stands for, whose parameter types are those of its argument variables.
+    // Top-level bindings have their type schemes. It is null where type checking did not record a type.
+    std::shared_ptr<Type> type;
+    // For a function, whether each of its arguments is certain to be evaluated whenever it is called with all of them.
+    // It is empty until strictness analysis has been run.
+    std::vector<bool> strict_arguments;
+    // For a worker made by splitting a function, whether each argument is an evaluated Int or Char passed unboxed, in a
+    // register or on the B stack, and whether the result is returned unboxed in R5, instead of as closures. Unlike all
+    // other variables, the argument variables of a worker for the arguments it takes unboxed stand for unboxed values.
+    // They are only used as the scrutinee of a literal case, as the operands of a primitive operation and as arguments
+    // that a worker takes unboxed. A call passes such an argument either one of them or a variable bound to an
+    // evaluated Int or Char, whose value is passed.
+    std::vector<bool> unboxed_arguments;
+    bool unboxed_result = false;
     STGLambdaForm(
-            const std::set<std::string> &free_variables,
-            const std::vector<std::string> &argument_variables,
+            const std::set<Symbol, SpellingOrder> &free_variables,
+            const std::vector<Symbol> &argument_variables,
             const bool &updatable,
             std::unique_ptr<STGExpression> &&expr):
             free_variables(free_variables),
@@ -43,117 +61,194 @@ struct STGLambdaForm {
 };
 
 struct STGLet : public STGExpression {
-    const std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
-    const std::unique_ptr<STGExpression> expr;
+    const std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+    std::unique_ptr<STGExpression> expr;
     const bool recursive;
     STGLet(
-            std::map<std::string, std::unique_ptr<STGLambdaForm>> &&bindings,
+            std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> &&bindings,
             std::unique_ptr<STGExpression> &&expr,
             const bool &recursive):
+            STGExpression(stgform::let),
             bindings(std::move(bindings)),
             expr(std::move(expr)),
             recursive(recursive) {}
-    stgform get_form() override { return stgform::let; }
+    // Definitions captured under a binder are nested one let inside another, so the chain is taken apart here
+    // instead of being destroyed recursively.
+    ~STGLet() override {
+        std::unique_ptr<STGExpression> next = std::move(expr);
+        while (next != nullptr && next->get_form() == stgform::let) {
+            next = std::move(static_cast<STGLet*>(next.get())->expr);
+        }
+    }
+};
+
+// The lets of the chain of lets that starts at expr, outermost first, and the expression the innermost one binds its
+// names in. Such chains can be far too long to recurse through, so passes over STG take them apart with this and
+// rebuild them one let at a time.
+std::pair<std::vector<const STGLet*>, const STGExpression*> let_chain(const STGExpression *expr);
+
+// Binds a join point: an expression that several alternatives of the cases within expr fall through to, which they
+// enter with an STGVariable naming the join point instead of each holding a copy of it. A join point that takes
+// arguments is entered with an STGApplication of it to the variables they are bound to. Those jumps only occur in tail
+// position and never in a lambda form, so the join point does not escape and needs no closure; it can be compiled as
+// code that the alternatives jump to, in the frame of the expression that binds it.
+struct STGLetNoEscape : public STGExpression {
+    const Symbol name;
+    const std::vector<Symbol> arguments;
+    std::unique_ptr<STGExpression> rhs;
+    std::unique_ptr<STGExpression> expr;
+    STGLetNoEscape(
+            Symbol name,
+            std::unique_ptr<STGExpression> &&rhs,
+            std::unique_ptr<STGExpression> &&expr):
+            STGExpression(stgform::letnoescape),
+            name(name),
+            rhs(std::move(rhs)),
+            expr(std::move(expr)) {}
+    STGLetNoEscape(
+            Symbol name,
+            const std::vector<Symbol> &arguments,
+            std::unique_ptr<STGExpression> &&rhs,
+            std::unique_ptr<STGExpression> &&expr):
+            STGExpression(stgform::letnoescape),
+            name(name),
+            arguments(arguments),
+            rhs(std::move(rhs)),
+            expr(std::move(expr)) {}
 };
 
+// A string literal evaluates to the list of its characters, which is unpacked lazily at run time.
 struct STGLiteral : public STGExpression {
-    const std::variant<int, char> value;
-    explicit STGLiteral(const std::variant<int, char> &value): value(value) {}
-    stgform get_form() override { return stgform::literal; }
+    const std::variant<int, char, std::string> value;
+    explicit STGLiteral(const std::variant<int, char, std::string> &value):
+            STGExpression(stgform::literal),
+            value(value) {}
+    explicit STGLiteral(const std::variant<int, char> &value):
+            STGExpression(stgform::literal),
+            value(std::visit([](auto v) { return std::variant<int, char, std::string>(v); }, value)) {}
 };
 
 struct STGApplication : public STGExpression {
-    const std::string lhs;
-    const std::vector<std::string> arguments;
+    const Symbol lhs;
+    const std::vector<Symbol> arguments;
     STGApplication(
-            std::string lhs,
-            const std::vector<std::string> &arguments): lhs(std::move(lhs)), arguments(arguments) {}
-    stgform get_form() override { return stgform::application; }
+            Symbol lhs,
+            const std::vector<Symbol> &arguments): STGExpression(stgform::application), lhs(lhs), arguments(arguments) {}
 };
 
 struct STGConstructor : public STGExpression {
-    const std::string constructor_name;
-    const std::vector<std::string> arguments;
-    explicit STGConstructor(std::string constructor_name): constructor_name(std::move(constructor_name)) {}
+    const Symbol constructor_name;
+    const std::vector<Symbol> arguments;
+    explicit STGConstructor(Symbol constructor_name): STGExpression(stgform::constructor), constructor_name(constructor_name) {}
     STGConstructor(
-            std::string constructor_name,
-            const std::vector<std::string> &arguments):
-            constructor_name(std::move(constructor_name)),
+            Symbol constructor_name,
+            const std::vector<Symbol> &arguments):
+            STGExpression(stgform::constructor),
+            constructor_name(constructor_name),
             arguments(arguments) {}
-    stgform get_form() override { return stgform::constructor; }
 };
 
 struct STGVariable : public STGExpression {
-    const std::string name;
-    explicit STGVariable(std::string name): name(std::move(name)) {}
-    stgform get_form() override { return stgform::variable; }
+    const Symbol name;
+    explicit STGVariable(Symbol name): STGExpression(stgform::variable), name(name) {}
 };
 
+// The scrutinee returns an Int or Char unboxed, in R5. default_var is bound to it boxed, as every variable a case
+// binds is.
 struct STGLiteralCase : public STGExpression {
     const std::unique_ptr<STGExpression> expr;
     const std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
-    const std::string default_var;
+    const Symbol default_var;
     const std::unique_ptr<STGExpression> default_expr;
     STGLiteralCase(
             std::unique_ptr<STGExpression> &&expr,
             std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> &&alts,
-            std::string default_var,
+            Symbol default_var,
             std::unique_ptr<STGExpression> &&default_expr):
+            STGExpression(stgform::literalcase),
             expr(std::move(expr)),
             alts(std::move(alts)),
-            default_var(std::move(default_var)),
+            default_var(default_var),
             default_expr(std::move(default_expr)) {}
-    stgform get_form() override { return stgform::literalcase; }
 };
 
 struct STGPattern {
-    const std::string constructor_name;
-    const std::vector<std::string> variables;
+    const Symbol constructor_name;
+    const std::vector<Symbol> variables;
+    // The types of the fields bound to the variables, each null where it is not known.
+    const std::vector<std::shared_ptr<Type>> variable_types;
     STGPattern(
-            std::string constructor_name,
-            const std::vector<std::string> &variables):
-            constructor_name(std::move(constructor_name)),
-            variables(variables) {}
+            Symbol constructor_name,
+            const std::vector<Symbol> &variables,
+            const std::vector<std::shared_ptr<Type>> &variable_types = {}):
+            constructor_name(constructor_name),
+            variables(variables),
+            variable_types(variable_types.empty() ? std::vector<std::shared_ptr<Type>>(variables.size()) : variable_types) {}
 };
 
 struct STGAlgebraicCase : public STGExpression {
     const std::unique_ptr<STGExpression> expr;
     const std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
-    const std::string default_var;
+    const Symbol default_var;
     const std::unique_ptr<STGExpression> default_expr;
     STGAlgebraicCase(
             std::unique_ptr<STGExpression> &&expr,
             std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> &&alts,
-            std::string default_var,
+            Symbol default_var,
             std::unique_ptr<STGExpression> &&default_expr):
+            STGExpression(stgform::algebraiccase),
             expr(std::move(expr)),
             alts(std::move(alts)),
-            default_var(std::move(default_var)),
+            default_var(default_var),
             default_expr(std::move(default_expr)) {}
-    stgform get_form() override { return stgform::algebraiccase; }
 };
 
 struct STGPrimitiveOp : public STGExpression {
-    const std::string left;
-    const std::string right;
+    const Symbol left;
+    const Symbol right;
     const builtinop op;
     STGPrimitiveOp(
-            std::string left,
-            std::string right,
-            const builtinop &op): left(std::move(left)), right(std::move(right)), op(op) {}
-    stgform get_form() override { return stgform::primitiveop; }
+            Symbol left,
+            Symbol right,
+            const builtinop &op): STGExpression(stgform::primitiveop), left(left), right(right), op(op) {}
 };
 
 struct STGProgram {
-    const std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
-    const std::map<std::string, STGDataConstructor> data_constructors;
+    std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+    const std::map<Symbol, STGDataConstructor, SpellingOrder> data_constructors;
+    // Whether the program has string literals, which are unpacked into both list constructors.
+    const bool string_literals;
     explicit STGProgram(
-            std::map<std::string, std::unique_ptr<STGLambdaForm>> &&bindings,
-            const std::map<std::string, STGDataConstructor> &data_constructors):
+            std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> &&bindings,
+            const std::map<Symbol, STGDataConstructor, SpellingOrder> &data_constructors,
+            bool string_literals):
             bindings(std::move(bindings)),
-            data_constructors(data_constructors) {}
+            data_constructors(data_constructors),
+            string_literals(string_literals) {}
 };
 
-std::unique_ptr<STGProgram> translate(const std::unique_ptr<Program> &program);
+class CompileStatistics;
+
+// How nested patterns are compiled to cases: which of the variables still to be matched is tested next. A column is
+// needed by an alternative whose pattern for it is a constructor or a literal, so that the alternative cannot be chosen
+// without testing it. needed tests the variable needed by the most alternatives, among those needed by the first one
+// still to be matched that matching the alternatives in order is sure to evaluate; leftmost tests the first variable
+// needed by that alternative.
+enum class ColumnHeuristic {leftmost, needed};
+
+// The number of closures each top-level binding is translated to is recorded in the statistics, if they are given.
+std::unique_ptr<STGProgram> translate(
+        const std::unique_ptr<Program> &program,
+        CompileStatistics *statistics = nullptr,
+        ColumnHeuristic column_heuristic = ColumnHeuristic::needed);
+// Translates the bindings reachable from roots, for a program compiled as separate modules. References to the bindings
+// in external are not followed but collected in used_external, as their code is generated along with another module.
+std::unique_ptr<STGProgram> translate(
+        const std::unique_ptr<Program> &program,
+        const std::vector<Symbol> &roots,
+        const std::unordered_set<Symbol> &external,
+        std::set<Symbol, SpellingOrder> &used_external,
+        CompileStatistics *statistics = nullptr,
+        ColumnHeuristic column_heuristic = ColumnHeuristic::needed);
 
 #endif //PICOHASKELL_STG_HPP
@@ -0,0 +1,14 @@
+#ifndef PICOHASKELL_STRICTNESS_HPP
+#define PICOHASKELL_STRICTNESS_HPP
+
+#include <memory>
+#include "stg/stg.hpp"
+
+// Finds the arguments each function of the program is certain to evaluate, by working out backwards which variables
+// evaluating each expression is certain to evaluate, and records them in the strict_arguments of its lambda form. A
+// thunk bound by a let whose body is then certain to evaluate it, such as one built for a strict argument or for the
+// operand of a primitive operation, is evaluated by a case where it is bound instead of being allocated and updated
+// later. Only thunks of data types, Int and Char, whose values a case can take, are evaluated early.
+void evaluate_strict_thunks(const std::unique_ptr<STGProgram> &program);
+
+#endif //PICOHASKELL_STRICTNESS_HPP
@@ -0,0 +1,16 @@
+#ifndef PICOHASKELL_WORKER_WRAPPER_HPP
+#define PICOHASKELL_WORKER_WRAPPER_HPP
+
+#include <memory>
+#include "stg/stg.hpp"
+
+// Splits each top-level function that is strict in an Int or Char argument, or returns an Int or Char, into a worker
+// that takes those arguments and returns its result unboxed, and a wrapper, under the function's name, that evaluates
+// the arguments with cases and calls the worker. The worker of f is bound to f.worker. It takes its unboxed arguments
+// by new names, and binds their old names to boxed copies only if its body still needs them boxed. Saturated calls of
+// f are made to call the worker directly, evaluating only the arguments not already known to be evaluated, so that a
+// loop passing an Int to itself does not allocate a closure for it on each iteration. It must be run after
+// evaluate_strict_thunks.
+void split_workers(const std::unique_ptr<STGProgram> &program, const Symbol &module_name);
+
+#endif //PICOHASKELL_WORKER_WRAPPER_HPP
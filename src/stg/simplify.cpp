@@ -0,0 +1,698 @@
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#include <vector>
+#include "stg/simplify.hpp"
+#include "symbols/scoped_map.hpp"
+#include "types/type_check.hpp"
+
+// Passes over the program are repeated until one changes nothing, or this many have been made.
+static const size_t maximum_passes = 8;
+
+// Calls visit on expr and every expression within it, with an explicit stack as chains of lets can be very long.
+template <typename F>
+static void for_each_expression(const STGExpression *expr, F visit) {
+    std::vector<const STGExpression*> to_visit = {expr};
+    while (!to_visit.empty()) {
+        const STGExpression *next = to_visit.back();
+        to_visit.pop_back();
+        visit(next);
+        switch (next->get_form()) {
+            case stgform::let:
+                for (const auto &[_, lambda_form]: static_cast<const STGLet*>(next)->bindings) {
+                    to_visit.push_back(lambda_form->expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLet*>(next)->expr.get());
+                break;
+            case stgform::letnoescape:
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(next)->rhs.get());
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(next)->expr.get());
+                break;
+            case stgform::literalcase:
+                to_visit.push_back(static_cast<const STGLiteralCase*>(next)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(next)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLiteralCase*>(next)->default_expr.get());
+                break;
+            case stgform::algebraiccase:
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(next)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(next)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(next)->default_expr.get());
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// The variables an expression refers to directly, rather than through the expressions within it.
+static std::vector<Symbol> variables_used(const STGExpression *expr) {
+    switch (expr->get_form()) {
+        case stgform::variable:
+            return {static_cast<const STGVariable*>(expr)->name};
+        case stgform::application: {
+            auto application = static_cast<const STGApplication*>(expr);
+            std::vector<Symbol> variables = {application->lhs};
+            variables.insert(variables.end(), application->arguments.begin(), application->arguments.end());
+            return variables;
+        }
+        case stgform::constructor:
+            return static_cast<const STGConstructor*>(expr)->arguments;
+        case stgform::primitiveop:
+            return {static_cast<const STGPrimitiveOp*>(expr)->left, static_cast<const STGPrimitiveOp*>(expr)->right};
+        default:
+            return {};
+    }
+}
+
+// The size of a lambda form counted in expressions and lambda forms.
+static size_t size_of(const STGLambdaForm *lambda_form) {
+    size_t size = 1;
+    for_each_expression(lambda_form->expr.get(), [&](const STGExpression *expr) {
+        size += expr->get_form() == stgform::let ? 1 + static_cast<const STGLet*>(expr)->bindings.size() : 1;
+    });
+    return size;
+}
+
+static bool is_value(const STGExpression *expr) {
+    return expr->get_form() == stgform::constructor || (
+            expr->get_form() == stgform::literal &&
+            !std::holds_alternative<std::string>(static_cast<const STGLiteral*>(expr)->value));
+}
+
+// Recomputes the free variables of a top-level lambda form and those within it, leaving out globals and join points.
+static void compute_free_variables(STGLambdaForm *top_level) {
+    enum class Step {enter, leave, expression, bind, unbind};
+    struct Visit {
+        Step step;
+        STGLambdaForm *lambda_form;
+        const STGExpression *expression;
+        std::vector<Symbol> names;
+    };
+    auto visit_expression = [](const STGExpression *expr) {
+        return Visit{Step::expression, nullptr, expr, {}};
+    };
+    auto scoped = [&](std::vector<Visit> &to_visit, const std::vector<Symbol> &names, const STGExpression *expr) {
+        to_visit.push_back({Step::unbind, nullptr, nullptr, names});
+        to_visit.push_back(visit_expression(expr));
+        to_visit.push_back({Step::bind, nullptr, nullptr, names});
+    };
+
+    std::vector<STGLambdaForm*> enclosing;
+    // The number of lambda forms enclosing each binding of a local variable that is in scope.
+    std::unordered_map<Symbol, std::vector<size_t>> depths;
+    std::vector<Visit> to_visit = {{Step::enter, top_level, nullptr, {}}};
+    while (!to_visit.empty()) {
+        Visit visit = std::move(to_visit.back());
+        to_visit.pop_back();
+
+        switch (visit.step) {
+            case Step::enter:
+                enclosing.push_back(visit.lambda_form);
+                visit.lambda_form->free_variables.clear();
+                to_visit.push_back({Step::leave, visit.lambda_form, nullptr, {}});
+                scoped(to_visit, visit.lambda_form->argument_variables, visit.lambda_form->expr.get());
+                continue;
+            case Step::leave:
+                enclosing.pop_back();
+                if (visit.lambda_form->argument_variables.empty() &&
+                        visit.lambda_form->expr->get_form() == stgform::constructor) {
+                    const auto &arguments = static_cast<const STGConstructor*>(visit.lambda_form->expr.get())->arguments;
+                    visit.lambda_form->free_variables =
+                            std::set<Symbol, SpellingOrder>(arguments.begin(), arguments.end());
+                }
+                continue;
+            case Step::bind:
+                for (const auto &name: visit.names) {
+                    depths[name].push_back(enclosing.size());
+                }
+                continue;
+            case Step::unbind:
+                for (const auto &name: visit.names) {
+                    depths[name].pop_back();
+                }
+                continue;
+            case Step::expression:
+                break;
+        }
+
+        const STGExpression *expr = visit.expression;
+        for (const auto &variable: variables_used(expr)) {
+            auto found = depths.find(variable);
+            if (found == depths.end() || found->second.empty()) {
+                continue;
+            }
+            // A variable already free in a lambda form is free in those enclosing it, up to where it is bound.
+            for (size_t i = enclosing.size(); i > found->second.back(); i--) {
+                if (!enclosing[i - 1]->free_variables.insert(variable).second) {
+                    break;
+                }
+            }
+        }
+        if (expr->get_form() == stgform::let) {
+            auto let = static_cast<const STGLet*>(expr);
+            std::vector<Symbol> names;
+            for (const auto &[name, _]: let->bindings) {
+                names.push_back(name);
+            }
+            to_visit.push_back({Step::unbind, nullptr, nullptr, names});
+            to_visit.push_back(visit_expression(let->expr.get()));
+            for (const auto &[_, lambda_form]: let->bindings) {
+                to_visit.push_back({Step::enter, lambda_form.get(), nullptr, {}});
+            }
+            to_visit.push_back({Step::bind, nullptr, nullptr, names});
+        } else if (expr->get_form() == stgform::letnoescape) {
+            auto join_point = static_cast<const STGLetNoEscape*>(expr);
+            scoped(to_visit, join_point->arguments, join_point->rhs.get());
+            to_visit.push_back(visit_expression(join_point->expr.get()));
+        } else if (expr->get_form() == stgform::literalcase) {
+            auto cAsE = static_cast<const STGLiteralCase*>(expr);
+            to_visit.push_back(visit_expression(cAsE->expr.get()));
+            for (const auto &[_, alt_expr]: cAsE->alts) {
+                to_visit.push_back(visit_expression(alt_expr.get()));
+            }
+            scoped(to_visit, cAsE->default_var.empty() ? std::vector<Symbol>() : std::vector<Symbol>{cAsE->default_var},
+                   cAsE->default_expr.get());
+        } else if (expr->get_form() == stgform::algebraiccase) {
+            auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+            to_visit.push_back(visit_expression(cAsE->expr.get()));
+            for (const auto &[pattern, alt_expr]: cAsE->alts) {
+                scoped(to_visit, pattern.variables, alt_expr.get());
+            }
+            scoped(to_visit, cAsE->default_var.empty() ? std::vector<Symbol>() : std::vector<Symbol>{cAsE->default_var},
+                   cAsE->default_expr.get());
+        }
+    }
+}
+
+// A value a variable is known to be bound to: a constructor applied to variables, or an Int or Char literal.
+struct KnownValue {
+    Symbol constructor_name;
+    std::vector<Symbol> arguments;
+    std::optional<std::variant<int, char>> literal;
+};
+
+// What is known about a local variable: the function it is bound to, if that can be inlined, and its value.
+struct LocalBinding {
+    const STGLambdaForm *function = nullptr;
+    std::optional<KnownValue> value;
+};
+
+// Rebuilds the bindings of a program, inlining functions and selecting the alternatives of cases of known values.
+class Simplifier {
+public:
+    Simplifier(const STGProgram &program, const Symbol &module_name, size_t inlining_threshold):
+            program(program),
+            prefix(module_name == Symbol("Main") ? "" : module_name.str()),
+            inlining_threshold(inlining_threshold) {}
+
+    // Makes one pass over the bindings, callees first, returning whether it changed any of them.
+    bool pass() {
+        changed = false;
+        occurrences.clear();
+        inlinable_globals.clear();
+        std::vector<Symbol> names;
+        std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> dependencies;
+        for (const auto &[name, lambda_form]: program.bindings) {
+            names.push_back(name);
+            std::set<Symbol, SpellingOrder> &refers_to = dependencies[name];
+            for_each_expression(lambda_form->expr.get(), [&](const STGExpression *expr) {
+                for (const auto &variable: variables_used(expr)) {
+                    occurrences[variable]++;
+                    if (program.bindings.count(variable) > 0) {
+                        refers_to.insert(variable);
+                    }
+                }
+                if (expr->get_form() == stgform::let) {
+                    for (const auto &[bound, _]: static_cast<const STGLet*>(expr)->bindings) {
+                        occurrences.try_emplace(bound, 0);
+                    }
+                } else if (expr->get_form() == stgform::letnoescape) {
+                    occurrences.try_emplace(static_cast<const STGLetNoEscape*>(expr)->name, 0);
+                }
+            });
+        }
+        auto groups = dependency_analysis(names, dependencies);
+        for (const auto &group: groups) {
+            const STGLambdaForm *lambda_form = program.bindings.at(group[0]).get();
+            if (group.size() == 1 &&
+                    dependencies.at(group[0]).count(group[0]) == 0 &&
+                    !lambda_form->argument_variables.empty() &&
+                    size_of(lambda_form) <= inlining_threshold) {
+                inlinable_globals.insert(group[0]);
+            }
+        }
+
+        for (const auto &group: groups) {
+            for (const auto &name: group) {
+                STGLambdaForm *lambda_form = program.bindings.at(name).get();
+                ScopedMap<Symbol>::Scope scope(renamings);
+                ScopedMap<LocalBinding>::Scope locals_scope(locals);
+                for (const auto &argument: lambda_form->argument_variables) {
+                    bind(argument);
+                }
+                inlining.push_back(name);
+                lambda_form->expr = simplify(lambda_form->expr.get());
+                inlining.pop_back();
+                if (lambda_form->argument_variables.empty() && is_value(lambda_form->expr.get())) {
+                    lambda_form->updatable = false;
+                }
+                // What is inlined later in the pass is the simplified body, which may have grown.
+                if (inlinable_globals.count(name) > 0 && size_of(lambda_form) > inlining_threshold) {
+                    inlinable_globals.erase(name);
+                }
+            }
+        }
+        return changed;
+    }
+
+private:
+    const STGProgram &program;
+    const std::string prefix;
+    unsigned long next = 0;
+    const size_t inlining_threshold;
+    bool changed = false;
+    // How often each local variable was referred to when the pass started.
+    std::unordered_map<Symbol, size_t> occurrences;
+    std::unordered_set<Symbol> inlinable_globals;
+    ScopedMap<Symbol> renamings;
+    ScopedMap<LocalBinding> locals;
+    // The top-level binding being simplified and the functions being inlined into it, which are not inlined again.
+    std::vector<Symbol> inlining;
+    bool freshen = false;
+
+    size_t occurrences_of(const Symbol &name) const {
+        auto found = occurrences.find(name);
+        return found != occurrences.end() && !freshen ? found->second : SIZE_MAX;
+    }
+
+    Symbol rename(const Symbol &name) const {
+        return renamings.count(name) ? renamings.at(name) : name;
+    }
+
+    std::vector<Symbol> rename(const std::vector<Symbol> &names) const {
+        std::vector<Symbol> renamed;
+        for (const auto &name: names) {
+            renamed.push_back(rename(name));
+        }
+        return renamed;
+    }
+
+    Symbol fresh_name() {
+        return Symbol(prefix + ".s" + std::to_string(next++));
+    }
+
+    // Brings a binder into scope, returning the name it is bound to in the rebuilt expression.
+    Symbol bind(const Symbol &name) {
+        Symbol bound = name;
+        if (freshen) {
+            bound = fresh_name();
+            renamings.bind(name, bound);
+        } else if (renamings.count(name)) {
+            renamings.bind(name, name);
+        }
+        locals.bind(bound, LocalBinding());
+        return bound;
+    }
+
+    std::optional<KnownValue> known_value(const Symbol &name) const {
+        if (locals.count(name)) {
+            return locals.at(name).value;
+        }
+        auto global = program.bindings.find(name);
+        if (global != program.bindings.end() && global->second->argument_variables.empty()) {
+            return value_of(global->second->expr.get());
+        }
+        return std::nullopt;
+    }
+
+    std::optional<KnownValue> value_of(const STGExpression *expr) const {
+        if (expr->get_form() == stgform::constructor) {
+            auto constructor = static_cast<const STGConstructor*>(expr);
+            return KnownValue{constructor->constructor_name, rename(constructor->arguments), std::nullopt};
+        }
+        if (is_value(expr)) {
+            auto literal = static_cast<const STGLiteral*>(expr);
+            if (std::holds_alternative<int>(literal->value)) {
+                return KnownValue{Symbol(), {}, std::get<int>(literal->value)};
+            }
+            return KnownValue{Symbol(), {}, std::get<char>(literal->value)};
+        }
+        return std::nullopt;
+    }
+
+    const STGLambdaForm *inlinable_function(const Symbol &name) const {
+        if (std::find(inlining.begin(), inlining.end(), name) != inlining.end()) {
+            return nullptr;
+        }
+        if (locals.count(name)) {
+            return locals.at(name).function;
+        }
+        return inlinable_globals.count(name) ? program.bindings.at(name).get() : nullptr;
+    }
+
+    // The body of the function with its parameters bound to the arguments, if it can be inlined.
+    std::unique_ptr<STGExpression> inline_call(const Symbol &name, const std::vector<Symbol> &arguments) {
+        const STGLambdaForm *function = inlinable_function(name);
+        if (function == nullptr || function->argument_variables.size() != arguments.size()) {
+            return nullptr;
+        }
+        changed = true;
+        ScopedMap<Symbol>::Scope scope(renamings);
+        for (size_t i = 0; i < arguments.size(); i++) {
+            renamings.bind(function->argument_variables[i], arguments[i]);
+        }
+        bool was_freshening = freshen;
+        freshen = true;
+        inlining.push_back(name);
+        auto inlined = simplify(function->expr.get());
+        inlining.pop_back();
+        freshen = was_freshening;
+        return inlined;
+    }
+
+    std::unique_ptr<STGLambdaForm> simplify(const STGLambdaForm *lambda_form) {
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        std::vector<Symbol> arguments;
+        for (const auto &argument: lambda_form->argument_variables) {
+            arguments.push_back(bind(argument));
+        }
+        bool updatable = lambda_form->updatable;
+        std::unique_ptr<STGExpression> expr;
+        // A partial application of a function that can be inlined becomes a function of the missing arguments.
+        if (arguments.empty() && !updatable && lambda_form->expr->get_form() == stgform::application) {
+            auto application = static_cast<const STGApplication*>(lambda_form->expr.get());
+            Symbol lhs = rename(application->lhs);
+            const STGLambdaForm *function = inlinable_function(lhs);
+            if (function != nullptr && function->argument_variables.size() > application->arguments.size()) {
+                std::vector<Symbol> call_arguments = rename(application->arguments);
+                for (size_t i = application->arguments.size(); i < function->argument_variables.size(); i++) {
+                    Symbol argument = fresh_name();
+                    locals.bind(argument, LocalBinding());
+                    arguments.push_back(argument);
+                    call_arguments.push_back(argument);
+                }
+                expr = inline_call(lhs, call_arguments);
+            }
+        }
+        if (expr == nullptr) {
+            expr = simplify(lambda_form->expr.get());
+        }
+        if (arguments.empty() && is_value(expr.get())) {
+            updatable = false;
+        }
+        auto simplified = std::make_unique<STGLambdaForm>(
+                std::set<Symbol, SpellingOrder>(),
+                arguments,
+                updatable,
+                std::move(expr));
+        simplified->type = lambda_form->type;
+        return simplified;
+    }
+
+    std::unique_ptr<STGExpression> simplify(const STGExpression *expr) {
+        switch (expr->get_form()) {
+            case stgform::let:
+                return simplify_let(static_cast<const STGLet*>(expr));
+            case stgform::letnoescape:
+                return simplify_join_point(static_cast<const STGLetNoEscape*>(expr));
+            case stgform::literal:
+                return std::make_unique<STGLiteral>(static_cast<const STGLiteral*>(expr)->value);
+            case stgform::variable:
+                return std::make_unique<STGVariable>(rename(static_cast<const STGVariable*>(expr)->name));
+            case stgform::application: {
+                auto application = static_cast<const STGApplication*>(expr);
+                Symbol lhs = rename(application->lhs);
+                std::vector<Symbol> arguments = rename(application->arguments);
+                auto inlined = inline_call(lhs, arguments);
+                // A call of a top-level partial application is a call of the function it applies.
+                auto global = program.bindings.find(lhs);
+                if (inlined == nullptr &&
+                        locals.count(lhs) == 0 &&
+                        global != program.bindings.end() &&
+                        global->second->argument_variables.empty() &&
+                        !global->second->updatable &&
+                        global->second->expr->get_form() == stgform::application) {
+                    auto partial_application = static_cast<const STGApplication*>(global->second->expr.get());
+                    std::vector<Symbol> all_arguments = partial_application->arguments;
+                    all_arguments.insert(all_arguments.end(), arguments.begin(), arguments.end());
+                    inlined = inline_call(partial_application->lhs, all_arguments);
+                }
+                if (inlined != nullptr) {
+                    return inlined;
+                }
+                return std::make_unique<STGApplication>(lhs, arguments);
+            }
+            case stgform::constructor: {
+                auto constructor = static_cast<const STGConstructor*>(expr);
+                return std::make_unique<STGConstructor>(constructor->constructor_name, rename(constructor->arguments));
+            }
+            case stgform::literalcase: {
+                auto cAsE = static_cast<const STGLiteralCase*>(expr);
+                return simplify_literal_case(cAsE, cAsE->expr.get());
+            }
+            case stgform::algebraiccase: {
+                auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+                return simplify_algebraic_case(cAsE, cAsE->expr.get());
+            }
+            case stgform::primitiveop: {
+                auto op = static_cast<const STGPrimitiveOp*>(expr);
+                return std::make_unique<STGPrimitiveOp>(rename(op->left), rename(op->right), op->op);
+            }
+        }
+        return nullptr;
+    }
+
+    // Simplifies the bindings of each let in a chain and then its body, rebuilding the lets that keep any bindings.
+    std::unique_ptr<STGExpression> simplify_let(const STGLet *first) {
+        auto [chain, body] = let_chain(first);
+        // The variable the chain ends by evaluating, whose thunk is evaluated in place if used nowhere else.
+        Symbol evaluated;
+        if (body->get_form() == stgform::variable) {
+            evaluated = static_cast<const STGVariable*>(body)->name;
+        } else if (body->get_form() == stgform::algebraiccase || body->get_form() == stgform::literalcase) {
+            const STGExpression *scrutinee = body->get_form() == stgform::algebraiccase
+                    ? static_cast<const STGAlgebraicCase*>(body)->expr.get()
+                    : static_cast<const STGLiteralCase*>(body)->expr.get();
+            if (scrutinee->get_form() == stgform::variable) {
+                evaluated = static_cast<const STGVariable*>(scrutinee)->name;
+            }
+        }
+
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        const STGLambdaForm *evaluated_in_place = nullptr;
+        std::vector<std::pair<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>, bool>> lets;
+        for (const STGLet *let: chain) {
+            std::vector<std::pair<Symbol, const STGLambdaForm*>> kept;
+            for (const auto &[name, lambda_form]: let->bindings) {
+                const STGExpression *rhs = lambda_form->expr.get();
+                if (occurrences_of(name) == 0) {
+                    changed = true;
+                } else if (
+                        !let->recursive &&
+                        name == evaluated &&
+                        occurrences_of(name) == 1 &&
+                        lambda_form->argument_variables.empty() &&
+                        (!is_value(rhs) || body->get_form() == stgform::variable)) {
+                    evaluated_in_place = lambda_form.get();
+                    changed = true;
+                } else if (
+                        !let->recursive &&
+                        lambda_form->argument_variables.empty() &&
+                        rhs->get_form() == stgform::variable) {
+                    renamings.bind(name, rename(static_cast<const STGVariable*>(rhs)->name));
+                    changed = true;
+                } else {
+                    kept.emplace_back(name, lambda_form.get());
+                }
+            }
+
+            std::vector<Symbol> bound;
+            for (const auto &[name, _]: kept) {
+                bound.push_back(bind(name));
+            }
+            if (!let->recursive) {
+                for (size_t i = 0; i < kept.size(); i++) {
+                    const STGLambdaForm *lambda_form = kept[i].second;
+                    LocalBinding binding;
+                    if (lambda_form->argument_variables.empty()) {
+                        binding.value = value_of(lambda_form->expr.get());
+                    } else if (
+                            occurrences_of(kept[i].first) == 1 ||
+                            size_of(lambda_form) <= inlining_threshold) {
+                        binding.function = lambda_form;
+                    }
+                    locals.bind(bound[i], binding);
+                }
+            }
+            std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+            for (size_t i = 0; i < kept.size(); i++) {
+                bindings[bound[i]] = simplify(kept[i].second);
+            }
+            lets.emplace_back(std::move(bindings), let->recursive);
+        }
+
+        std::unique_ptr<STGExpression> result;
+        if (evaluated_in_place == nullptr) {
+            result = simplify(body);
+        } else if (body->get_form() == stgform::variable) {
+            result = simplify(evaluated_in_place->expr.get());
+        } else if (body->get_form() == stgform::algebraiccase) {
+            result = simplify_algebraic_case(static_cast<const STGAlgebraicCase*>(body), evaluated_in_place->expr.get());
+        } else {
+            result = simplify_literal_case(static_cast<const STGLiteralCase*>(body), evaluated_in_place->expr.get());
+        }
+        while (!lets.empty()) {
+            if (!lets.back().first.empty()) {
+                result = std::make_unique<STGLet>(std::move(lets.back().first), std::move(result), lets.back().second);
+            }
+            lets.pop_back();
+        }
+        return result;
+    }
+
+    std::unique_ptr<STGExpression> simplify_join_point(const STGLetNoEscape *join_point) {
+        if (occurrences_of(join_point->name) == 0) {
+            changed = true;
+            return simplify(join_point->expr.get());
+        }
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        Symbol name = bind(join_point->name);
+        std::vector<Symbol> arguments;
+        std::unique_ptr<STGExpression> rhs;
+        {
+            ScopedMap<Symbol>::Scope rhs_scope(renamings);
+            ScopedMap<LocalBinding>::Scope rhs_locals_scope(locals);
+            for (const auto &argument: join_point->arguments) {
+                arguments.push_back(bind(argument));
+            }
+            rhs = simplify(join_point->rhs.get());
+        }
+        auto expr = simplify(join_point->expr.get());
+        return std::make_unique<STGLetNoEscape>(name, arguments, std::move(rhs), std::move(expr));
+    }
+
+    // The value scrutinised by a case, if it is known, and the variable it is bound to, if it is one.
+    std::pair<std::optional<KnownValue>, Symbol> scrutinised_value(const STGExpression *scrutinee) const {
+        if (scrutinee->get_form() == stgform::variable) {
+            Symbol variable = rename(static_cast<const STGVariable*>(scrutinee)->name);
+            return {known_value(variable), variable};
+        }
+        return {value_of(scrutinee), Symbol()};
+    }
+
+    // The default alternative of a case of a known value, in which the default variable stands for that value.
+    std::unique_ptr<STGExpression> select_default(
+            const Symbol &default_var,
+            const STGExpression *default_expr,
+            const STGExpression *scrutinee,
+            const Symbol &variable) {
+        if (default_var.empty()) {
+            return simplify(default_expr);
+        }
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        if (!variable.empty()) {
+            renamings.bind(default_var, variable);
+            return simplify(default_expr);
+        }
+        auto value = simplify(scrutinee);
+        Symbol name = bind(default_var);
+        locals.bind(name, LocalBinding{nullptr, value_of(scrutinee)});
+        std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+        bindings[name] = std::make_unique<STGLambdaForm>(
+                std::set<Symbol, SpellingOrder>(),
+                std::vector<Symbol>(),
+                false,
+                std::move(value));
+        return std::make_unique<STGLet>(std::move(bindings), simplify(default_expr), false);
+    }
+
+    std::unique_ptr<STGExpression> simplify_algebraic_case(const STGAlgebraicCase *cAsE, const STGExpression *scrutinee) {
+        auto [value, variable] = scrutinised_value(scrutinee);
+        if (value && !value->literal) {
+            changed = true;
+            for (const auto &[pattern, alt_expr]: cAsE->alts) {
+                if (pattern.constructor_name == value->constructor_name) {
+                    ScopedMap<Symbol>::Scope scope(renamings);
+                    for (size_t i = 0; i < pattern.variables.size(); i++) {
+                        renamings.bind(pattern.variables[i], value->arguments[i]);
+                    }
+                    return simplify(alt_expr.get());
+                }
+            }
+            return select_default(cAsE->default_var, cAsE->default_expr.get(), scrutinee, variable);
+        }
+
+        auto expr = simplify(scrutinee);
+        std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
+        for (const auto &[pattern, alt_expr]: cAsE->alts) {
+            ScopedMap<Symbol>::Scope scope(renamings);
+            ScopedMap<LocalBinding>::Scope locals_scope(locals);
+            std::vector<Symbol> variables;
+            for (const auto &pattern_variable: pattern.variables) {
+                variables.push_back(bind(pattern_variable));
+            }
+            if (!variable.empty()) {
+                locals.bind(variable, LocalBinding{nullptr, KnownValue{pattern.constructor_name, variables, std::nullopt}});
+            }
+            auto simplified = simplify(alt_expr.get());
+            alts.emplace_back(STGPattern(pattern.constructor_name, variables, pattern.variable_types), std::move(simplified));
+        }
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        Symbol default_var = cAsE->default_var.empty() ? Symbol() : bind(cAsE->default_var);
+        auto default_expr = simplify(cAsE->default_expr.get());
+        return std::make_unique<STGAlgebraicCase>(std::move(expr), std::move(alts), default_var, std::move(default_expr));
+    }
+
+    std::unique_ptr<STGExpression> simplify_literal_case(const STGLiteralCase *cAsE, const STGExpression *scrutinee) {
+        auto [value, variable] = scrutinised_value(scrutinee);
+        if (value && value->literal) {
+            changed = true;
+            auto literal = std::visit([](auto v) { return std::variant<int, char, std::string>(v); }, *value->literal);
+            for (const auto &[alt_literal, alt_expr]: cAsE->alts) {
+                if (alt_literal.value == literal) {
+                    return simplify(alt_expr.get());
+                }
+            }
+            return select_default(cAsE->default_var, cAsE->default_expr.get(), scrutinee, variable);
+        }
+
+        auto expr = simplify(scrutinee);
+        std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
+        for (const auto &[alt_literal, alt_expr]: cAsE->alts) {
+            ScopedMap<LocalBinding>::Scope locals_scope(locals);
+            if (!variable.empty() && !std::holds_alternative<std::string>(alt_literal.value)) {
+                locals.bind(variable, LocalBinding{nullptr, value_of(&alt_literal)});
+            }
+            alts.emplace_back(alt_literal, simplify(alt_expr.get()));
+        }
+        ScopedMap<Symbol>::Scope scope(renamings);
+        ScopedMap<LocalBinding>::Scope locals_scope(locals);
+        Symbol default_var = cAsE->default_var.empty() ? Symbol() : bind(cAsE->default_var);
+        auto default_expr = simplify(cAsE->default_expr.get());
+        return std::make_unique<STGLiteralCase>(std::move(expr), std::move(alts), default_var, std::move(default_expr));
+    }
+};
+
+void simplify(const std::unique_ptr<STGProgram> &program, const Symbol &module_name, size_t inlining_threshold) {
+    Simplifier simplifier(*program, module_name, inlining_threshold);
+    for (size_t i = 0; i < maximum_passes && simplifier.pass(); i++) {}
+    for (const auto &[_, lambda_form]: program->bindings) {
+        compute_free_variables(lambda_form.get());
+    }
+}
@@ -3,131 +3,156 @@
 #include <memory>
 #include <algorithm>
 #include <list>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include "stg/stg.hpp"
 #include "parser/syntax.hpp"
 #include "types/type_check.hpp"
+#include "symbols/scoped_map.hpp"
+#include "statistics/statistics.hpp"
+
+// Fresh names start with a dot, so that they cannot clash with names in the source. When modules are compiled
+// separately, the names made for each module are also prefixed with its name.
+struct NameSupply {
+    const std::string prefix;
+    unsigned long next = 0;
+};
+
+// What translation needs to know about the data constructors of the program, and how it compiles matches on them.
+struct DataConstructors {
+    const std::unordered_map<Symbol, size_t> &arities;
+    // The number of data constructors of the type each one belongs to.
+    std::unordered_map<Symbol, size_t> type_sizes;
+    ColumnHeuristic column_heuristic;
+};
+
+Symbol fresh_name(NameSupply *name_supply) {
+    return Symbol(name_supply->prefix + "." + std::to_string(name_supply->next++));
+}
 
 void add_definition(
-        const std::string &name,
+        const Symbol &name,
         std::unique_ptr<STGLambdaForm> &&lambda_form,
-        std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> &definitions) {
-    std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions) {
+    std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
     bindings[name] = std::move(lambda_form);
     definitions.push_back(std::move(bindings));
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_expression(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_expression(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, std::string> &variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities);
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors);
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_variable(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_variable(
         const std::unique_ptr<Expression> &expr,
-        const std::map<std::string, std::string> &variable_renamings) {
-    auto var = dynamic_cast<Variable*>(expr.get());
+        const ScopedMap<Symbol> &variable_renamings) {
+    auto var = static_cast<Variable*>(expr.get());
     std::unique_ptr<STGVariable> translated_var;
     if (variable_renamings.count(var->name) > 0) {
         translated_var = std::make_unique<STGVariable>(variable_renamings.at(var->name));
     } else {
         translated_var = std::make_unique<STGVariable>(var->name);
     }
-    std::set<std::string> free_variables;
+    std::set<Symbol, SpellingOrder> free_variables;
     free_variables.insert(translated_var->name);
     auto lambda_form = std::make_unique<STGLambdaForm>(
             free_variables,
-            std::vector<std::string>(),
+            std::vector<Symbol>(),
             true,
             std::move(translated_var));
     return std::make_pair(
             std::move(lambda_form),
-            std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>());
+            std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>());
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_literal(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_literal(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name) {
-    std::variant<int, char> value = dynamic_cast<Literal*>(expr.get())->value;
+        NameSupply *name_supply) {
+    std::variant<int, char, std::string> value = static_cast<Literal*>(expr.get())->value;
     return std::make_pair(
             std::make_unique<STGLambdaForm>(
-                    std::set<std::string>(),
-                    std::vector<std::string>(),
+                    std::set<Symbol, SpellingOrder>(),
+                    std::vector<Symbol>(),
                     false,
                     std::make_unique<STGLiteral>(value)),
-            std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>());
+            std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>());
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_constructor(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_constructor(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, size_t> &data_constructor_arities) {
-    auto constructor = dynamic_cast<Constructor*>(expr.get());
+        NameSupply *name_supply,
+        const DataConstructors &data_constructors) {
+    auto constructor = static_cast<Constructor*>(expr.get());
 
-    std::vector<std::string> argument_variables;
-    for (int i = 0; i < data_constructor_arities.at(constructor->name); i++) {
-        argument_variables.push_back("." + std::to_string((*next_variable_name)++));
+    std::vector<Symbol> argument_variables;
+    for (size_t i = 0; i < data_constructors.arities.at(constructor->name); i++) {
+        argument_variables.push_back(fresh_name(name_supply));
     }
     return std::make_pair(
             std::make_unique<STGLambdaForm>(
-                    std::set<std::string>(),
+                    std::set<Symbol, SpellingOrder>(),
                     argument_variables,
                     false,
                     std::make_unique<STGConstructor>(
                             constructor->name,
                             argument_variables)),
-            std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>());
+            std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>());
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_built_in_op(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_built_in_op(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, std::string> &variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
-    std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> definitions;
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> definitions;
 
-    auto op = dynamic_cast<BuiltInOp*>(expr.get());
+    auto op = static_cast<BuiltInOp*>(expr.get());
 
-    std::string left;
+    Symbol left;
     if (op->left) {
         auto translated = translate_expression(
                 op->left,
-                next_variable_name,
+                name_supply,
                 variable_renamings,
-                data_constructor_arities);
+                data_constructors);
 
         for (auto &definition: translated.second) {
             definitions.push_back(std::move(definition));
         }
 
         if (translated.first->expr->get_form() == stgform::variable) {
-            left = dynamic_cast<STGVariable*>(translated.first->expr.get())->name;
+            left = static_cast<STGVariable*>(translated.first->expr.get())->name;
         } else {
-            std::string name = "." + std::to_string((*next_variable_name)++);
+            Symbol name = fresh_name(name_supply);
             add_definition(name, std::move(translated.first), definitions);
             left = name;
         }
     }
 
-    std::string right;
+    Symbol right;
     auto translated = translate_expression(
             op->right,
-            next_variable_name,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
 
     for (auto &definition: translated.second) {
         definitions.push_back(std::move(definition));
     }
 
     if (translated.first->expr->get_form() == stgform::variable) {
-        right = dynamic_cast<STGVariable *>(translated.first->expr.get())->name;
+        right = static_cast<STGVariable *>(translated.first->expr.get())->name;
     } else {
-        std::string name = "." + std::to_string((*next_variable_name)++);
+        Symbol name = fresh_name(name_supply);
         add_definition(name, std::move(translated.first), definitions);
         right = name;
     }
 
-    std::set<std::string> free_variables;
+    std::set<Symbol, SpellingOrder> free_variables;
     if (!left.empty()) {
         free_variables.insert(left);
     }
@@ -135,23 +160,24 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
     return std::make_pair(
             std::make_unique<STGLambdaForm>(
                     free_variables,
-                    std::vector<std::string>(),
+                    std::vector<Symbol>(),
                     true,
                     std::make_unique<STGPrimitiveOp>(left, right, op->op)),
             std::move(definitions));
 }
 
-std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> capture_definitions_that_depend_on_names(
-        std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> &&definitions,
+std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> capture_definitions_that_depend_on_names(
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &&definitions,
         std::unique_ptr<STGExpression> &expr,
-        std::set<std::string> &free_variables_in_expr,
-        const std::vector<std::string> &names) {
-    std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> independent_definitions;
-    std::vector<std::pair<std::map<std::string, std::unique_ptr<STGLambdaForm>>, bool>> definitions_that_depend_on_names;
-    std::set<std::string> names_that_depend_on_names(names.begin(), names.end());
+        std::set<Symbol, SpellingOrder> &free_variables_in_expr,
+        const std::vector<Symbol> &names) {
+    std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> independent_definitions;
+    std::vector<std::pair<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>, bool>>
+            definitions_that_depend_on_names;
+    std::set<Symbol, SpellingOrder> names_that_depend_on_names(names.begin(), names.end());
     for (auto &definition: definitions) {
-        std::set<std::string> defined_names;
-        std::set<std::string> free_variables_in_definition;
+        std::set<Symbol, SpellingOrder> defined_names;
+        std::set<Symbol, SpellingOrder> free_variables_in_definition;
         bool depends_on_names = false;
         for (auto &[name, lambda_form]: definition) {
             defined_names.insert(name);
@@ -196,22 +222,22 @@ std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> capture_defin
 
 std::unique_ptr<STGExpression> translate_alt_expression(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, std::string> &variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::vector<std::string> &names_bound_in_pattern,
-        std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> &definitions,
-        std::set<std::string> &free_variables) {
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors,
+        const std::vector<Symbol> &names_bound_in_pattern,
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions,
+        std::set<Symbol, SpellingOrder> &free_variables) {
     auto alt_expr_translated = translate_expression(
             expr,
-            next_variable_name,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
     auto alt_definitions = std::move(alt_expr_translated.second);
-    std::set<std::string> free_variables_in_alt;
+    std::set<Symbol, SpellingOrder> free_variables_in_alt;
     std::unique_ptr<STGExpression> alt_expr;
     if (!alt_expr_translated.first->argument_variables.empty()) {
-        std::string name = "." + std::to_string((*next_variable_name)++);
+        Symbol name = fresh_name(name_supply);
         add_definition(name, std::move(alt_expr_translated.first),  alt_definitions);
         free_variables_in_alt.insert(name);
         alt_expr = std::make_unique<STGVariable>(name);
@@ -239,290 +265,593 @@ std::unique_ptr<STGExpression> translate_alt_expression(
     return alt_expr;
 }
 
-std::unique_ptr<STGExpression> copy(const std::unique_ptr<STGExpression> &expr);
-
-std::unique_ptr<STGLambdaForm> copy(const std::unique_ptr<STGLambdaForm> &lambda_form) {
-    return std::make_unique<STGLambdaForm>(
-            lambda_form->free_variables,
-            lambda_form->argument_variables,
-            lambda_form->updatable,
-            copy(lambda_form->expr));
+// Whether an expression jumps to a join point, which it can only do in tail position.
+bool jumps_to(const STGExpression *expr, const Symbol &join_point) {
+    std::vector<const STGExpression*> to_visit = {expr};
+    while (!to_visit.empty()) {
+        const STGExpression *e = to_visit.back();
+        to_visit.pop_back();
+        switch(e->get_form()) {
+            case stgform::variable:
+                if (static_cast<const STGVariable*>(e)->name == join_point) {
+                    return true;
+                }
+                break;
+            case stgform::application:
+                if (static_cast<const STGApplication*>(e)->lhs == join_point) {
+                    return true;
+                }
+                break;
+            case stgform::let:
+                to_visit.push_back(static_cast<const STGLet*>(e)->expr.get());
+                break;
+            case stgform::letnoescape:
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(e)->rhs.get());
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(e)->expr.get());
+                break;
+            case stgform::literalcase:
+                for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(e)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLiteralCase*>(e)->default_expr.get());
+                break;
+            case stgform::algebraiccase:
+                for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(e)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(e)->default_expr.get());
+                break;
+            default:
+                break;
+        }
+    }
+    return false;
 }
 
-std::unique_ptr<STGExpression> copy(const std::unique_ptr<STGExpression> &expr) {
-    switch(expr->get_form()) {
-        case stgform::variable:
-            return std::make_unique<STGVariable>(dynamic_cast<STGVariable*>(expr.get())->name);
-        case stgform::constructor:
-            return std::make_unique<STGConstructor>(
-                    dynamic_cast<STGConstructor*>(expr.get())->constructor_name,
-                    dynamic_cast<STGConstructor*>(expr.get())->arguments);
-        case stgform::literal:
-            return std::make_unique<STGLiteral>(dynamic_cast<STGLiteral*>(expr.get())->value);
-        case stgform::literalcase: {
-            auto cAsE = dynamic_cast<STGLiteralCase*>(expr.get());
-            auto default_expr = copy(cAsE->default_expr);
-            auto default_var = cAsE->default_var;
-            auto expression = copy(cAsE->expr);
-            std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
-            for (const auto &[lit, e]: cAsE->alts) {
-                alts.emplace_back(lit, copy(e));
-            }
-            return std::make_unique<STGLiteralCase>(
-                    std::move(expression),
-                    std::move(alts),
-                    default_var,
-                    std::move(default_expr));
+// What the alternatives of a case fall through to, bound to a join point unless it is a variable.
+class FallThrough {
+public:
+    FallThrough(std::unique_ptr<STGExpression> &&expr, NameSupply *name_supply):
+            expr(std::move(expr)),
+            name_supply(name_supply) {}
+
+    // The variable that is entered to fall through.
+    Symbol target() {
+        if (expr->get_form() == stgform::variable) {
+            return static_cast<const STGVariable*>(expr.get())->name;
         }
-        case stgform::algebraiccase: {
-            auto cAsE = dynamic_cast<STGAlgebraicCase*>(expr.get());
-            auto default_expr = copy(cAsE->default_expr);
-            auto default_var = cAsE->default_var;
-            auto expression = copy(cAsE->expr);
-            std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
-            for (const auto &[pat, e]: cAsE->alts) {
-                alts.emplace_back(pat, copy(e));
-            }
-            return std::make_unique<STGAlgebraicCase>(
-                    std::move(expression),
-                    std::move(alts),
-                    default_var,
-                    std::move(default_expr));
+        if (join_point.empty()) {
+            join_point = fresh_name(name_supply);
         }
-        case stgform::application:
-            return std::make_unique<STGApplication>(
-                    dynamic_cast<STGApplication*>(expr.get())->lhs,
-                    dynamic_cast<STGApplication*>(expr.get())->arguments);
-        case stgform::let: {
-            auto let = dynamic_cast<STGLet*>(expr.get());
-            std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
-            for (const auto &[name, lambda_form]: let->bindings) {
-                bindings[name] = copy(lambda_form);
+        return join_point;
+    }
+
+    // The join point is only bound if an alternative jumps to it.
+    template <typename Alt>
+    std::unique_ptr<STGExpression> default_expr(const std::vector<Alt> &alts) {
+        for (const auto &[_, alt_expr]: alts) {
+            if (!join_point.empty() && jumps_to(alt_expr.get(), join_point)) {
+                return std::make_unique<STGVariable>(join_point);
             }
-            return std::make_unique<STGLet>(
-                    std::move(bindings),
-                    copy(let->expr),
-                    let->recursive);
         }
-        case stgform::primitiveop:
-            return std::make_unique<STGPrimitiveOp>(
-                    dynamic_cast<STGPrimitiveOp*>(expr.get())->left,
-                    dynamic_cast<STGPrimitiveOp*>(expr.get())->right,
-                    dynamic_cast<STGPrimitiveOp*>(expr.get())->op);
+        join_point = Symbol();
+        return std::move(expr);
+    }
+
+    std::unique_ptr<STGExpression> bind(std::unique_ptr<STGExpression> &&cAsE) {
+        if (join_point.empty()) {
+            return std::move(cAsE);
+        }
+        return std::make_unique<STGLetNoEscape>(join_point, std::move(expr), std::move(cAsE));
+    }
+
+private:
+    std::unique_ptr<STGExpression> expr;
+    NameSupply *name_supply;
+    Symbol join_point;
+};
+
+// A row of a pattern matrix: patterns still to match, names bound so far and the alternative's expression.
+using Row = std::tuple<
+        std::vector<Pattern*>,
+        std::vector<std::pair<Symbol, Symbol>>,
+        const std::unique_ptr<Expression>*>;
+
+// The types of the fields of a constructor, recorded on the sub-patterns of an alternative that matches it.
+std::vector<std::shared_ptr<Type>> field_types(const std::vector<Pattern*> &patterns) {
+    std::vector<std::shared_ptr<Type>> types;
+    for (const auto &pattern: patterns) {
+        types.push_back(pattern->type);
     }
+    return types;
 }
 
-std::unique_ptr<STGExpression> translate_case(
-        const std::vector<std::string> &variables,
-        const std::list<std::tuple<std::list<Pattern*>, std::map<std::string, std::string>, const std::unique_ptr<Expression>*>> &alternatives,
-        const std::vector<std::string> &names_bound_in_pattern,
-        std::unique_ptr<STGExpression> &&default_expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> &definitions,
-        std::set<std::string> &free_variables) {
-    if (variables.empty()) {
-        const auto &[_, variable_renamings, expr] = *alternatives.begin();
-        return translate_alt_expression(
-                *expr,
-                next_variable_name,
-                variable_renamings,
-                data_constructor_arities,
-                names_bound_in_pattern,
-                definitions,
-                free_variables);
+// Whether a variable has to be tested to match a pattern against it.
+bool is_test(const Pattern *pattern) {
+    return pattern != nullptr &&
+           (pattern->get_form() == patternform::constructor || pattern->get_form() == patternform::literal);
+}
+
+void bind_names_in_pattern(
+        const Pattern *pattern,
+        const Symbol &variable,
+        std::vector<std::pair<Symbol, Symbol>> &renamings) {
+    if (pattern == nullptr) {
+        return;
+    }
+    for (const auto &as: pattern->as) {
+        renamings.emplace_back(as, variable);
     }
+    if (pattern->get_form() == patternform::variable) {
+        renamings.emplace_back(static_cast<const VariablePattern*>(pattern)->name, variable);
+    }
+}
 
-    std::unique_ptr<STGExpression> next_group = std::move(default_expr);
-    std::list<std::tuple<
-            std::list<Pattern*>,
-            std::map<std::string, std::string>,
-            const std::unique_ptr<Expression>*>> variable_alts;
-    std::map<std::string, std::list<std::tuple<
-            std::list<Pattern*>,
-            std::map<std::string, std::string>,
-            const std::unique_ptr<Expression>*>>> constructor_alts;
-    std::map<std::variant<int, char>, std::list<std::tuple<
-            std::list<Pattern*>,
-            std::map<std::string, std::string>,
-            const std::unique_ptr<Expression>*>>> literal_alts;
-
-    for (auto it = alternatives.rbegin(); ; ++it) {
-        std::list<Pattern*> patterns;
-        std::map<std::string, std::string> variable_renamings;
-        const std::unique_ptr<Expression>* expr;
-        patternform form;
-
-        if (it != alternatives.rend()) {
-            patterns = std::get<0>(*it);
-            variable_renamings = std::get<1>(*it);
-            expr = std::get<2>(*it);
-            form = (*patterns.begin())->get_form();
-            for (const auto &as: (*patterns.begin())->as) {
-                variable_renamings[as] = variables[0];
-            }
+// A decision tree: a leaf selects expr, or falls through if it is null; other nodes test variable.
+struct DecisionTree {
+    const std::unique_ptr<Expression> *expr = nullptr;
+    std::vector<std::pair<Symbol, Symbol>> renamings;
+    Symbol variable;
+    std::vector<std::pair<STGPattern, std::unique_ptr<DecisionTree>>> constructor_branches;
+    std::vector<std::pair<STGLiteral, std::unique_ptr<DecisionTree>>> literal_branches;
+    std::unique_ptr<DecisionTree> default_branch;
+};
+
+// Whether matching the rows in order is sure to test column c.
+bool is_forced(const std::list<Row> &rows, size_t c) {
+    for (const auto &[patterns, _, __]: rows) {
+        if (!is_test(patterns[c])) {
+            return false;
+        }
+        size_t first = 0;
+        while (!is_test(patterns[first])) {
+            first++;
         }
+        if (first == c) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        if (!variable_alts.empty() && (it == alternatives.rend() || (form != patternform::variable && form != patternform::wild))) {
-            std::vector<std::string> new_variables;
-            for (auto vit = variables.begin()+1; vit != variables.end(); vit++) {
-                new_variables.push_back(*vit);
+// Chooses the forced column of the first row to test next, as ColumnHeuristic describes.
+std::optional<size_t> choose_column(const std::list<Row> &rows, ColumnHeuristic column_heuristic) {
+    const auto &patterns = std::get<0>(rows.front());
+    std::optional<size_t> column;
+    size_t most_needed = 0;
+    size_t longest_prefix = 0;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (!is_test(patterns[i]) || (column && !is_forced(rows, i))) {
+            continue;
+        }
+        if (column_heuristic == ColumnHeuristic::leftmost) {
+            return i;
+        }
+        size_t needed = 0;
+        size_t prefix = 0;
+        bool in_prefix = true;
+        for (const auto &row: rows) {
+            if (is_test(std::get<0>(row)[i])) {
+                needed++;
+                prefix += in_prefix;
+            } else {
+                in_prefix = false;
             }
-            next_group = translate_case(
-                    new_variables,
-                    variable_alts,
-                    names_bound_in_pattern,
-                    std::move(next_group),
-                    next_variable_name,
-                    data_constructor_arities,
-                    definitions,
-                    free_variables);
-            variable_alts.clear();
-        } else if (!constructor_alts.empty() && (it == alternatives.rend() || form != patternform::constructor)) {
-            std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> translated_alts;
-            for (const auto &[constructor_name, alts]: constructor_alts) {
-                std::vector<std::string> argument_variables;
-                for (int i = 0; i < data_constructor_arities.at(constructor_name); i++) {
-                    argument_variables.push_back("." + std::to_string((*next_variable_name)++));
-                }
+        }
+        if (!column || needed > most_needed || (needed == most_needed && prefix > longest_prefix)) {
+            column = i;
+            most_needed = needed;
+            longest_prefix = prefix;
+        }
+    }
+    return column;
+}
 
-                std::vector<std::string> bound_names = names_bound_in_pattern;
-                bound_names.insert(
-                        bound_names.end(),
-                        argument_variables.begin(),
-                        argument_variables.end());
-                std::vector<std::string> new_variables = argument_variables;
-                for (auto vit = variables.begin()+1; vit != variables.end(); vit++) {
-                    new_variables.push_back(*vit);
-                }
-                auto alt_expr = translate_case(
-                        new_variables,
-                        alts,
-                        bound_names,
-                        copy(next_group),
-                        next_variable_name,
-                        data_constructor_arities,
-                        definitions,
-                        free_variables);
+// Compiles a pattern matrix to a decision tree, or returns null if it would have more nodes than budget.
+std::unique_ptr<DecisionTree> compile_pattern_matrix(
+        const std::vector<Symbol> &variables,
+        const std::list<Row> &rows,
+        NameSupply *name_supply,
+        const DataConstructors &data_constructors,
+        size_t &budget) {
+    if (budget == 0) {
+        return nullptr;
+    }
+    budget--;
+    auto tree = std::make_unique<DecisionTree>();
+    if (rows.empty()) {
+        return tree;
+    }
 
-                translated_alts.emplace_back(
-                        STGPattern(constructor_name, argument_variables),
-                        std::move(alt_expr));
-            }
+    std::optional<size_t> column = choose_column(rows, data_constructors.column_heuristic);
+    if (!column) {
+        const auto &[patterns, renamings, expr] = rows.front();
+        tree->expr = expr;
+        tree->renamings = renamings;
+        for (size_t i = 0; i < patterns.size(); i++) {
+            bind_names_in_pattern(patterns[i], variables[i], tree->renamings);
+        }
+        return tree;
+    }
 
-            next_group = std::make_unique<STGAlgebraicCase>(
-                    std::make_unique<STGVariable>(variables[0]),
-                    std::move(translated_alts),
-                    "",
-                    std::move(next_group));
-
-            constructor_alts.clear();
-        } else if (!literal_alts.empty() && (it == alternatives.rend() || form != patternform::literal)) {
-            std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> translated_alts;
-            for (const auto &[literal_value, alts]: literal_alts) {
-                std::vector<std::string> new_variables;
-                for (auto vit = variables.begin()+1; vit != variables.end(); vit++) {
-                    new_variables.push_back(*vit);
-                }
-                auto alt_expr = translate_case(
-                        new_variables,
-                        alts,
-                        names_bound_in_pattern,
-                        copy(next_group),
-                        next_variable_name,
-                        data_constructor_arities,
-                        definitions,
-                        free_variables);
+    const size_t c = *column;
+    tree->variable = variables[c];
+
+    // The rows for each constructor or literal in the column, and those that match anything there.
+    std::map<Symbol, std::list<Row>, SpellingOrder> constructor_rows;
+    std::map<Symbol, const ConstructorPattern*, SpellingOrder> constructor_patterns;
+    std::map<std::variant<int, char>, std::list<Row>> literal_rows;
+    std::list<Row> default_rows;
+    // Rows that match anything go into every branch, so the branches are found first.
+    for (const auto &[patterns, _, __]: rows) {
+        if (is_test(patterns[c]) && patterns[c]->get_form() == patternform::constructor) {
+            auto constructor = static_cast<const ConstructorPattern*>(patterns[c]);
+            constructor_patterns.emplace(constructor->name, constructor);
+            constructor_rows[constructor->name];
+        } else if (is_test(patterns[c])) {
+            literal_rows[static_cast<const LiteralPattern*>(patterns[c])->value];
+        }
+    }
 
-                translated_alts.emplace_back(
-                        STGLiteral(literal_value),
-                        std::move(alt_expr));
+    for (const auto &[patterns, renamings, expr]: rows) {
+        const Pattern *pattern = patterns[c];
+        std::vector<Pattern*> rest(patterns.begin(), patterns.begin() + c);
+        rest.insert(rest.end(), patterns.begin() + c + 1, patterns.end());
+        std::vector<std::pair<Symbol, Symbol>> row_renamings = renamings;
+        bind_names_in_pattern(pattern, variables[c], row_renamings);
+
+        if (is_test(pattern) && pattern->get_form() == patternform::constructor) {
+            auto constructor = static_cast<const ConstructorPattern*>(pattern);
+            std::vector<Pattern*> fields(rest.begin(), rest.begin() + c);
+            for (const auto &arg: constructor->args) {
+                fields.push_back(arg.get());
+            }
+            fields.insert(fields.end(), rest.begin() + c, rest.end());
+            constructor_rows[constructor->name].emplace_back(fields, row_renamings, expr);
+        } else if (is_test(pattern)) {
+            literal_rows[static_cast<const LiteralPattern*>(pattern)->value].emplace_back(rest, row_renamings, expr);
+        } else {
+            for (auto &[name, specialised]: constructor_rows) {
+                std::vector<Pattern*> fields(rest.begin(), rest.begin() + c);
+                fields.resize(c + data_constructors.arities.at(name), nullptr);
+                fields.insert(fields.end(), rest.begin() + c, rest.end());
+                specialised.emplace_back(fields, row_renamings, expr);
+            }
+            for (auto &[_, specialised]: literal_rows) {
+                specialised.emplace_back(rest, row_renamings, expr);
             }
+            default_rows.emplace_back(rest, row_renamings, expr);
+        }
+    }
 
-            next_group = std::make_unique<STGLiteralCase>(
-                    std::make_unique<STGVariable>(variables[0]),
-                    std::move(translated_alts),
-                    "",
-                    std::move(next_group));
+    std::vector<Symbol> rest_of_variables(variables.begin(), variables.begin() + c);
+    rest_of_variables.insert(rest_of_variables.end(), variables.begin() + c + 1, variables.end());
 
-            literal_alts.clear();
+    for (const auto &[constructor_name, specialised]: constructor_rows) {
+        std::vector<Symbol> argument_variables;
+        for (size_t i = 0; i < data_constructors.arities.at(constructor_name); i++) {
+            argument_variables.push_back(fresh_name(name_supply));
         }
+        std::vector<Symbol> new_variables(rest_of_variables.begin(), rest_of_variables.begin() + c);
+        new_variables.insert(new_variables.end(), argument_variables.begin(), argument_variables.end());
+        new_variables.insert(new_variables.end(), rest_of_variables.begin() + c, rest_of_variables.end());
 
-        if (it == alternatives.rend()) {
-            break;
+        std::vector<Pattern*> field_patterns;
+        for (const auto &arg: constructor_patterns.at(constructor_name)->args) {
+            field_patterns.push_back(arg.get());
         }
+        auto branch = compile_pattern_matrix(new_variables, specialised, name_supply, data_constructors, budget);
+        if (branch == nullptr) {
+            return nullptr;
+        }
+        tree->constructor_branches.emplace_back(
+                STGPattern(constructor_name, argument_variables, field_types(field_patterns)),
+                std::move(branch));
+    }
+    for (const auto &[literal_value, specialised]: literal_rows) {
+        auto branch = compile_pattern_matrix(rest_of_variables, specialised, name_supply, data_constructors, budget);
+        if (branch == nullptr) {
+            return nullptr;
+        }
+        tree->literal_branches.emplace_back(STGLiteral(literal_value), std::move(branch));
+    }
 
-        if (form == patternform::variable || form == patternform::wild) {
-            if (form == patternform::variable) {
-                std::string name = dynamic_cast<VariablePattern *>(*patterns.begin())->name;
-                variable_renamings[name] = variables[0];
+    bool exhaustive = false;
+    if (!constructor_rows.empty()) {
+        auto number_of_constructors = data_constructors.type_sizes.find(constructor_rows.begin()->first);
+        exhaustive = number_of_constructors != data_constructors.type_sizes.end() &&
+                number_of_constructors->second == constructor_rows.size();
+    }
+    if (!exhaustive) {
+        tree->default_branch = compile_pattern_matrix(
+                rest_of_variables,
+                default_rows,
+                name_supply,
+                data_constructors,
+                budget);
+        if (tree->default_branch == nullptr) {
+            return nullptr;
+        }
+    }
+    return tree;
+}
+
+void collect_leaves(
+        const DecisionTree *tree,
+        std::map<const std::unique_ptr<Expression>*, std::vector<const DecisionTree*>> &leaves) {
+    if (tree->variable.empty()) {
+        if (tree->expr != nullptr) {
+            leaves[tree->expr].push_back(tree);
+        }
+        return;
+    }
+    for (const auto &[_, branch]: tree->constructor_branches) {
+        collect_leaves(branch.get(), leaves);
+    }
+    for (const auto &[_, branch]: tree->literal_branches) {
+        collect_leaves(branch.get(), leaves);
+    }
+    if (tree->default_branch != nullptr) {
+        collect_leaves(tree->default_branch.get(), leaves);
+    }
+}
+
+// The names bound by the patterns of an alternative, in order, which the join point for it takes as arguments.
+std::map<Symbol, Symbol, SpellingOrder> names_bound_at_leaf(const DecisionTree *leaf) {
+    return std::map<Symbol, Symbol, SpellingOrder>(leaf->renamings.begin(), leaf->renamings.end());
+}
+
+std::unique_ptr<STGExpression> translate_decision_tree(
+        const DecisionTree *tree,
+        const Symbol &fall_through,
+        const std::map<const std::unique_ptr<Expression>*, Symbol> &join_points,
+        const std::vector<Symbol> &names_bound_in_pattern,
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors,
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions,
+        std::set<Symbol, SpellingOrder> &free_variables) {
+    if (tree->variable.empty()) {
+        if (tree->expr == nullptr) {
+            return std::make_unique<STGVariable>(fall_through);
+        }
+        auto join_point = join_points.find(tree->expr);
+        if (join_point != join_points.end()) {
+            std::vector<Symbol> arguments;
+            for (const auto &[_, variable]: names_bound_at_leaf(tree)) {
+                arguments.push_back(variable);
             }
-            patterns.pop_front();
-            variable_alts.emplace_front(patterns, variable_renamings, expr);
-        } else if (form == patternform::constructor) {
-            std::string constructor_name = dynamic_cast<ConstructorPattern*>(*patterns.begin())->name;
-            if (constructor_alts.count(constructor_name) == 0) {
-                constructor_alts[constructor_name] = std::list<std::tuple<
-                        std::list<Pattern*>,
-                        std::map<std::string, std::string>,
-                        const std::unique_ptr<Expression>*>>();
+            if (arguments.empty()) {
+                return std::make_unique<STGVariable>(join_point->second);
             }
-            std::list<Pattern*> sub_patterns;
-            for (const auto &sub_pattern: dynamic_cast<ConstructorPattern*>(*patterns.begin())->args) {
-                sub_patterns.push_back(sub_pattern.get());
+            return std::make_unique<STGApplication>(join_point->second, arguments);
+        }
+        ScopedMap<Symbol>::Scope scope(variable_renamings);
+        for (const auto &[name, renamed]: tree->renamings) {
+            variable_renamings.bind(name, renamed);
+        }
+        return translate_alt_expression(
+                *tree->expr,
+                name_supply,
+                variable_renamings,
+                data_constructors,
+                names_bound_in_pattern,
+                definitions,
+                free_variables);
+    }
+
+    auto translate_branch = [&](const DecisionTree *branch, const std::vector<Symbol> &fields) {
+        std::vector<Symbol> bound_names = names_bound_in_pattern;
+        bound_names.insert(bound_names.end(), fields.begin(), fields.end());
+        return translate_decision_tree(
+                branch,
+                fall_through,
+                join_points,
+                bound_names,
+                name_supply,
+                variable_renamings,
+                data_constructors,
+                definitions,
+                free_variables);
+    };
+    std::unique_ptr<STGExpression> default_expr = tree->default_branch != nullptr
+            ? translate_branch(tree->default_branch.get(), {})
+            : std::make_unique<STGVariable>(Symbol("case_error"));
+
+    if (!tree->constructor_branches.empty()) {
+        std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
+        for (const auto &[pattern, branch]: tree->constructor_branches) {
+            alts.emplace_back(pattern, translate_branch(branch.get(), pattern.variables));
+        }
+        return std::make_unique<STGAlgebraicCase>(
+                std::make_unique<STGVariable>(tree->variable),
+                std::move(alts),
+                Symbol(),
+                std::move(default_expr));
+    }
+    std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
+    for (const auto &[literal, branch]: tree->literal_branches) {
+        alts.emplace_back(literal, translate_branch(branch.get(), {}));
+    }
+    return std::make_unique<STGLiteralCase>(
+            std::make_unique<STGVariable>(tree->variable),
+            std::move(alts),
+            Symbol(),
+            std::move(default_expr));
+}
+
+// Translates the decision tree of a block of alternatives, sharing those selected at several leaves as join points.
+std::unique_ptr<STGExpression> translate_block(
+        const DecisionTree *tree,
+        const std::list<Row> &alternatives,
+        const std::vector<Symbol> &names_bound_in_pattern,
+        const Symbol &fall_through,
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors,
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions,
+        std::set<Symbol, SpellingOrder> &free_variables) {
+    std::map<const std::unique_ptr<Expression>*, std::vector<const DecisionTree*>> leaves;
+    collect_leaves(tree, leaves);
+    std::map<const std::unique_ptr<Expression>*, Symbol> join_points;
+    std::vector<std::tuple<Symbol, std::vector<Symbol>, std::unique_ptr<STGExpression>>> join_point_definitions;
+    for (const auto &[_, __, expr]: alternatives) {
+        auto selected = leaves.find(expr);
+        if (selected == leaves.end() || selected->second.size() < 2) {
+            continue;
+        }
+        Symbol name = fresh_name(name_supply);
+        std::vector<Symbol> arguments;
+        ScopedMap<Symbol>::Scope scope(variable_renamings);
+        for (const auto &[bound_name, _]: names_bound_at_leaf(selected->second.front())) {
+            arguments.push_back(fresh_name(name_supply));
+            variable_renamings.bind(bound_name, arguments.back());
+        }
+        std::vector<Symbol> bound_names = names_bound_in_pattern;
+        bound_names.insert(bound_names.end(), arguments.begin(), arguments.end());
+        auto rhs = translate_alt_expression(
+                *expr,
+                name_supply,
+                variable_renamings,
+                data_constructors,
+                bound_names,
+                definitions,
+                free_variables);
+        join_points.emplace(expr, name);
+        join_point_definitions.emplace_back(name, std::move(arguments), std::move(rhs));
+    }
+
+    auto translated = translate_decision_tree(
+            tree,
+            fall_through,
+            join_points,
+            names_bound_in_pattern,
+            name_supply,
+            variable_renamings,
+            data_constructors,
+            definitions,
+            free_variables);
+    for (auto it = join_point_definitions.rbegin(); it != join_point_definitions.rend(); ++it) {
+        auto &[name, arguments, rhs] = *it;
+        translated = std::make_unique<STGLetNoEscape>(name, arguments, std::move(rhs), std::move(translated));
+    }
+    return translated;
+}
+
+// The number of patterns in a pattern and its sub-patterns that need testing.
+size_t count_tests(const Pattern *pattern) {
+    if (!is_test(pattern)) {
+        return 0;
+    }
+    size_t tests = 1;
+    if (pattern->get_form() == patternform::constructor) {
+        for (const auto &arg: static_cast<const ConstructorPattern*>(pattern)->args) {
+            tests += count_tests(arg.get());
+        }
+    }
+    return tests;
+}
+
+// The nodes a decision tree may have for each of its rows and each test their patterns need.
+const size_t nodes_per_test = 3;
+
+// Translates the alternatives in blocks whose decision trees stay within budget, each falling through to the next.
+std::unique_ptr<STGExpression> translate_case(
+        const std::vector<Symbol> &variables,
+        const std::list<Row> &alternatives,
+        const std::vector<Symbol> &names_bound_in_pattern,
+        const Symbol &fall_through,
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors,
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions,
+        std::set<Symbol, SpellingOrder> &free_variables) {
+    std::vector<std::pair<std::list<Row>, std::unique_ptr<DecisionTree>>> blocks;
+    std::list<Row> rows = alternatives;
+    size_t block_size = rows.size();
+    do {
+        std::list<Row> block;
+        block.splice(block.end(), rows, rows.begin(), std::next(rows.begin(), std::min(block_size, rows.size())));
+        while (true) {
+            size_t budget = 0;
+            for (const auto &[patterns, _, __]: block) {
+                budget += nodes_per_test;
+                for (const auto &pattern: patterns) {
+                    budget += nodes_per_test * count_tests(pattern);
+                }
             }
-            patterns.pop_front();
-            patterns.splice(patterns.begin(), sub_patterns);
-            constructor_alts[constructor_name].emplace_front(patterns, variable_renamings, expr);
-        } else if (form == patternform::literal) {
-            auto literal_value = dynamic_cast<LiteralPattern*>(*patterns.begin())->value;
-            if (literal_alts.count(literal_value) == 0) {
-                literal_alts[literal_value] = std::list<std::tuple<
-                        std::list<Pattern*>,
-                        std::map<std::string, std::string>,
-                        const std::unique_ptr<Expression>*>>();
+            auto tree = compile_pattern_matrix(variables, block, name_supply, data_constructors, budget);
+            if (tree != nullptr) {
+                block_size = 2 * block.size();
+                blocks.emplace_back(std::move(block), std::move(tree));
+                break;
             }
-            patterns.pop_front();
-            literal_alts[literal_value].emplace_front(patterns, variable_renamings, expr);
+            rows.splice(rows.begin(), block, std::next(block.begin(), (block.size() + 1) / 2), block.end());
         }
+    } while (!rows.empty());
+
+    // Each block falls through to the join point of the next, and the last to fall_through.
+    std::vector<std::pair<Symbol, std::unique_ptr<STGExpression>>> fall_throughs;
+    Symbol next_fall_through = fall_through;
+    std::unique_ptr<STGExpression> translated;
+    for (size_t i = blocks.size(); i-- > 0; ) {
+        translated = translate_block(
+                blocks[i].second.get(),
+                blocks[i].first,
+                names_bound_in_pattern,
+                next_fall_through,
+                name_supply,
+                variable_renamings,
+                data_constructors,
+                definitions,
+                free_variables);
+        if (i > 0) {
+            next_fall_through = fresh_name(name_supply);
+            fall_throughs.emplace_back(next_fall_through, std::move(translated));
+        }
+    }
+    for (auto it = fall_throughs.rbegin(); it != fall_throughs.rend(); ++it) {
+        translated = std::make_unique<STGLetNoEscape>(it->first, std::move(it->second), std::move(translated));
     }
-    return std::move(next_group);
+    return translated;
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_case(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_case(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        std::map<std::string, std::string> variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
-    auto cAsE = dynamic_cast<Case*>(expr.get());
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    auto cAsE = static_cast<Case*>(expr.get());
+    ScopedMap<Symbol>::Scope scope(variable_renamings);
 
-    std::string as;
+    Symbol as;
 
     auto translated = translate_expression(
             cAsE->exp,
-            next_variable_name,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
 
-    std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> definitions = std::move(translated.second);
+    std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> definitions =
+            std::move(translated.second);
 
     patternform first_alt_pattern_form = cAsE->alts[0].first->get_form();
 
     if (first_alt_pattern_form == patternform::wild || first_alt_pattern_form == patternform::variable) {
         if (!cAsE->alts[0].first->as.empty() || first_alt_pattern_form == patternform::variable) {
-            as = "." + std::to_string((*next_variable_name)++);
+            as = fresh_name(name_supply);
             add_definition(as, std::move(translated.first), definitions);
             if (first_alt_pattern_form == patternform::variable) {
-                variable_renamings[dynamic_cast<VariablePattern*>(cAsE->alts[0].first.get())->name] = as;
+                variable_renamings.bind(static_cast<VariablePattern*>(cAsE->alts[0].first.get())->name, as);
             }
-            for (const std::string& name: cAsE->alts[0].first->as) {
-                variable_renamings[name] = as;
+            for (const Symbol &name: cAsE->alts[0].first->as) {
+                variable_renamings.bind(name, as);
             }
             auto alt_expr_translated = translate_expression(
                     cAsE->alts[0].second,
-                    next_variable_name,
+                    name_supply,
                     variable_renamings,
-                    data_constructor_arities);
+                    data_constructors);
             for (auto &definition: alt_expr_translated.second) {
                 definitions.push_back(std::move(definition));
             }
@@ -530,84 +859,77 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
         } else {
             return translate_expression(
                     cAsE->alts[0].second,
-                    next_variable_name,
+                    name_supply,
                     variable_renamings,
-                    data_constructor_arities);
+                    data_constructors);
         }
     } else if (first_alt_pattern_form == patternform::literal || first_alt_pattern_form == patternform::constructor) {
-        std::string default_var;
-        std::unique_ptr<STGExpression> default_expr = std::make_unique<STGVariable>("case_error");
-        std::set<std::string> free_variables;
+        Symbol default_var;
+        std::unique_ptr<STGExpression> default_expr = std::make_unique<STGVariable>(Symbol("case_error"));
+        std::set<Symbol, SpellingOrder> free_variables;
 
         std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> literal_alts;
-        std::map<
-                std::string,
-                std::list<std::tuple<
-                        std::list<Pattern*>,
-                        std::map<std::string, std::string>,
-                        const std::unique_ptr<Expression>*>>> constructor_alts;
+        std::map<Symbol, std::list<Row>, SpellingOrder> constructor_alts;
 
         for (const auto &alt: cAsE->alts) {
-            std::map<std::string, std::string> local_variable_renamings = variable_renamings;
+            std::vector<std::pair<Symbol, Symbol>> pattern_renamings;
             if (!alt.first->as.empty()) {
                 if (as.empty()) {
-                    as = "." + std::to_string((*next_variable_name)++);
+                    as = fresh_name(name_supply);
                     add_definition(as, std::move(translated.first), definitions);
                 }
                 for (const auto &name: alt.first->as) {
-                    local_variable_renamings[name] = as;
+                    pattern_renamings.emplace_back(name, as);
                 }
             }
 
             if (alt.first->get_form() == patternform::constructor) {
-                std::string constructor_name = dynamic_cast<ConstructorPattern*>(alt.first.get())->name;
-                if (constructor_alts.count(constructor_name) == 0) {
-                    constructor_alts[constructor_name] = std::list<std::tuple<
-                            std::list<Pattern*>,
-                            std::map<std::string, std::string>,
-                            const std::unique_ptr<Expression>*>>();
-                }
-                std::list<Pattern*> sub_patterns;
-                for (const auto &sub_pattern: dynamic_cast<ConstructorPattern*>(alt.first.get())->args) {
+                Symbol constructor_name = static_cast<ConstructorPattern*>(alt.first.get())->name;
+                std::vector<Pattern*> sub_patterns;
+                for (const auto &sub_pattern: static_cast<ConstructorPattern*>(alt.first.get())->args) {
                     sub_patterns.push_back(sub_pattern.get());
                 }
                 constructor_alts[constructor_name].emplace_back(
                         sub_patterns,
-                        local_variable_renamings,
+                        pattern_renamings,
                         &alt.second);
             } else {
-                std::vector<std::string> names_bound_in_pattern;
+                std::vector<Symbol> names_bound_in_pattern;
                 if (alt.first->get_form() == patternform::variable) {
-                    std::string name = dynamic_cast<VariablePattern *>(alt.first.get())->name;
+                    Symbol name = static_cast<VariablePattern *>(alt.first.get())->name;
                     if (first_alt_pattern_form == patternform::constructor) {
                         if (as.empty()) {
-                            as = "." + std::to_string((*next_variable_name)++);
+                            as = fresh_name(name_supply);
                             add_definition(as, std::move(translated.first), definitions);
                         }
-                        local_variable_renamings[name] = as;
+                        pattern_renamings.emplace_back(name, as);
                     } else {
                         names_bound_in_pattern.push_back(name);
                     }
                 }
 
+                ScopedMap<Symbol>::Scope alt_scope(variable_renamings);
+                for (const auto &[name, renamed]: pattern_renamings) {
+                    variable_renamings.bind(name, renamed);
+                }
                 auto alt_expr = translate_alt_expression(
                         alt.second,
-                        next_variable_name,
-                        local_variable_renamings,
-                        data_constructor_arities,
+                        name_supply,
+                        variable_renamings,
+                        data_constructors,
                         names_bound_in_pattern,
                         definitions,
                         free_variables);
 
                 if (alt.first->get_form() == patternform::literal) {
-                    STGLiteral literal(dynamic_cast<LiteralPattern *>(alt.first.get())->value);
+                    STGLiteral literal(static_cast<LiteralPattern *>(alt.first.get())->value);
                     literal_alts.emplace_back(literal, std::move(alt_expr));
                 } else if (alt.first->get_form() == patternform::wild) {
                     default_expr = std::move(alt_expr);
                     break;
                 } else if (alt.first->get_form() == patternform::variable) {
                     if (first_alt_pattern_form != patternform::constructor) {
-                        default_var = dynamic_cast<VariablePattern *>(alt.first.get())->name;
+                        default_var = static_cast<VariablePattern *>(alt.first.get())->name;
                     }
                     default_expr = std::move(alt_expr);
                     break;
@@ -615,25 +937,30 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
             }
         }
 
+        FallThrough fall_through(std::move(default_expr), name_supply);
         std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> translated_alts;
         for (const auto &[constructor_name, alts]: constructor_alts) {
-            std::vector<std::string> argument_variables;
-            for (int i = 0; i < data_constructor_arities.at(constructor_name); i++) {
-                argument_variables.push_back("." + std::to_string((*next_variable_name)++));
+            std::vector<Symbol> argument_variables;
+            for (size_t i = 0; i < data_constructors.arities.at(constructor_name); i++) {
+                argument_variables.push_back(fresh_name(name_supply));
             }
 
             auto alt_expr = translate_case(
                     argument_variables,
                     alts,
                     argument_variables,
-                    copy(default_expr),
-                    next_variable_name,
-                    data_constructor_arities,
+                    fall_through.target(),
+                    name_supply,
+                    variable_renamings,
+                    data_constructors,
                     definitions,
                     free_variables);
 
             translated_alts.emplace_back(
-                    STGPattern(constructor_name, argument_variables),
+                    STGPattern(
+                            constructor_name,
+                            argument_variables,
+                            field_types(std::get<0>(alts.front()))),
                     std::move(alt_expr));
         }
 
@@ -650,160 +977,189 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
         }
 
         if (first_alt_pattern_form == patternform::literal) {
+            default_expr = fall_through.default_expr(literal_alts);
             case_expr = std::make_unique<STGLiteralCase>(
                     std::move(case_expr),
                     std::move(literal_alts),
                     default_var,
                     std::move(default_expr));
         } else if (first_alt_pattern_form == patternform::constructor) {
-            case_expr = std::make_unique<STGAlgebraicCase>(
+            default_expr = fall_through.default_expr(translated_alts);
+            case_expr = fall_through.bind(std::make_unique<STGAlgebraicCase>(
                     std::move(case_expr),
                     std::move(translated_alts),
                     default_var,
-                    std::move(default_expr));
+                    std::move(default_expr)));
         }
 
         return std::make_pair(
                 std::make_unique<STGLambdaForm>(
                         free_variables,
-                        std::vector<std::string>(),
+                        std::vector<Symbol>(),
                         true,
                         std::move(case_expr)),
                 std::move(definitions));
     }
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_application(
-        const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, std::string> &variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
-    std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> definitions;
-    std::vector<std::string> argument_variables;
-
-    auto expression = &expr;
-    do {
-        auto app = dynamic_cast<Application*>(expression->get());
-
-        auto translated = translate_expression(
-                app->right,
-                next_variable_name,
-                variable_renamings,
-                data_constructor_arities);
+std::unique_ptr<STGLambdaForm> translate_application(
+        const Application *application,
+        std::unique_ptr<STGLambdaForm> &&last_argument,
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors,
+        std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> &definitions) {
+    std::vector<Symbol> argument_variables(application->arguments.size());
+
+    for (size_t i = application->arguments.size(); i-- > 0; ) {
+        std::unique_ptr<STGLambdaForm> argument;
+        if (i == application->arguments.size() - 1) {
+            argument = std::move(last_argument);
+        } else {
+            auto translated = translate_expression(
+                    application->arguments[i],
+                    name_supply,
+                    variable_renamings,
+                    data_constructors);
 
-        for (auto &definition: translated.second) {
-            definitions.push_back(std::move(definition));
+            for (auto &definition: translated.second) {
+                definitions.push_back(std::move(definition));
+            }
+            argument = std::move(translated.first);
         }
 
-        if (translated.first->expr->get_form() == stgform::variable) {
-            argument_variables.insert(
-                    argument_variables.begin(),
-                    dynamic_cast<STGVariable*>(translated.first->expr.get())->name);
+        if (argument->expr->get_form() == stgform::variable) {
+            argument_variables[i] = static_cast<STGVariable*>(argument->expr.get())->name;
         } else {
-            std::string name = "." + std::to_string((*next_variable_name)++);
-            add_definition(name, std::move(translated.first), definitions);
-            argument_variables.insert(argument_variables.begin(), name);
+            Symbol name = fresh_name(name_supply);
+            add_definition(name, std::move(argument), definitions);
+            argument_variables[i] = name;
         }
+    }
 
-        expression = &(app->left);
-    } while ((*expression)->get_form() == expform::application);
+    const auto &function = application->function;
 
-    if ((*expression)->get_form() == expform::constructor) {
-        std::string constructor_name = dynamic_cast<Constructor*>(expression->get())->name;
-        std::vector<std::string> additional_argument_variables;
-        for (int i = argument_variables.size(); i < data_constructor_arities.at(constructor_name); i++) {
-            additional_argument_variables.push_back("." + std::to_string((*next_variable_name)++));
+    if (function->get_form() == expform::constructor) {
+        Symbol constructor_name = static_cast<Constructor*>(function.get())->name;
+        std::vector<Symbol> additional_argument_variables;
+        for (size_t i = argument_variables.size(); i < data_constructors.arities.at(constructor_name); i++) {
+            additional_argument_variables.push_back(fresh_name(name_supply));
         }
-        std::vector<std::string> combined_argument_variables = argument_variables;
+        std::vector<Symbol> combined_argument_variables = argument_variables;
         combined_argument_variables.insert(
                 combined_argument_variables.end(),
                 additional_argument_variables.begin(),
                 additional_argument_variables.end());
-        return std::make_pair(
-                std::make_unique<STGLambdaForm>(
-                        std::set<std::string>(argument_variables.begin(), argument_variables.end()),
-                        additional_argument_variables,
-                        false,
-                        std::make_unique<STGConstructor>(constructor_name, combined_argument_variables)),
-                std::move(definitions));
+        return std::make_unique<STGLambdaForm>(
+                std::set<Symbol, SpellingOrder>(argument_variables.begin(), argument_variables.end()),
+                additional_argument_variables,
+                false,
+                std::make_unique<STGConstructor>(constructor_name, combined_argument_variables));
     }
 
     auto translated = translate_expression(
-            *expression,
-            next_variable_name,
+            function,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
 
     for (auto &definition: translated.second) {
         definitions.push_back(std::move(definition));
     }
 
+    Symbol name;
     if (translated.first->expr->get_form() == stgform::variable) {
-        std::string name = dynamic_cast<STGVariable*>(translated.first->expr.get())->name;
-        std::set<std::string> free_variables;
-        free_variables.insert(name);
-        free_variables.insert(argument_variables.begin(), argument_variables.end());
-        return std::make_pair(
-                std::make_unique<STGLambdaForm>(
-                        free_variables,
-                        std::vector<std::string>(),
-                        true,
-                        std::make_unique<STGApplication>(name, argument_variables)),
-                std::move(definitions));
+        name = static_cast<STGVariable*>(translated.first->expr.get())->name;
     } else {
-        std::string name = "." + std::to_string((*next_variable_name)++);
+        name = fresh_name(name_supply);
         add_definition(name, std::move(translated.first), definitions);
-        std::set<std::string> free_variables;
-        free_variables.insert(name);
-        free_variables.insert(argument_variables.begin(), argument_variables.end());
-        return std::make_pair(
-                std::make_unique<STGLambdaForm>(
-                        free_variables,
-                        std::vector<std::string>(),
-                        true,
-                        std::make_unique<STGApplication>(name, argument_variables)),
-                std::move(definitions));
     }
+    std::set<Symbol, SpellingOrder> free_variables;
+    free_variables.insert(name);
+    free_variables.insert(argument_variables.begin(), argument_variables.end());
+    return std::make_unique<STGLambdaForm>(
+            free_variables,
+            std::vector<Symbol>(),
+            true,
+            std::make_unique<STGApplication>(name, argument_variables));
+}
 
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_application(
+        const std::unique_ptr<Expression> &expr,
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    // Applications nested in last arguments, as built for list literals, are collected first and translated from the
+    // innermost outwards, so that the definitions of every level are gathered in a single vector.
+    std::vector<const Application*> spine;
+    const Expression *current = expr.get();
+    while (current->get_form() == expform::application) {
+        spine.push_back(static_cast<const Application*>(current));
+        current = spine.back()->arguments.back().get();
+    }
+
+    auto translated = translate_expression(
+            spine.back()->arguments.back(),
+            name_supply,
+            variable_renamings,
+            data_constructors);
+    std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> definitions =
+            std::move(translated.second);
+    std::unique_ptr<STGLambdaForm> lambda_form = std::move(translated.first);
+
+    while (!spine.empty()) {
+        lambda_form = translate_application(
+                spine.back(),
+                std::move(lambda_form),
+                name_supply,
+                variable_renamings,
+                data_constructors,
+                definitions);
+        lambda_form->type = spine.back()->type;
+        spine.pop_back();
+    }
+
+    return std::make_pair(std::move(lambda_form), std::move(definitions));
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_let(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_let(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        std::map<std::string, std::string> variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
-    auto let = dynamic_cast<Let*>(expr.get());
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    auto let = static_cast<Let*>(expr.get());
+    ScopedMap<Symbol>::Scope scope(variable_renamings);
 
-    std::vector<std::string> names_defined;
+    std::vector<Symbol> names_defined;
     for (const auto &[name, _]: let->bindings) {
-        variable_renamings[name] = "." + std::to_string((*next_variable_name)++);
+        variable_renamings.bind(name, fresh_name(name_supply));
         names_defined.push_back(name);
     }
-    std::map<std::string, std::set<std::string>> dependencies;
+    std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> dependencies;
     for (const auto &[name, expression]: let->bindings) {
-        dependencies[name] = std::set<std::string>();
+        dependencies[name] = std::set<Symbol, SpellingOrder>();
         for (const auto &free_variable: find_free_variables(expression)) {
-            if (std::count(names_defined.begin(), names_defined.end(), free_variable)) {
+            if (let->bindings.count(free_variable) > 0) {
                 dependencies[name].insert(free_variable);
             }
         }
     }
     auto dependency_groups = dependency_analysis(names_defined, dependencies);
 
-    std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>> definitions;
+    std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>> definitions;
 
     for (const auto &group: dependency_groups) {
-        std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
-        std::set<std::string> names_defined_in_group;
+        std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+        std::set<Symbol, SpellingOrder> names_defined_in_group;
         for (const auto &name: group) {
-            names_defined_in_group.insert(variable_renamings[name]);
+            names_defined_in_group.insert(variable_renamings.at(name));
         }
         for (const auto &name: group) {
             auto translated = translate_expression(
                     let->bindings.at(name),
-                    next_variable_name,
+                    name_supply,
                     variable_renamings,
-                    data_constructor_arities);
+                    data_constructors);
             for (auto &definition: translated.second) {
                 bool depends_on_names_in_group = false;
                 for (auto &[n, lambda_form]: definition) {
@@ -824,16 +1180,16 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
                     }
                 }
             }
-            bindings[variable_renamings[name]] = std::move(translated.first);
+            bindings[variable_renamings.at(name)] = std::move(translated.first);
         }
         definitions.push_back(std::move(bindings));
     }
 
     auto translated = translate_expression(
             let->e,
-            next_variable_name,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
 
    for (auto &definition: translated.second) {
        definitions.push_back(std::move(definition));
@@ -842,30 +1198,31 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
    return std::make_pair(std::move(translated.first), std::move(definitions));
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_abstraction(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_abstraction(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        std::map<std::string, std::string> variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    ScopedMap<Symbol>::Scope scope(variable_renamings);
     auto expression = &expr;
-    std::vector<std::string> argument_variables;
+    std::vector<Symbol> argument_variables;
     do {
-        auto abstraction = dynamic_cast<Abstraction*>(expression->get());
+        auto abstraction = static_cast<Abstraction*>(expression->get());
         for (const auto &arg: abstraction->args) {
-            std::string new_name = "." + std::to_string((*next_variable_name)++);
+            Symbol new_name = fresh_name(name_supply);
             argument_variables.push_back(new_name);
-            variable_renamings[arg] = new_name;
+            variable_renamings.bind(arg, new_name);
         }
         expression = &(abstraction->body);
     } while ((*expression)->get_form() == expform::abstraction);
 
     auto translated = translate_expression(
             *expression,
-            next_variable_name,
+            name_supply,
             variable_renamings,
-            data_constructor_arities);
+            data_constructors);
 
-    std::set<std::string> free_variables = translated.first->free_variables;
+    std::set<Symbol, SpellingOrder> free_variables = translated.first->free_variables;
     std::unique_ptr<STGExpression> body_expression = std::move(translated.first->expr);
 
     for (const auto &variable: argument_variables) {
@@ -887,180 +1244,272 @@ std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std:
             std::move(independent_definitions));
 }
 
-std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<std::string, std::unique_ptr<STGLambdaForm>>>> translate_expression(
+std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translate_expression(
         const std::unique_ptr<Expression> &expr,
-        unsigned long *next_variable_name,
-        const std::map<std::string, std::string> &variable_renamings,
-        const std::map<std::string, size_t> &data_constructor_arities) {
+        NameSupply *name_supply,
+        ScopedMap<Symbol> &variable_renamings,
+        const DataConstructors &data_constructors) {
+    std::pair<std::unique_ptr<STGLambdaForm>, std::vector<std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder>>> translated;
     switch(expr->get_form()) {
         case expform::variable:
-            return translate_variable(expr, variable_renamings);
+            translated = translate_variable(expr, variable_renamings);
+            break;
         case expform::literal:
-            return translate_literal(expr, next_variable_name);
+            translated = translate_literal(expr, name_supply);
+            break;
         case expform::abstraction:
-            return translate_abstraction(expr, next_variable_name, variable_renamings, data_constructor_arities);
+            translated = translate_abstraction(expr, name_supply, variable_renamings, data_constructors);
+            break;
         case expform::let:
-            return translate_let(expr, next_variable_name, variable_renamings, data_constructor_arities);
+            translated = translate_let(expr, name_supply, variable_renamings, data_constructors);
+            break;
         case expform::constructor:
-            return translate_constructor(expr, next_variable_name, data_constructor_arities);
+            translated = translate_constructor(expr, name_supply, data_constructors);
+            break;
         case expform::application:
-            return translate_application(expr, next_variable_name, variable_renamings, data_constructor_arities);
+            translated = translate_application(expr, name_supply, variable_renamings, data_constructors);
+            break;
         case expform::builtinop:
-            return translate_built_in_op(expr, next_variable_name, variable_renamings, data_constructor_arities);
+            translated = translate_built_in_op(expr, name_supply, variable_renamings, data_constructors);
+            break;
         case expform::cAsE:
-            return translate_case(expr, next_variable_name, variable_renamings, data_constructor_arities);
+            translated = translate_case(expr, name_supply, variable_renamings, data_constructors);
+            break;
     }
+    translated.first->type = expr->type;
+    return translated;
 }
 
 void remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
         const std::unique_ptr<STGLambdaForm> &lambda_form,
-        const std::set<std::string> &globals,
-        const std::map<std::string, size_t> &number_of_arguments,
-        std::set<std::string> &used_data_constructors);
-
-void remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-        const std::unique_ptr<STGExpression> &expr,
-        const std::set<std::string> &globals,
-        const std::map<std::string, size_t> &number_of_arguments,
-        std::set<std::string> &used_data_constructors) {
-    if (expr->get_form() == stgform::let) {
-        auto let = dynamic_cast<STGLet*>(expr.get());
-        std::map<std::string, size_t> local_number_of_arguments = number_of_arguments;
-        for (const auto &[name, lambda_form]: let->bindings) {
-            local_number_of_arguments[name] = lambda_form->argument_variables.size();
-        }
-        for (const auto &[_, lambda_form]: let->bindings) {
-            remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                    lambda_form,
-                    globals,
-                    local_number_of_arguments,
-                    used_data_constructors);
-        }
-        remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                let->expr,
-                globals,
-                local_number_of_arguments,
-                used_data_constructors);
-    } else if (expr->get_form() == stgform::literalcase) {
-        auto cAsE = dynamic_cast<STGLiteralCase*>(expr.get());
-        remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                cAsE->expr,
-                globals,
-                number_of_arguments,
-                used_data_constructors);
-        remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                cAsE->default_expr,
-                globals,
-                number_of_arguments,
-                used_data_constructors);
-        for (const auto &[_, e]: cAsE->alts) {
-            remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                    e,
-                    globals,
-                    number_of_arguments,
-                    used_data_constructors);
-        }
-    } else if (expr->get_form() == stgform::algebraiccase) {
-        auto cAsE = dynamic_cast<STGAlgebraicCase*>(expr.get());
-        remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                cAsE->expr,
-                globals,
-                number_of_arguments,
-                used_data_constructors);
-        remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                cAsE->default_expr,
-                globals,
-                number_of_arguments,
-                used_data_constructors);
-        for (const auto &[p, e]: cAsE->alts) {
-            used_data_constructors.insert(p.constructor_name);
-            std::map<std::string, size_t> local_number_of_arguments = number_of_arguments;
-            for (const auto &v: p.variables) {
-                local_number_of_arguments[v] = 0;
+        const std::unordered_set<Symbol> &globals,
+        const std::unordered_map<Symbol, size_t> &number_of_arguments,
+        std::set<Symbol, SpellingOrder> &used_data_constructors,
+        bool &string_literals) {
+    // Lambda forms and expressions are visited with an explicit stack. Entries with neither bring local names into
+    // scope or take them out again, and are pushed around the lambda forms and expressions in the scope of those names.
+    struct Visit {
+        STGLambdaForm *lambda_form;
+        const STGExpression *expression;
+        std::vector<std::pair<Symbol, size_t>> names;
+        bool bind;
+    };
+    auto visit_lambda_form = [](STGLambdaForm *lambda_form) {
+        return Visit{lambda_form, nullptr, {}, false};
+    };
+    auto visit_expression = [](const STGExpression *expression) {
+        return Visit{nullptr, expression, {}, false};
+    };
+    auto scoped = [](std::vector<Visit> &to_visit, const std::vector<std::pair<Symbol, size_t>> &names, const Visit &visit) {
+        to_visit.push_back({nullptr, nullptr, names, false});
+        to_visit.push_back(visit);
+        to_visit.push_back({nullptr, nullptr, names, true});
+    };
+
+    std::unordered_map<Symbol, std::vector<size_t>> local_number_of_arguments;
+    std::vector<Visit> to_visit = {visit_lambda_form(lambda_form.get())};
+    while (!to_visit.empty()) {
+        Visit visit = std::move(to_visit.back());
+        to_visit.pop_back();
+
+        if (visit.lambda_form != nullptr) {
+            STGLambdaForm *lf = visit.lambda_form;
+            if (lf->expr->get_form() != stgform::constructor || !lf->argument_variables.empty()) {
+                for (auto it = lf->free_variables.begin(); it != lf->free_variables.end(); ) {
+                    if (globals.count(*it)) {
+                        it = lf->free_variables.erase(it);
+                    } else {
+                        it++;
+                    }
+                }
+            }
+            if (lf->expr->get_form() == stgform::application) {
+                auto application = static_cast<STGApplication*>(lf->expr.get());
+                auto local = local_number_of_arguments.find(application->lhs);
+                size_t arity = local != local_number_of_arguments.end() && !local->second.empty()
+                        ? local->second.back()
+                        : number_of_arguments.at(application->lhs);
+                if (application->arguments.size() < arity) {
+                    lf->updatable = false;
+                }
+            }
+            std::vector<std::pair<Symbol, size_t>> names;
+            for (const auto &v: lf->argument_variables) {
+                names.emplace_back(v, 0);
             }
-            remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-                    e,
-                    globals,
-                    local_number_of_arguments,
-                    used_data_constructors);
+            scoped(to_visit, names, visit_expression(lf->expr.get()));
+            continue;
         }
-    } else if (expr->get_form() == stgform::constructor) {
-        used_data_constructors.insert(dynamic_cast<STGConstructor*>(expr.get())->constructor_name);
-    }
-}
 
-void remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-        const std::unique_ptr<STGLambdaForm> &lambda_form,
-        const std::set<std::string> &globals,
-        const std::map<std::string, size_t> &number_of_arguments,
-        std::set<std::string> &used_data_constructors) {
-    if (lambda_form->expr->get_form() != stgform::constructor || !lambda_form->argument_variables.empty()) {
-        for (auto it = lambda_form->free_variables.begin(); it != lambda_form->free_variables.end(); ) {
-            if (globals.count(*it)) {
-                it = lambda_form->free_variables.erase(it);
-            } else {
-                it++;
+        if (visit.expression == nullptr) {
+            for (const auto &[name, arity]: visit.names) {
+                if (visit.bind) {
+                    local_number_of_arguments[name].push_back(arity);
+                } else {
+                    local_number_of_arguments[name].pop_back();
+                }
             }
+            continue;
         }
-    }
-    if (lambda_form->expr->get_form() == stgform::application) {
-        auto application = dynamic_cast<STGApplication*>(lambda_form->expr.get());
-        if (application->arguments.size() < number_of_arguments.at(application->lhs)) {
-            lambda_form->updatable = false;
+
+        const STGExpression *expr = visit.expression;
+        if (expr->get_form() == stgform::let) {
+            auto let = static_cast<const STGLet*>(expr);
+            std::vector<std::pair<Symbol, size_t>> names;
+            for (const auto &[name, lambda_form]: let->bindings) {
+                names.emplace_back(name, lambda_form->argument_variables.size());
+            }
+            to_visit.push_back({nullptr, nullptr, names, false});
+            for (const auto &[_, lambda_form]: let->bindings) {
+                to_visit.push_back(visit_lambda_form(lambda_form.get()));
+            }
+            to_visit.push_back(visit_expression(let->expr.get()));
+            to_visit.push_back({nullptr, nullptr, names, true});
+        } else if (expr->get_form() == stgform::letnoescape) {
+            auto join_point = static_cast<const STGLetNoEscape*>(expr);
+            std::vector<std::pair<Symbol, size_t>> names;
+            for (const auto &v: join_point->arguments) {
+                names.emplace_back(v, 0);
+            }
+            scoped(to_visit, names, visit_expression(join_point->rhs.get()));
+            to_visit.push_back(visit_expression(join_point->expr.get()));
+        } else if (expr->get_form() == stgform::literalcase) {
+            auto cAsE = static_cast<const STGLiteralCase*>(expr);
+            to_visit.push_back(visit_expression(cAsE->expr.get()));
+            to_visit.push_back(visit_expression(cAsE->default_expr.get()));
+            for (const auto &[_, e]: cAsE->alts) {
+                to_visit.push_back(visit_expression(e.get()));
+            }
+        } else if (expr->get_form() == stgform::algebraiccase) {
+            auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+            to_visit.push_back(visit_expression(cAsE->expr.get()));
+            to_visit.push_back(visit_expression(cAsE->default_expr.get()));
+            for (const auto &[p, e]: cAsE->alts) {
+                used_data_constructors.insert(p.constructor_name);
+                std::vector<std::pair<Symbol, size_t>> names;
+                for (const auto &v: p.variables) {
+                    names.emplace_back(v, 0);
+                }
+                scoped(to_visit, names, visit_expression(e.get()));
+            }
+        } else if (expr->get_form() == stgform::constructor) {
+            used_data_constructors.insert(static_cast<const STGConstructor*>(expr)->constructor_name);
+        } else if (
+                expr->get_form() == stgform::literal &&
+                std::holds_alternative<std::string>(static_cast<const STGLiteral*>(expr)->value)) {
+            used_data_constructors.insert(Symbol("[]"));
+            used_data_constructors.insert(Symbol(":"));
+            string_literals = true;
         }
     }
+}
 
-    std::map<std::string, size_t> local_number_of_arguments = number_of_arguments;
-
-    for (const auto &v: lambda_form->argument_variables) {
-        local_number_of_arguments[v] = 0;
+// Counts a lambda form along with those bound by the lets within it.
+size_t count_lambda_forms(const std::unique_ptr<STGLambdaForm> &lambda_form) {
+    size_t count = 1;
+    std::vector<const STGExpression*> to_visit = {lambda_form->expr.get()};
+    while (!to_visit.empty()) {
+        const STGExpression *expr = to_visit.back();
+        to_visit.pop_back();
+        switch(expr->get_form()) {
+            case stgform::let:
+                count += static_cast<const STGLet*>(expr)->bindings.size();
+                for (const auto &[_, bound]: static_cast<const STGLet*>(expr)->bindings) {
+                    to_visit.push_back(bound->expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLet*>(expr)->expr.get());
+                break;
+            case stgform::letnoescape:
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->rhs.get());
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->expr.get());
+                break;
+            case stgform::literalcase:
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->default_expr.get());
+                break;
+            case stgform::algebraiccase:
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->default_expr.get());
+                break;
+            default:
+                break;
+        }
     }
-
-    remove_globals_from_free_variables_list_and_mark_partial_applications_as_non_updatable_and_collect_used_data_constructors(
-            lambda_form->expr,
-            globals,
-            local_number_of_arguments,
-            used_data_constructors);
+    return count;
 }
 
-std::unique_ptr<STGProgram> translate(const std::unique_ptr<Program> &program) {
-    std::map<std::string, std::unique_ptr<STGLambdaForm>> bindings;
-    unsigned long next_variable_name = 0;
+std::unique_ptr<STGProgram> translate(
+        const std::unique_ptr<Program> &program,
+        const std::vector<Symbol> &roots,
+        const std::unordered_set<Symbol> &external,
+        std::set<Symbol, SpellingOrder> &used_external,
+        CompileStatistics *statistics,
+        ColumnHeuristic column_heuristic) {
+    std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+    NameSupply name_supply{program->module_name == Symbol("Main") ? "" : program->module_name.str()};
+    DataConstructors constructors{program->data_constructor_arities, {}, column_heuristic};
+    for (const auto &[_, type_constructor]: program->type_constructors) {
+        for (const auto &name: type_constructor->data_constructors) {
+            constructors.type_sizes[name] = type_constructor->data_constructors.size();
+        }
+    }
 
     for (const auto &[name, expr]: program->bindings) {
+        ScopedMap<Symbol> variable_renamings;
         auto translated = translate_expression(
                 expr,
-                &next_variable_name,
-                std::map<std::string, std::string>(),
-                program->data_constructor_arities);
+                &name_supply,
+                variable_renamings,
+                constructors);
 
         bindings[name] = std::move(translated.first);
+        if (program->types.count(name) > 0) {
+            bindings[name]->type = program->types.at(name);
+        }
 
         auto definitions = std::move(translated.second);
+        std::vector<Symbol> lifted;
         for (auto &definition: definitions) {
             for (auto &[n, lambda_form]: definition) {
                 bindings[n] = std::move(lambda_form);
+                lifted.push_back(n);
             }
         }
+        if (statistics != nullptr) {
+            statistics->add_lifted_definitions(name, lifted);
+        }
     }
 
-    std::map<std::string, size_t> number_of_arguments;
-    std::set<std::string> globals;
+    std::unordered_map<Symbol, size_t> number_of_arguments;
+    std::unordered_set<Symbol> globals;
     for (const auto &[name, lambda_form]: bindings) {
         number_of_arguments[name] = lambda_form->argument_variables.size();
         globals.insert(name);
     }
+    for (const auto &[name, arity]: program->imported_arities) {
+        number_of_arguments[name] = arity;
+        globals.insert(name);
+    }
 
-    std::map<std::string, std::unique_ptr<STGLambdaForm>> used_bindings;
-    std::vector<std::string> to_add = {"main"};
-    std::set<std::string> used_data_constructors;
+    std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> used_bindings;
+    std::vector<Symbol> to_add = roots;
+    std::set<Symbol, SpellingOrder> used_data_constructors;
+    bool string_literals = false;
 
     while (!to_add.empty()) {
-        std::string name = to_add.back();
+        Symbol name = to_add.back();
         to_add.pop_back();
         auto lambda_form = std::move(bindings.at(name));
         for (const auto &depends_on: lambda_form->free_variables) {
-            if (
+            if (external.count(depends_on) > 0) {
+                used_external.insert(depends_on);
+            } else if (
                     used_bindings.count(depends_on) == 0 &&
                     std::count(to_add.begin(), to_add.end(), depends_on) == 0 &&
                     depends_on != name &&
@@ -1072,24 +1521,28 @@ std::unique_ptr<STGProgram> translate(const std::unique_ptr<Program> &program) {
                 lambda_form,
                 globals,
                 number_of_arguments,
-                used_data_constructors);
+                used_data_constructors,
+                string_literals);
+        if (statistics != nullptr) {
+            statistics->add_closures(name, count_lambda_forms(lambda_form));
+        }
         used_bindings[name] = std::move(lambda_form);
     }
 
-    std::map<std::string, STGDataConstructor> data_constructors;
+    std::map<Symbol, STGDataConstructor, SpellingOrder> data_constructors;
 
     for (const auto &[_, type_constructor]: program->type_constructors) {
         for (unsigned int i = 0; i < type_constructor->data_constructors.size(); i++) {
-            std::string name = type_constructor->data_constructors.at(i);
+            Symbol name = type_constructor->data_constructors.at(i);
             if (used_data_constructors.count(name)) {
                 size_t tag = i;
-                if (name == "[]") {
+                if (name == Symbol("[]")) {
                     tag = 0;
-                } else if (name == ":") {
+                } else if (name == Symbol(":")) {
                     tag = 1;
-                } else if (name == "False") {
+                } else if (name == Symbol("False")) {
                     tag = 0;
-                } else if (name == "True") {
+                } else if (name == Symbol("True")) {
                     tag = 1;
                 }
                 size_t arity = program->data_constructor_arities.at(name);
@@ -1101,5 +1554,23 @@ std::unique_ptr<STGProgram> translate(const std::unique_ptr<Program> &program) {
 
     return std::make_unique<STGProgram>(
             std::move(used_bindings),
-            data_constructors);
+            data_constructors,
+            string_literals);
+}
+
+std::unique_ptr<STGProgram> translate(
+        const std::unique_ptr<Program> &program,
+        CompileStatistics *statistics,
+        ColumnHeuristic column_heuristic) {
+    std::set<Symbol, SpellingOrder> used_external;
+    return translate(program, {Symbol("main")}, {}, used_external, statistics, column_heuristic);
+}
+
+std::pair<std::vector<const STGLet*>, const STGExpression*> let_chain(const STGExpression *expr) {
+    std::vector<const STGLet*> chain;
+    while (expr->get_form() == stgform::let) {
+        chain.push_back(static_cast<const STGLet*>(expr));
+        expr = chain.back()->expr.get();
+    }
+    return {chain, expr};
 }
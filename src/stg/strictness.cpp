@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "stg/strictness.hpp"
+#include "types/type_check.hpp"
+#include "types/types.hpp"
+
+// The variables that evaluating an expression is certain to evaluate; one that is certain to fail evaluates all.
+struct Demand {
+    bool fails = false;
+    std::set<Symbol> variables;
+
+    bool includes(const Symbol &name) const {
+        return fails || variables.count(name) > 0;
+    }
+
+    void add(const Demand &other) {
+        fails = fails || other.fails;
+        variables.insert(other.variables.begin(), other.variables.end());
+    }
+
+    void remove(const std::vector<Symbol> &names) {
+        for (const auto &name: names) {
+            variables.erase(name);
+        }
+    }
+};
+
+// What is certain to be evaluated when either of two expressions is, but it is not known which.
+static Demand either(const Demand &a, const Demand &b) {
+    if (a.fails) {
+        return b;
+    }
+    if (b.fails) {
+        return a;
+    }
+    Demand demand;
+    std::set_intersection(
+            a.variables.begin(), a.variables.end(),
+            b.variables.begin(), b.variables.end(),
+            std::inserter(demand.variables, demand.variables.end()));
+    return demand;
+}
+
+static const Symbol case_error("case_error");
+
+// How a case takes apart a value of a type, if it can.
+enum class CaseKind {none, literal, algebraic};
+
+static CaseKind case_kind(const std::shared_ptr<Type> &type) {
+    if (type == nullptr) {
+        return CaseKind::none;
+    }
+    std::shared_ptr<Type> head = follow_substitution(type);
+    while (head->get_form() == typeform::application) {
+        head = follow_substitution(static_cast<TypeApplication*>(head.get())->left);
+    }
+    if (head->get_form() != typeform::constructor) {
+        return CaseKind::none;
+    }
+    if (is_literal_type(head)) {
+        return CaseKind::literal;
+    }
+    return split_function_type(type) ? CaseKind::none : CaseKind::algebraic;
+}
+
+class StrictnessAnalysis {
+public:
+    explicit StrictnessAnalysis(const STGProgram &program): program(program) {}
+
+    // Analyses the top-level functions after those they call, each group of functions that call each other together.
+    void analyse() {
+        std::vector<Symbol> names;
+        std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> dependencies;
+        for (const auto &[name, lambda_form]: program.bindings) {
+            names.push_back(name);
+            std::set<Symbol, SpellingOrder> &calls = dependencies[name];
+            std::vector<const STGExpression*> to_visit = {lambda_form->expr.get()};
+            while (!to_visit.empty()) {
+                const STGExpression *expr = to_visit.back();
+                to_visit.pop_back();
+                switch (expr->get_form()) {
+                    case stgform::variable:
+                        calls.insert(static_cast<const STGVariable*>(expr)->name);
+                        break;
+                    case stgform::application:
+                        calls.insert(static_cast<const STGApplication*>(expr)->lhs);
+                        break;
+                    case stgform::let:
+                        for (const auto &[_, bound]: static_cast<const STGLet*>(expr)->bindings) {
+                            to_visit.push_back(bound->expr.get());
+                        }
+                        to_visit.push_back(static_cast<const STGLet*>(expr)->expr.get());
+                        break;
+                    case stgform::letnoescape:
+                        to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->rhs.get());
+                        to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->expr.get());
+                        break;
+                    case stgform::literalcase:
+                        to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->expr.get());
+                        for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(expr)->alts) {
+                            to_visit.push_back(alt_expr.get());
+                        }
+                        to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->default_expr.get());
+                        break;
+                    case stgform::algebraiccase:
+                        to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->expr.get());
+                        for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(expr)->alts) {
+                            to_visit.push_back(alt_expr.get());
+                        }
+                        to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->default_expr.get());
+                        break;
+                    default:
+                        break;
+                }
+            }
+            for (auto it = calls.begin(); it != calls.end(); ) {
+                it = program.bindings.count(*it) > 0 ? std::next(it) : calls.erase(it);
+            }
+        }
+
+        for (const auto &group: dependency_analysis(names, dependencies)) {
+            std::vector<std::pair<Symbol, const STGLambdaForm*>> functions;
+            for (const auto &name: group) {
+                if (!program.bindings.at(name)->argument_variables.empty()) {
+                    functions.emplace_back(name, program.bindings.at(name).get());
+                }
+            }
+            analyse_functions(functions, group.size() > 1 || dependencies.at(group[0]).count(group[0]) > 0);
+        }
+        for (const auto &[name, lambda_form]: program.bindings) {
+            if (!lambda_form->argument_variables.empty()) {
+                lambda_form->strict_arguments = signatures.at(name);
+            }
+        }
+    }
+
+    // Evaluates the thunks that are certain to be evaluated where they are bound, in every top-level binding.
+    void transform() {
+        remember = true;
+        for (const auto &[_, lambda_form]: program.bindings) {
+            lambda_form->expr = transform(lambda_form->expr.get());
+            demands.clear();
+        }
+    }
+
+private:
+    const STGProgram &program;
+    // Whether each function analysed so far, top-level or local, is certain to evaluate each of its arguments.
+    std::unordered_map<Symbol, std::vector<bool>> signatures;
+    // The arguments of each join point, and what entering it is certain to evaluate.
+    std::unordered_map<Symbol, std::pair<std::vector<Symbol>, Demand>> join_points;
+    // The demands worked out for the binding being transformed, once the signatures are final.
+    bool remember = false;
+    std::unordered_map<const STGExpression*, Demand> demands;
+
+    std::vector<bool> signature_of(const STGLambdaForm *lambda_form) {
+        Demand demand = demand_of(lambda_form->expr.get());
+        std::vector<bool> signature;
+        for (const auto &argument: lambda_form->argument_variables) {
+            signature.push_back(demand.includes(argument));
+        }
+        return signature;
+    }
+
+    // Weakens the signatures of functions that may call each other from strict in every argument until they agree.
+    void analyse_functions(const std::vector<std::pair<Symbol, const STGLambdaForm*>> &functions, bool recursive) {
+        if (!recursive) {
+            for (const auto &[name, lambda_form]: functions) {
+                signatures[name] = signature_of(lambda_form);
+            }
+            return;
+        }
+        for (const auto &[name, lambda_form]: functions) {
+            signatures[name] = std::vector<bool>(lambda_form->argument_variables.size(), true);
+        }
+        bool remembered = remember;
+        remember = false;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const auto &[name, lambda_form]: functions) {
+                std::vector<bool> signature = signature_of(lambda_form);
+                if (signature != signatures.at(name)) {
+                    signatures[name] = signature;
+                    changed = true;
+                }
+            }
+        }
+        remember = remembered;
+    }
+
+    void analyse_let(const STGLet *let) {
+        std::vector<std::pair<Symbol, const STGLambdaForm*>> functions;
+        for (const auto &[name, lambda_form]: let->bindings) {
+            if (!lambda_form->argument_variables.empty()) {
+                functions.emplace_back(name, lambda_form.get());
+            }
+        }
+        analyse_functions(functions, let->recursive);
+    }
+
+    // Adds what evaluating the thunks bound by the let that the demand includes is certain to evaluate in turn.
+    Demand force(const Demand &demand, const STGLet *let) {
+        Demand forced = demand;
+        std::vector<Symbol> to_force;
+        for (const auto &[name, _]: let->bindings) {
+            if (demand.variables.count(name) > 0) {
+                to_force.push_back(name);
+            }
+        }
+        while (!to_force.empty() && !forced.fails) {
+            const auto &lambda_form = let->bindings.at(to_force.back());
+            to_force.pop_back();
+            if (!lambda_form->argument_variables.empty() || !lambda_form->updatable) {
+                continue;
+            }
+            Demand evaluated = demand_of(lambda_form->expr.get());
+            forced.fails = evaluated.fails;
+            for (const auto &variable: evaluated.variables) {
+                if (forced.variables.insert(variable).second && let->bindings.count(variable) > 0) {
+                    to_force.push_back(variable);
+                }
+            }
+        }
+        return forced;
+    }
+
+    Demand call(const Symbol &function, const std::vector<Symbol> &arguments) {
+        auto join_point = join_points.find(function);
+        if (join_point != join_points.end()) {
+            const auto &[parameters, entered] = join_point->second;
+            Demand demand = entered;
+            demand.remove(parameters);
+            for (size_t i = 0; i < parameters.size(); i++) {
+                if (entered.variables.count(parameters[i]) > 0) {
+                    demand.variables.insert(arguments[i]);
+                }
+            }
+            return demand;
+        }
+        Demand demand;
+        demand.variables.insert(function);
+        auto signature = signatures.find(function);
+        if (signature != signatures.end() && arguments.size() >= signature->second.size()) {
+            for (size_t i = 0; i < signature->second.size(); i++) {
+                if (signature->second[i]) {
+                    demand.variables.insert(arguments[i]);
+                }
+            }
+        }
+        return demand;
+    }
+
+    Demand demand_of(const STGExpression *expr) {
+        if (remember) {
+            auto found = demands.find(expr);
+            if (found != demands.end()) {
+                return found->second;
+            }
+        }
+        Demand demand = compute_demand(expr);
+        if (remember) {
+            demands.emplace(expr, demand);
+        }
+        return demand;
+    }
+
+    Demand compute_demand(const STGExpression *expr) {
+        Demand demand;
+        switch (expr->get_form()) {
+            case stgform::literal:
+            case stgform::constructor:
+                break;
+            case stgform::variable: {
+                Symbol name = static_cast<const STGVariable*>(expr)->name;
+                if (name == case_error) {
+                    demand.fails = true;
+                } else {
+                    demand = call(name, {});
+                }
+                break;
+            }
+            case stgform::application:
+                demand = call(
+                        static_cast<const STGApplication*>(expr)->lhs,
+                        static_cast<const STGApplication*>(expr)->arguments);
+                break;
+            case stgform::primitiveop: {
+                auto op = static_cast<const STGPrimitiveOp*>(expr);
+                if (!op->left.empty()) {
+                    demand.variables.insert(op->left);
+                }
+                demand.variables.insert(op->right);
+                break;
+            }
+            case stgform::let: {
+                auto [chain, body] = let_chain(expr);
+                for (const STGLet *let: chain) {
+                    analyse_let(let);
+                }
+                demand = demand_of(body);
+                for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+                    demand = force(demand, *it);
+                    for (const auto &[name, _]: (*it)->bindings) {
+                        demand.variables.erase(name);
+                    }
+                }
+                break;
+            }
+            case stgform::letnoescape: {
+                auto join_point = static_cast<const STGLetNoEscape*>(expr);
+                join_points[join_point->name] = {join_point->arguments, demand_of(join_point->rhs.get())};
+                demand = demand_of(join_point->expr.get());
+                break;
+            }
+            case stgform::literalcase: {
+                auto cAsE = static_cast<const STGLiteralCase*>(expr);
+                Demand alternatives = demand_of(cAsE->default_expr.get());
+                alternatives.remove({cAsE->default_var});
+                for (const auto &[_, alt_expr]: cAsE->alts) {
+                    alternatives = either(alternatives, demand_of(alt_expr.get()));
+                }
+                demand = demand_of(cAsE->expr.get());
+                demand.add(alternatives);
+                break;
+            }
+            case stgform::algebraiccase: {
+                auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+                Demand alternatives = demand_of(cAsE->default_expr.get());
+                alternatives.remove({cAsE->default_var});
+                for (const auto &[pattern, alt_expr]: cAsE->alts) {
+                    Demand alternative = demand_of(alt_expr.get());
+                    alternative.remove(pattern.variables);
+                    alternatives = either(alternatives, alternative);
+                }
+                demand = demand_of(cAsE->expr.get());
+                demand.add(alternatives);
+                break;
+            }
+        }
+        return demand;
+    }
+
+    std::unique_ptr<STGLambdaForm> transform(const Symbol &name, const STGLambdaForm *lambda_form) {
+        auto transformed = std::make_unique<STGLambdaForm>(
+                lambda_form->free_variables,
+                lambda_form->argument_variables,
+                lambda_form->updatable,
+                transform(lambda_form->expr.get()));
+        transformed->type = lambda_form->type;
+        if (!lambda_form->argument_variables.empty()) {
+            transformed->strict_arguments = signatures.at(name);
+        }
+        return transformed;
+    }
+
+    std::unique_ptr<STGExpression> transform(const STGExpression *expr) {
+        switch (expr->get_form()) {
+            case stgform::let:
+                return transform_let(static_cast<const STGLet*>(expr));
+            case stgform::letnoescape: {
+                auto join_point = static_cast<const STGLetNoEscape*>(expr);
+                // Jumps to the join point are only understood once it has been analysed.
+                demand_of(join_point);
+                auto rhs = transform(join_point->rhs.get());
+                return std::make_unique<STGLetNoEscape>(
+                        join_point->name,
+                        join_point->arguments,
+                        std::move(rhs),
+                        transform(join_point->expr.get()));
+            }
+            case stgform::literal:
+                return std::make_unique<STGLiteral>(static_cast<const STGLiteral*>(expr)->value);
+            case stgform::variable:
+                return std::make_unique<STGVariable>(static_cast<const STGVariable*>(expr)->name);
+            case stgform::application:
+                return std::make_unique<STGApplication>(
+                        static_cast<const STGApplication*>(expr)->lhs,
+                        static_cast<const STGApplication*>(expr)->arguments);
+            case stgform::constructor:
+                return std::make_unique<STGConstructor>(
+                        static_cast<const STGConstructor*>(expr)->constructor_name,
+                        static_cast<const STGConstructor*>(expr)->arguments);
+            case stgform::primitiveop: {
+                auto op = static_cast<const STGPrimitiveOp*>(expr);
+                return std::make_unique<STGPrimitiveOp>(op->left, op->right, op->op);
+            }
+            case stgform::literalcase: {
+                auto cAsE = static_cast<const STGLiteralCase*>(expr);
+                std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
+                for (const auto &[literal, alt_expr]: cAsE->alts) {
+                    alts.emplace_back(literal, transform(alt_expr.get()));
+                }
+                auto scrutinee = transform(cAsE->expr.get());
+                return std::make_unique<STGLiteralCase>(
+                        std::move(scrutinee),
+                        std::move(alts),
+                        cAsE->default_var,
+                        transform(cAsE->default_expr.get()));
+            }
+            case stgform::algebraiccase: {
+                auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+                std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
+                for (const auto &[pattern, alt_expr]: cAsE->alts) {
+                    alts.emplace_back(pattern, transform(alt_expr.get()));
+                }
+                auto scrutinee = transform(cAsE->expr.get());
+                return std::make_unique<STGAlgebraicCase>(
+                        std::move(scrutinee),
+                        std::move(alts),
+                        cAsE->default_var,
+                        transform(cAsE->default_expr.get()));
+            }
+        }
+        return nullptr;
+    }
+
+    std::unique_ptr<STGExpression> transform_let(const STGLet *first) {
+        auto [chain, body] = let_chain(first);
+        for (const STGLet *let: chain) {
+            analyse_let(let);
+        }
+        // What the body of each let in the chain is certain to evaluate.
+        std::vector<Demand> demands_of_bodies(chain.size());
+        Demand demand = demand_of(body);
+        for (size_t i = chain.size(); i-- > 0; ) {
+            demands_of_bodies[i] = demand;
+            demand = force(demand, chain[i]);
+            for (const auto &[name, _]: chain[i]->bindings) {
+                demand.variables.erase(name);
+            }
+        }
+
+        std::unique_ptr<STGExpression> result = transform(body);
+        for (size_t i = chain.size(); i-- > 0; ) {
+            const STGLet *let = chain[i];
+            Demand forced = force(demands_of_bodies[i], let);
+            std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+            std::vector<std::pair<Symbol, const STGLambdaForm*>> evaluated;
+            for (const auto &[name, lambda_form]: let->bindings) {
+                if (!let->recursive &&
+                        !forced.fails &&
+                        forced.variables.count(name) > 0 &&
+                        lambda_form->argument_variables.empty() &&
+                        lambda_form->updatable &&
+                        case_kind(lambda_form->type) != CaseKind::none) {
+                    evaluated.emplace_back(name, lambda_form.get());
+                } else {
+                    bindings[name] = transform(name, lambda_form.get());
+                }
+            }
+            if (!bindings.empty()) {
+                result = std::make_unique<STGLet>(std::move(bindings), std::move(result), let->recursive);
+            }
+            for (const auto &[name, lambda_form]: evaluated) {
+                auto scrutinee = transform(lambda_form->expr.get());
+                if (case_kind(lambda_form->type) == CaseKind::literal) {
+                    result = std::make_unique<STGLiteralCase>(
+                            std::move(scrutinee),
+                            std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>>(),
+                            name,
+                            std::move(result));
+                } else {
+                    result = std::make_unique<STGAlgebraicCase>(
+                            std::move(scrutinee),
+                            std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>>(),
+                            name,
+                            std::move(result));
+                }
+            }
+        }
+        return result;
+    }
+};
+
+void evaluate_strict_thunks(const std::unique_ptr<STGProgram> &program) {
+    StrictnessAnalysis analysis(*program);
+    analysis.analyse();
+    analysis.transform();
+}
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "stg/worker_wrapper.hpp"
+#include "types/types.hpp"
+
+// The types of the parameters and result of a function of arity arguments, or none if its type is not known.
+static std::vector<std::shared_ptr<Type>> parameter_types(std::shared_ptr<Type> type, size_t arity) {
+    std::vector<std::shared_ptr<Type>> types;
+    if (type == nullptr) {
+        return types;
+    }
+    for (size_t i = 0; i < arity; i++) {
+        auto split = split_function_type(type);
+        if (!split) {
+            return {};
+        }
+        types.push_back(split->first);
+        type = split->second;
+    }
+    types.push_back(type);
+    return types;
+}
+
+// A case that evaluates a variable or a call of a worker and binds the boxed value to bound.
+static std::unique_ptr<STGExpression> evaluate(
+        std::unique_ptr<STGExpression> &&scrutinee,
+        const Symbol &bound,
+        std::unique_ptr<STGExpression> &&expr) {
+    return std::make_unique<STGLiteralCase>(
+            std::move(scrutinee),
+            std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>>(),
+            bound,
+            std::move(expr));
+}
+
+// Whether an expression refers to a variable, itself or in the free variables of a lambda form it binds.
+static bool uses(const STGExpression *expr, const Symbol &name) {
+    std::vector<const STGExpression*> to_visit = {expr};
+    while (!to_visit.empty()) {
+        expr = to_visit.back();
+        to_visit.pop_back();
+        switch (expr->get_form()) {
+            case stgform::let:
+                for (const auto &[_, lambda_form]: static_cast<const STGLet*>(expr)->bindings) {
+                    if (lambda_form->free_variables.count(name) > 0) {
+                        return true;
+                    }
+                }
+                to_visit.push_back(static_cast<const STGLet*>(expr)->expr.get());
+                break;
+            case stgform::letnoescape:
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->rhs.get());
+                to_visit.push_back(static_cast<const STGLetNoEscape*>(expr)->expr.get());
+                break;
+            case stgform::literal:
+                break;
+            case stgform::variable:
+                if (static_cast<const STGVariable*>(expr)->name == name) {
+                    return true;
+                }
+                break;
+            case stgform::application: {
+                auto application = static_cast<const STGApplication*>(expr);
+                const auto &arguments = application->arguments;
+                if (application->lhs == name ||
+                        std::find(arguments.begin(), arguments.end(), name) != arguments.end()) {
+                    return true;
+                }
+                break;
+            }
+            case stgform::constructor: {
+                const auto &arguments = static_cast<const STGConstructor*>(expr)->arguments;
+                if (std::find(arguments.begin(), arguments.end(), name) != arguments.end()) {
+                    return true;
+                }
+                break;
+            }
+            case stgform::primitiveop: {
+                auto op = static_cast<const STGPrimitiveOp*>(expr);
+                if (op->left == name || op->right == name) {
+                    return true;
+                }
+                break;
+            }
+            case stgform::literalcase:
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGLiteralCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGLiteralCase*>(expr)->default_expr.get());
+                break;
+            case stgform::algebraiccase:
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->expr.get());
+                for (const auto &[_, alt_expr]: static_cast<const STGAlgebraicCase*>(expr)->alts) {
+                    to_visit.push_back(alt_expr.get());
+                }
+                to_visit.push_back(static_cast<const STGAlgebraicCase*>(expr)->default_expr.get());
+                break;
+        }
+    }
+    return false;
+}
+
+class WorkerWrapper {
+public:
+    WorkerWrapper(STGProgram &program, const Symbol &module_name):
+            program(program),
+            prefix(module_name == Symbol("Main") ? "" : module_name.str()) {}
+
+    void split() {
+        std::vector<Symbol> functions;
+        for (const auto &[name, lambda_form]: program.bindings) {
+            if (lambda_form->argument_variables.empty() ||
+                    lambda_form->strict_arguments.size() != lambda_form->argument_variables.size()) {
+                continue;
+            }
+            auto types = parameter_types(lambda_form->type, lambda_form->argument_variables.size());
+            if (types.empty()) {
+                continue;
+            }
+            bool unboxed = lambda_form->unboxed_result = is_literal_type(types.back());
+            lambda_form->unboxed_arguments.clear();
+            for (size_t i = 0; i < lambda_form->argument_variables.size(); i++) {
+                lambda_form->unboxed_arguments.push_back(lambda_form->strict_arguments[i] && is_literal_type(types[i]));
+                unboxed = unboxed || lambda_form->unboxed_arguments.back();
+            }
+            if (unboxed) {
+                functions.push_back(name);
+            } else {
+                lambda_form->unboxed_arguments.clear();
+                lambda_form->unboxed_result = false;
+            }
+        }
+
+        // The wrapper keeps the function's name; the worker takes its body and new names for unboxed arguments.
+        for (const Symbol &name: functions) {
+            Symbol worker_name(name.str() + ".worker");
+            workers[name] = worker_name;
+            std::unique_ptr<STGLambdaForm> function = std::move(program.bindings.at(name));
+            std::vector<Symbol> arguments = function->argument_variables;
+            for (size_t i = 0; i < arguments.size(); i++) {
+                if (function->unboxed_arguments[i]) {
+                    arguments[i] = fresh_name();
+                }
+            }
+            std::unique_ptr<STGExpression> expr = std::make_unique<STGApplication>(worker_name, arguments);
+            if (function->unboxed_result) {
+                Symbol result = fresh_name();
+                expr = evaluate(std::move(expr), result, std::make_unique<STGVariable>(result));
+            }
+            for (size_t i = arguments.size(); i-- > 0; ) {
+                if (function->unboxed_arguments[i]) {
+                    expr = evaluate(
+                            std::make_unique<STGVariable>(function->argument_variables[i]),
+                            arguments[i],
+                            std::move(expr));
+                }
+            }
+            auto wrapper = std::make_unique<STGLambdaForm>(
+                    function->free_variables,
+                    function->argument_variables,
+                    false,
+                    std::move(expr));
+            wrapper->type = function->type;
+            wrapper->strict_arguments = function->strict_arguments;
+
+            std::vector<Symbol> worker_arguments = function->argument_variables;
+            for (size_t i = 0; i < worker_arguments.size(); i++) {
+                if (function->unboxed_arguments[i]) {
+                    worker_arguments[i] = fresh_name();
+                    unboxed_arguments[worker_name].emplace_back(function->argument_variables[i], worker_arguments[i]);
+                }
+            }
+            auto worker = std::make_unique<STGLambdaForm>(
+                    function->free_variables,
+                    worker_arguments,
+                    function->updatable,
+                    std::move(function->expr));
+            worker->type = function->type;
+            worker->strict_arguments = function->strict_arguments;
+            worker->unboxed_arguments = function->unboxed_arguments;
+            worker->unboxed_result = function->unboxed_result;
+            program.bindings[name] = std::move(wrapper);
+            program.bindings[worker_name] = std::move(worker);
+        }
+
+        if (workers.empty()) {
+            return;
+        }
+        for (const auto &[name, lambda_form]: program.bindings) {
+            if (workers.count(name) > 0) {
+                continue;
+            }
+            std::vector<std::pair<Symbol, Symbol>> arguments;
+            auto found = unboxed_arguments.find(name);
+            if (found != unboxed_arguments.end()) {
+                arguments = found->second;
+            }
+            unboxed.insert(arguments.begin(), arguments.end());
+            lambda_form->expr = rewrite(lambda_form->expr.get(), lambda_form->unboxed_result);
+            unboxed.clear();
+            evaluated.clear();
+
+            // The body refers to an argument by its old name where it needs it boxed, so it is boxed for it.
+            for (auto it = arguments.rbegin(); it != arguments.rend(); it++) {
+                if (uses(lambda_form->expr.get(), it->first)) {
+                    lambda_form->expr = evaluate(
+                            std::make_unique<STGVariable>(it->second),
+                            it->first,
+                            std::move(lambda_form->expr));
+                }
+            }
+        }
+    }
+
+private:
+    STGProgram &program;
+    const std::string prefix;
+    size_t next = 0;
+    // The worker of each function that has been split.
+    std::map<Symbol, Symbol> workers;
+    // The names each worker's body has for the arguments it takes unboxed, with the names the worker takes them by.
+    std::map<Symbol, std::vector<std::pair<Symbol, Symbol>>> unboxed_arguments;
+    // The variables in scope known to be bound to evaluated Ints and Chars.
+    std::set<Symbol> evaluated;
+    // The unboxed values of the variables in scope that have them.
+    std::map<Symbol, Symbol> unboxed;
+
+    Symbol fresh_name() {
+        return Symbol(prefix + ".u" + std::to_string(next++));
+    }
+
+    // The value of a variable where a primitive operation or a literal case takes it: its unboxed value if it has one.
+    Symbol value_of(const Symbol &name) const {
+        auto found = unboxed.find(name);
+        return found != unboxed.end() ? found->second : name;
+    }
+
+    std::unique_ptr<STGLambdaForm> rewrite(const STGLambdaForm *lambda_form) {
+        std::set<Symbol> outer;
+        std::map<Symbol, Symbol> outer_unboxed;
+        std::swap(outer, evaluated);
+        std::swap(outer_unboxed, unboxed);
+        auto rewritten = std::make_unique<STGLambdaForm>(
+                lambda_form->free_variables,
+                lambda_form->argument_variables,
+                lambda_form->updatable,
+                rewrite(lambda_form->expr.get(), false));
+        std::swap(outer, evaluated);
+        std::swap(outer_unboxed, unboxed);
+        rewritten->type = lambda_form->type;
+        rewritten->strict_arguments = lambda_form->strict_arguments;
+        return rewritten;
+    }
+
+    // Rewrites a saturated call of a split function to call its worker with the arguments it takes unboxed.
+    std::unique_ptr<STGExpression> rewrite_call(const STGApplication *application, bool returns_unboxed) {
+        auto worker = workers.find(application->lhs);
+        if (worker == workers.end() ||
+                program.bindings.at(worker->second)->argument_variables.size() != application->arguments.size()) {
+            return std::make_unique<STGApplication>(application->lhs, application->arguments);
+        }
+        const auto &lambda_form = program.bindings.at(worker->second);
+        std::vector<Symbol> arguments = application->arguments;
+        std::vector<std::pair<Symbol, Symbol>> to_evaluate;
+        std::map<Symbol, Symbol> evaluating;
+        for (size_t i = 0; i < arguments.size(); i++) {
+            if (!lambda_form->unboxed_arguments[i]) {
+                continue;
+            }
+            if (unboxed.count(arguments[i]) > 0) {
+                arguments[i] = unboxed.at(arguments[i]);
+                continue;
+            }
+            if (evaluated.count(arguments[i]) > 0) {
+                continue;
+            }
+            auto [bound, added] = evaluating.try_emplace(arguments[i], Symbol());
+            if (added) {
+                bound->second = fresh_name();
+                to_evaluate.emplace_back(arguments[i], bound->second);
+            }
+            arguments[i] = bound->second;
+        }
+        std::unique_ptr<STGExpression> expr = std::make_unique<STGApplication>(worker->second, arguments);
+        if (lambda_form->unboxed_result && !returns_unboxed) {
+            Symbol result = fresh_name();
+            expr = evaluate(std::move(expr), result, std::make_unique<STGVariable>(result));
+        }
+        for (auto it = to_evaluate.rbegin(); it != to_evaluate.rend(); it++) {
+            expr = evaluate(std::make_unique<STGVariable>(it->first), it->second, std::move(expr));
+        }
+        return expr;
+    }
+
+    // returns_unboxed is whether the value of the expression is returned unboxed in R5.
+    std::unique_ptr<STGExpression> rewrite(const STGExpression *expr, bool returns_unboxed) {
+        switch (expr->get_form()) {
+            case stgform::let: {
+                auto [chain, body] = let_chain(expr);
+                std::unique_ptr<STGExpression> result = rewrite(body, returns_unboxed);
+                for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+                    std::map<Symbol, std::unique_ptr<STGLambdaForm>, SpellingOrder> bindings;
+                    for (const auto &[name, lambda_form]: (*it)->bindings) {
+                        bindings[name] = rewrite(lambda_form.get());
+                    }
+                    result = std::make_unique<STGLet>(std::move(bindings), std::move(result), (*it)->recursive);
+                }
+                return result;
+            }
+            case stgform::letnoescape: {
+                auto join_point = static_cast<const STGLetNoEscape*>(expr);
+                auto rhs = rewrite(join_point->rhs.get(), returns_unboxed);
+                return std::make_unique<STGLetNoEscape>(
+                        join_point->name,
+                        join_point->arguments,
+                        std::move(rhs),
+                        rewrite(join_point->expr.get(), returns_unboxed));
+            }
+            case stgform::literal:
+                return std::make_unique<STGLiteral>(static_cast<const STGLiteral*>(expr)->value);
+            case stgform::variable:
+                return std::make_unique<STGVariable>(static_cast<const STGVariable*>(expr)->name);
+            case stgform::application:
+                return rewrite_call(static_cast<const STGApplication*>(expr), returns_unboxed);
+            case stgform::constructor:
+                return std::make_unique<STGConstructor>(
+                        static_cast<const STGConstructor*>(expr)->constructor_name,
+                        static_cast<const STGConstructor*>(expr)->arguments);
+            case stgform::primitiveop: {
+                auto op = static_cast<const STGPrimitiveOp*>(expr);
+                return std::make_unique<STGPrimitiveOp>(
+                        op->left.empty() ? op->left : value_of(op->left),
+                        value_of(op->right),
+                        op->op);
+            }
+            case stgform::literalcase: {
+                auto cAsE = static_cast<const STGLiteralCase*>(expr);
+                std::unique_ptr<STGExpression> scrutinee;
+                Symbol value;
+                if (cAsE->expr->get_form() == stgform::variable) {
+                    Symbol name = static_cast<const STGVariable*>(cAsE->expr.get())->name;
+                    auto found = unboxed.find(name);
+                    if (found != unboxed.end()) {
+                        value = found->second;
+                    }
+                    scrutinee = std::make_unique<STGVariable>(value_of(name));
+                } else {
+                    scrutinee = rewrite(cAsE->expr.get(), true);
+                }
+                std::vector<std::pair<STGLiteral, std::unique_ptr<STGExpression>>> alts;
+                for (const auto &[literal, alt_expr]: cAsE->alts) {
+                    alts.emplace_back(literal, rewrite(alt_expr.get(), returns_unboxed));
+                }
+                // The variable the case binds shares the unboxed value of the one it takes apart.
+                bool bound = evaluated.insert(cAsE->default_var).second;
+                bool has_value = !value.empty() &&
+                        !cAsE->default_var.empty() &&
+                        unboxed.emplace(cAsE->default_var, value).second;
+                auto default_expr = rewrite(cAsE->default_expr.get(), returns_unboxed);
+                if (bound) {
+                    evaluated.erase(cAsE->default_var);
+                }
+                if (has_value) {
+                    unboxed.erase(cAsE->default_var);
+                }
+                return std::make_unique<STGLiteralCase>(
+                        std::move(scrutinee),
+                        std::move(alts),
+                        cAsE->default_var,
+                        std::move(default_expr));
+            }
+            case stgform::algebraiccase: {
+                auto cAsE = static_cast<const STGAlgebraicCase*>(expr);
+                auto scrutinee = rewrite(cAsE->expr.get(), true);
+                std::vector<std::pair<STGPattern, std::unique_ptr<STGExpression>>> alts;
+                for (const auto &[pattern, alt_expr]: cAsE->alts) {
+                    alts.emplace_back(pattern, rewrite(alt_expr.get(), returns_unboxed));
+                }
+                return std::make_unique<STGAlgebraicCase>(
+                        std::move(scrutinee),
+                        std::move(alts),
+                        cAsE->default_var,
+                        rewrite(cAsE->default_expr.get(), returns_unboxed));
+            }
+        }
+        return nullptr;
+    }
+};
+
+void split_workers(const std::unique_ptr<STGProgram> &program, const Symbol &module_name) {
+    WorkerWrapper(*program, module_name).split();
+}
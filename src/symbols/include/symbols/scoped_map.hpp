@@ -0,0 +1,88 @@
+#ifndef PICOHASKELL_SCOPED_MAP_HPP
+#define PICOHASKELL_SCOPED_MAP_HPP
+
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "symbols/symbol.hpp"
+
+// A map from names to values that passes extend as they enter the scope of a binding and restore as they leave it,
+// such as the assumptions of type inference. Binding a name inside a scope remembers the value it shadows, and the
+// scope puts those values back in reverse order when it ends, so entering and leaving a scope costs one step per name
+// bound in it rather than a copy of the whole map.
+template <typename V>
+class ScopedMap {
+public:
+    ScopedMap() = default;
+    // Starts out with the names of another map, which must outlive this one and not change while it is in use. This
+    // lets several threads extend the same map at once.
+    explicit ScopedMap(const ScopedMap *outer): outer(outer) {}
+
+    size_t count(const Symbol &name) const {
+        return find(name) != nullptr;
+    }
+
+    const V &at(const Symbol &name) const {
+        const V *value = find(name);
+        if (value == nullptr) {
+            throw std::out_of_range("ScopedMap::at: " + name.str());
+        }
+        return *value;
+    }
+
+    void bind(const Symbol &name, V value) {
+        auto found = values.find(name);
+        if (scopes > 0) {
+            undo.emplace_back(
+                    name,
+                    found != values.end() ? std::optional<V>(std::move(found->second)) : std::nullopt);
+        }
+        if (found != values.end()) {
+            found->second = std::move(value);
+        } else {
+            values.emplace(name, std::move(value));
+        }
+    }
+
+    // Undoes the bindings made while it exists when it is destroyed, including when an exception leaves the scope.
+    class Scope {
+    public:
+        explicit Scope(ScopedMap &map): map(map), mark(map.undo.size()) { map.scopes++; }
+        ~Scope() {
+            while (map.undo.size() > mark) {
+                auto &[name, value] = map.undo.back();
+                if (value) {
+                    map.values[name] = std::move(*value);
+                } else {
+                    map.values.erase(name);
+                }
+                map.undo.pop_back();
+            }
+            map.scopes--;
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        ScopedMap &map;
+        const size_t mark;
+    };
+
+private:
+    const V *find(const Symbol &name) const {
+        auto found = values.find(name);
+        if (found != values.end()) {
+            return &found->second;
+        }
+        return outer != nullptr ? outer->find(name) : nullptr;
+    }
+
+    const ScopedMap *outer = nullptr;
+    std::unordered_map<Symbol, V> values;
+    std::vector<std::pair<Symbol, std::optional<V>>> undo;
+    size_t scopes = 0;
+};
+
+#endif //PICOHASKELL_SCOPED_MAP_HPP
@@ -0,0 +1,48 @@
+#ifndef PICOHASKELL_SYMBOL_HPP
+#define PICOHASKELL_SYMBOL_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// A name interned in the global symbol table, so that copying, hashing, comparing and ordering are integer operations.
+// Ordering by ID depends on the order in which names were interned, which varies with the order threads reach them, so
+// ordered containers whose order of iteration reaches the output use SpellingOrder instead. Interning takes the symbol
+// table's lock, so a symbol is never made from a literal without saying so.
+class Symbol {
+public:
+    Symbol(): id(0) {}
+    explicit Symbol(std::string_view name): id(intern(name)) {}
+    Symbol(const std::string &name): Symbol(std::string_view(name)) {}
+    explicit Symbol(const char *name): Symbol(std::string_view(name)) {}
+
+    uint32_t get_id() const { return id; }
+    const std::string &str() const;
+    bool empty() const { return id == 0; }
+
+    friend bool operator==(const Symbol &a, const Symbol &b) { return a.id == b.id; }
+    friend bool operator!=(const Symbol &a, const Symbol &b) { return a.id != b.id; }
+    friend bool operator<(const Symbol &a, const Symbol &b) { return a.id < b.id; }
+    friend std::ostream &operator<<(std::ostream &s, const Symbol &symbol) { return s << symbol.str(); }
+
+private:
+    static uint32_t intern(std::string_view name);
+    uint32_t id;
+};
+
+// Orders symbols by spelling, as plain strings were ordered, for containers whose order of iteration decides the
+// generated code, the interface and snapshot files, cache keys, reports or the order in which fresh names are made.
+struct SpellingOrder {
+    bool operator()(const Symbol &a, const Symbol &b) const { return a.get_id() != b.get_id() && a.str() < b.str(); }
+};
+
+namespace std {
+    template<>
+    struct hash<Symbol> {
+        size_t operator()(const Symbol &symbol) const noexcept { return symbol.get_id(); }
+    };
+}
+
+#endif //PICOHASKELL_SYMBOL_HPP
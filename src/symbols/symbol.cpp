@@ -0,0 +1,61 @@
+#include <array>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include "symbols/symbol.hpp"
+
+namespace {
+    // Spellings are stored in fixed-size chunks that never move, so str() can read them without locking:
+    // a thread can only hold a symbol's ID after the chunk holding its spelling has been written.
+    constexpr uint32_t chunk_bits = 16;
+    constexpr uint32_t chunk_size = 1 << chunk_bits;
+    constexpr uint32_t maximum_chunks = 1 << 10;
+
+    struct SymbolTable {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::array<std::unique_ptr<std::string[]>, maximum_chunks> spellings;
+        uint32_t size = 0;
+
+        SymbolTable() { intern(""); }
+
+        uint32_t intern(std::string_view name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = ids.find(name);
+            if (it != ids.end()) {
+                return it->second;
+            }
+            uint32_t id = size;
+            if ((id >> chunk_bits) >= maximum_chunks) {
+                throw std::length_error("Too many distinct names.");
+            }
+            auto &chunk = spellings[id >> chunk_bits];
+            if (!chunk) {
+                chunk = std::make_unique<std::string[]>(chunk_size);
+            }
+            std::string &spelling = chunk[id & (chunk_size - 1)];
+            spelling = name;
+            ids.emplace(spelling, id);
+            size++;
+            return id;
+        }
+
+        const std::string &spelling(uint32_t id) const {
+            return spellings[id >> chunk_bits][id & (chunk_size - 1)];
+        }
+    };
+
+    SymbolTable &table() {
+        static SymbolTable symbol_table;
+        return symbol_table;
+    }
+}
+
+uint32_t Symbol::intern(std::string_view name) {
+    return table().intern(name);
+}
+
+const std::string &Symbol::str() const {
+    return table().spelling(id);
+}
@@ -0,0 +1,55 @@
+#ifndef PICOHASKELL_TYPE_CACHE_HPP
+#define PICOHASKELL_TYPE_CACHE_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "parser/syntax.hpp"
+#include "symbols/scoped_map.hpp"
+#include "types/types.hpp"
+
+// Type schemes inferred for groups of top-level bindings, kept in files in a directory so that later runs of the
+// compiler can load them instead of inferring them again. A group is described by its definitions and type signatures
+// together with the type schemes of every name it refers to and the kinds of the type constructors its signatures use,
+// so it is only found again while neither it nor anything it depends on has changed. Files are named by a hash of the
+// description and hold the description as well, which is compared on loading, so that groups whose descriptions hash
+// to the same value are never mistaken for each other.
+class TypeCache {
+public:
+    explicit TypeCache(std::string directory);
+
+    static std::string describe(
+            const std::vector<Symbol> &names,
+            const std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> &declarations,
+            const std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> &type_signatures,
+            const ScopedMap<std::shared_ptr<Type>> &assumptions,
+            const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds);
+
+    // Returns the type schemes of the names, in the same order, and counts a hit or a miss. A file that cannot be
+    // read, that was stored for another description, or that does not hold a scheme for exactly those names, counts
+    // as a miss.
+    std::optional<std::vector<std::shared_ptr<Type>>> load(
+            const std::string &description,
+            const std::vector<Symbol> &names);
+    // Types that have not been fully inferred are not stored.
+    void store(
+            const std::string &description,
+            const std::vector<Symbol> &names,
+            const std::vector<std::shared_ptr<Type>> &schemes);
+
+    // Groups of bindings are looked up on several threads at once, so the counts are atomic.
+    std::atomic<size_t> hits = 0;
+    std::atomic<size_t> misses = 0;
+
+private:
+    std::string directory;
+
+    std::string path(const std::string &description) const;
+};
+
+#endif //PICOHASKELL_TYPE_CACHE_HPP
@@ -2,12 +2,23 @@
 #define PICOHASKELL_TYPE_CHECK_HPP
 
 #include <memory>
+#include <unordered_map>
 #include "types/types.hpp"
 
-void type_check(const std::unique_ptr<Program> &program, bool check_for_main);
-std::vector<std::vector<std::string>> dependency_analysis(
-        std::vector<std::string> names,
-        const std::map<std::string, std::set<std::string>> &dependencies);
-std::set<std::string> find_free_variables(const std::unique_ptr<Expression> &exp);
+class TypeCache;
+class CompileStatistics;
+
+// Infers the types of the program's bindings and checks them against their signatures. Top-level binding groups
+// whose types are in the cache, if one is given, are not inferred again. The cost of inferring each top-level binding
+// is recorded in the statistics, if they are given.
+void type_check(
+        const std::unique_ptr<Program> &program,
+        bool check_for_main,
+        TypeCache *cache = nullptr,
+        CompileStatistics *statistics = nullptr);
+std::vector<std::vector<Symbol>> dependency_analysis(
+        const std::vector<Symbol> &names,
+        const std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> &dependencies);
+std::set<Symbol, SpellingOrder> find_free_variables(const std::unique_ptr<Expression> &exp);
 
 #endif //PICOHASKELL_TYPE_CHECK_HPP
@@ -1,57 +1,120 @@
 #ifndef PICOHASKELL_TYPES_HPP
 #define PICOHASKELL_TYPES_HPP
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <map>
+#include <optional>
 #include <set>
 #include <utility>
 #include <vector>
 #include <stdexcept>
+#include "arena/arena.hpp"
+#include "symbols/symbol.hpp"
+#include "statistics/statistics.hpp"
 
 enum class typeform {variable, universallyquantifiedvariable, constructor, application};
+enum class kindform {star, arrow, variable};
 
 class TypeError : public std::runtime_error {
 public:
     explicit TypeError(const std::string &s): std::runtime_error(s) {}
 };
 
-struct Type {
+// The form of a type is stored in the node itself, so passes can switch on it and static_cast to the matching
+// subclass without any RTTI.
+struct Type : public ArenaAllocated {
+    const typeform form;
+    // Set on the single shared copy of a type without any variables, see hash_cons.
+    bool hash_consed = false;
+    explicit Type(const typeform &form): form(form) {}
     virtual ~Type() = default;
-    virtual typeform get_form() const = 0;
+    typeform get_form() const { return form; }
 };
 
 struct UniversallyQuantifiedVariable : public Type {
-    const std::string id;
-    explicit UniversallyQuantifiedVariable(std::string id): id(std::move(id)) {}
-    typeform get_form() const override { return typeform::universallyquantifiedvariable; }
+    const Symbol id;
+    explicit UniversallyQuantifiedVariable(Symbol id): Type(typeform::universallyquantifiedvariable), id(id) {}
 };
 
 struct TypeConstructor : public Type {
-    const std::string id;
-    explicit TypeConstructor(std::string id): id(std::move(id)) {}
-    typeform get_form() const override { return typeform::constructor; }
+    const Symbol id;
+    explicit TypeConstructor(Symbol id): Type(typeform::constructor), id(id) {}
 };
 
 struct TypeApplication : public Type {
     const std::shared_ptr<Type> left;
     const std::shared_ptr<Type> right;
-    TypeApplication(Type* const &left, Type* const &right): left(left), right(right) {}
+    TypeApplication(Type* const &left, Type* const &right): Type(typeform::application), left(left), right(right) {}
     TypeApplication(
             std::shared_ptr<Type> left,
-            std::shared_ptr<Type> right): left(std::move(left)), right(std::move(right)) {}
-    typeform get_form() const override { return typeform::application; }
+            std::shared_ptr<Type> right): Type(typeform::application), left(std::move(left)), right(std::move(right)) {}
 };
 
+// Type and kind variables form union-find forests: a bound variable points towards the type it stands for, and the
+// rank bounds the height of the tree of variables bound to an unbound one, so that the shorter tree is put under
+// the taller one when two are unified.
+// The level of a type variable is the number of enclosing declaration groups whose types were being inferred when
+// it was created, lowered whenever it is unified with a type from an outer group. A group's type variables can be
+// generalised exactly when their level is still deeper than the group's.
 struct TypeVariable : public Type {
     std::shared_ptr<Type> bound_to;
-    std::string id;
-    TypeVariable() { static int i = 0; id = std::to_string(i++); }
-    typeform get_form() const override { return typeform::variable; }
+    unsigned int rank = 0;
+    unsigned int level;
+    unsigned int id;
+    // Modules may be type checked on several threads at once, so the ids are drawn from an atomic counter.
+    explicit TypeVariable(unsigned int level): Type(typeform::variable), level(level) {
+        static std::atomic<unsigned int> i = 0;
+        id = i++;
+        inference_counters.type_variables++;
+    }
 };
 
-Type *make_function_type(Type* const &argType, Type* const &resultType);
-Type *make_list_type(Type* const &elementType);
-Type *make_tuple_type(const std::vector<Type*> &components);
+struct Kind {
+    const kindform form;
+    explicit Kind(const kindform &form): form(form) {}
+    virtual ~Kind() = default;
+    kindform get_form() const { return form; }
+};
+
+struct StarKind : public Kind {
+    StarKind(): Kind(kindform::star) {}
+};
+
+struct ArrowKind : public Kind {
+    const std::shared_ptr<Kind> left;
+    const std::shared_ptr<Kind> right;
+    ArrowKind(
+            const std::shared_ptr<Kind> &left,
+            const std::shared_ptr<Kind> &right): Kind(kindform::arrow), left(left), right(right) {}
+};
+
+struct KindVariable : public Kind {
+    std::shared_ptr<Kind> bound_to;
+    unsigned int rank = 0;
+    KindVariable(): Kind(kindform::variable) {}
+};
+
+Type *make_function_type(Arena &arena, Type* const &argType, Type* const &resultType);
+std::shared_ptr<Type> make_function_type(std::shared_ptr<Type> argType, std::shared_ptr<Type> resultType);
+Type *make_list_type(Arena &arena, Type* const &elementType);
+Type *make_tuple_type(Arena &arena, const std::vector<Type*> &components);
+
+std::shared_ptr<Type> follow_substitution(std::shared_ptr<Type> t);
+// Splits a function type into the types of its argument and result, if it is known to be one.
+std::optional<std::pair<std::shared_ptr<Type>, std::shared_ptr<Type>>> split_function_type(
+        const std::shared_ptr<Type> &t);
+// Whether a type is known to be Int or Char, whose values are literals.
+bool is_literal_type(const std::shared_ptr<Type> &t);
+
+// Types without any variables are hash-consed: there is only ever one copy of each, allocated from an arena that
+// lives as long as the program, so two such types are equal exactly when they are the same pointer. These build
+// types from their parts, sharing the existing copy whenever the parts are hash-consed themselves.
+std::shared_ptr<Type> make_type_constructor(Symbol id);
+std::shared_ptr<Type> make_type_application(std::shared_ptr<Type> left, std::shared_ptr<Type> right);
+std::shared_ptr<Type> make_universally_quantified_variable(Symbol id);
+// Returns the shared copy of each part of a type that has no variables once its bound type variables are followed.
+std::shared_ptr<Type> hash_cons(const std::shared_ptr<Type> &t);
 
 #endif //PICOHASKELL_TYPES_HPP
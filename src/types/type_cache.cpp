@@ -0,0 +1,386 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+#include <variant>
+#include "types/type_cache.hpp"
+
+// Changed whenever the format of the descriptions or of the files changes, so that old files are never read.
+static const char *const magic = "picohaskell type cache 2\n";
+
+static uint64_t hash_description(std::string_view description) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char &c: description) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static void write_bytes(std::string &output, std::string_view bytes) {
+    output += std::to_string(bytes.size()) + ":";
+    output += bytes;
+}
+
+static void write_symbol(std::string &output, const Symbol &symbol) {
+    write_bytes(output, symbol.str());
+}
+
+// Writes a type in prefix form, which the files use as well. Returns false if it has type variables that are still
+// unbound, which are written, but differently on every run.
+static bool write_type(std::string &output, std::shared_ptr<Type> type) {
+    type = follow_substitution(type);
+    switch(type->get_form()) {
+        case typeform::variable:
+            output += "?" + std::to_string(static_cast<TypeVariable*>(type.get())->id) + ";";
+            return false;
+        case typeform::universallyquantifiedvariable:
+            output += "V";
+            write_symbol(output, static_cast<UniversallyQuantifiedVariable*>(type.get())->id);
+            return true;
+        case typeform::constructor:
+            output += "C";
+            write_symbol(output, static_cast<TypeConstructor*>(type.get())->id);
+            return true;
+        case typeform::application:
+            output += "@";
+            return write_type(output, static_cast<TypeApplication*>(type.get())->left) &&
+                   write_type(output, static_cast<TypeApplication*>(type.get())->right);
+    }
+}
+
+static std::optional<std::string_view> read_bytes(std::string_view input, size_t &position) {
+    size_t colon = input.find(':', position);
+    if (colon == std::string_view::npos || colon == position) {
+        return std::nullopt;
+    }
+    size_t length = 0;
+    for (size_t i = position; i < colon; i++) {
+        if (input[i] < '0' || input[i] > '9') {
+            return std::nullopt;
+        }
+        length = length * 10 + (input[i] - '0');
+    }
+    if (length > input.size() - colon - 1) {
+        return std::nullopt;
+    }
+    position = colon + 1 + length;
+    return input.substr(colon + 1, length);
+}
+
+static std::optional<Symbol> read_symbol(std::string_view input, size_t &position) {
+    std::optional<std::string_view> bytes = read_bytes(input, position);
+    if (!bytes) {
+        return std::nullopt;
+    }
+    return Symbol(*bytes);
+}
+
+static std::shared_ptr<Type> read_type(std::string_view input, size_t &position) {
+    if (position >= input.size()) {
+        return nullptr;
+    }
+    char form = input[position++];
+    if (form == '@') {
+        std::shared_ptr<Type> left = read_type(input, position);
+        std::shared_ptr<Type> right = left != nullptr ? read_type(input, position) : nullptr;
+        return right != nullptr ? make_type_application(left, right) : nullptr;
+    } else if (form == 'C' || form == 'V') {
+        std::optional<Symbol> name = read_symbol(input, position);
+        if (!name) {
+            return nullptr;
+        }
+        return form == 'C' ? make_type_constructor(*name) : make_universally_quantified_variable(*name);
+    }
+    return nullptr;
+}
+
+static void write_kind(std::string &output, const std::shared_ptr<Kind> &kind) {
+    switch(kind->get_form()) {
+        case kindform::star:
+            output += "*";
+            break;
+        case kindform::arrow:
+            output += ">";
+            write_kind(output, static_cast<ArrowKind*>(kind.get())->left);
+            write_kind(output, static_cast<ArrowKind*>(kind.get())->right);
+            break;
+        case kindform::variable:
+            output += "?";
+            break;
+    }
+}
+
+static void find_type_constructors(
+        const std::shared_ptr<Type> &type,
+        std::set<Symbol, SpellingOrder> &type_constructors) {
+    if (type->get_form() == typeform::constructor) {
+        type_constructors.insert(static_cast<TypeConstructor*>(type.get())->id);
+    } else if (type->get_form() == typeform::application) {
+        find_type_constructors(static_cast<TypeApplication*>(type.get())->left, type_constructors);
+        find_type_constructors(static_cast<TypeApplication*>(type.get())->right, type_constructors);
+    }
+}
+
+static void describe_literal(std::string &output, const std::variant<int, char> &value) {
+    if (std::holds_alternative<int>(value)) {
+        output += "i" + std::to_string(std::get<int>(value)) + ";";
+    } else {
+        output += "c";
+        output += std::get<char>(value);
+    }
+}
+
+// Writes the structure of an expression, in an order from which it could be read back, and collects every name it
+// refers to, whether or not it is bound inside the expression, and the type constructors its type signatures use.
+// Line numbers are left out, as they do not affect types. Long list literals nest deeply, so the expression is walked
+// with an explicit stack.
+static void describe_expression(
+        std::string &output,
+        std::set<Symbol, SpellingOrder> &names,
+        std::set<Symbol, SpellingOrder> &type_constructors,
+        const Expression *expression) {
+    std::vector<std::variant<const Expression*, const Pattern*>> to_describe = {expression};
+    while (!to_describe.empty()) {
+        auto next = to_describe.back();
+        to_describe.pop_back();
+        if (std::holds_alternative<const Pattern*>(next)) {
+            const Pattern *pattern = std::get<const Pattern*>(next);
+            output += static_cast<char>('A' + static_cast<int>(pattern->get_form()));
+            output += std::to_string(pattern->as.size()) + ";";
+            for (const Symbol &name: pattern->as) {
+                write_symbol(output, name);
+            }
+            switch(pattern->get_form()) {
+                case patternform::constructor: {
+                    auto constructor = static_cast<const ConstructorPattern*>(pattern);
+                    write_symbol(output, constructor->name);
+                    names.insert(constructor->name);
+                    output += std::to_string(constructor->args.size()) + ";";
+                    for (auto it = constructor->args.rbegin(); it != constructor->args.rend(); it++) {
+                        to_describe.emplace_back(it->get());
+                    }
+                    break;
+                }
+                case patternform::wild:
+                    break;
+                case patternform::literal:
+                    describe_literal(output, static_cast<const LiteralPattern*>(pattern)->value);
+                    break;
+                case patternform::variable:
+                    write_symbol(output, static_cast<const VariablePattern*>(pattern)->name);
+                    break;
+            }
+            continue;
+        }
+
+        const Expression *e = std::get<const Expression*>(next);
+        output += static_cast<char>('a' + static_cast<int>(e->get_form()));
+        switch(e->get_form()) {
+            case expform::variable:
+                write_symbol(output, static_cast<const Variable*>(e)->name);
+                names.insert(static_cast<const Variable*>(e)->name);
+                break;
+            case expform::constructor:
+                write_symbol(output, static_cast<const Constructor*>(e)->name);
+                names.insert(static_cast<const Constructor*>(e)->name);
+                break;
+            case expform::literal: {
+                const auto &value = static_cast<const Literal*>(e)->value;
+                if (std::holds_alternative<int>(value)) {
+                    describe_literal(output, std::get<int>(value));
+                } else if (std::holds_alternative<char>(value)) {
+                    describe_literal(output, std::get<char>(value));
+                } else {
+                    output += "s";
+                    write_bytes(output, std::get<std::string>(value));
+                }
+                break;
+            }
+            case expform::abstraction: {
+                auto abstraction = static_cast<const Abstraction*>(e);
+                output += std::to_string(abstraction->args.size()) + ";";
+                for (const Symbol &arg: abstraction->args) {
+                    write_symbol(output, arg);
+                }
+                to_describe.emplace_back(abstraction->body.get());
+                break;
+            }
+            case expform::application: {
+                auto application = static_cast<const Application*>(e);
+                output += std::to_string(application->arguments.size()) + ";";
+                for (auto it = application->arguments.rbegin(); it != application->arguments.rend(); it++) {
+                    to_describe.emplace_back(it->get());
+                }
+                to_describe.emplace_back(application->function.get());
+                break;
+            }
+            case expform::cAsE: {
+                auto cAsE = static_cast<const Case*>(e);
+                output += std::to_string(cAsE->alts.size()) + ";";
+                for (auto it = cAsE->alts.rbegin(); it != cAsE->alts.rend(); it++) {
+                    to_describe.emplace_back(it->second.get());
+                    to_describe.emplace_back(it->first.get());
+                }
+                to_describe.emplace_back(cAsE->exp.get());
+                break;
+            }
+            case expform::let: {
+                auto let = static_cast<const Let*>(e);
+                output += std::to_string(let->bindings.size()) + ";";
+                for (const auto &[name, _]: let->bindings) {
+                    write_symbol(output, name);
+                }
+                output += std::to_string(let->type_signatures.size()) + ";";
+                for (const auto &[name, type]: let->type_signatures) {
+                    write_symbol(output, name);
+                    write_type(output, type);
+                    find_type_constructors(type, type_constructors);
+                }
+                to_describe.emplace_back(let->e.get());
+                for (auto it = let->bindings.rbegin(); it != let->bindings.rend(); it++) {
+                    to_describe.emplace_back(it->second.get());
+                }
+                break;
+            }
+            case expform::builtinop: {
+                auto op = static_cast<const BuiltInOp*>(e);
+                output += static_cast<char>('a' + static_cast<int>(op->op));
+                to_describe.emplace_back(op->right.get());
+                if (op->op != builtinop::negate) {
+                    to_describe.emplace_back(op->left.get());
+                }
+                break;
+            }
+        }
+    }
+}
+
+TypeCache::TypeCache(std::string directory): directory(std::move(directory)) {
+    // If the directory cannot be created, nothing is found in the cache and storing fails quietly.
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+}
+
+std::string TypeCache::describe(
+        const std::vector<Symbol> &names,
+        const std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> &declarations,
+        const std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> &type_signatures,
+        const ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds) {
+    std::set<Symbol, SpellingOrder> group(names.begin(), names.end());
+    std::set<Symbol, SpellingOrder> referenced;
+    std::set<Symbol, SpellingOrder> type_constructors;
+    std::string description;
+    for (const Symbol &name: group) {
+        write_symbol(description, name);
+        describe_expression(description, referenced, type_constructors, declarations.at(name).get());
+        auto signature = type_signatures.find(name);
+        if (signature != type_signatures.end()) {
+            description += "s";
+            write_type(description, signature->second);
+        } else {
+            description += "n";
+        }
+    }
+    for (const Symbol &name: referenced) {
+        if (group.count(name) > 0) {
+            continue;
+        }
+        write_symbol(description, name);
+        if (assumptions.count(name) > 0) {
+            write_type(description, assumptions.at(name));
+        } else {
+            description += "-";
+        }
+    }
+    for (const Symbol &name: type_constructors) {
+        write_symbol(description, name);
+        auto kind = type_constructor_kinds.find(name);
+        if (kind != type_constructor_kinds.end()) {
+            write_kind(description, kind->second);
+        } else {
+            description += "-";
+        }
+    }
+    return description;
+}
+
+std::string TypeCache::path(const std::string &description) const {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash_description(description)));
+    return directory + "/" + name + ".types";
+}
+
+std::optional<std::vector<std::shared_ptr<Type>>> TypeCache::load(
+        const std::string &description,
+        const std::vector<Symbol> &names) {
+    std::ifstream file(path(description), std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string input = contents.str();
+
+    std::unordered_map<Symbol, std::shared_ptr<Type>> read;
+    bool ok = file && input.compare(0, std::string_view(magic).size(), magic) == 0;
+    size_t position = std::string_view(magic).size();
+    if (ok) {
+        std::optional<std::string_view> stored = read_bytes(input, position);
+        ok = stored && *stored == description && position < input.size() && input[position++] == '\n';
+    }
+    while (ok && position < input.size()) {
+        std::optional<Symbol> name = read_symbol(input, position);
+        std::shared_ptr<Type> type = name ? read_type(input, position) : nullptr;
+        ok = type != nullptr && position < input.size() && input[position++] == '\n';
+        if (ok) {
+            read[*name] = type;
+        }
+    }
+    std::vector<std::shared_ptr<Type>> schemes;
+    for (const Symbol &name: names) {
+        auto found = read.find(name);
+        ok = ok && found != read.end();
+        if (ok) {
+            schemes.push_back(found->second);
+        }
+    }
+    if (!ok || read.size() != names.size()) {
+        misses++;
+        return std::nullopt;
+    }
+    hits++;
+    return schemes;
+}
+
+void TypeCache::store(
+        const std::string &description,
+        const std::vector<Symbol> &names,
+        const std::vector<std::shared_ptr<Type>> &schemes) {
+    std::string output = magic;
+    write_bytes(output, description);
+    output += "\n";
+    for (size_t i = 0; i < names.size(); i++) {
+        write_symbol(output, names[i]);
+        if (!write_type(output, schemes[i])) {
+            return;
+        }
+        output += "\n";
+    }
+    // Written to a file of its own first and then renamed, so that other compilers using the same directory never
+    // read half of it.
+    std::string destination = path(description);
+    std::string temporary = destination + "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file << output;
+        if (!file) {
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    if (std::rename(temporary.c_str(), destination.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
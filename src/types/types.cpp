@@ -2,114 +2,287 @@
 #pragma ide diagnostic ignored "misc-no-recursion"
 #include "types/types.hpp"
 #include "parser/syntax.hpp"
+#include "types/type_check.hpp"
+#include "types/type_cache.hpp"
+#include "symbols/scoped_map.hpp"
 #include <string>
+#include <unordered_map>
 #include <algorithm>
-
-
-Type *make_function_type(Type* const &argType, Type* const &resultType) {
-    Type *partial = new TypeApplication(new TypeConstructor("->"), argType);
-    return new TypeApplication(partial, resultType);
+#include <cctype>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+
+
+Type *make_function_type(Arena &arena, Type* const &argType, Type* const &resultType) {
+    Type *partial = new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("->")), argType);
+    return new (arena) TypeApplication(partial, resultType);
 }
 
-Type *make_list_type(Type* const &elementType) {
-    return new TypeApplication(new TypeConstructor("[]"), elementType);
+Type *make_list_type(Arena &arena, Type* const &elementType) {
+    return new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("[]")), elementType);
 }
 
-Type *make_tuple_type(const std::vector<Type*> &components) {
+Type *make_tuple_type(Arena &arena, const std::vector<Type*> &components) {
     std::string constructor = "(" + std::string(components.size() - 1, ',') + ")";
-    Type *t = new TypeConstructor(constructor);
+    Type *t = new (arena) TypeConstructor(constructor);
     for (const auto &c: components) {
-        t = new TypeApplication(t, c);
+        t = new (arena) TypeApplication(t, c);
     }
     return t;
 }
 
-enum class kindform {star, arrow, variable};
-
-struct Kind {
-    virtual ~Kind() = default;
-    virtual kindform get_form() const = 0;
+namespace {
+struct TypeApplicationHash {
+    size_t operator()(const std::pair<const Type*, const Type*> &parts) const {
+        size_t left = std::hash<const Type*>()(parts.first);
+        return left ^ (std::hash<const Type*>()(parts.second) + 0x9e3779b97f4a7c15 + (left << 6) + (left >> 2));
+    }
 };
 
-struct StarKind : public Kind {
-    kindform get_form() const override { return kindform::star; }
+// Holds the only copy of every hash-consed type. Type checking runs on several threads at once, so it is guarded by
+// a mutex, which threads share while they only look types up and take in turn to add one. It is never destroyed, so
+// that types can still be used by destructors that run at exit.
+struct TypeStore {
+    std::shared_mutex mutex;
+    Arena arena;
+    std::unordered_map<Symbol, std::shared_ptr<Type>> constructors;
+    std::unordered_map<std::pair<const Type*, const Type*>, std::shared_ptr<Type>, TypeApplicationHash> applications;
 };
+}
 
-struct ArrowKind : public Kind {
-    const std::shared_ptr<Kind> left;
-    const std::shared_ptr<Kind> right;
-    kindform get_form() const override { return kindform::arrow; }
-    ArrowKind(
-            const std::shared_ptr<Kind> &left,
-            const std::shared_ptr<Kind> &right): left(left), right(right) {}
-};
+static TypeStore &type_store() {
+    static TypeStore *store = new TypeStore();
+    return *store;
+}
 
-struct KindVariable : public Kind {
-    std::shared_ptr<Kind> bound_to;
-    kindform get_form() const override { return kindform::variable; }
+std::shared_ptr<Type> make_type_constructor(Symbol id) {
+    TypeStore &store = type_store();
+    {
+        std::shared_lock<std::shared_mutex> lock(store.mutex);
+        auto found = store.constructors.find(id);
+        if (found != store.constructors.end()) {
+            return found->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(store.mutex);
+    std::shared_ptr<Type> &type = store.constructors[id];
+    if (type == nullptr) {
+        type = std::shared_ptr<Type>(new (store.arena) TypeConstructor(id));
+        type->hash_consed = true;
+    }
+    return type;
+}
+
+std::shared_ptr<Type> make_type_application(std::shared_ptr<Type> left, std::shared_ptr<Type> right) {
+    if (!left->hash_consed || !right->hash_consed) {
+        return std::make_shared<TypeApplication>(std::move(left), std::move(right));
+    }
+    TypeStore &store = type_store();
+    {
+        std::shared_lock<std::shared_mutex> lock(store.mutex);
+        auto found = store.applications.find({left.get(), right.get()});
+        if (found != store.applications.end()) {
+            return found->second;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(store.mutex);
+    std::shared_ptr<Type> &type = store.applications[{left.get(), right.get()}];
+    if (type == nullptr) {
+        type = std::shared_ptr<Type>(new (store.arena) TypeApplication(std::move(left), std::move(right)));
+        type->hash_consed = true;
+    }
+    return type;
+}
+
+// The type constructors inference uses most often, made once so that using them takes no lock, neither the type
+// store's nor the symbol table's to intern their names.
+struct FixedTypes {
+    const Symbol function_name{"->"};
+    const Symbol int_name{"Int"};
+    const Symbol char_name{"Char"};
+    const std::shared_ptr<Type> function = make_type_constructor(function_name);
+    const std::shared_ptr<Type> int_type = make_type_constructor(int_name);
+    const std::shared_ptr<Type> char_type = make_type_constructor(char_name);
+    const std::shared_ptr<Type> bool_type = make_type_constructor(Symbol("Bool"));
+    const std::shared_ptr<Type> string_type = make_type_application(make_type_constructor(Symbol("[]")), char_type);
 };
 
+static const FixedTypes &fixed_types() {
+    static const FixedTypes types;
+    return types;
+}
+
+std::shared_ptr<Type> make_function_type(std::shared_ptr<Type> argType, std::shared_ptr<Type> resultType) {
+    return make_type_application(
+            make_type_application(fixed_types().function, std::move(argType)),
+            std::move(resultType));
+}
+
+std::shared_ptr<Type> make_universally_quantified_variable(Symbol id) {
+    return std::make_shared<UniversallyQuantifiedVariable>(id);
+}
+
+// Finds the type a variable stands for, and points every variable on the way there directly at it, so that finding
+// it again takes a single step.
 std::shared_ptr<Type> follow_substitution(std::shared_ptr<Type> t) {
-    if (t->get_form() != typeform::variable) {
-        return t;
+    std::shared_ptr<Type> found = t;
+    while (found->get_form() == typeform::variable && static_cast<TypeVariable*>(found.get())->bound_to != nullptr) {
+        found = static_cast<TypeVariable*>(found.get())->bound_to;
     }
-    auto v = std::dynamic_pointer_cast<TypeVariable>(t);
-    if (v->bound_to == nullptr) {
-        return v;
+    while (t != found) {
+        auto variable = static_cast<TypeVariable*>(t.get());
+        std::shared_ptr<Type> next = std::move(variable->bound_to);
+        variable->bound_to = found;
+        t = std::move(next);
     }
-    return follow_substitution(v->bound_to);
+    return found;
 }
 
-bool occurs_check_ok(const std::shared_ptr<TypeVariable> &v, const std::shared_ptr<Type> &t) {
-    if (t == v) {
-        return false;
+std::shared_ptr<Type> hash_cons(const std::shared_ptr<Type> &t) {
+    std::shared_ptr<Type> type = follow_substitution(t);
+    if (type->hash_consed) {
+        return type;
     }
-    switch(t->get_form()) {
+    switch(type->get_form()) {
         case typeform::variable:
-            if (std::dynamic_pointer_cast<TypeVariable>(t)->bound_to == nullptr) {
-                return true;
-            }
-            return occurs_check_ok(v, std::dynamic_pointer_cast<TypeVariable>(t)->bound_to);
+        case typeform::universallyquantifiedvariable:
+            return type;
         case typeform::constructor:
-            return true;
+            return make_type_constructor(static_cast<TypeConstructor*>(type.get())->id);
         case typeform::application:
-            return occurs_check_ok(v, std::dynamic_pointer_cast<TypeApplication>(t)->left) &&
-                   occurs_check_ok(v, std::dynamic_pointer_cast<TypeApplication>(t)->right);
-        case typeform::universallyquantifiedvariable:
-            return true;
+            auto left = hash_cons(static_cast<TypeApplication*>(type.get())->left);
+            auto right = hash_cons(static_cast<TypeApplication*>(type.get())->right);
+            if (
+                    left != static_cast<TypeApplication*>(type.get())->left ||
+                    right != static_cast<TypeApplication*>(type.get())->right) {
+                return make_type_application(left, right);
+            } else {
+                return type;
+            }
+    }
+}
+
+// Binds the root of the shorter tree to the root of the taller one, which keeps the lower of the two levels.
+void unify_variables(
+        TypeVariable *a,
+        const std::shared_ptr<Type> &a_type,
+        TypeVariable *b,
+        const std::shared_ptr<Type> &b_type) {
+    if (a->rank < b->rank) {
+        b->level = std::min(a->level, b->level);
+        a->bound_to = b_type;
+    } else {
+        if (a->rank == b->rank) {
+            a->rank++;
+        }
+        a->level = std::min(a->level, b->level);
+        b->bound_to = a_type;
+    }
+}
+
+// Binds a variable to a type after checking that the variable does not occur in it. The variables in the type are
+// moved down to the level of the variable, so that they are not generalised while the variable is still in scope.
+bool bind_variable(TypeVariable *v, const std::shared_ptr<Type> &t) {
+    std::vector<Type*> to_visit = {t.get()};
+    while (!to_visit.empty()) {
+        Type *type = to_visit.back();
+        to_visit.pop_back();
+        if (type == v) {
+            return false;
+        }
+        switch(type->get_form()) {
+            case typeform::variable: {
+                auto variable = static_cast<TypeVariable*>(type);
+                if (variable->bound_to != nullptr) {
+                    to_visit.push_back(follow_substitution(variable->bound_to).get());
+                } else {
+                    variable->level = std::min(variable->level, v->level);
+                }
+                break;
+            }
+            case typeform::constructor:
+                break;
+            case typeform::application:
+                to_visit.push_back(static_cast<TypeApplication*>(type)->right.get());
+                to_visit.push_back(static_cast<TypeApplication*>(type)->left.get());
+                break;
+            case typeform::universallyquantifiedvariable:
+                break;
+        }
+    }
+    v->bound_to = t;
+    return true;
+}
+
+bool occurs_check_ok(const TypeVariable *v, const std::shared_ptr<Type> &t) {
+    std::vector<const Type*> to_visit = {t.get()};
+    while (!to_visit.empty()) {
+        const Type *type = to_visit.back();
+        to_visit.pop_back();
+        if (type == v) {
+            return false;
+        }
+        switch(type->get_form()) {
+            case typeform::variable:
+                if (static_cast<const TypeVariable*>(type)->bound_to != nullptr) {
+                    to_visit.push_back(follow_substitution(static_cast<const TypeVariable*>(type)->bound_to).get());
+                }
+                break;
+            case typeform::constructor:
+                break;
+            case typeform::application:
+                to_visit.push_back(static_cast<const TypeApplication*>(type)->right.get());
+                to_visit.push_back(static_cast<const TypeApplication*>(type)->left.get());
+                break;
+            case typeform::universallyquantifiedvariable:
+                break;
+        }
     }
+    return true;
 }
 
 void unify(std::shared_ptr<Type> a, std::shared_ptr<Type> b) {
+    inference_counters.unifications++;
     a = follow_substitution(a);
     b = follow_substitution(b);
     if (a == b) {
         return;
     }
+    // Different hash-consed types never unify, whatever their size.
+    if (a->hash_consed && b->hash_consed) {
+        throw TypeError("Failed to unify types.");
+    }
     if (
             a->get_form() == typeform::constructor &&
             b->get_form() == typeform::constructor &&
-            std::dynamic_pointer_cast<TypeConstructor>(a)->id == std::dynamic_pointer_cast<TypeConstructor>(b)->id) {
+            static_cast<TypeConstructor*>(a.get())->id == static_cast<TypeConstructor*>(b.get())->id) {
+        return;
+    } else if (a->get_form() == typeform::variable && b->get_form() == typeform::variable) {
+        unify_variables(static_cast<TypeVariable*>(a.get()), a, static_cast<TypeVariable*>(b.get()), b);
         return;
     } else if (a->get_form() == typeform::variable) {
-        if (!occurs_check_ok(std::dynamic_pointer_cast<TypeVariable>(a), b)) {
+        if (!bind_variable(static_cast<TypeVariable*>(a.get()), b)) {
             throw TypeError("Failed to unify types: occurs check failed.");
         }
-        std::dynamic_pointer_cast<TypeVariable>(a)->bound_to = b;
         return;
     } else if (b->get_form() == typeform::variable) {
-        if (!occurs_check_ok(std::dynamic_pointer_cast<TypeVariable>(b), a)) {
+        if (!bind_variable(static_cast<TypeVariable*>(b.get()), a)) {
             throw TypeError("Failed to unify types: occurs check failed.");
         }
-        std::dynamic_pointer_cast<TypeVariable>(b)->bound_to = a;
         return;
     } else if (a->get_form() == typeform::application && b->get_form() == typeform::application) {
         unify(
-                std::dynamic_pointer_cast<TypeApplication>(a)->left,
-                std::dynamic_pointer_cast<TypeApplication>(b)->left);
+                static_cast<TypeApplication*>(a.get())->left,
+                static_cast<TypeApplication*>(b.get())->left);
         unify(
-                std::dynamic_pointer_cast<TypeApplication>(a)->right,
-                std::dynamic_pointer_cast<TypeApplication>(b)->right);
+                static_cast<TypeApplication*>(a.get())->right,
+                static_cast<TypeApplication*>(b.get())->right);
         return;
     }
 
@@ -118,26 +291,30 @@ void unify(std::shared_ptr<Type> a, std::shared_ptr<Type> b) {
 
 std::shared_ptr<Type> instantiate(
         const std::shared_ptr<Type> &t,
-        std::map<std::string, std::shared_ptr<Type>> &variables) {
+        std::unordered_map<Symbol, std::shared_ptr<Type>> &variables,
+        unsigned int level) {
+    if (t->hash_consed) {
+        return t;
+    }
     switch(t->get_form()) {
         case typeform::variable:
             return t;
         case typeform::universallyquantifiedvariable: {
-            const std::string name = std::dynamic_pointer_cast<UniversallyQuantifiedVariable>(t)->id;
+            const Symbol name = static_cast<UniversallyQuantifiedVariable*>(t.get())->id;
             if (variables.count(name) == 0) {
-                variables[name] = std::make_shared<TypeVariable>();
+                variables[name] = std::make_shared<TypeVariable>(level);
             }
             return variables.at(name);
         }
         case typeform::constructor:
             return t;
         case typeform::application: {
-            auto left = instantiate(std::dynamic_pointer_cast<TypeApplication>(t)->left, variables);
-            auto right = instantiate(std::dynamic_pointer_cast<TypeApplication>(t)->right, variables);
+            auto left = instantiate(static_cast<TypeApplication*>(t.get())->left, variables, level);
+            auto right = instantiate(static_cast<TypeApplication*>(t.get())->right, variables, level);
             if (
-                    left != std::dynamic_pointer_cast<TypeApplication>(t)->left ||
-                    right != std::dynamic_pointer_cast<TypeApplication>(t)->right) {
-                return std::make_shared<TypeApplication>(left, right);
+                    left != static_cast<TypeApplication*>(t.get())->left ||
+                    right != static_cast<TypeApplication*>(t.get())->right) {
+                return make_type_application(left, right);
             } else {
                 return t;
             }
@@ -145,40 +322,76 @@ std::shared_ptr<Type> instantiate(
     }
 }
 
-std::shared_ptr<Type> instantiate(const std::shared_ptr<Type> &t) {
-    std::map<std::string, std::shared_ptr<Type>> variables;
-    return instantiate(t, variables);
+std::shared_ptr<Type> instantiate(const std::shared_ptr<Type> &t, unsigned int level) {
+    std::unordered_map<Symbol, std::shared_ptr<Type>> variables;
+    return instantiate(t, variables, level);
 }
 
+// Replaces the variables of a type signature by type constructors of the same names, which only unify with
+// themselves, so that a binding checked against the signature has to work whatever types they stand for. Declared
+// type constructors start with a capital letter, so they cannot be confused with these.
+std::shared_ptr<Type> skolemise(const std::shared_ptr<Type> &t) {
+    if (t->hash_consed) {
+        return t;
+    }
+    switch(t->get_form()) {
+        case typeform::universallyquantifiedvariable:
+            return make_type_constructor(static_cast<UniversallyQuantifiedVariable*>(t.get())->id);
+        case typeform::variable:
+        case typeform::constructor:
+            return t;
+        case typeform::application:
+            return make_type_application(
+                    skolemise(static_cast<TypeApplication*>(t.get())->left),
+                    skolemise(static_cast<TypeApplication*>(t.get())->right));
+    }
+}
+
+// Quantifies the variables created below the given level that have not since been unified with a type from the
+// assumptions at that level or above, which would have lowered their level. They are named by the order in which
+// they occur in the type, so that the type scheme does not depend on how many variables were created before it, on
+// any thread.
 std::shared_ptr<Type> generalise(
         const std::shared_ptr<Type> &t,
-        const std::map<std::string, std::shared_ptr<Type>> &assumptions) {
+        unsigned int level,
+        std::unordered_map<const TypeVariable*, std::shared_ptr<Type>> &quantified) {
     std::shared_ptr<Type> type = follow_substitution(t);
+    if (type->hash_consed) {
+        return type;
+    }
     switch(type->get_form()) {
         case typeform::variable: {
-            for (const auto &[name, t1]: assumptions) {
-                if (!occurs_check_ok(std::dynamic_pointer_cast<TypeVariable>(type), t1)) {
-                    return type;
-                }
+            auto variable = static_cast<const TypeVariable*>(type.get());
+            if (variable->level <= level) {
+                return type;
+            }
+            if (quantified.count(variable) == 0) {
+                std::string name = std::to_string(quantified.size());
+                quantified[variable] = make_universally_quantified_variable(name);
             }
-            return std::make_shared<UniversallyQuantifiedVariable>(std::dynamic_pointer_cast<TypeVariable>(type)->id);
+            return quantified.at(variable);
         }
         case typeform::universallyquantifiedvariable:
         case typeform::constructor:
             return type;
         case typeform::application:
-            auto left = generalise(std::dynamic_pointer_cast<TypeApplication>(type)->left, assumptions);
-            auto right = generalise(std::dynamic_pointer_cast<TypeApplication>(type)->right, assumptions);
+            auto left = generalise(static_cast<TypeApplication*>(type.get())->left, level, quantified);
+            auto right = generalise(static_cast<TypeApplication*>(type.get())->right, level, quantified);
             if (
-                    left != std::dynamic_pointer_cast<TypeApplication>(type)->left ||
-                    right != std::dynamic_pointer_cast<TypeApplication>(type)->right) {
-                return std::make_shared<TypeApplication>(left, right);
+                    left != static_cast<TypeApplication*>(type.get())->left ||
+                    right != static_cast<TypeApplication*>(type.get())->right) {
+                return make_type_application(left, right);
             } else {
                 return type;
             }
     }
 }
 
+std::shared_ptr<Type> generalise(const std::shared_ptr<Type> &t, unsigned int level) {
+    std::unordered_map<const TypeVariable*, std::shared_ptr<Type>> quantified;
+    return generalise(t, level, quantified);
+}
+
 bool contains_variables(const std::shared_ptr<Type> &type) {
     switch(type->get_form()) {
         case typeform::constructor:
@@ -187,8 +400,8 @@ bool contains_variables(const std::shared_ptr<Type> &type) {
         case typeform::universallyquantifiedvariable:
             return true;
         case typeform::application:
-            return contains_variables(std::dynamic_pointer_cast<TypeApplication>(type)->left) ||
-                   contains_variables(std::dynamic_pointer_cast<TypeApplication>(type)->right);
+            return contains_variables(static_cast<TypeApplication*>(type.get())->left) ||
+                   contains_variables(static_cast<TypeApplication*>(type.get())->right);
     }
 }
 
@@ -201,33 +414,36 @@ void check_type_signature(
     if (inferred_type_instantiated == type_signature) {
         return;
     }
+    if (inferred_type_instantiated->hash_consed && type_signature->hash_consed) {
+        throw TypeError("Failed to verify type signature.");
+    }
     if (
             inferred_type_instantiated->get_form() == typeform::constructor &&
             type_signature->get_form() == typeform::constructor &&
-            std::dynamic_pointer_cast<TypeConstructor>(inferred_type_instantiated)->id ==
-                std::dynamic_pointer_cast<TypeConstructor>(type_signature)->id) {
+            static_cast<TypeConstructor*>(inferred_type_instantiated.get())->id ==
+                static_cast<TypeConstructor*>(type_signature.get())->id) {
         return;
     } else if (inferred_type_instantiated->get_form() == typeform::variable) {
-        const auto &variable = std::dynamic_pointer_cast<TypeVariable>(inferred_type_instantiated);
+        const auto variable = static_cast<TypeVariable*>(inferred_type_instantiated.get());
         if (!occurs_check_ok(variable, type_signature)) {
             throw TypeError("Failed to verify type signature: occurs check failed.");
         }
         if (!occurs_check_ok(variable, inferred_type_scheme) && contains_variables(type_signature)) {
             throw TypeError("Failed to verify type signature.");
         }
-        std::dynamic_pointer_cast<TypeVariable>(inferred_type_instantiated)->bound_to = type_signature;
+        static_cast<TypeVariable*>(inferred_type_instantiated.get())->bound_to = type_signature;
         return;
     } else if (
             inferred_type_instantiated->get_form() == typeform::application &&
             type_signature->get_form() == typeform::application) {
         check_type_signature(
                 inferred_type_scheme,
-                std::dynamic_pointer_cast<TypeApplication>(inferred_type_instantiated)->left,
-                std::dynamic_pointer_cast<TypeApplication>(type_signature)->left);
+                static_cast<TypeApplication*>(inferred_type_instantiated.get())->left,
+                static_cast<TypeApplication*>(type_signature.get())->left);
         check_type_signature(
                 inferred_type_scheme,
-                std::dynamic_pointer_cast<TypeApplication>(inferred_type_instantiated)->right,
-                std::dynamic_pointer_cast<TypeApplication>(type_signature)->right);
+                static_cast<TypeApplication*>(inferred_type_instantiated.get())->right,
+                static_cast<TypeApplication*>(type_signature.get())->right);
         return;
     }
 
@@ -236,45 +452,48 @@ void check_type_signature(
 
 void check_type_signature(
         const std::shared_ptr<Type> &inferred_type_scheme,
-        const std::shared_ptr<Type> &type_signature) {
+        const std::shared_ptr<Type> &type_signature,
+        unsigned int level) {
     check_type_signature(
             inferred_type_scheme,
-            instantiate(inferred_type_scheme),
-            instantiate(type_signature));
+            instantiate(inferred_type_scheme, level),
+            instantiate(type_signature, level));
 }
 
-std::vector<std::string> find_variables_bound_by(const std::unique_ptr<Pattern> &pattern) {
-    std::vector<std::string> variables = pattern->as;
+std::vector<Symbol> find_variables_bound_by(const std::unique_ptr<Pattern> &pattern) {
+    std::vector<Symbol> variables = pattern->as;
     switch(pattern->get_form()) {
         case patternform::wild:
         case patternform::literal:
             return variables;
         case patternform::variable:
-            variables.push_back(dynamic_cast<VariablePattern*>(pattern.get())->name);
+            variables.push_back(static_cast<VariablePattern*>(pattern.get())->name);
             return variables;
         case patternform::constructor:
-            for (const auto &pat: dynamic_cast<ConstructorPattern*>(pattern.get())->args) {
-                std::vector<std::string> new_variables = find_variables_bound_by(pat);
+            for (const auto &pat: static_cast<ConstructorPattern*>(pattern.get())->args) {
+                std::vector<Symbol> new_variables = find_variables_bound_by(pat);
                 variables.insert(variables.end(), new_variables.begin(), new_variables.end());
             }
             return variables;
     }
 }
 
-std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> type_inference_pattern(
-        const std::map<std::string, std::shared_ptr<Type>> &constructor_types,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::unique_ptr<Pattern> &p);
-
-std::pair<std::vector<std::shared_ptr<Type>>, std::map<std::string, std::shared_ptr<Type>>> type_inference_patterns(
-        const std::map<std::string, std::shared_ptr<Type>> &constructor_types,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::vector<std::unique_ptr<Pattern>> &ps) {
+std::pair<std::shared_ptr<Type>, std::unordered_map<Symbol, std::shared_ptr<Type>>> type_inference_pattern(
+        const ScopedMap<std::shared_ptr<Type>> &constructor_types,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unique_ptr<Pattern> &p,
+        unsigned int level);
+
+std::pair<std::vector<std::shared_ptr<Type>>, std::unordered_map<Symbol, std::shared_ptr<Type>>> type_inference_patterns(
+        const ScopedMap<std::shared_ptr<Type>> &constructor_types,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::vector<std::unique_ptr<Pattern>> &ps,
+        unsigned int level) {
     std::vector<std::shared_ptr<Type>> types_matched;
-    std::map<std::string, std::shared_ptr<Type>> new_assumptions;
+    std::unordered_map<Symbol, std::shared_ptr<Type>> new_assumptions;
 
     for (const auto &p: ps) {
-        auto inferred = type_inference_pattern(constructor_types, data_constructor_arities, p);
+        auto inferred = type_inference_pattern(constructor_types, data_constructor_arities, p, level);
         types_matched.push_back(inferred.first);
         for (auto const &[name, type]: inferred.second) {
             new_assumptions[name] = type;
@@ -284,11 +503,12 @@ std::pair<std::vector<std::shared_ptr<Type>>, std::map<std::string, std::shared_
     return std::make_pair(types_matched, new_assumptions);
 }
 
-std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> type_inference_pattern(
-        const std::map<std::string, std::shared_ptr<Type>> &constructor_types,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::unique_ptr<Pattern> &p) {
-    std::vector<std::string> variables = find_variables_bound_by(p);
+std::pair<std::shared_ptr<Type>, std::unordered_map<Symbol, std::shared_ptr<Type>>> type_inference_pattern(
+        const ScopedMap<std::shared_ptr<Type>> &constructor_types,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unique_ptr<Pattern> &p,
+        unsigned int level) {
+    std::vector<Symbol> variables = find_variables_bound_by(p);
     if (variables.size() > std::set(variables.begin(), variables.end()).size()) {
         throw TypeError(
                 "Line " +
@@ -296,18 +516,18 @@ std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> t
                 ": a variable should occur at most once within a pattern.");
     }
     std::shared_ptr<Type> type_matched;
-    std::map<std::string, std::shared_ptr<Type>> new_assumptions;
+    std::unordered_map<Symbol, std::shared_ptr<Type>> new_assumptions;
     switch (p->get_form()) {
         case patternform::constructor: {
-            if (constructor_types.count(dynamic_cast<ConstructorPattern *>(p.get())->name) == 0) {
+            if (constructor_types.count(static_cast<ConstructorPattern *>(p.get())->name) == 0) {
                 throw TypeError(
                         "Line " +
                         std::to_string(p->line) +
                         ": reference in pattern to undefined data constructor " +
-                        dynamic_cast<ConstructorPattern *>(p.get())->name + ".");
+                        static_cast<ConstructorPattern *>(p.get())->name.str() + ".");
             }
-            if (dynamic_cast<ConstructorPattern *>(p.get())->args.size() !=
-                data_constructor_arities.at(dynamic_cast<ConstructorPattern *>(p.get())->name)) {
+            if (static_cast<ConstructorPattern *>(p.get())->args.size() !=
+                data_constructor_arities.at(static_cast<ConstructorPattern *>(p.get())->name)) {
                 throw TypeError(
                         "Line " +
                         std::to_string(p->line) +
@@ -316,19 +536,19 @@ std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> t
             auto sub_patterns = type_inference_patterns(
                     constructor_types,
                     data_constructor_arities,
-                    dynamic_cast<ConstructorPattern *>(p.get())->args);
-            type_matched = std::make_shared<TypeVariable>();
+                    static_cast<ConstructorPattern *>(p.get())->args,
+                    level);
+            type_matched = std::make_shared<TypeVariable>(level);
             new_assumptions = sub_patterns.second;
             auto expected_constructor_type = type_matched;
             for (int i = sub_patterns.first.size() - 1; i >= 0; i--) {
-                expected_constructor_type = std::make_shared<TypeApplication>(
-                        std::make_shared<TypeApplication>(
-                                std::make_shared<TypeConstructor>("->"),
-                                sub_patterns.first[i]),
+                expected_constructor_type = make_function_type(
+                        sub_patterns.first[i],
                         expected_constructor_type);
             }
             auto constructor_type = instantiate(
-                    constructor_types.at(dynamic_cast<ConstructorPattern *>(p.get())->name));
+                    constructor_types.at(static_cast<ConstructorPattern *>(p.get())->name),
+                    level);
             try {
                 unify(constructor_type, expected_constructor_type);
             } catch (const TypeError &e) {
@@ -336,24 +556,24 @@ std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> t
                         "Line " +
                         std::to_string(p->line) +
                         ": could not unify the type of the data constructor " +
-                        dynamic_cast<ConstructorPattern *>(p.get())->name +
+                        static_cast<ConstructorPattern *>(p.get())->name.str() +
                         " with the type implied by the pattern it was used in.");
             }
             break;
         }
         case patternform::wild:
-            type_matched = std::make_shared<TypeVariable>();
+            type_matched = std::make_shared<TypeVariable>(level);
             break;
         case patternform::literal:
-            if (std::holds_alternative<int>(dynamic_cast<LiteralPattern*>(p.get())->value)) {
-                type_matched = std::make_shared<TypeConstructor>("Int");
-            } else if (std::holds_alternative<char>(dynamic_cast<LiteralPattern*>(p.get())->value)) {
-                type_matched = std::make_shared<TypeConstructor>("Char");
+            if (std::holds_alternative<int>(static_cast<LiteralPattern*>(p.get())->value)) {
+                type_matched = fixed_types().int_type;
+            } else if (std::holds_alternative<char>(static_cast<LiteralPattern*>(p.get())->value)) {
+                type_matched = fixed_types().char_type;
             }
             break;
         case patternform::variable:
-            type_matched = std::make_shared<TypeVariable>();
-            new_assumptions[dynamic_cast<VariablePattern*>(p.get())->name] = type_matched;
+            type_matched = std::make_shared<TypeVariable>(level);
+            new_assumptions[static_cast<VariablePattern*>(p.get())->name] = type_matched;
             break;
     }
 
@@ -361,56 +581,90 @@ std::pair<std::shared_ptr<Type>, std::map<std::string, std::shared_ptr<Type>>> t
         new_assumptions[v] = type_matched;
     }
 
+    p->type = type_matched;
     return std::make_pair(type_matched, new_assumptions);
 }
 
-std::map<std::string, std::shared_ptr<Type>> type_inference_declarations(
-        const std::map<std::string, std::shared_ptr<Type>> &assumptions,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::map<std::string, std::shared_ptr<Kind>> &type_constructor_kinds,
-        const std::map<std::string, std::unique_ptr<Expression>> &declarations,
-        const std::map<std::string, std::shared_ptr<Type>> &type_signatures);
+void type_inference_declarations(
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> &declarations,
+        const std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> &type_signatures,
+        const std::unordered_map<Symbol, std::shared_ptr<Type>> &checked_types,
+        unsigned int level,
+        TypeCache *cache,
+        CompileStatistics *statistics);
+
+std::shared_ptr<Type> type_inference_application(
+        const int &line,
+        const std::shared_ptr<Type> &function_type,
+        const std::shared_ptr<Type> &argument_type,
+        unsigned int level) {
+    std::shared_ptr<Type> result_type = std::make_shared<TypeVariable>(level);
+    std::shared_ptr<Type> expected_function_type = make_function_type(
+            argument_type,
+            result_type);
+    try {
+        unify(function_type, expected_function_type);
+    } catch (const TypeError &e) {
+        throw TypeError(
+                "Line " +
+                std::to_string(line) +
+                ": could not infer type for application.");
+    }
+    return result_type;
+}
 
 std::shared_ptr<Type> type_inference_expression(
-        std::map<std::string, std::shared_ptr<Type>> assumptions,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::map<std::string, std::shared_ptr<Kind>> &type_constructor_kinds,
-        const std::unique_ptr<Expression> &expression) {
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::unique_ptr<Expression> &expression,
+        unsigned int level);
+
+static std::shared_ptr<Type> infer_expression_type(
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::unique_ptr<Expression> &expression,
+        unsigned int level) {
     switch(expression->get_form()) {
         case expform::literal:
-            if (std::holds_alternative<int>(dynamic_cast<Literal*>(expression.get())->value)) {
-                return std::make_shared<TypeConstructor>("Int");
-            } else if (std::holds_alternative<char>(dynamic_cast<Literal*>(expression.get())->value)) {
-                return std::make_shared<TypeConstructor>("Char");
+            if (std::holds_alternative<int>(static_cast<Literal*>(expression.get())->value)) {
+                return fixed_types().int_type;
+            } else if (std::holds_alternative<char>(static_cast<Literal*>(expression.get())->value)) {
+                return fixed_types().char_type;
+            } else {
+                return fixed_types().string_type;
             }
         case expform::variable:
-            if (assumptions.count(dynamic_cast<Variable*>(expression.get())->name) == 0) {
+            if (assumptions.count(static_cast<Variable*>(expression.get())->name) == 0) {
                 throw TypeError(
                         "Line " +
                         std::to_string(expression->line) +
                         ": undefined reference to name " +
-                        dynamic_cast<Variable*>(expression.get())->name + ".");
+                        static_cast<Variable*>(expression.get())->name.str() + ".");
             }
-            return instantiate(assumptions.at(dynamic_cast<Variable*>(expression.get())->name));
+            return instantiate(assumptions.at(static_cast<Variable*>(expression.get())->name), level);
         case expform::constructor:
-            if (assumptions.count(dynamic_cast<Constructor*>(expression.get())->name) == 0) {
+            if (assumptions.count(static_cast<Constructor*>(expression.get())->name) == 0) {
                 throw TypeError(
                         "Line " +
                         std::to_string(expression->line) +
                         ": undefined reference to name " +
-                        dynamic_cast<Constructor*>(expression.get())->name + ".");
+                        static_cast<Constructor*>(expression.get())->name.str() + ".");
             }
-            return instantiate(assumptions.at(dynamic_cast<Constructor*>(expression.get())->name));
+            return instantiate(assumptions.at(static_cast<Constructor*>(expression.get())->name), level);
         case expform::abstraction: {
-            std::shared_ptr<Type> result_type = std::make_shared<TypeVariable>();
+            ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
+            std::shared_ptr<Type> result_type = std::make_shared<TypeVariable>(level);
             std::shared_ptr<Type> type = result_type;
-            for (int i = dynamic_cast<Abstraction*>(expression.get())->args.size() - 1; i >= 0; i--) {
-                std::shared_ptr<Type> arg_type = std::make_shared<TypeVariable>();
-                assumptions[dynamic_cast<Abstraction*>(expression.get())->args.at(i)] = arg_type;
-                type = std::make_shared<TypeApplication>(
-                        std::make_shared<TypeApplication>(
-                                std::make_shared<TypeConstructor>("->"),
-                                arg_type),
+            for (int i = static_cast<Abstraction*>(expression.get())->args.size() - 1; i >= 0; i--) {
+                std::shared_ptr<Type> arg_type = std::make_shared<TypeVariable>(level);
+                assumptions.bind(static_cast<Abstraction*>(expression.get())->args.at(i), arg_type);
+                type = make_function_type(
+                        arg_type,
                         type);
             }
             unify(
@@ -419,59 +673,76 @@ std::shared_ptr<Type> type_inference_expression(
                             assumptions,
                             data_constructor_arities,
                             type_constructor_kinds,
-                            dynamic_cast<Abstraction*>(expression.get())->body));
+                            static_cast<Abstraction*>(expression.get())->body,
+                            level));
             return type;
         }
         case expform::application: {
-            std::shared_ptr<Type> left_type = type_inference_expression(
-                    assumptions,
-                    data_constructor_arities,
-                    type_constructor_kinds,
-                    dynamic_cast<Application*>(expression.get())->left);
-            std::shared_ptr<Type> right_type = type_inference_expression(
+            // The spine of applications nested in last arguments, as built for list literals, is walked with an
+            // explicit stack. Each entry holds the type of the application applied to all but its last argument.
+            std::vector<std::pair<Application*, std::shared_ptr<Type>>> spine;
+            Expression *current = expression.get();
+            while (current->get_form() == expform::application) {
+                auto application = static_cast<Application*>(current);
+                std::shared_ptr<Type> type = type_inference_expression(
+                        assumptions,
+                        data_constructor_arities,
+                        type_constructor_kinds,
+                        application->function,
+                        level);
+                for (size_t i = 0; i + 1 < application->arguments.size(); i++) {
+                    type = type_inference_application(
+                            application->line,
+                            type,
+                            type_inference_expression(
+                                    assumptions,
+                                    data_constructor_arities,
+                                    type_constructor_kinds,
+                                    application->arguments[i],
+                                    level),
+                            level);
+                }
+                spine.emplace_back(application, type);
+                current = application->arguments.back().get();
+            }
+            std::shared_ptr<Type> type = type_inference_expression(
                     assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    dynamic_cast<Application*>(expression.get())->right);
-            std::shared_ptr<Type> type = std::make_shared<TypeVariable>();
-            std::shared_ptr<Type> expected_left_type = std::make_shared<TypeApplication>(
-                    std::make_shared<TypeApplication>(
-                            std::make_shared<TypeConstructor>("->"),
-                            right_type),
-                    type);
-            try {
-                unify(left_type, expected_left_type);
-            } catch (const TypeError &e) {
-                throw TypeError(
-                        "Line " +
-                        std::to_string(expression->line) +
-                        ": could not infer type for application.");
+                    spine.back().first->arguments.back(),
+                    level);
+            while (!spine.empty()) {
+                type = type_inference_application(spine.back().first->line, spine.back().second, type, level);
+                spine.back().first->type = type;
+                spine.pop_back();
             }
             return type;
         }
         case expform::builtinop: {
             std::shared_ptr<Type> left_type;
-            if (dynamic_cast<BuiltInOp*>(expression.get())->op != builtinop::negate) {
+            if (static_cast<BuiltInOp*>(expression.get())->op != builtinop::negate) {
                 left_type = type_inference_expression(
                         assumptions,
                         data_constructor_arities,
                         type_constructor_kinds,
-                        dynamic_cast<BuiltInOp *>(expression.get())->left);
+                        static_cast<BuiltInOp *>(expression.get())->left,
+                        level);
             }
             std::shared_ptr<Type> right_type = type_inference_expression(
                     assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    dynamic_cast<BuiltInOp*>(expression.get())->right);
-            switch(dynamic_cast<BuiltInOp*>(expression.get())->op) {
+                    static_cast<BuiltInOp*>(expression.get())->right,
+                    level);
+            switch(static_cast<BuiltInOp*>(expression.get())->op) {
                 case builtinop::add:
                 case builtinop::subtract:
                 case builtinop::times:
                 case builtinop::divide:
                     try {
-                        unify(left_type, std::make_shared<TypeConstructor>("Int"));
-                        unify(right_type, std::make_shared<TypeConstructor>("Int"));
-                        return std::make_shared<TypeConstructor>("Int");
+                        unify(left_type, fixed_types().int_type);
+                        unify(right_type, fixed_types().int_type);
+                        return fixed_types().int_type;
                     } catch (const TypeError &e) {
                         throw TypeError(
                                 "Line " +
@@ -480,8 +751,8 @@ std::shared_ptr<Type> type_inference_expression(
                     }
                 case builtinop::negate:
                     try {
-                        unify(right_type, std::make_shared<TypeConstructor>("Int"));
-                        return std::make_shared<TypeConstructor>("Int");
+                        unify(right_type, fixed_types().int_type);
+                        return fixed_types().int_type;
                     } catch (const TypeError &e) {
                         throw TypeError(
                                 "Line " +
@@ -490,9 +761,9 @@ std::shared_ptr<Type> type_inference_expression(
                     }
                 case builtinop::charequality:
                     try {
-                        unify(left_type, std::make_shared<TypeConstructor>("Char"));
-                        unify(right_type, std::make_shared<TypeConstructor>("Char"));
-                        return std::make_shared<TypeConstructor>("Bool");
+                        unify(left_type, fixed_types().char_type);
+                        unify(right_type, fixed_types().char_type);
+                        return fixed_types().bool_type;
                     } catch (const TypeError &e) {
                         throw TypeError(
                                 "Line " +
@@ -505,9 +776,9 @@ std::shared_ptr<Type> type_inference_expression(
                 case builtinop::gt:
                 case builtinop::gte:
                     try {
-                        unify(left_type, std::make_shared<TypeConstructor>("Int"));
-                        unify(right_type, std::make_shared<TypeConstructor>("Int"));
-                        return std::make_shared<TypeConstructor>("Bool");
+                        unify(left_type, fixed_types().int_type);
+                        unify(right_type, fixed_types().int_type);
+                        return fixed_types().bool_type;
                     } catch (const TypeError &e) {
                         throw TypeError(
                                 "Line " +
@@ -521,10 +792,11 @@ std::shared_ptr<Type> type_inference_expression(
                     assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    dynamic_cast<Case*>(expression.get())->exp);
-            std::shared_ptr<Type> result_type = std::make_shared<TypeVariable>();
-            for (const auto &alt: dynamic_cast<Case*>(expression.get())->alts) {
-                auto pattern = type_inference_pattern(assumptions, data_constructor_arities, alt.first);
+                    static_cast<Case*>(expression.get())->exp,
+                    level);
+            std::shared_ptr<Type> result_type = std::make_shared<TypeVariable>(level);
+            for (const auto &alt: static_cast<Case*>(expression.get())->alts) {
+                auto pattern = type_inference_pattern(assumptions, data_constructor_arities, alt.first, level);
                 try {
                     unify(pattern.first, exp_type);
                 } catch (const TypeError &e) {
@@ -533,18 +805,19 @@ std::shared_ptr<Type> type_inference_expression(
                             std::to_string(alt.first->line) +
                             ": type expected by pattern does not unify with type of expression being analysed by case.");
                 }
-                std::map<std::string, std::shared_ptr<Type>> new_assumptions = assumptions;
+                ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
                 for (const auto &[name, type]: pattern.second) {
-                    new_assumptions[name] = type;
+                    assumptions.bind(name, type);
                 }
                 try {
                     unify(
                             result_type,
                             type_inference_expression(
-                                    new_assumptions,
+                                    assumptions,
                                     data_constructor_arities,
                                     type_constructor_kinds,
-                                    alt.second));
+                                    alt.second,
+                                    level));
                 } catch (const TypeError &e) {
                     throw TypeError(
                             "Line " +
@@ -555,109 +828,389 @@ std::shared_ptr<Type> type_inference_expression(
             return result_type;
         }
         case expform::let: {
-            std::map<std::string, std::shared_ptr<Type>> local_assumptions = type_inference_declarations(
+            ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
+            type_inference_declarations(
                     assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    dynamic_cast<Let*>(expression.get())->bindings,
-                    dynamic_cast<Let*>(expression.get())->type_signatures);
+                    static_cast<Let*>(expression.get())->bindings,
+                    static_cast<Let*>(expression.get())->type_signatures,
+                    {},
+                    level,
+                    nullptr,
+                    nullptr);
             return type_inference_expression(
-                    local_assumptions,
+                    assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    dynamic_cast<Let*>(expression.get())->e);
+                    static_cast<Let*>(expression.get())->e,
+                    level);
         }
     }
 }
 
-std::set<std::string> find_free_variables(const std::unique_ptr<Expression> &exp) {
-    switch(exp->get_form()) {
-        case expform::variable:
-            return std::set<std::string>({dynamic_cast<Variable*>(exp.get())->name});
-        case expform::constructor:
-        case expform::literal:
-            return {};
+// Infers the type of an expression and records it on the expression.
+std::shared_ptr<Type> type_inference_expression(
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::unique_ptr<Expression> &expression,
+        unsigned int level) {
+    expression->type = infer_expression_type(
+            assumptions,
+            data_constructor_arities,
+            type_constructor_kinds,
+            expression,
+            level);
+    return expression->type;
+}
+
+std::optional<std::pair<std::shared_ptr<Type>, std::shared_ptr<Type>>> split_function_type(
+        const std::shared_ptr<Type> &t) {
+    std::shared_ptr<Type> type = follow_substitution(t);
+    if (type->get_form() != typeform::application) {
+        return std::nullopt;
+    }
+    std::shared_ptr<Type> partial = follow_substitution(static_cast<TypeApplication*>(type.get())->left);
+    if (partial->get_form() != typeform::application) {
+        return std::nullopt;
+    }
+    std::shared_ptr<Type> constructor = follow_substitution(static_cast<TypeApplication*>(partial.get())->left);
+    if (
+            constructor->get_form() != typeform::constructor ||
+            static_cast<TypeConstructor*>(constructor.get())->id != fixed_types().function_name) {
+        return std::nullopt;
+    }
+    return std::make_pair(
+            static_cast<TypeApplication*>(partial.get())->right,
+            static_cast<TypeApplication*>(type.get())->right);
+}
+
+bool is_literal_type(const std::shared_ptr<Type> &t) {
+    std::shared_ptr<Type> type = follow_substitution(t);
+    if (type->get_form() != typeform::constructor) {
+        return false;
+    }
+    Symbol id = static_cast<TypeConstructor*>(type.get())->id;
+    return id == fixed_types().int_name || id == fixed_types().char_name;
+}
+
+void unify_with_expected_type(
+        const int &line,
+        const std::shared_ptr<Type> &type,
+        const std::shared_ptr<Type> &expected_type) {
+    try {
+        unify(type, expected_type);
+    } catch (const TypeError &e) {
+        throw TypeError(
+                "Line " +
+                std::to_string(line) +
+                ": type of expression does not match the type expected by the type signature.");
+    }
+}
+
+// Checks an expression against the type it is known to have from a type signature, rather than inferring a type for
+// it and comparing the two afterwards. Lambda arguments and case alternatives take their types from the expected
+// type, and arguments are checked against the parameter types of functions whose types are known, so that far fewer
+// type variables are created and unified. Expressions that cannot make use of the expected type are inferred.
+void type_check_expression(
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::unique_ptr<Expression> &expression,
+        const std::shared_ptr<Type> &expected_type,
+        unsigned int level) {
+    expression->type = expected_type;
+    switch(expression->get_form()) {
         case expform::abstraction: {
-            std::set<std::string> variables = find_free_variables(dynamic_cast<Abstraction*>(exp.get())->body);
-            for (const std::string &v: dynamic_cast<Abstraction*>(exp.get())->args) {
-                variables.erase(v);
+            ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
+            std::shared_ptr<Type> type = expected_type;
+            for (const Symbol &arg: static_cast<Abstraction*>(expression.get())->args) {
+                auto parameter = split_function_type(type);
+                if (!parameter) {
+                    parameter = std::make_pair(
+                            std::make_shared<TypeVariable>(level),
+                            std::make_shared<TypeVariable>(level));
+                    unify_with_expected_type(
+                            expression->line,
+                            make_function_type(parameter->first, parameter->second),
+                            type);
+                }
+                assumptions.bind(arg, parameter->first);
+                type = parameter->second;
             }
-            return variables;
+            type_check_expression(
+                    assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    static_cast<Abstraction*>(expression.get())->body,
+                    type,
+                    level);
+            return;
         }
         case expform::application: {
-            std::set<std::string> variables = find_free_variables(dynamic_cast<Application*>(exp.get())->left);
-            for (const std::string &v: find_free_variables(dynamic_cast<Application*>(exp.get())->right)) {
-                variables.insert(v);
+            // Applications nested in last arguments, as built for list literals, are checked in a loop, each against
+            // the parameter type of the application it is the last argument of.
+            const std::unique_ptr<Expression> *current = &expression;
+            std::shared_ptr<Type> current_type = expected_type;
+            while ((*current)->get_form() == expform::application) {
+                auto application = static_cast<const Application*>(current->get());
+                (*current)->type = current_type;
+                std::shared_ptr<Type> type = type_inference_expression(
+                        assumptions,
+                        data_constructor_arities,
+                        type_constructor_kinds,
+                        application->function,
+                        level);
+                for (const auto &argument: application->arguments) {
+                    auto parameter = split_function_type(type);
+                    if (!parameter) {
+                        parameter = std::make_pair(
+                                std::make_shared<TypeVariable>(level),
+                                std::make_shared<TypeVariable>(level));
+                        try {
+                            unify(type, make_function_type(parameter->first, parameter->second));
+                        } catch (const TypeError &e) {
+                            throw TypeError(
+                                    "Line " +
+                                    std::to_string(application->line) +
+                                    ": could not infer type for application.");
+                        }
+                    }
+                    if (&argument == &application->arguments.back()) {
+                        unify_with_expected_type(application->line, parameter->second, current_type);
+                        current = &argument;
+                        current_type = parameter->first;
+                    } else {
+                        type_check_expression(
+                                assumptions,
+                                data_constructor_arities,
+                                type_constructor_kinds,
+                                argument,
+                                parameter->first,
+                                level);
+                        type = parameter->second;
+                    }
+                }
             }
-            return variables;
+            type_check_expression(
+                    assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    *current,
+                    current_type,
+                    level);
+            return;
         }
         case expform::cAsE: {
-            std::set<std::string> variables = find_free_variables(dynamic_cast<Case*>(exp.get())->exp);
-            for (const auto &alt: dynamic_cast<Case*>(exp.get())->alts) {
-                std::set<std::string> new_variables = find_free_variables(alt.second);
-                for (const std::string &v: find_variables_bound_by(alt.first)) {
-                    new_variables.erase(v);
+            std::shared_ptr<Type> exp_type = type_inference_expression(
+                    assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    static_cast<Case*>(expression.get())->exp,
+                    level);
+            for (const auto &alt: static_cast<Case*>(expression.get())->alts) {
+                auto pattern = type_inference_pattern(assumptions, data_constructor_arities, alt.first, level);
+                try {
+                    unify(pattern.first, exp_type);
+                } catch (const TypeError &e) {
+                    throw TypeError(
+                            "Line " +
+                            std::to_string(alt.first->line) +
+                            ": type expected by pattern does not unify with type of expression being analysed by case.");
                 }
-                for (const std::string &v: new_variables) {
-                    variables.insert(v);
+                ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
+                for (const auto &[name, type]: pattern.second) {
+                    assumptions.bind(name, type);
                 }
+                type_check_expression(
+                        assumptions,
+                        data_constructor_arities,
+                        type_constructor_kinds,
+                        alt.second,
+                        expected_type,
+                        level);
             }
-            return variables;
+            return;
         }
         case expform::let: {
-            std::set<std::string> variables = find_free_variables(dynamic_cast<Let*>(exp.get())->e);
-            std::set<std::string> bound_names;
-            for (const auto &[name, e]: dynamic_cast<Let*>(exp.get())->bindings) {
-                bound_names.insert(name);
-                for (const std::string &v: find_free_variables(e)) {
-                    variables.insert(v);
+            ScopedMap<std::shared_ptr<Type>>::Scope scope(assumptions);
+            type_inference_declarations(
+                    assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    static_cast<Let*>(expression.get())->bindings,
+                    static_cast<Let*>(expression.get())->type_signatures,
+                    {},
+                    level,
+                    nullptr,
+                    nullptr);
+            type_check_expression(
+                    assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    static_cast<Let*>(expression.get())->e,
+                    expected_type,
+                    level);
+            return;
+        }
+        default:
+            unify_with_expected_type(
+                    expression->line,
+                    type_inference_expression(
+                            assumptions,
+                            data_constructor_arities,
+                            type_constructor_kinds,
+                            expression,
+                            level),
+                    expected_type);
+    }
+}
+
+std::set<Symbol, SpellingOrder> find_free_variables(const std::unique_ptr<Expression> &exp) {
+    // Expressions are visited with an explicit stack. Entries without an expression bind or unbind names, and are
+    // pushed around the subexpressions in the scope of those names.
+    struct Visit {
+        const Expression *expression;
+        std::vector<Symbol> names;
+        bool bind;
+    };
+    auto scoped = [](std::vector<Visit> &to_visit, const std::vector<Symbol> &names, auto push_subexpressions) {
+        to_visit.push_back({nullptr, names, false});
+        push_subexpressions();
+        to_visit.push_back({nullptr, names, true});
+    };
+
+    std::set<Symbol, SpellingOrder> variables;
+    std::unordered_map<Symbol, size_t> bound;
+    std::vector<Visit> to_visit = {{exp.get(), {}, false}};
+    while (!to_visit.empty()) {
+        Visit visit = std::move(to_visit.back());
+        to_visit.pop_back();
+        if (visit.expression == nullptr) {
+            for (const Symbol &v: visit.names) {
+                if (visit.bind) {
+                    bound[v]++;
+                } else if (--bound[v] == 0) {
+                    bound.erase(v);
                 }
             }
-            for (const std::string &v: bound_names) {
-                variables.erase(v);
-            }
-            return variables;
+            continue;
         }
-        case expform::builtinop: {
-            std::set<std::string> variables;
-            if (dynamic_cast<BuiltInOp*>(exp.get())->op != builtinop::negate) {
-                const auto &left = find_free_variables(dynamic_cast<BuiltInOp*>(exp.get())->left);
-                variables.insert(left.begin(), left.end());
+        switch(visit.expression->get_form()) {
+            case expform::variable:
+                if (bound.count(static_cast<const Variable*>(visit.expression)->name) == 0) {
+                    variables.insert(static_cast<const Variable*>(visit.expression)->name);
+                }
+                break;
+            case expform::constructor:
+            case expform::literal:
+                break;
+            case expform::abstraction: {
+                auto abstraction = static_cast<const Abstraction*>(visit.expression);
+                scoped(to_visit, abstraction->args, [&]() {
+                    to_visit.push_back({abstraction->body.get(), {}, false});
+                });
+                break;
+            }
+            case expform::application: {
+                auto application = static_cast<const Application*>(visit.expression);
+                to_visit.push_back({application->function.get(), {}, false});
+                for (const auto &argument: application->arguments) {
+                    to_visit.push_back({argument.get(), {}, false});
+                }
+                break;
+            }
+            case expform::cAsE: {
+                auto cAsE = static_cast<const Case*>(visit.expression);
+                to_visit.push_back({cAsE->exp.get(), {}, false});
+                for (const auto &alt: cAsE->alts) {
+                    scoped(to_visit, find_variables_bound_by(alt.first), [&]() {
+                        to_visit.push_back({alt.second.get(), {}, false});
+                    });
+                }
+                break;
+            }
+            case expform::let: {
+                auto let = static_cast<const Let*>(visit.expression);
+                std::vector<Symbol> bound_names;
+                for (const auto &[name, _]: let->bindings) {
+                    bound_names.push_back(name);
+                }
+                scoped(to_visit, bound_names, [&]() {
+                    to_visit.push_back({let->e.get(), {}, false});
+                    for (const auto &[_, e]: let->bindings) {
+                        to_visit.push_back({e.get(), {}, false});
+                    }
+                });
+                break;
+            }
+            case expform::builtinop: {
+                auto op = static_cast<const BuiltInOp*>(visit.expression);
+                if (op->op != builtinop::negate) {
+                    to_visit.push_back({op->left.get(), {}, false});
+                }
+                to_visit.push_back({op->right.get(), {}, false});
+                break;
             }
-            const auto &right = find_free_variables(dynamic_cast<BuiltInOp*>(exp.get())->right);
-            variables.insert(right.begin(), right.end());
-            return variables;
         }
     }
+    return variables;
 }
 
 std::shared_ptr<Kind> follow_substitution(std::shared_ptr<Kind> k) {
-    if (k->get_form() != kindform::variable) {
-        return k;
+    std::shared_ptr<Kind> found = k;
+    while (found->get_form() == kindform::variable && static_cast<KindVariable*>(found.get())->bound_to != nullptr) {
+        found = static_cast<KindVariable*>(found.get())->bound_to;
     }
-    auto v = std::dynamic_pointer_cast<KindVariable>(k);
-    if (v->bound_to == nullptr) {
-        return v;
+    while (k != found) {
+        auto variable = static_cast<KindVariable*>(k.get());
+        std::shared_ptr<Kind> next = std::move(variable->bound_to);
+        variable->bound_to = found;
+        k = std::move(next);
     }
-    return follow_substitution(v->bound_to);
+    return found;
 }
 
-bool occurs_check_ok(const std::shared_ptr<KindVariable> &v, const std::shared_ptr<Kind> &k) {
-    if (k == v) {
-        return false;
+// Binds the root of the shorter tree to the root of the taller one.
+void unify_variables(
+        KindVariable *a,
+        const std::shared_ptr<Kind> &a_kind,
+        KindVariable *b,
+        const std::shared_ptr<Kind> &b_kind) {
+    if (a->rank < b->rank) {
+        a->bound_to = b_kind;
+    } else {
+        if (a->rank == b->rank) {
+            a->rank++;
+        }
+        b->bound_to = a_kind;
     }
-    switch(k->get_form()) {
-        case kindform::variable:
-            if (std::dynamic_pointer_cast<KindVariable>(k)->bound_to == nullptr) {
-                return true;
-            }
-            return occurs_check_ok(v, std::dynamic_pointer_cast<KindVariable>(k)->bound_to);
-        case kindform::star:
-            return true;
-        case kindform::arrow:
-            return occurs_check_ok(v, std::dynamic_pointer_cast<ArrowKind>(k)->left) &&
-                   occurs_check_ok(v, std::dynamic_pointer_cast<ArrowKind>(k)->right);
+}
+
+bool occurs_check_ok(const KindVariable *v, const std::shared_ptr<Kind> &k) {
+    std::vector<const Kind*> to_visit = {k.get()};
+    while (!to_visit.empty()) {
+        const Kind *kind = to_visit.back();
+        to_visit.pop_back();
+        if (kind == v) {
+            return false;
+        }
+        switch(kind->get_form()) {
+            case kindform::variable:
+                if (static_cast<const KindVariable*>(kind)->bound_to != nullptr) {
+                    to_visit.push_back(follow_substitution(static_cast<const KindVariable*>(kind)->bound_to).get());
+                }
+                break;
+            case kindform::star:
+                break;
+            case kindform::arrow:
+                to_visit.push_back(static_cast<const ArrowKind*>(kind)->right.get());
+                to_visit.push_back(static_cast<const ArrowKind*>(kind)->left.get());
+                break;
+        }
     }
+    return true;
 }
 
 void unify(std::shared_ptr<Kind> a, std::shared_ptr<Kind> b) {
@@ -668,25 +1221,28 @@ void unify(std::shared_ptr<Kind> a, std::shared_ptr<Kind> b) {
     }
     if (a->get_form() == kindform::star && b->get_form() == kindform::star) {
         return;
+    } else if (a->get_form() == kindform::variable && b->get_form() == kindform::variable) {
+        unify_variables(static_cast<KindVariable*>(a.get()), a, static_cast<KindVariable*>(b.get()), b);
+        return;
     } else if (a->get_form() == kindform::variable) {
-        if (!occurs_check_ok(std::dynamic_pointer_cast<KindVariable>(a), b)) {
+        if (!occurs_check_ok(static_cast<KindVariable*>(a.get()), b)) {
             throw TypeError("Failed to unify kinds: occurs check failed.");
         }
-        std::dynamic_pointer_cast<KindVariable>(a)->bound_to = b;
+        static_cast<KindVariable*>(a.get())->bound_to = b;
         return;
     } else if (b->get_form() == kindform::variable) {
-        if (!occurs_check_ok(std::dynamic_pointer_cast<KindVariable>(b), a)) {
+        if (!occurs_check_ok(static_cast<KindVariable*>(b.get()), a)) {
             throw TypeError("Failed to unify kinds: occurs check failed.");
         }
-        std::dynamic_pointer_cast<KindVariable>(b)->bound_to = a;
+        static_cast<KindVariable*>(b.get())->bound_to = a;
         return;
     } else if (a->get_form() == kindform::arrow && b->get_form() == kindform::arrow) {
         unify(
-                std::dynamic_pointer_cast<ArrowKind>(a)->left,
-                std::dynamic_pointer_cast<ArrowKind>(b)->left);
+                static_cast<ArrowKind*>(a.get())->left,
+                static_cast<ArrowKind*>(b.get())->left);
         unify(
-                std::dynamic_pointer_cast<ArrowKind>(a)->right,
-                std::dynamic_pointer_cast<ArrowKind>(b)->right);
+                static_cast<ArrowKind*>(a.get())->right,
+                static_cast<ArrowKind*>(b.get())->right);
         return;
     }
 
@@ -701,11 +1257,11 @@ std::shared_ptr<Kind> generalise(const std::shared_ptr<Kind> &k) {
         case kindform::variable:
             return std::make_shared<StarKind>();
         case kindform::arrow:
-            auto left = generalise(std::dynamic_pointer_cast<ArrowKind>(kind)->left);
-            auto right = generalise(std::dynamic_pointer_cast<ArrowKind>(kind)->right);
+            auto left = generalise(static_cast<ArrowKind*>(kind.get())->left);
+            auto right = generalise(static_cast<ArrowKind*>(kind.get())->right);
             if (
-                    left != std::dynamic_pointer_cast<ArrowKind>(kind)->left ||
-                    right != std::dynamic_pointer_cast<ArrowKind>(kind)->right) {
+                    left != static_cast<ArrowKind*>(kind.get())->left ||
+                    right != static_cast<ArrowKind*>(kind.get())->right) {
                 return std::make_shared<ArrowKind>(left, right);
             } else {
                 return kind;
@@ -715,32 +1271,32 @@ std::shared_ptr<Kind> generalise(const std::shared_ptr<Kind> &k) {
 
 std::shared_ptr<Kind> kind_inference(
         const std::shared_ptr<Type> &t,
-        const std::map<std::string, std::shared_ptr<Kind>> &variable_kinds,
-        const std::map<std::string, std::shared_ptr<Kind>> &type_constructor_kinds) {
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &variable_kinds,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds) {
     switch(t->get_form()) {
         case typeform::variable:
             throw TypeError("cannot infer kind of instantiated type variable.");
         case typeform::universallyquantifiedvariable:
-            if (variable_kinds.count(std::dynamic_pointer_cast<UniversallyQuantifiedVariable>(t)->id) == 0) {
+            if (variable_kinds.count(static_cast<UniversallyQuantifiedVariable*>(t.get())->id) == 0) {
                 throw TypeError(
                         "unbound type variable \"" +
-                        std::dynamic_pointer_cast<UniversallyQuantifiedVariable>(t)->id + "\".");
+                        static_cast<UniversallyQuantifiedVariable*>(t.get())->id.str() + "\".");
             }
-            return variable_kinds.at(std::dynamic_pointer_cast<UniversallyQuantifiedVariable>(t)->id);
+            return variable_kinds.at(static_cast<UniversallyQuantifiedVariable*>(t.get())->id);
         case typeform::constructor:
-            if (type_constructor_kinds.count(std::dynamic_pointer_cast<TypeConstructor>(t)->id) == 0) {
+            if (type_constructor_kinds.count(static_cast<TypeConstructor*>(t.get())->id) == 0) {
                 throw TypeError(
                         "unbound type constructor \"" +
-                        std::dynamic_pointer_cast<TypeConstructor>(t)->id + "\".");
+                        static_cast<TypeConstructor*>(t.get())->id.str() + "\".");
             }
-            return type_constructor_kinds.at(std::dynamic_pointer_cast<TypeConstructor>(t)->id);
+            return type_constructor_kinds.at(static_cast<TypeConstructor*>(t.get())->id);
         case typeform::application: {
             std::shared_ptr<Kind> left_kind = kind_inference(
-                    dynamic_cast<TypeApplication*>(t.get())->left,
+                    static_cast<TypeApplication*>(t.get())->left,
                     variable_kinds,
                     type_constructor_kinds);
             std::shared_ptr<Kind> right_kind = kind_inference(
-                    dynamic_cast<TypeApplication*>(t.get())->right,
+                    static_cast<TypeApplication*>(t.get())->right,
                     variable_kinds,
                     type_constructor_kinds);
             std::shared_ptr<Kind> kind = std::make_shared<KindVariable>();
@@ -755,106 +1311,199 @@ std::shared_ptr<Kind> kind_inference(
     }
 }
 
-std::set<std::string> find_universally_quantified_variable_names(std::shared_ptr<Type> type) {
+std::set<Symbol> find_universally_quantified_variable_names(std::shared_ptr<Type> type) {
     type = follow_substitution(type);
     switch (type->get_form()) {
         case typeform::constructor:
         case typeform::variable:
             return {};
         case typeform::universallyquantifiedvariable:
-            return {std::dynamic_pointer_cast<UniversallyQuantifiedVariable>(type)->id};
+            return {static_cast<UniversallyQuantifiedVariable*>(type.get())->id};
         case typeform::application: {
-            std::set<std::string> left = find_universally_quantified_variable_names(
-                    std::dynamic_pointer_cast<TypeApplication>(type)->left);
-            std::set<std::string> right = find_universally_quantified_variable_names(
-                    std::dynamic_pointer_cast<TypeApplication>(type)->right);
+            std::set<Symbol> left = find_universally_quantified_variable_names(
+                    static_cast<TypeApplication*>(type.get())->left);
+            std::set<Symbol> right = find_universally_quantified_variable_names(
+                    static_cast<TypeApplication*>(type.get())->right);
             left.insert(right.begin(), right.end());
             return left;
         }
     }
 }
 
-std::vector<std::vector<std::string>> dependency_analysis(
-        std::vector<std::string> names,
-        const std::map<std::string, std::set<std::string>> &dependencies) {
-    std::vector<std::vector<std::string>> dependency_groups;
-
-    std::vector<std::vector<std::string>> stack;
-    while (!names.empty()) {
-        stack.push_back({names.back()});
-        names.pop_back();
-
-        while (!stack.empty()) {
-            std::vector<std::string> current = stack.back();
-            stack.pop_back();
-
-            std::set<std::string> depends_on;
-            for (const auto &name: current) {
-                for (const auto &dependency: dependencies.at(name)) {
-                    depends_on.insert(dependency);
-                }
+// Tarjan's algorithm, which finds the strongly connected components of the dependency graph in a single depth first
+// search, in O(names + dependencies). Each component is completed only after every component it depends on, so the
+// groups come out in an order in which they can be type checked or translated. The search is driven by an explicit
+// stack, since chains of dependencies can be as long as the program.
+std::vector<std::vector<Symbol>> dependency_analysis(
+        const std::vector<Symbol> &names,
+        const std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> &dependencies) {
+    std::unordered_map<Symbol, size_t> indices;
+    for (size_t i = 0; i < names.size(); i++) {
+        indices[names[i]] = i;
+    }
+    // The dependencies of each name on other names in the list, as indices into it.
+    std::vector<std::vector<size_t>> edges(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        for (const Symbol &dependency: dependencies.at(names[i])) {
+            auto found = indices.find(dependency);
+            if (found != indices.end()) {
+                edges[i].push_back(found->second);
             }
+        }
+    }
 
-            bool dependencies_ok = true;
-            for (const auto &dependency: depends_on) {
-                const auto &iterator = std::find(names.begin(), names.end(), dependency);
-                if (iterator != names.end()) {
-                    stack.push_back(current);
-                    stack.push_back({dependency});
-                    names.erase(iterator);
-                    dependencies_ok = false;
-                    break;
-                } else {
-                    for (int i = 0; i < stack.size(); i++) {
-                        if (std::count(stack[i].begin(), stack[i].end(), dependency) > 0) {
-                            size_t number_to_pop = stack.size() - i;
-                            std::vector<std::string> new_group;
-                            for (int j = 0; j < number_to_pop; j++) {
-                                new_group.insert(new_group.end(), stack.back().begin(), stack.back().end());
-                                stack.pop_back();
-                            }
-                            new_group.insert(new_group.end(), current.begin(), current.end());
-                            stack.push_back(new_group);
-                            dependencies_ok = false;
-                            break;
-                        }
-                    }
-                    if (!dependencies_ok) {
-                        break;
-                    }
+    const size_t unvisited = std::numeric_limits<size_t>::max();
+    std::vector<size_t> order(names.size(), unvisited);
+    std::vector<size_t> low_link(names.size());
+    std::vector<bool> on_stack(names.size(), false);
+    std::vector<size_t> stack;
+    // The names being searched from, each with the position of the next of its dependencies to follow.
+    std::vector<std::pair<size_t, size_t>> search;
+    size_t next_order = 0;
+
+    std::vector<std::vector<Symbol>> dependency_groups;
+    for (size_t root = names.size(); root-- > 0;) {
+        if (order[root] != unvisited) {
+            continue;
+        }
+        search.emplace_back(root, 0);
+        order[root] = low_link[root] = next_order++;
+        stack.push_back(root);
+        on_stack[root] = true;
+        while (!search.empty()) {
+            auto &[name, next_edge] = search.back();
+            if (next_edge < edges[name].size()) {
+                size_t dependency = edges[name][next_edge++];
+                if (order[dependency] == unvisited) {
+                    order[dependency] = low_link[dependency] = next_order++;
+                    stack.push_back(dependency);
+                    on_stack[dependency] = true;
+                    search.emplace_back(dependency, 0);
+                } else if (on_stack[dependency]) {
+                    low_link[name] = std::min(low_link[name], order[dependency]);
                 }
+                continue;
             }
 
-            if (dependencies_ok) {
-                dependency_groups.push_back(current);
+            size_t finished = name;
+            search.pop_back();
+            if (!search.empty()) {
+                size_t parent = search.back().first;
+                low_link[parent] = std::min(low_link[parent], low_link[finished]);
+            }
+            if (low_link[finished] == order[finished]) {
+                std::vector<Symbol> group;
+                size_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    group.push_back(names[member]);
+                } while (member != finished);
+                dependency_groups.push_back(std::move(group));
             }
         }
     }
     return dependency_groups;
 }
 
-std::map<std::string, std::shared_ptr<Type>> type_inference_declarations(
-        const std::map<std::string, std::shared_ptr<Type>> &assumptions,
-        const std::map<std::string, size_t> &data_constructor_arities,
-        const std::map<std::string, std::shared_ptr<Kind>> &type_constructor_kinds,
-        const std::map<std::string, std::unique_ptr<Expression>> &declarations,
-        const std::map<std::string, std::shared_ptr<Type>> &type_signatures) {
-    std::map<std::string, std::shared_ptr<Type>> local_assumptions = assumptions;
+// Runs a task for each index on as many threads as there are cores. A task is started once the tasks it depends on,
+// those that list it among their dependents, have finished, and whichever thread is free takes the next task that
+// is ready. If tasks fail, the tasks that depend on them are not run, and the error of the first task to fail in
+// order of index is rethrown, which is the error a serial run in that order would have stopped at.
+void run_in_parallel(const std::vector<std::vector<size_t>> &dependents, const std::function<void(size_t)> &task) {
+    std::vector<size_t> waiting_for(dependents.size(), 0);
+    for (const auto &ds: dependents) {
+        for (size_t d: ds) {
+            waiting_for[d]++;
+        }
+    }
+    // Ready tasks are taken from the back, so the tasks that come first are started first.
+    std::vector<size_t> ready;
+    for (size_t i = dependents.size(); i-- > 0;) {
+        if (waiting_for[i] == 0) {
+            ready.push_back(i);
+        }
+    }
 
-    std::map<std::string, std::set<std::string>> free_variables;
+    std::vector<std::exception_ptr> errors(dependents.size());
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t running = 0;
+    auto work = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&]() { return !ready.empty() || running == 0; });
+            if (ready.empty()) {
+                return;
+            }
+            size_t i = ready.back();
+            ready.pop_back();
+            running++;
+            lock.unlock();
+            try {
+                task(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            lock.lock();
+            running--;
+            if (!errors[i]) {
+                for (auto d = dependents[i].rbegin(); d != dependents[i].rend(); d++) {
+                    if (--waiting_for[*d] == 0) {
+                        ready.push_back(*d);
+                    }
+                }
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    size_t number_of_threads = std::min<size_t>(
+            dependents.size(),
+            std::max(1u, std::thread::hardware_concurrency()));
+    for (size_t i = 1; i < number_of_threads; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (const auto &error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
 
-    std::vector<std::string> explicitly_typed_bindings;
-    std::vector<std::string> implicitly_typed_bindings;
+void type_inference_declarations(
+        ScopedMap<std::shared_ptr<Type>> &assumptions,
+        const std::unordered_map<Symbol, size_t> &data_constructor_arities,
+        const std::unordered_map<Symbol, std::shared_ptr<Kind>> &type_constructor_kinds,
+        const std::map<Symbol, std::unique_ptr<Expression>, SpellingOrder> &declarations,
+        const std::map<Symbol, std::shared_ptr<Type>, SpellingOrder> &type_signatures,
+        const std::unordered_map<Symbol, std::shared_ptr<Type>> &checked_types,
+        unsigned int level,
+        TypeCache *cache,
+        CompileStatistics *statistics) {
+    std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> free_variables;
+
+    std::vector<Symbol> explicitly_typed_bindings;
+    std::vector<Symbol> implicitly_typed_bindings;
 
     for (const auto &[name, type]: type_signatures) {
+        if (checked_types.count(name) > 0) {
+            continue;
+        }
         if (declarations.count(name) == 0) {
             throw TypeError(
                     "Type signature for \"" +
-                    name +
+                    name.str() +
                     "\" with no matching binding.");
         }
-        std::map<std::string, std::shared_ptr<Kind>> variable_kinds;
-        for (const std::string &v: find_universally_quantified_variable_names(type)) {
+        std::unordered_map<Symbol, std::shared_ptr<Kind>> variable_kinds;
+        for (const Symbol &v: find_universally_quantified_variable_names(type)) {
             variable_kinds[v] = std::make_shared<KindVariable>();
         }
         std::shared_ptr<Kind> kind;
@@ -863,7 +1512,7 @@ std::map<std::string, std::shared_ptr<Type>> type_inference_declarations(
         } catch (const TypeError &e) {
             throw TypeError(
                     "Type signature for \"" +
-                    name +
+                    name.str() +
                     "\" with invalid type: " +
                     e.what());
         }
@@ -872,13 +1521,15 @@ std::map<std::string, std::shared_ptr<Type>> type_inference_declarations(
         } catch (const TypeError &e) {
             throw TypeError(
                     "Type signature for " +
-                    name +
+                    name.str() +
                     " with invalid type.");
         }
     }
 
     for (const auto &[name, definition]: declarations) {
-        if (type_signatures.count(name) > 0) {
+        if (checked_types.count(name) > 0) {
+            assumptions.bind(name, hash_cons(checked_types.at(name)));
+        } else if (type_signatures.count(name) > 0) {
             explicitly_typed_bindings.push_back(name);
         } else {
             implicitly_typed_bindings.push_back(name);
@@ -887,90 +1538,297 @@ std::map<std::string, std::shared_ptr<Type>> type_inference_declarations(
     }
 
     for (const auto &name: explicitly_typed_bindings) {
-        local_assumptions[name] = type_signatures.at(name);
+        assumptions.bind(name, hash_cons(type_signatures.at(name)));
     }
 
-    std::vector<std::vector<std::string>> dependency_groups = dependency_analysis(
+    std::vector<std::vector<Symbol>> dependency_groups = dependency_analysis(
             implicitly_typed_bindings,
             free_variables);
 
-
-    for (const auto &current: dependency_groups) {
-        for (const auto &name: current) {
-            local_assumptions[name] = std::make_shared<TypeVariable>();
+    auto infer_group = [&](
+            ScopedMap<std::shared_ptr<Type>> &group_assumptions,
+            const std::vector<Symbol> &group) {
+        std::string description;
+        if (cache != nullptr) {
+            description = TypeCache::describe(
+                    group,
+                    declarations,
+                    type_signatures,
+                    group_assumptions,
+                    type_constructor_kinds);
+            if (auto schemes = cache->load(description, group)) {
+                for (size_t i = 0; i < group.size(); i++) {
+                    group_assumptions.bind(group[i], (*schemes)[i]);
+                }
+                return;
+            }
+        }
+        for (const auto &name: group) {
+            group_assumptions.bind(name, std::make_shared<TypeVariable>(level + 1));
         }
-        for (const auto &name: current) {
+        for (const auto &name: group) {
+            InferenceTimer timer(statistics, name);
             std::shared_ptr<Type> type = type_inference_expression(
-                    local_assumptions,
+                    group_assumptions,
                     data_constructor_arities,
                     type_constructor_kinds,
-                    declarations.at(name));
+                    declarations.at(name),
+                    level + 1);
             try {
-                unify(type, local_assumptions[name]);
+                unify(type, group_assumptions.at(name));
             } catch (const TypeError &e) {
                 throw TypeError(
                         "Line " +
                         std::to_string(declarations.at(name)->line) +
                         ": could not deduce type for name " +
-                        name + ".");
+                        name.str() + ".");
             }
         }
-        for (const auto &name: current) {
-            local_assumptions[name] = generalise(local_assumptions[name], assumptions);
+        std::vector<std::shared_ptr<Type>> schemes;
+        for (const auto &name: group) {
+            schemes.push_back(generalise(group_assumptions.at(name), level));
+            group_assumptions.bind(name, schemes.back());
+        }
+        if (cache != nullptr) {
+            cache->store(description, group, schemes);
+        }
+    };
+
+    auto check_explicitly_typed_binding = [&](
+            ScopedMap<std::shared_ptr<Type>> &binding_assumptions,
+            const Symbol &name) {
+        // Top-level assumptions have no type variables that those of the signature could escape into, so top-level
+        // bindings are checked against their signatures directly. A binding found in the cache has been checked
+        // against the same signature before.
+        if (level == 0) {
+            std::string description;
+            if (cache != nullptr) {
+                description = TypeCache::describe(
+                        {name},
+                        declarations,
+                        type_signatures,
+                        binding_assumptions,
+                        type_constructor_kinds);
+                if (cache->load(description, {name})) {
+                    return;
+                }
+            }
+            InferenceTimer timer(statistics, name);
+            type_check_expression(
+                    binding_assumptions,
+                    data_constructor_arities,
+                    type_constructor_kinds,
+                    declarations.at(name),
+                    skolemise(binding_assumptions.at(name)),
+                    level + 1);
+            if (cache != nullptr) {
+                cache->store(description, {name}, {binding_assumptions.at(name)});
+            }
+            return;
         }
-    }
-
-    for (const auto &name: explicitly_typed_bindings) {
         std::shared_ptr<Type> type = type_inference_expression(
-                local_assumptions,
+                binding_assumptions,
                 data_constructor_arities,
                 type_constructor_kinds,
-                declarations.at(name));
-        type = generalise(type, local_assumptions);
+                declarations.at(name),
+                level + 1);
+        type = generalise(type, level);
         try {
-            check_type_signature(type, local_assumptions[name]);
+            check_type_signature(type, binding_assumptions.at(name), level);
         } catch (const TypeError &e) {
             throw TypeError(
                     "Line " +
                     std::to_string(declarations.at(name)->line) +
                     ": could not confirm type for name " +
-                    name + ".");
+                    name.str() + ".");
+        }
+    };
+
+    // The types of nested declarations can depend on variables of the enclosing scopes that are still being
+    // inferred, so only top-level declarations, whose assumptions are all generalised, are inferred in parallel.
+    if (level > 0) {
+        for (const auto &group: dependency_groups) {
+            infer_group(assumptions, group);
         }
+        for (const auto &name: explicitly_typed_bindings) {
+            check_explicitly_typed_binding(assumptions, name);
+        }
+        return;
     }
 
-    return local_assumptions;
+    // A group can be inferred once the groups it depends on have been, with assumptions that extend the ones shared
+    // by all groups with the types of the names it uses from those groups.
+    std::unordered_map<Symbol, size_t> group_of;
+    for (size_t i = 0; i < dependency_groups.size(); i++) {
+        for (const auto &name: dependency_groups[i]) {
+            group_of[name] = i;
+        }
+    }
+    std::vector<std::vector<size_t>> dependents(dependency_groups.size());
+    std::vector<std::set<Symbol>> names_used(dependency_groups.size());
+    for (size_t i = 0; i < dependency_groups.size(); i++) {
+        std::set<size_t> depends_on;
+        for (const auto &name: dependency_groups[i]) {
+            for (const auto &free_variable: free_variables.at(name)) {
+                auto found = group_of.find(free_variable);
+                if (found != group_of.end() && found->second != i) {
+                    depends_on.insert(found->second);
+                    names_used[i].insert(free_variable);
+                }
+            }
+        }
+        for (size_t dependency: depends_on) {
+            dependents[dependency].push_back(i);
+        }
+    }
+    std::vector<std::unordered_map<Symbol, std::shared_ptr<Type>>> inferred(dependency_groups.size());
+    run_in_parallel(dependents, [&](size_t i) {
+        ScopedMap<std::shared_ptr<Type>> group_assumptions(&assumptions);
+        for (const auto &name: names_used[i]) {
+            group_assumptions.bind(name, inferred[group_of.at(name)].at(name));
+        }
+        infer_group(group_assumptions, dependency_groups[i]);
+        for (const auto &name: dependency_groups[i]) {
+            inferred[i][name] = group_assumptions.at(name);
+        }
+    });
+    for (const auto &types: inferred) {
+        for (const auto &[name, type]: types) {
+            assumptions.bind(name, type);
+        }
+    }
+
+    run_in_parallel(std::vector<std::vector<size_t>>(explicitly_typed_bindings.size()), [&](size_t i) {
+        ScopedMap<std::shared_ptr<Type>> binding_assumptions(&assumptions);
+        check_explicitly_typed_binding(binding_assumptions, explicitly_typed_bindings[i]);
+    });
 }
 
-std::set<std::string> find_referenced_type_constructors(std::shared_ptr<Type> t) {
+std::set<Symbol, SpellingOrder> find_referenced_type_constructors(std::shared_ptr<Type> t) {
     t = follow_substitution(t);
     switch(t->get_form()) {
         case typeform::universallyquantifiedvariable:
         case typeform::variable:
             return {};
         case typeform::application: {
-            std::set<std::string> left = find_referenced_type_constructors(
-                    std::dynamic_pointer_cast<TypeApplication>(t)->left);
-            std::set<std::string> right = find_referenced_type_constructors(
-                    std::dynamic_pointer_cast<TypeApplication>(t)->right);
+            std::set<Symbol, SpellingOrder> left = find_referenced_type_constructors(
+                    static_cast<TypeApplication*>(t.get())->left);
+            std::set<Symbol, SpellingOrder> right = find_referenced_type_constructors(
+                    static_cast<TypeApplication*>(t.get())->right);
             left.insert(right.begin(), right.end());
             return left;
         }
         case typeform::constructor:
-            return {std::dynamic_pointer_cast<TypeConstructor>(t)->id};
+            return {static_cast<TypeConstructor*>(t.get())->id};
     }
 }
 
-void type_check(const std::unique_ptr<Program> &program, bool check_for_main) {
-    std::map<std::string, std::shared_ptr<Type>> assumptions;
+// Turns the type constructors that skolemise made of the variables of a signature back into those variables. Data
+// constructors are capitalised, so type constructors named like variables can only have come from skolemise.
+std::shared_ptr<Type> unskolemise(const std::shared_ptr<Type> &t) {
+    switch(t->get_form()) {
+        case typeform::constructor: {
+            const Symbol &id = static_cast<TypeConstructor*>(t.get())->id;
+            if (std::islower(static_cast<unsigned char>(id.str()[0]))) {
+                return make_universally_quantified_variable(id);
+            }
+            return t;
+        }
+        case typeform::application: {
+            std::shared_ptr<Type> left = unskolemise(static_cast<TypeApplication*>(t.get())->left);
+            std::shared_ptr<Type> right = unskolemise(static_cast<TypeApplication*>(t.get())->right);
+            if (
+                    left == static_cast<TypeApplication*>(t.get())->left &&
+                    right == static_cast<TypeApplication*>(t.get())->right) {
+                return t;
+            }
+            return make_type_application(left, right);
+        }
+        default:
+            return t;
+    }
+}
 
-    std::map<std::string, std::shared_ptr<Kind>> type_constructor_kinds;
+// Replaces the types recorded on the expressions and patterns of a definition with their final types, in which
+// every bound type variable has been replaced by its binding. Variables left unbound were generalised, and stand for
+// any type.
+void record_final_types(const std::unique_ptr<Expression> &definition) {
+    std::vector<Expression*> to_visit = {definition.get()};
+    std::vector<Pattern*> patterns;
+    while (!to_visit.empty()) {
+        Expression *expression = to_visit.back();
+        to_visit.pop_back();
+        if (expression->type != nullptr) {
+            expression->type = unskolemise(hash_cons(expression->type));
+        }
+        switch(expression->get_form()) {
+            case expform::abstraction:
+                to_visit.push_back(static_cast<Abstraction*>(expression)->body.get());
+                break;
+            case expform::application:
+                to_visit.push_back(static_cast<Application*>(expression)->function.get());
+                for (const auto &argument: static_cast<Application*>(expression)->arguments) {
+                    to_visit.push_back(argument.get());
+                }
+                break;
+            case expform::cAsE:
+                to_visit.push_back(static_cast<Case*>(expression)->exp.get());
+                for (const auto &[pattern, alt_expression]: static_cast<Case*>(expression)->alts) {
+                    patterns.push_back(pattern.get());
+                    to_visit.push_back(alt_expression.get());
+                }
+                break;
+            case expform::let:
+                for (const auto &[_, binding]: static_cast<Let*>(expression)->bindings) {
+                    to_visit.push_back(binding.get());
+                }
+                to_visit.push_back(static_cast<Let*>(expression)->e.get());
+                break;
+            case expform::builtinop:
+                if (static_cast<BuiltInOp*>(expression)->left != nullptr) {
+                    to_visit.push_back(static_cast<BuiltInOp*>(expression)->left.get());
+                }
+                to_visit.push_back(static_cast<BuiltInOp*>(expression)->right.get());
+                break;
+            default:
+                break;
+        }
+        while (!patterns.empty()) {
+            Pattern *pattern = patterns.back();
+            patterns.pop_back();
+            if (pattern->type != nullptr) {
+                pattern->type = unskolemise(hash_cons(pattern->type));
+            }
+            if (pattern->get_form() == patternform::constructor) {
+                for (const auto &arg: static_cast<ConstructorPattern*>(pattern)->args) {
+                    patterns.push_back(arg.get());
+                }
+            }
+        }
+    }
+}
+
+void type_check(
+        const std::unique_ptr<Program> &program,
+        bool check_for_main,
+        TypeCache *cache,
+        CompileStatistics *statistics) {
+    ScopedMap<std::shared_ptr<Type>> assumptions;
+    for (const auto &[name, type]: program->types) {
+        assumptions.bind(name, hash_cons(type));
+    }
 
-    std::vector<std::string> type_constructor_names;
-    std::map<std::string, std::set<std::string>> free_type_constructors;
+    std::unordered_map<Symbol, std::shared_ptr<Kind>> type_constructor_kinds = program->type_constructor_kinds;
+
+    std::vector<Symbol> type_constructor_names;
+    std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> free_type_constructors;
 
     for (const auto &[name, constructor]: program->type_constructors) {
+        if (type_constructor_kinds.count(name) > 0) {
+            continue;
+        }
         type_constructor_names.push_back(name);
-        std::set<std::string> referenced_type_constructors;
+        std::set<Symbol, SpellingOrder> referenced_type_constructors;
         for (const auto &data_constructor: constructor->data_constructors) {
             for (const auto &type: program->data_constructors[data_constructor]->types) {
                 const auto &cs = find_referenced_type_constructors(type);
@@ -980,14 +1838,14 @@ void type_check(const std::unique_ptr<Program> &program, bool check_for_main) {
         free_type_constructors[name] = referenced_type_constructors;
     }
 
-    std::vector<std::vector<std::string>> dependency_groups = dependency_analysis(
+    std::vector<std::vector<Symbol>> dependency_groups = dependency_analysis(
             type_constructor_names,
             free_type_constructors);
 
     for (const auto &current: dependency_groups) {
-        std::map<std::string, std::map<std::string, std::shared_ptr<Kind>>> argument_variable_kinds;
-        for (const std::string &type_constructor: current) {
-            std::map<std::string, std::shared_ptr<Kind>> arg_kinds;
+        std::unordered_map<Symbol, std::unordered_map<Symbol, std::shared_ptr<Kind>>> argument_variable_kinds;
+        for (const Symbol &type_constructor: current) {
+            std::unordered_map<Symbol, std::shared_ptr<Kind>> arg_kinds;
             std::shared_ptr<Kind> type_constructor_kind = std::make_shared<StarKind>();
             for (int i = program->type_constructors.at(type_constructor)->argument_variables.size() - 1; i >= 0; i--) {
                 std::shared_ptr<Kind> k = std::make_shared<KindVariable>();
@@ -997,14 +1855,14 @@ void type_check(const std::unique_ptr<Program> &program, bool check_for_main) {
             argument_variable_kinds[type_constructor] = arg_kinds;
             type_constructor_kinds[type_constructor] = type_constructor_kind;
         }
-        for (const std::string &type_constructor: current) {
-            std::shared_ptr<Type> base_data_constructor_type = std::make_shared<TypeConstructor>(type_constructor);
-            for (const std::string &variable: program->type_constructors[type_constructor]->argument_variables) {
-                base_data_constructor_type = std::make_shared<TypeApplication>(
+        for (const Symbol &type_constructor: current) {
+            std::shared_ptr<Type> base_data_constructor_type = make_type_constructor(type_constructor);
+            for (const Symbol &variable: program->type_constructors[type_constructor]->argument_variables) {
+                base_data_constructor_type = make_type_application(
                         base_data_constructor_type,
-                        std::make_shared<UniversallyQuantifiedVariable>(variable));
+                        make_universally_quantified_variable(variable));
             }
-            for (const std::string &data_constructor: program->type_constructors[type_constructor]->data_constructors) {
+            for (const Symbol &data_constructor: program->type_constructors[type_constructor]->data_constructors) {
                 std::shared_ptr<Type> data_constructor_type = base_data_constructor_type;
                 for (int i = program->data_constructors[data_constructor]->types.size() - 1; i >= 0; i--) {
                     std::shared_ptr<Kind> k;
@@ -1027,39 +1885,52 @@ void type_check(const std::unique_ptr<Program> &program, bool check_for_main) {
                                 std::to_string(program->data_constructors[data_constructor]->line) +
                                 " invalid type in data constructor.");
                     }
-                    data_constructor_type = std::make_shared<TypeApplication>(
-                            std::make_shared<TypeApplication>(
-                                    std::make_shared<TypeConstructor>("->"),
-                                    program->data_constructors[data_constructor]->types[i]),
-                                    data_constructor_type);
+                    data_constructor_type = make_function_type(
+                            hash_cons(program->data_constructors[data_constructor]->types[i]),
+                            data_constructor_type);
                 }
-                assumptions[data_constructor] = data_constructor_type;
+                assumptions.bind(data_constructor, data_constructor_type);
             }
         }
-        for (const std::string &type_constructor: current) {
+        for (const Symbol &type_constructor: current) {
             type_constructor_kinds[type_constructor] = generalise(type_constructor_kinds[type_constructor]);
         }
     }
 
-    std::map<std::string, std::shared_ptr<Type>> result = type_inference_declarations(
+    type_inference_declarations(
             assumptions,
             program->data_constructor_arities,
             type_constructor_kinds,
             program->bindings,
-            program->type_signatures);
+            program->type_signatures,
+            program->types,
+            0,
+            cache,
+            statistics);
+    for (const auto &[_, definition]: program->bindings) {
+        record_final_types(definition);
+    }
+
+    program->type_constructor_kinds = type_constructor_kinds;
+    for (const auto &[name, _]: program->data_constructors) {
+        program->types[name] = assumptions.at(name);
+    }
+    for (const auto &[name, _]: program->bindings) {
+        program->types[name] = assumptions.at(name);
+    }
 
     if (check_for_main) {
-        if (result.count("main") > 0) {
-            auto main_type = follow_substitution(result.at("main"));
+        if (assumptions.count(Symbol("main")) > 0) {
+            auto main_type = follow_substitution(assumptions.at(Symbol("main")));
             if (main_type->get_form() == typeform::application) {
                 auto left = follow_substitution(
-                        std::dynamic_pointer_cast<TypeApplication>(main_type)->left);
+                        static_cast<TypeApplication*>(main_type.get())->left);
                 auto right = follow_substitution(
-                        std::dynamic_pointer_cast<TypeApplication>(main_type)->right);
+                        static_cast<TypeApplication*>(main_type.get())->right);
                 if (left->get_form() == typeform::constructor && right->get_form() == typeform::constructor) {
-                    auto left_id = std::dynamic_pointer_cast<TypeConstructor>(left)->id;
-                    auto right_id = std::dynamic_pointer_cast<TypeConstructor>(right)->id;
-                    if (left_id == "[]" && right_id == "Char") {
+                    auto left_id = static_cast<TypeConstructor*>(left.get())->id;
+                    auto right_id = static_cast<TypeConstructor*>(right.get())->id;
+                    if (left_id == Symbol("[]") && right_id == Symbol("Char")) {
                         return;
                     }
                 }
@@ -0,0 +1,27 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include "test/test_utilities.hpp"
+#include "generation/generation.hpp"
+#include "stg/stg.hpp"
+#include "types/type_check.hpp"
+
+static std::string generate(const char *source) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    EXPECT_EQ(parse_string(source, program.get()), 0);
+    type_check(program, false);
+    std::stringstream code;
+    generate_target_code(translate(program), code);
+    return code.str();
+}
+
+TEST(Generation, UnpacksStringsOnlyWhenThereAreAny) {
+    std::string code = generate("main = \"ab\"");
+    EXPECT_NE(code.find(".unpack_string_entry_code:"), std::string::npos);
+    EXPECT_NE(code.find(".Nil_closure:"), std::string::npos);
+
+    // A program that builds lists without [] and has no string literals does not need the code that unpacks them.
+    code = generate("main = let { xs = 'a' : xs } in xs");
+    EXPECT_EQ(code.find(".unpack_string_entry_code"), std::string::npos);
+    EXPECT_NE(code.find(".Cons_standard_entry_code:"), std::string::npos);
+}
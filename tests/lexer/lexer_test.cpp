@@ -1,4 +1,7 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <string>
 #include <vector>
 #include "test/test_utilities.hpp"
 #include "parser/parser.hpp"
@@ -34,7 +37,7 @@
     auto result = lex_string(str);                                       \
     ASSERT_EQ(result.size(), 1);                                         \
     ASSERT_EQ(result[0].kind(), yy::parser::symbol_kind_type::S_STRING); \
-    EXPECT_EQ(result[0].value.as<std::string>(), s);                     \
+    EXPECT_EQ(result[0].value.as<std::string_view>(), s);                \
 }
 
 TEST(Lexer, RecognisesKeywords) {
@@ -251,8 +254,8 @@ TEST(Lexer, HandlesStringLiterals) {
     ASSERT_EQ(result.size(), 2);
     ASSERT_EQ(result[0].kind(), yy::parser::symbol_kind_type::S_STRING);
     ASSERT_EQ(result[1].kind(), yy::parser::symbol_kind_type::S_STRING);
-    EXPECT_EQ(result[0].value.as<std::string>(), "abc123");
-    EXPECT_EQ(result[1].value.as<std::string>(), "abc143");
+    EXPECT_EQ(result[0].value.as<std::string_view>(), "abc123");
+    EXPECT_EQ(result[1].value.as<std::string_view>(), "abc143");
 
     EXPECT_STRING(R"("a bc\&123")", "a bc123");
     EXPECT_STRING(R"("")", "");
@@ -310,3 +313,40 @@ TEST(Lexer, TracksLocations) {
     EXPECT_EQ(result[5].location.end.line, 9);
     EXPECT_EQ(result[5].location.end.column, 11);
 }
+
+TEST(Lexer, LexesMappedFilesInPlace) {
+    std::string path = (std::filesystem::temp_directory_path() / "picohaskell_lexer_test.hs").string();
+    FILE *file = fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    fputs("main = \"in\\tplace\" Identifier", file);
+    fclose(file);
+
+    auto source = SourceBuffer::map_file(path.c_str());
+    std::remove(path.c_str());
+    ASSERT_NE(source, nullptr);
+    const char *begin = source->data();
+    const char *end = source->data() + source->size();
+
+    auto result = lex_source(std::move(source));
+    ASSERT_EQ(result.size(), 4);
+    ASSERT_EQ(result[0].kind(), yy::parser::symbol_kind_type::S_VARID);
+    ASSERT_EQ(result[2].kind(), yy::parser::symbol_kind_type::S_STRING);
+    ASSERT_EQ(result[3].kind(), yy::parser::symbol_kind_type::S_CONID);
+    EXPECT_EQ(result[0].value.as<Symbol>(), Symbol("main"));
+    EXPECT_EQ(result[2].value.as<std::string_view>(), "in\tplace");
+    EXPECT_EQ(result[3].value.as<Symbol>(), Symbol("Identifier"));
+    const char *data = result[2].value.as<std::string_view>().data();
+    EXPECT_TRUE(data >= begin && data < end);
+}
+
+TEST(Lexer, InternsIdentifiers) {
+    auto result = lex_string("abc Abc abc Abc abd");
+    ASSERT_EQ(result.size(), 5);
+    EXPECT_EQ(result[0].value.as<Symbol>(), result[2].value.as<Symbol>());
+    EXPECT_EQ(result[1].value.as<Symbol>(), result[3].value.as<Symbol>());
+    EXPECT_NE(result[0].value.as<Symbol>(), result[1].value.as<Symbol>());
+    EXPECT_NE(result[0].value.as<Symbol>(), result[4].value.as<Symbol>());
+    EXPECT_EQ(result[0].value.as<Symbol>().str(), "abc");
+    EXPECT_EQ(result[1].value.as<Symbol>().str(), "Abc");
+    EXPECT_EQ(result[4].value.as<Symbol>().str(), "abd");
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "test/test_utilities.hpp"
+#include "modules/interface.hpp"
+#include "modules/modules.hpp"
+#include "types/type_check.hpp"
+
+static std::string make_directory() {
+    char directory[] = "/tmp/picohaskell_modules_XXXXXX";
+    return mkdtemp(directory);
+}
+
+static void write_module(const std::string &directory, const std::string &name, const std::string &source) {
+    std::ofstream(directory + "/" + name + ".hs") << source;
+}
+
+static ModuleReport compile_main(
+        const std::string &directory,
+        const char *source,
+        std::string *output = nullptr,
+        bool optimise = true) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    EXPECT_EQ(parse_string(source, program.get()), 0);
+    std::stringstream code;
+    ModuleReport report = compile_modules(program, directory, code, nullptr, nullptr, optimise);
+    if (output != nullptr) {
+        *output = code.str();
+    }
+    return report;
+}
+
+TEST(Modules, CompilesImportedModules) {
+    std::string directory = make_directory();
+    write_module(directory, "Colours",
+                 "module Colours where {\n"
+                 "data Colour = Red | Green\n"
+                 ";name c = case c of { Red -> \"red\" ; Green -> helper }\n"
+                 ";helper = \"green\"\n"
+                 "}");
+    const char *main = "import Colours\n;main = name Green";
+
+    std::string first;
+    ModuleReport report = compile_main(directory, main, &first);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Colours")}));
+    EXPECT_TRUE(report.up_to_date.empty());
+    EXPECT_NE(first.find("main_closure:"), std::string::npos);
+    EXPECT_NE(first.find("name_closure:"), std::string::npos);
+    EXPECT_NE(first.find("helper_closure:"), std::string::npos);
+    EXPECT_NE(first.find("Red_standard_entry_code:"), std::string::npos);
+
+    std::string second;
+    report = compile_main(directory, main, &second);
+    EXPECT_TRUE(report.compiled.empty());
+    EXPECT_EQ(report.up_to_date, std::vector<Symbol>({Symbol("Colours")}));
+    EXPECT_EQ(first, second);
+}
+
+TEST(Modules, RecompilesOnlyWhatChanged) {
+    std::string directory = make_directory();
+    write_module(directory, "Base", "module Base where {\nbase = 'a'\n}");
+    write_module(directory, "Left", "module Left where {\nimport Base\n;left = [base]\n}");
+    write_module(directory, "Right", "module Right where {\nimport Base\n;right = [base, base]\n}");
+    const char *main = "import Left\n;import Right\n;main = left";
+
+    ModuleReport report = compile_main(directory, main);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Base"), Symbol("Left"), Symbol("Right")}));
+
+    // A change that leaves the exports of Base alone does not affect the modules that import it.
+    write_module(directory, "Base", "module Base where {\nbase = 'b'\n}");
+    report = compile_main(directory, main);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Base")}));
+    EXPECT_EQ(report.up_to_date, std::vector<Symbol>({Symbol("Left"), Symbol("Right")}));
+
+    // Changing its type does, and here makes main an [Int].
+    write_module(directory, "Base", "module Base where {\nbase = 1\n}");
+    EXPECT_THROW(compile_main(directory, main), ModuleError);
+    write_module(directory, "Left", "module Left where {\nimport Base\n;left = \"left\"\n}");
+    report = compile_main(directory, main);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Left")}));
+    EXPECT_EQ(report.up_to_date, std::vector<Symbol>({Symbol("Base"), Symbol("Right")}));
+
+    // Code compiled with optimisation is not reused without it, nor the other way round.
+    report = compile_main(directory, main, nullptr, false);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Base"), Symbol("Left"), Symbol("Right")}));
+    report = compile_main(directory, main, nullptr, false);
+    EXPECT_TRUE(report.compiled.empty());
+    report = compile_main(directory, main);
+    EXPECT_EQ(report.compiled, std::vector<Symbol>({Symbol("Base"), Symbol("Left"), Symbol("Right")}));
+}
+
+TEST(Modules, ReportsErrors) {
+    std::string directory = make_directory();
+    write_module(directory, "A", "module A where {\nimport B\n;a = 'a'\n}");
+    write_module(directory, "B", "module B where {\nimport A\n;b = 'b'\n}");
+    EXPECT_THROW(compile_main(directory, "import A\n;main = [a]"), ModuleError);
+
+    write_module(directory, "B", "module B where {\nb = 'b'\n}");
+    write_module(directory, "C", "module C where {\nb = 'c'\n}");
+    EXPECT_THROW(compile_main(directory, "import B\n;import C\n;main = [b]"), ModuleError);
+    EXPECT_THROW(compile_main(directory, "import B\n;b = 'm'\n;main = [b]"), ModuleError);
+    EXPECT_THROW(compile_main(directory, "import Missing\n;main = \"\""), ModuleError);
+    EXPECT_THROW(compile_main(directory, "import C\n;main = [c]"), ModuleError);
+}
+
+TEST(Modules, InterfacesRoundTrip) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    program->module_name = Symbol("Trees");
+    int result = parse_string("data Tree a = Leaf | Node (Tree a) a (Tree a)\n;size t = 0", program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+
+    ModuleInterface interface;
+    interface.name = Symbol("Trees");
+    interface.imports = {Symbol("Lists")};
+    interface.source_hash = hash_bytes("source");
+    interface.optimised = true;
+    interface.dependencies[Symbol("Lists")] = 42;
+    interface.exports = write_exports(*program, {Symbol("Tree")}, {{Symbol("size"), 1}});
+    interface.export_hash = hash_bytes(interface.exports);
+    interface.data_constructors.emplace(Symbol("Node"), STGDataConstructor(1, 3, 1));
+    interface.prelude_bindings = {Symbol("error")};
+    interface.string_literals = true;
+
+    ModuleInterface loaded = read_interface(write_interface(interface));
+    EXPECT_EQ(loaded.name, interface.name);
+    EXPECT_EQ(loaded.imports, interface.imports);
+    EXPECT_EQ(loaded.source_hash, interface.source_hash);
+    EXPECT_EQ(loaded.optimised, interface.optimised);
+    EXPECT_EQ(loaded.dependencies, interface.dependencies);
+    EXPECT_EQ(loaded.exports, interface.exports);
+    EXPECT_EQ(loaded.export_hash, interface.export_hash);
+    ASSERT_EQ(loaded.data_constructors.count(Symbol("Node")), 1);
+    EXPECT_EQ(loaded.data_constructors.at(Symbol("Node")).arity, 3);
+    EXPECT_EQ(loaded.prelude_bindings, interface.prelude_bindings);
+    EXPECT_EQ(loaded.string_literals, interface.string_literals);
+
+    std::unique_ptr<Program> importer = std::make_unique<Program>();
+    parse_string("main = \"\"", importer.get());
+    import_exports(loaded, importer.get());
+    EXPECT_EQ(importer->type_constructors.count(Symbol("Tree")), 1);
+    EXPECT_EQ(importer->data_constructor_arities.at(Symbol("Node")), 3);
+    EXPECT_EQ(importer->imported_arities.at(Symbol("size")), 1);
+    EXPECT_TRUE(same_type(importer->types.at(Symbol("size")).get(), program->types.at(Symbol("size")).get()));
+    EXPECT_TRUE(same_type(importer->types.at(Symbol("Leaf")).get(), program->types.at(Symbol("Leaf")).get()));
+}
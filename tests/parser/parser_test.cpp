@@ -1,64 +1,68 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 #include "test/test_utilities.hpp"
 
 TEST(Parser, ParsesTypeSignatures) {
+    Arena arena;
     std::unique_ptr<Program> program = std::make_unique<Program>();
     int result = parse_string("a :: ()", program.get());
     ASSERT_EQ(result, 0);
     EXPECT_TRUE(
-            same_type(program->type_signatures["a"].get(),
-            std::make_unique<TypeConstructor>("()").get()));
+            same_type(program->type_signatures[Symbol("a")].get(),
+            new (arena) TypeConstructor(Symbol("()"))));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: [] Int", program.get());
     ASSERT_EQ(result, 0);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), make_list_type(new TypeConstructor("Int"))));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), make_list_type(arena, new (arena) TypeConstructor(Symbol("Int")))));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: [Int]", program.get());
     ASSERT_EQ(result, 0);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), make_list_type(new TypeConstructor("Int"))));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), make_list_type(arena, new (arena) TypeConstructor(Symbol("Int")))));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: Int -> Int -> Int", program.get());
     ASSERT_EQ(result, 0);
-    auto expected = make_function_type(new TypeConstructor("Int"), make_function_type(new TypeConstructor("Int"), new TypeConstructor("Int")));
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), expected));
+    auto expected = make_function_type(arena, new (arena) TypeConstructor(Symbol("Int")), make_function_type(arena, new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Int"))));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), expected));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: (->) Int (Int -> Int)", program.get());
     ASSERT_EQ(result, 0);
-    expected = make_function_type(new TypeConstructor("Int"), make_function_type(new TypeConstructor("Int"), new TypeConstructor("Int")));
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), expected));
+    expected = make_function_type(arena, new (arena) TypeConstructor(Symbol("Int")), make_function_type(arena, new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Int"))));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), expected));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: (Int -> Int) -> Int", program.get());
     ASSERT_EQ(result, 0);
-    expected = make_function_type(make_function_type(new TypeConstructor("Int"), new TypeConstructor("Int")), new TypeConstructor("Int"));
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), expected));
+    expected = make_function_type(arena, make_function_type(arena, new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Int"))), new (arena) TypeConstructor(Symbol("Int")));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), expected));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: cheesecake -> cheesecake", program.get());
     ASSERT_EQ(result, 0);
-    auto cheesecake = new UniversallyQuantifiedVariable("cheesecake");
-    expected = make_function_type(cheesecake, cheesecake);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), expected));
+    auto cheesecake = new (arena) UniversallyQuantifiedVariable(Symbol("cheesecake"));
+    expected = make_function_type(arena, cheesecake, cheesecake);
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), expected));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: (Int,Double)", program.get());
     ASSERT_EQ(result, 0);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), make_tuple_type({new TypeConstructor("Int"), new TypeConstructor("Double")})));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), make_tuple_type(arena, {new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Double"))})));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: (Int,Double,Int)", program.get());
     ASSERT_EQ(result, 0);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), make_tuple_type({new TypeConstructor("Int"), new TypeConstructor("Double"), new TypeConstructor("Int")})));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), make_tuple_type(arena, {new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Double")), new (arena) TypeConstructor(Symbol("Int"))})));
 
     program = std::make_unique<Program>();
     result = parse_string("a :: (,,) Int Double Int", program.get());
     ASSERT_EQ(result, 0);
-    EXPECT_TRUE(same_type(program->type_signatures["a"].get(), make_tuple_type({new TypeConstructor("Int"), new TypeConstructor("Double"), new TypeConstructor("Int")})));
+    EXPECT_TRUE(same_type(program->type_signatures[Symbol("a")].get(), make_tuple_type(arena, {new (arena) TypeConstructor(Symbol("Int")), new (arena) TypeConstructor(Symbol("Double")), new (arena) TypeConstructor(Symbol("Int"))})));
 }
 
 TEST(Parser, ParsesDataDecls) {
@@ -69,52 +73,52 @@ TEST(Parser, ParsesDataDecls) {
     program = std::make_unique<Program>();
     result = parse_string("data Hi", program.get());
     ASSERT_EQ(result, 0);
-    const auto &hi = program->type_constructors["Hi"];
+    const auto &hi = program->type_constructors[Symbol("Hi")];
 
     EXPECT_EQ(hi->line, 1);
-    EXPECT_EQ(hi->name, "Hi");
+    EXPECT_EQ(hi->name, Symbol("Hi"));
     EXPECT_EQ(hi->argument_variables.size(), 0);
     EXPECT_EQ(hi->data_constructors.size(), 0);
 
     program = std::make_unique<Program>();
     result = parse_string("data Hi = Bye | No", program.get());
     ASSERT_EQ(result, 0);
-    const auto &hi2 = program->type_constructors["Hi"];
+    const auto &hi2 = program->type_constructors[Symbol("Hi")];
 
     EXPECT_EQ(hi2->line, 1);
-    EXPECT_EQ(hi2->name, "Hi");
+    EXPECT_EQ(hi2->name, Symbol("Hi"));
     EXPECT_EQ(hi2->argument_variables.size(), 0);
     ASSERT_EQ(hi2->data_constructors.size(), 2);
-    const auto &bye = program->data_constructors["Bye"];
+    const auto &bye = program->data_constructors[Symbol("Bye")];
     EXPECT_EQ(bye->line, 1);
-    EXPECT_EQ(bye->name, "Bye");
+    EXPECT_EQ(bye->name, Symbol("Bye"));
     EXPECT_EQ(bye->types.size(), 0);
-    EXPECT_EQ(bye->type_constructor, "Hi");
-    const auto &no = program->data_constructors["No"];
+    EXPECT_EQ(bye->type_constructor, Symbol("Hi"));
+    const auto &no = program->data_constructors[Symbol("No")];
     EXPECT_EQ(no->line, 1);
-    EXPECT_EQ(no->name, "No");
+    EXPECT_EQ(no->name, Symbol("No"));
     EXPECT_EQ(no->types.size(), 0);
-    EXPECT_EQ(no->type_constructor, "Hi");
+    EXPECT_EQ(no->type_constructor, Symbol("Hi"));
 
     program = std::make_unique<Program>();
     result = parse_string("data Hi a b = Bye a | No", program.get());
     ASSERT_EQ(result, 0);
-    const auto &hi3 = program->type_constructors["Hi"];
+    const auto &hi3 = program->type_constructors[Symbol("Hi")];
 
     EXPECT_EQ(hi3->line, 1);
-    EXPECT_EQ(hi3->name, "Hi");
+    EXPECT_EQ(hi3->name, Symbol("Hi"));
     EXPECT_EQ(hi3->argument_variables.size(), 2);
     ASSERT_EQ(hi3->data_constructors.size(), 2);
-    const auto &bye2 = program->data_constructors["Bye"];
+    const auto &bye2 = program->data_constructors[Symbol("Bye")];
     EXPECT_EQ(bye2->line, 1);
-    EXPECT_EQ(bye2->name, "Bye");
+    EXPECT_EQ(bye2->name, Symbol("Bye"));
     EXPECT_EQ(bye2->types.size(), 1);
-    EXPECT_EQ(bye2->type_constructor, "Hi");
-    const auto &no2 = program->data_constructors["No"];
+    EXPECT_EQ(bye2->type_constructor, Symbol("Hi"));
+    const auto &no2 = program->data_constructors[Symbol("No")];
     EXPECT_EQ(no2->line, 1);
-    EXPECT_EQ(no2->name, "No");
+    EXPECT_EQ(no2->name, Symbol("No"));
     EXPECT_EQ(no2->types.size(), 0);
-    EXPECT_EQ(no2->type_constructor, "Hi");
+    EXPECT_EQ(no2->type_constructor, Symbol("Hi"));
 
     program = std::make_unique<Program>();
     EXPECT_THROW(parse_string("data Hi a\n;data Hi", program.get()), ParseError);
@@ -128,28 +132,28 @@ TEST(Parser, ParsesDataDecls) {
     program = std::make_unique<Program>();
     result = parse_string("data Hi = Bye\n;data Bye = Hi", program.get());
     ASSERT_EQ(result, 0);
-    const auto &hi4 = program->type_constructors["Hi"];
+    const auto &hi4 = program->type_constructors[Symbol("Hi")];
 
     EXPECT_EQ(hi4->line, 1);
-    EXPECT_EQ(hi4->name, "Hi");
+    EXPECT_EQ(hi4->name, Symbol("Hi"));
     EXPECT_EQ(hi4->argument_variables.size(), 0);
     ASSERT_EQ(hi4->data_constructors.size(), 1);
-    const auto &bye3 = program->data_constructors["Bye"];
+    const auto &bye3 = program->data_constructors[Symbol("Bye")];
     EXPECT_EQ(bye3->line, 1);
-    EXPECT_EQ(bye3->name, "Bye");
+    EXPECT_EQ(bye3->name, Symbol("Bye"));
     EXPECT_EQ(bye3->types.size(), 0);
-    EXPECT_EQ(bye3->type_constructor, "Hi");
-    const auto &bye4 = program->type_constructors["Bye"];
+    EXPECT_EQ(bye3->type_constructor, Symbol("Hi"));
+    const auto &bye4 = program->type_constructors[Symbol("Bye")];
 
     EXPECT_EQ(bye4->line, 2);
-    EXPECT_EQ(bye4->name, "Bye");
+    EXPECT_EQ(bye4->name, Symbol("Bye"));
     EXPECT_EQ(bye4->argument_variables.size(), 0);
     ASSERT_EQ(bye4->data_constructors.size(), 1);
-    const auto &hi5 = program->data_constructors["Hi"];
+    const auto &hi5 = program->data_constructors[Symbol("Hi")];
     EXPECT_EQ(hi5->line, 2);
-    EXPECT_EQ(hi5->name, "Hi");
+    EXPECT_EQ(hi5->name, Symbol("Hi"));
     EXPECT_EQ(hi5->types.size(), 0);
-    EXPECT_EQ(hi5->type_constructor, "Bye");
+    EXPECT_EQ(hi5->type_constructor, Symbol("Bye"));
 }
 
 TEST(Parser, ParsesVariableExpressions) {
@@ -157,12 +161,12 @@ TEST(Parser, ParsesVariableExpressions) {
     auto result = parse_string("a = b \n;c = d", program.get());
     ASSERT_EQ(result, 0);
 
-    const auto &a = program->bindings["a"];
-    EXPECT_EQ(dynamic_cast<Variable*>(a.get())->name, "b");
+    const auto &a = program->bindings[Symbol("a")];
+    EXPECT_EQ(dynamic_cast<Variable*>(a.get())->name, Symbol("b"));
 
-    const auto &c = program->bindings["c"];
+    const auto &c = program->bindings[Symbol("c")];
     ASSERT_EQ(c->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(c.get())->name, "d");
+    EXPECT_EQ(dynamic_cast<Variable*>(c.get())->name, Symbol("d"));
 
     program = std::make_unique<Program>();
     EXPECT_THROW(parse_string("a = b \n;a = d", program.get()), ParseError);
@@ -173,29 +177,33 @@ TEST(Parser, ParsesLiteralExpressions) {
     auto result = parse_string("a = 1\n;b = 'a'\n;c = \"hi\"", program.get());
     ASSERT_EQ(result, 0);
 
-    const auto &a = program->bindings["a"];
+    const auto &a = program->bindings[Symbol("a")];
     EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(a.get())->value), 1);
 
-    const auto &b = program->bindings["b"];
+    const auto &b = program->bindings[Symbol("b")];
     EXPECT_EQ(std::get<char>(dynamic_cast<Literal*>(b.get())->value), 'a');
 
-    auto str = dynamic_cast<Application*>(program->bindings["c"].get());
-    ASSERT_EQ(str->left->get_form(), expform::application);
-    auto l = dynamic_cast<Application*>(str->left.get());
-    ASSERT_EQ(l->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(l->left.get())->name, ":");
-    ASSERT_EQ(l->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<char>(dynamic_cast<Literal*>(l->right.get())->value), 'h');
-    ASSERT_EQ(str->right->get_form(), expform::application);
-    auto r = dynamic_cast<Application*>(str->right.get());
-    ASSERT_EQ(r->left->get_form(), expform::application);
-    auto rl = dynamic_cast<Application*>(r->left.get());
-    ASSERT_EQ(rl->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(rl->left.get())->name, ":");
-    ASSERT_EQ(rl->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<char>(dynamic_cast<Literal*>(rl->right.get())->value), 'i');
-    ASSERT_EQ(r->right->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(r->right.get())->name, "[]");
+    const auto &c = program->bindings[Symbol("c")];
+    ASSERT_EQ(c->get_form(), expform::literal);
+    EXPECT_EQ(std::get<std::string>(dynamic_cast<Literal*>(c.get())->value), "hi");
+
+    program = std::make_unique<Program>();
+    result = parse_string("a = \"a\\NULb\"", program.get());
+    ASSERT_EQ(result, 0);
+
+    auto str = dynamic_cast<Application*>(program->bindings[Symbol("a")].get());
+    ASSERT_EQ(str->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(str->function.get())->name, Symbol(":"));
+    ASSERT_EQ(str->arguments.size(), 2);
+    ASSERT_EQ(str->arguments[0]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<char>(dynamic_cast<Literal*>(str->arguments[0].get())->value), 'a');
+    ASSERT_EQ(str->arguments[1]->get_form(), expform::application);
+    auto r = dynamic_cast<Application*>(str->arguments[1].get());
+    ASSERT_EQ(r->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(r->function.get())->name, Symbol(":"));
+    ASSERT_EQ(r->arguments.size(), 2);
+    ASSERT_EQ(r->arguments[0]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<char>(dynamic_cast<Literal*>(r->arguments[0].get())->value), '\0');
 }
 
 TEST(Parser, ParsesConstructorExpressions) {
@@ -203,17 +211,17 @@ TEST(Parser, ParsesConstructorExpressions) {
     auto result = parse_string("a = ()\n;b = []\n;c = (,,)\n;d = Toast", program.get());
     ASSERT_EQ(result, 0);
 
-    const auto &a = program->bindings["a"];
-    EXPECT_EQ(dynamic_cast<Constructor*>(a.get())->name, "()");
+    const auto &a = program->bindings[Symbol("a")];
+    EXPECT_EQ(dynamic_cast<Constructor*>(a.get())->name, Symbol("()"));
 
-    const auto &b = program->bindings["b"];
-    EXPECT_EQ(dynamic_cast<Constructor*>(b.get())->name, "[]");
+    const auto &b = program->bindings[Symbol("b")];
+    EXPECT_EQ(dynamic_cast<Constructor*>(b.get())->name, Symbol("[]"));
 
-    const auto &c = program->bindings["c"];
-    EXPECT_EQ(dynamic_cast<Constructor*>(c.get())->name, "(,,)");
+    const auto &c = program->bindings[Symbol("c")];
+    EXPECT_EQ(dynamic_cast<Constructor*>(c.get())->name, Symbol("(,,)"));
 
-    const auto &d = program->bindings["d"];
-    EXPECT_EQ(dynamic_cast<Constructor*>(d.get())->name, "Toast");
+    const auto &d = program->bindings[Symbol("d")];
+    EXPECT_EQ(dynamic_cast<Constructor*>(d.get())->name, Symbol("Toast"));
 }
 
 TEST(Parser, ParsesApplicationExpressions) {
@@ -221,11 +229,25 @@ TEST(Parser, ParsesApplicationExpressions) {
     auto result = parse_string("a = b c d", program.get());
     ASSERT_EQ(result, 0);
 
-    const auto &a = dynamic_cast<Application*>(program->bindings["a"].get());
-    EXPECT_EQ(dynamic_cast<Variable*>(a->right.get())->name, "d");
-    auto l = dynamic_cast<Application*>(a->left.get());
-    EXPECT_EQ(dynamic_cast<Variable*>(l->left.get())->name, "b");
-    EXPECT_EQ(dynamic_cast<Variable*>(l->right.get())->name, "c");
+    const auto &a = dynamic_cast<Application*>(program->bindings[Symbol("a")].get());
+    EXPECT_EQ(dynamic_cast<Variable*>(a->function.get())->name, Symbol("b"));
+    ASSERT_EQ(a->arguments.size(), 2);
+    EXPECT_EQ(dynamic_cast<Variable*>(a->arguments[0].get())->name, Symbol("c"));
+    EXPECT_EQ(dynamic_cast<Variable*>(a->arguments[1].get())->name, Symbol("d"));
+
+    program = std::make_unique<Program>();
+    result = parse_string("a = (b c) (d e)", program.get());
+    ASSERT_EQ(result, 0);
+
+    const auto &f = dynamic_cast<Application*>(program->bindings[Symbol("a")].get());
+    EXPECT_EQ(dynamic_cast<Variable*>(f->function.get())->name, Symbol("b"));
+    ASSERT_EQ(f->arguments.size(), 2);
+    EXPECT_EQ(dynamic_cast<Variable*>(f->arguments[0].get())->name, Symbol("c"));
+    ASSERT_EQ(f->arguments[1]->get_form(), expform::application);
+    auto g = dynamic_cast<Application*>(f->arguments[1].get());
+    EXPECT_EQ(dynamic_cast<Variable*>(g->function.get())->name, Symbol("d"));
+    ASSERT_EQ(g->arguments.size(), 1);
+    EXPECT_EQ(dynamic_cast<Variable*>(g->arguments[0].get())->name, Symbol("e"));
 }
 
 TEST(Parser, ParsesLambdaAbstractions) {
@@ -234,30 +256,29 @@ TEST(Parser, ParsesLambdaAbstractions) {
     ASSERT_EQ(result, 0);
 
 
-    ASSERT_EQ(program->bindings["l"]->get_form(), expform::abstraction);
-    auto l = dynamic_cast<Abstraction*>(program->bindings["l"].get());
+    ASSERT_EQ(program->bindings[Symbol("l")]->get_form(), expform::abstraction);
+    auto l = dynamic_cast<Abstraction*>(program->bindings[Symbol("l")].get());
     auto args = l->args;
     EXPECT_EQ(args.size(), 2);
-    EXPECT_EQ(std::count(args.begin(), args.end(), "a"), 1);
-    EXPECT_EQ(std::count(args.begin(), args.end(), "b"), 1);
+    EXPECT_EQ(std::count(args.begin(), args.end(), Symbol("a")), 1);
+    EXPECT_EQ(std::count(args.begin(), args.end(), Symbol("b")), 1);
     ASSERT_EQ(l->body->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(l->body.get())->name, "a");
+    EXPECT_EQ(dynamic_cast<Variable*>(l->body.get())->name, Symbol("a"));
 }
 
-#define TESTINFIXOP(opstr) {                                             \
-    auto program = std::make_unique<Program>();                          \
-    int result = parse_string("a = b " opstr " c", program.get());       \
-    ASSERT_EQ(result, 0);                                                \
-    ASSERT_EQ(program->bindings["a"]->get_form(), expform::application); \
-    auto b = dynamic_cast<Application*>(program->bindings["a"].get());   \
-    ASSERT_EQ(b->left->get_form(), expform::application);                \
-    auto l = dynamic_cast<Application*>(b->left.get());                  \
-    ASSERT_EQ(l->left->get_form(), expform::variable);                   \
-    EXPECT_EQ(dynamic_cast<Variable*>(l->left.get())->name, (opstr));    \
-    ASSERT_EQ(l->right->get_form(), expform::variable);                  \
-    EXPECT_EQ(dynamic_cast<Variable*>(l->right.get())->name, "b");       \
-    ASSERT_EQ(b->right->get_form(), expform::variable);                  \
-    EXPECT_EQ(dynamic_cast<Variable*>(b->right.get())->name, "c");       \
+#define TESTINFIXOP(opstr) {                                              \
+    auto program = std::make_unique<Program>();                           \
+    int result = parse_string("a = b " opstr " c", program.get());        \
+    ASSERT_EQ(result, 0);                                                 \
+    ASSERT_EQ(program->bindings[Symbol("a")]->get_form(), expform::application);  \
+    auto b = dynamic_cast<Application*>(program->bindings[Symbol("a")].get());    \
+    ASSERT_EQ(b->function->get_form(), expform::variable);                \
+    EXPECT_EQ(dynamic_cast<Variable*>(b->function.get())->name, Symbol(opstr)); \
+    ASSERT_EQ(b->arguments.size(), 2);                                    \
+    ASSERT_EQ(b->arguments[0]->get_form(), expform::variable);            \
+    EXPECT_EQ(dynamic_cast<Variable*>(b->arguments[0].get())->name, Symbol("b")); \
+    ASSERT_EQ(b->arguments[1]->get_form(), expform::variable);            \
+    EXPECT_EQ(dynamic_cast<Variable*>(b->arguments[1].get())->name, Symbol("c")); \
 }
 
 TEST(Parser, ParsesInfix) {
@@ -282,27 +303,26 @@ TEST(Parser, ParsesInfix) {
     auto result = parse_string("a = -c", program.get());
     ASSERT_EQ(result, 0);
 
-    ASSERT_EQ(program->bindings["a"]->get_form(), expform::builtinop);
-    auto a = dynamic_cast<BuiltInOp*>(program->bindings["a"].get());
+    ASSERT_EQ(program->bindings[Symbol("a")]->get_form(), expform::builtinop);
+    auto a = dynamic_cast<BuiltInOp*>(program->bindings[Symbol("a")].get());
     EXPECT_EQ(a->left, nullptr);
     ASSERT_EQ(a->right->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(a->right.get())->name, "c");
+    EXPECT_EQ(dynamic_cast<Variable*>(a->right.get())->name, Symbol("c"));
     EXPECT_EQ(a->op, builtinop::negate);
 
     program = std::make_unique<Program>();
     result = parse_string("a = b:c", program.get());
     ASSERT_EQ(result, 0);
 
-    ASSERT_EQ(program->bindings["a"]->get_form(), expform::application);
-    auto b = dynamic_cast<Application*>(program->bindings["a"].get());
-    ASSERT_EQ(b->left->get_form(), expform::application);
-    auto l = dynamic_cast<Application*>(b->left.get());
-    ASSERT_EQ(l->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(l->left.get())->name, ":");
-    ASSERT_EQ(l->right->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(l->right.get())->name, "b");
-    ASSERT_EQ(b->right->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(b->right.get())->name, "c");
+    ASSERT_EQ(program->bindings[Symbol("a")]->get_form(), expform::application);
+    auto b = dynamic_cast<Application*>(program->bindings[Symbol("a")].get());
+    ASSERT_EQ(b->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(b->function.get())->name, Symbol(":"));
+    ASSERT_EQ(b->arguments.size(), 2);
+    ASSERT_EQ(b->arguments[0]->get_form(), expform::variable);
+    EXPECT_EQ(dynamic_cast<Variable*>(b->arguments[0].get())->name, Symbol("b"));
+    ASSERT_EQ(b->arguments[1]->get_form(), expform::variable);
+    EXPECT_EQ(dynamic_cast<Variable*>(b->arguments[1].get())->name, Symbol("c"));
 }
 
 TEST(Parser, ParsesConditionals) {
@@ -311,16 +331,16 @@ TEST(Parser, ParsesConditionals) {
     ASSERT_EQ(result, 0);
 
 
-    ASSERT_EQ(program->bindings["i"]->get_form(), expform::cAsE);
-    auto i = dynamic_cast<Case*>(program->bindings["i"].get());
+    ASSERT_EQ(program->bindings[Symbol("i")]->get_form(), expform::cAsE);
+    auto i = dynamic_cast<Case*>(program->bindings[Symbol("i")].get());
     ASSERT_EQ(i->exp->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(i->exp.get())->name, "a");
+    EXPECT_EQ(dynamic_cast<Variable*>(i->exp.get())->name, Symbol("a"));
 
     const auto &alts = i->alts;
     ASSERT_EQ(alts.size(), 2);
     ASSERT_EQ(alts[0].first->get_form(), patternform::constructor);
     auto p = dynamic_cast<ConstructorPattern*>(alts[0].first.get());
-    EXPECT_EQ(p->name, "True");
+    EXPECT_EQ(p->name, Symbol("True"));
     EXPECT_EQ(p->args.size(), 0);
     ASSERT_EQ(alts[0].second->get_form(), expform::literal);
     auto l = dynamic_cast<Literal*>(alts[0].second.get());
@@ -328,7 +348,7 @@ TEST(Parser, ParsesConditionals) {
 
     ASSERT_EQ(alts[1].first->get_form(), patternform::constructor);
     p = dynamic_cast<ConstructorPattern*>(alts[1].first.get());
-    EXPECT_EQ(p->name, "False");
+    EXPECT_EQ(p->name, Symbol("False"));
     EXPECT_EQ(p->args.size(), 0);
     ASSERT_EQ(alts[1].second->get_form(), expform::literal);
     l = dynamic_cast<Literal*>(alts[1].second.get());
@@ -341,26 +361,24 @@ TEST(Parser, ParsesLists) {
     ASSERT_EQ(result, 0);
 
 
-    ASSERT_EQ(program->bindings["l"]->get_form(), expform::application);
-    auto l = dynamic_cast<Application*>(program->bindings["l"].get());
+    ASSERT_EQ(program->bindings[Symbol("l")]->get_form(), expform::application);
+    auto l = dynamic_cast<Application*>(program->bindings[Symbol("l")].get());
 
-    ASSERT_EQ(l->left->get_form(), expform::application);
-    auto ll = dynamic_cast<Application*>(l->left.get());
-    ASSERT_EQ(ll->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(ll->left.get())->name, ":");
-    ASSERT_EQ(ll->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(ll->right.get())->value), 1);
+    ASSERT_EQ(l->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(l->function.get())->name, Symbol(":"));
+    ASSERT_EQ(l->arguments.size(), 2);
+    ASSERT_EQ(l->arguments[0]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->arguments[0].get())->value), 1);
 
-    ASSERT_EQ(l->right->get_form(), expform::application);
-    auto r = dynamic_cast<Application*>(l->right.get());
-    ASSERT_EQ(r->left->get_form(), expform::application);
-    auto rl = dynamic_cast<Application*>(r->left.get());
-    ASSERT_EQ(rl->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(rl->left.get())->name, ":");
-    ASSERT_EQ(rl->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(rl->right.get())->value), 2);
-    ASSERT_EQ(r->right->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(r->right.get())->name, "[]");
+    ASSERT_EQ(l->arguments[1]->get_form(), expform::application);
+    auto r = dynamic_cast<Application*>(l->arguments[1].get());
+    ASSERT_EQ(r->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(r->function.get())->name, Symbol(":"));
+    ASSERT_EQ(r->arguments.size(), 2);
+    ASSERT_EQ(r->arguments[0]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(r->arguments[0].get())->value), 2);
+    ASSERT_EQ(r->arguments[1]->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(r->arguments[1].get())->name, Symbol("[]"));
 }
 
 TEST(Parser, ParsesTuples) {
@@ -369,18 +387,16 @@ TEST(Parser, ParsesTuples) {
     ASSERT_EQ(result, 0);
 
 
-    ASSERT_EQ(program->bindings["l"]->get_form(), expform::application);
-    auto l = dynamic_cast<Application*>(program->bindings["l"].get());
-
-    ASSERT_EQ(l->left->get_form(), expform::application);
-    auto ll = dynamic_cast<Application*>(l->left.get());
-    ASSERT_EQ(ll->left->get_form(), expform::constructor);
-    EXPECT_EQ(dynamic_cast<Constructor*>(ll->left.get())->name, "(,)");
-    ASSERT_EQ(ll->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(ll->right.get())->value), 1);
+    ASSERT_EQ(program->bindings[Symbol("l")]->get_form(), expform::application);
+    auto l = dynamic_cast<Application*>(program->bindings[Symbol("l")].get());
 
-    ASSERT_EQ(l->right->get_form(), expform::literal);
-    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->right.get())->value), 2);
+    ASSERT_EQ(l->function->get_form(), expform::constructor);
+    EXPECT_EQ(dynamic_cast<Constructor*>(l->function.get())->name, Symbol("(,)"));
+    ASSERT_EQ(l->arguments.size(), 2);
+    ASSERT_EQ(l->arguments[0]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->arguments[0].get())->value), 1);
+    ASSERT_EQ(l->arguments[1]->get_form(), expform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->arguments[1].get())->value), 2);
 }
 
 TEST(Parser, ParsesLetExpressions) {
@@ -400,30 +416,31 @@ TEST(Parser, ParsesLetExpressions) {
     auto result = parse_string("a = let {a :: b -> b; a x = x; p = 1} in p", program.get());
     ASSERT_EQ(result, 0);
 
-    ASSERT_EQ(program->bindings["a"]->get_form(), expform::let);
-    auto l = dynamic_cast<Let*>(program->bindings["a"].get());
+    ASSERT_EQ(program->bindings[Symbol("a")]->get_form(), expform::let);
+    auto l = dynamic_cast<Let*>(program->bindings[Symbol("a")].get());
 
     ASSERT_EQ(l->e->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(l->e.get())->name, "p");
+    EXPECT_EQ(dynamic_cast<Variable*>(l->e.get())->name, Symbol("p"));
 
     EXPECT_EQ(l->bindings.size(), 2);
 
-    EXPECT_EQ(l->bindings.at("a")->get_form(), expform::abstraction);
-    auto lam = dynamic_cast<Abstraction*>(l->bindings.at("a").get());
+    EXPECT_EQ(l->bindings.at(Symbol("a"))->get_form(), expform::abstraction);
+    auto lam = dynamic_cast<Abstraction*>(l->bindings.at(Symbol("a")).get());
     auto args = lam->args;
     EXPECT_EQ(args.size(), 1);
-    EXPECT_EQ(std::count(args.begin(), args.end(), "x"), 1);
+    EXPECT_EQ(std::count(args.begin(), args.end(), Symbol("x")), 1);
     ASSERT_EQ(lam->body->get_form(), expform::variable);
-    EXPECT_EQ(dynamic_cast<Variable*>(lam->body.get())->name, "x");
+    EXPECT_EQ(dynamic_cast<Variable*>(lam->body.get())->name, Symbol("x"));
 
-    EXPECT_EQ(l->bindings.at("p")->get_form(), expform::literal);
-    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->bindings.at("p").get())->value), 1);
+    EXPECT_EQ(l->bindings.at(Symbol("p"))->get_form(), expform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(l->bindings.at(Symbol("p")).get())->value), 1);
 
     EXPECT_EQ(l->type_signatures.size(), 1);
 
-    auto b = new UniversallyQuantifiedVariable("b");
-    auto expected =make_function_type(b, b);
-    EXPECT_TRUE(same_type(l->type_signatures.at("a").get(), expected));
+    Arena arena;
+    auto b = new (arena) UniversallyQuantifiedVariable(Symbol("b"));
+    auto expected = make_function_type(arena, b, b);
+    EXPECT_TRUE(same_type(l->type_signatures.at(Symbol("a")).get(), expected));
 }
 
 TEST(Parser, ParsesCaseExpressions) {
@@ -431,8 +448,8 @@ TEST(Parser, ParsesCaseExpressions) {
     auto result = parse_string("a = case 1 of {_ -> 2; _ -> 3}", program.get());
     ASSERT_EQ(result, 0);
 
-    ASSERT_EQ(program->bindings["a"]->get_form(), expform::cAsE);
-    auto c = dynamic_cast<Case*>(program->bindings["a"].get());
+    ASSERT_EQ(program->bindings[Symbol("a")]->get_form(), expform::cAsE);
+    auto c = dynamic_cast<Case*>(program->bindings[Symbol("a")].get());
 
     EXPECT_EQ(c->exp->get_form(), expform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<Literal*>(c->exp.get())->value), 1);
@@ -452,31 +469,31 @@ TEST(Parser, ParsesPatterns) {
     auto program = std::make_unique<Program>();
     auto result = parse_string("a = case 1 of {[1,2] -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p->get_form(), patternform::constructor);
     auto c = dynamic_cast<ConstructorPattern*>(p.get());
-    EXPECT_EQ(c->name, ":");
+    EXPECT_EQ(c->name, Symbol(":"));
     EXPECT_EQ(c->args.size(), 2);
     ASSERT_EQ(c->args[0]->get_form(), patternform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<LiteralPattern*>(c->args[0].get())->value), 1);
     ASSERT_EQ(c->args[1]->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(c->args[1].get());
-    EXPECT_EQ(c->name, ":");
+    EXPECT_EQ(c->name, Symbol(":"));
     EXPECT_EQ(c->args.size(), 2);
     ASSERT_EQ(c->args[0]->get_form(), patternform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<LiteralPattern*>(c->args[0].get())->value), 2);
     ASSERT_EQ(c->args[1]->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(c->args[1].get());
-    EXPECT_EQ(c->name, "[]");
+    EXPECT_EQ(c->name, Symbol("[]"));
     EXPECT_EQ(c->args.size(), 0);
 
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {(1,2) -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p1 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p1 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p1->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(p1.get());
-    EXPECT_EQ(c->name, "(,)");
+    EXPECT_EQ(c->name, Symbol("(,)"));
     EXPECT_EQ(c->args.size(), 2);
     ASSERT_EQ(c->args[0]->get_form(), patternform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<LiteralPattern*>(c->args[0].get())->value), 1);
@@ -486,52 +503,102 @@ TEST(Parser, ParsesPatterns) {
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {Hi -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p2 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p2 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p2->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(p2.get());
-    EXPECT_EQ(c->name, "Hi");
+    EXPECT_EQ(c->name, Symbol("Hi"));
     EXPECT_EQ(c->args.size(), 0);
 
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {a@Hi -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p3 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p3 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p3->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(p3.get());
-    EXPECT_EQ(c->name, "Hi");
+    EXPECT_EQ(c->name, Symbol("Hi"));
     EXPECT_EQ(c->args.size(), 0);
     ASSERT_EQ(c->as.size(), 1);
-    EXPECT_EQ(c->as[0], "a");
+    EXPECT_EQ(c->as[0], Symbol("a"));
 
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {Hi a -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p4 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p4 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p4->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(p4.get());
-    EXPECT_EQ(c->name, "Hi");
+    EXPECT_EQ(c->name, Symbol("Hi"));
     ASSERT_EQ(c->args.size(), 1);
     ASSERT_EQ(c->args[0]->get_form(), patternform::variable);
     auto v = dynamic_cast<VariablePattern*>(c->args[0].get());
-    EXPECT_EQ(v->name, "a");
+    EXPECT_EQ(v->name, Symbol("a"));
 
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {(-2) -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p5 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p5 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p5->get_form(), patternform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<LiteralPattern*>(p5.get())->value), -2);
 
     program = std::make_unique<Program>();
     result = parse_string("a = case 1 of {a:b -> 2}", program.get());
     ASSERT_EQ(result, 0);
-    const auto &p6 = dynamic_cast<Case*>(program->bindings["a"].get())->alts[0].first;
+    const auto &p6 = dynamic_cast<Case*>(program->bindings[Symbol("a")].get())->alts[0].first;
     ASSERT_EQ(p6->get_form(), patternform::constructor);
     c = dynamic_cast<ConstructorPattern*>(p6.get());
-    EXPECT_EQ(c->name, ":");
+    EXPECT_EQ(c->name, Symbol(":"));
     ASSERT_EQ(c->args.size(), 2);
     ASSERT_EQ(c->args[0]->get_form(), patternform::variable);
-    EXPECT_EQ(dynamic_cast<VariablePattern*>(c->args[0].get())->name, "a");
+    EXPECT_EQ(dynamic_cast<VariablePattern*>(c->args[0].get())->name, Symbol("a"));
     ASSERT_EQ(c->args[1]->get_form(), patternform::variable);
-    EXPECT_EQ(dynamic_cast<VariablePattern*>(c->args[1].get())->name, "b");
+    EXPECT_EQ(dynamic_cast<VariablePattern*>(c->args[1].get())->name, Symbol("b"));
+}
+
+TEST(Parser, ParsesModuleHeadersAndImports) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string("a = 1", program.get());
+    ASSERT_EQ(result, 0);
+    EXPECT_EQ(program->module_name, Symbol("Main"));
+    EXPECT_TRUE(program->imports.empty());
+
+    program = std::make_unique<Program>();
+    result = parse_string("module Lists where {\nimport Maybe\n;import Pairs\n;a = 1\n}", program.get());
+    ASSERT_EQ(result, 0);
+    EXPECT_EQ(program->module_name, Symbol("Lists"));
+    ASSERT_EQ(program->imports.size(), 2);
+    EXPECT_EQ(program->imports[0], std::make_pair(2, Symbol("Maybe")));
+    EXPECT_EQ(program->imports[1], std::make_pair(3, Symbol("Pairs")));
+    EXPECT_EQ(program->bindings.count(Symbol("a")), 1);
+
+    program = std::make_unique<Program>();
+    result = parse_string("import Maybe", program.get());
+    ASSERT_EQ(result, 0);
+    ASSERT_EQ(program->imports.size(), 1);
+
+    program = std::make_unique<Program>();
+    result = parse_string("a = 1 ; import Maybe", program.get());
+    EXPECT_NE(result, 0);
+}
+
+TEST(Parser, ParsesConcurrently) {
+    std::vector<std::unique_ptr<Program>> programs;
+    std::vector<int> results(8, -1);
+    for (int i = 0; i < 8; i++) {
+        programs.push_back(std::make_unique<Program>());
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&programs, &results, i]() {
+            std::string source = "a" + std::to_string(i) + " = case 1 of {{- comment -} x -> \"str\\ning\"}";
+            results[i] = parse_string(source.c_str(), programs[i].get());
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    for (int i = 0; i < 8; i++) {
+        ASSERT_EQ(results[i], 0);
+        EXPECT_EQ(programs[i]->bindings.count("a" + std::to_string(i)), 1);
+    }
 }
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include "test/test_utilities.hpp"
+#include "prelude/prelude.hpp"
+#include "prelude/snapshot.hpp"
+#include "types/type_check.hpp"
+
+TEST(Prelude, SnapshotMatchesSource) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    add_prelude_source(program.get());
+    type_check(program, false);
+    EXPECT_EQ(
+            write_snapshot(*program),
+            std::string(reinterpret_cast<const char*>(prelude_snapshot), prelude_snapshot_size));
+}
+
+TEST(Prelude, LoadsKindsAndTypes) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    add_prelude(program.get());
+    EXPECT_EQ(program->type_constructors.count(Symbol("Bool")), 1);
+    EXPECT_EQ(program->data_constructor_arities.at(Symbol(":")), 2);
+    EXPECT_EQ(program->data_constructor_arities.at(Symbol("(,,)")), 3);
+
+    const auto &list_kind = program->type_constructor_kinds.at(Symbol("[]"));
+    ASSERT_EQ(list_kind->get_form(), kindform::arrow);
+    EXPECT_EQ(static_cast<ArrowKind*>(list_kind.get())->left->get_form(), kindform::star);
+    EXPECT_EQ(static_cast<ArrowKind*>(list_kind.get())->right->get_form(), kindform::star);
+
+    Arena arena;
+    EXPECT_TRUE(same_type(
+            program->types.at(Symbol("True")).get(),
+            new (arena) TypeConstructor(Symbol("Bool"))));
+    EXPECT_TRUE(same_type(
+            program->types.at(Symbol(":")).get(),
+            make_function_type(
+                    arena,
+                    new (arena) UniversallyQuantifiedVariable(Symbol("a")),
+                    make_function_type(
+                            arena,
+                            make_list_type(arena, new (arena) UniversallyQuantifiedVariable(Symbol("a"))),
+                            make_list_type(arena, new (arena) UniversallyQuantifiedVariable(Symbol("a")))))));
+}
+
+TEST(Prelude, SnapshotsRoundTrip) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string(
+            "data T a = A Int | B a (T a)\n"
+            ";f :: T Char -> Char\n"
+            ";f x = case x of { A 1 -> 'a' ; B c (A 2) -> c ; t@(B _ _) -> 'z' }\n"
+            ";g a b = let { h = \\q -> q ; k :: Char ; k = h 'c' } in B k (B a b)\n"
+            ";n = - 1\n"
+            ";l = (\"x\\NULy\", [f (A 3), 'b'])\n"
+            ";main = \"abc\"",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    std::string snapshot = write_snapshot(*program);
+
+    std::unique_ptr<Program> loaded = std::make_unique<Program>();
+    read_snapshot(snapshot, loaded.get());
+    EXPECT_EQ(loaded->bindings.size(), program->bindings.size());
+    EXPECT_EQ(loaded->types.size(), program->types.size());
+    EXPECT_EQ(write_snapshot(*loaded), snapshot);
+    type_check(loaded, true);
+
+    loaded = std::make_unique<Program>();
+    EXPECT_THROW(read_snapshot(snapshot.substr(0, snapshot.size() / 2), loaded.get()), SnapshotError);
+}
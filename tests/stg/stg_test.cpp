@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <algorithm>
 #include "test/test_utilities.hpp"
 #include "stg/stg.hpp"
+#include "stg/simplify.hpp"
+#include "stg/strictness.hpp"
+#include "stg/worker_wrapper.hpp"
+#include "types/type_check.hpp"
 
 #define EXPECT_VARIABLE(lambda_form, v) {                                            \
     EXPECT_EQ((lambda_form)->argument_variables.size(), 0);                          \
@@ -14,7 +19,7 @@ TEST(STGTranslation, TranslatesVariables) {
     int result = parse_string_no_prelude("main = a", program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_VARIABLE(translated->bindings.at("main"), "a");
+    EXPECT_VARIABLE(translated->bindings.at(Symbol("main")), Symbol("a"));
 }
 
 #define EXPECT_CHAR(lambda_form, c) {                                                \
@@ -32,19 +37,30 @@ TEST(STGTranslation, TranslatesLiterals) {
     int result = parse_string_no_prelude("main = 1", program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::literal);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literal);
     EXPECT_EQ(
-            std::get<int>(dynamic_cast<STGLiteral*>(translated->bindings.at("main")->expr.get())->value),
+            std::get<int>(dynamic_cast<STGLiteral*>(translated->bindings.at(Symbol("main"))->expr.get())->value),
             1);
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = 'a'", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_CHAR(translated->bindings.at("main"), 'a');
+    EXPECT_CHAR(translated->bindings.at(Symbol("main")), 'a');
+
+    program = std::make_unique<Program>();
+    result = parse_string("main = \"abc\"", program.get());
+    ASSERT_EQ(result, 0);
+    translated = translate(program);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literal);
+    EXPECT_EQ(
+            std::get<std::string>(dynamic_cast<STGLiteral*>(translated->bindings.at(Symbol("main"))->expr.get())->value),
+            "abc");
+    EXPECT_EQ(translated->data_constructors.count(Symbol("[]")), 1);
+    EXPECT_EQ(translated->data_constructors.count(Symbol(":")), 1);
 }
 
 TEST(STGTranslation, TranslatesAbstractions) {
@@ -52,13 +68,13 @@ TEST(STGTranslation, TranslatesAbstractions) {
     int result = parse_string_no_prelude("main a = \\a -> a", program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 2);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[1], ".1");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>((translated->bindings.at("main"))->expr.get())->name, ".1");
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 2);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[1], Symbol(".1"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>((translated->bindings.at(Symbol("main")))->expr.get())->name, Symbol(".1"));
 }
 
 TEST(STGTranslation, TranslatesLet) {
@@ -69,24 +85,24 @@ TEST(STGTranslation, TranslatesLet) {
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 2);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::let);
-    auto let = dynamic_cast<STGLet*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::let);
+    auto let = dynamic_cast<STGLet*>(translated->bindings.at(Symbol("main"))->expr.get());
     EXPECT_EQ(let->recursive, false);
     EXPECT_EQ(let->bindings.size(), 1);
-    EXPECT_VARIABLE(let->bindings.at(".1"), ".0");
+    EXPECT_VARIABLE(let->bindings.at(Symbol(".1")), Symbol(".0"));
     ASSERT_EQ(let->expr->get_form(), stgform::let);
     let = dynamic_cast<STGLet*>(let->expr.get());
     EXPECT_EQ(let->recursive, false);
     EXPECT_EQ(let->bindings.size(), 1);
-    EXPECT_VARIABLE(let->bindings.at(".2"), ".1");
+    EXPECT_VARIABLE(let->bindings.at(Symbol(".2")), Symbol(".1"));
     ASSERT_EQ(let->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(let->expr.get())->name, ".4");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(let->expr.get())->name, Symbol(".4"));
 
-    EXPECT_CHAR(translated->bindings.at(".4"), 'b');
+    EXPECT_CHAR(translated->bindings.at(Symbol(".4")), 'b');
 }
 
 TEST(STGTranslation, TranslatesConstructors) {
@@ -94,25 +110,25 @@ TEST(STGTranslation, TranslatesConstructors) {
     int result = parse_string_no_prelude("data T = Test\n;main = Test", program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments.size(), 0);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->constructor_name, "Test");
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 0);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->constructor_name, Symbol("Test"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("data T = Test T\n;main = Test", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments.size(), 1);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments[0], ".0");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->constructor_name, "Test");
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 1);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[0], Symbol(".0"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->constructor_name, Symbol("Test"));
 }
 
 TEST(STGTranslation, TranslatesApplications) {
@@ -120,63 +136,63 @@ TEST(STGTranslation, TranslatesApplications) {
     int result = parse_string_no_prelude("data T = Test T T | Nil\n;main = Test Nil", program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_EQ(translated->bindings.at(".0")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".0")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".0")->updatable, false);
-    ASSERT_EQ(translated->bindings.at(".0")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".0")->expr.get())->constructor_name, "Nil");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".0")->expr.get())->arguments.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".1");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments.size(), 2);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments[0], ".0");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments[1], ".1");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->constructor_name, "Test");
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol(".0"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".0"))->expr.get())->constructor_name, Symbol("Nil"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".0"))->expr.get())->arguments.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".1"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 2);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[0], Symbol(".0"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[1], Symbol(".1"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->constructor_name, Symbol("Test"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("data T = Test T | Nil | Nill\n;main = Test Nil Nill", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at(".0")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".0")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".0")->updatable, false);
-    ASSERT_EQ(translated->bindings.at(".0")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".0")->expr.get())->constructor_name, "Nill");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".0")->expr.get())->arguments.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".1")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".1")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".1")->updatable, false);
-    ASSERT_EQ(translated->bindings.at(".1")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".1")->expr.get())->constructor_name, "Nil");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(".1")->expr.get())->arguments.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 2);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count(".0"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count(".1"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::constructor);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->constructor_name, "Test");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments.size(), 2);
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments[0], ".1");
-    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at("main")->expr.get())->arguments[1], ".0");
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".0"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol(".0"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".0"))->expr.get())->constructor_name, Symbol("Nill"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".0"))->expr.get())->arguments.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".1"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".1"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".1"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol(".1"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".1"))->expr.get())->constructor_name, Symbol("Nil"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol(".1"))->expr.get())->arguments.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 2);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol(".0")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol(".1")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->constructor_name, Symbol("Test"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 2);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[0], Symbol(".1"));
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[1], Symbol(".0"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("a b c d = b\n;main = a q c", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 2);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("q"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("c"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::application);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->lhs, "a");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments.size(), 2);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments[0], "q");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments[1], "c");
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 2);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("q")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("c")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->lhs, Symbol("a"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 2);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[0], Symbol("q"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[1], Symbol("c"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -185,34 +201,34 @@ TEST(STGTranslation, TranslatesApplications) {
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 6);
-    EXPECT_VARIABLE(translated->bindings.at(".1"), "r");
-    EXPECT_EQ(translated->bindings.at(".2")->free_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at(".2")->free_variables.count("t"), 1);
-    EXPECT_EQ(translated->bindings.at(".2")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".2")->updatable, true);
-    ASSERT_EQ(translated->bindings.at(".2")->expr->get_form(), stgform::application);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".2")->expr.get())->lhs, ".1");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".2")->expr.get())->arguments.size(), 1);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".2")->expr.get())->arguments[0], "t");
-    EXPECT_EQ(translated->bindings.at(".4")->free_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at(".4")->free_variables.count("g"), 1);
-    EXPECT_EQ(translated->bindings.at(".4")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at(".4")->updatable, true);
-    ASSERT_EQ(translated->bindings.at(".4")->expr->get_form(), stgform::application);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".4")->expr.get())->lhs, "f");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".4")->expr.get())->arguments.size(), 1);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(".4")->expr.get())->arguments[0], "g");
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 2);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("c"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("d"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::application);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->lhs, ".4");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments.size(), 3);
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments[0], ".2");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments[1], "c");
-    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at("main")->expr.get())->arguments[2], "d");
+    EXPECT_VARIABLE(translated->bindings.at(Symbol(".1")), Symbol("r"));
+    EXPECT_EQ(translated->bindings.at(Symbol(".2"))->free_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol(".2"))->free_variables.count(Symbol("t")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol(".2"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".2"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol(".2"))->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".2"))->expr.get())->lhs, Symbol(".1"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".2"))->expr.get())->arguments.size(), 1);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".2"))->expr.get())->arguments[0], Symbol("t"));
+    EXPECT_EQ(translated->bindings.at(Symbol(".4"))->free_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol(".4"))->free_variables.count(Symbol("g")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol(".4"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol(".4"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol(".4"))->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".4"))->expr.get())->lhs, Symbol("f"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".4"))->expr.get())->arguments.size(), 1);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol(".4"))->expr.get())->arguments[0], Symbol("g"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 2);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("c")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("d")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->lhs, Symbol(".4"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments.size(), 3);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[0], Symbol(".2"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[1], Symbol("c"));
+    EXPECT_EQ(dynamic_cast<STGApplication*>(translated->bindings.at(Symbol("main"))->expr.get())->arguments[2], Symbol("d"));
 }
 
 TEST(STGTranslation, TranslatesCase) {
@@ -221,30 +237,30 @@ TEST(STGTranslation, TranslatesCase) {
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 1);
-    EXPECT_CHAR(translated->bindings.at("main"), 'a');
+    EXPECT_CHAR(translated->bindings.at(Symbol("main")), 'a');
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = case let { x = 'b' } in x of { x@_ -> 'a' }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 1);
-    EXPECT_CHAR(translated->bindings.at("main"), 'a');
+    EXPECT_CHAR(translated->bindings.at(Symbol("main")), 'a');
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = case 'a' of { a -> a }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 2);
-    EXPECT_CHAR(translated->bindings.at(".0"), 'a');
-    EXPECT_VARIABLE(translated->bindings.at("main"), ".0");
+    EXPECT_CHAR(translated->bindings.at(Symbol(".0")), 'a');
+    EXPECT_VARIABLE(translated->bindings.at(Symbol("main")), Symbol(".0"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = case 'a' of { x@a -> x ; _ -> 'b' }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 2);
-    EXPECT_CHAR(translated->bindings.at(".0"), 'a');
-    EXPECT_VARIABLE(translated->bindings.at("main"), ".0");
+    EXPECT_CHAR(translated->bindings.at(Symbol(".0")), 'a');
+    EXPECT_VARIABLE(translated->bindings.at(Symbol("main")), Symbol(".0"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -253,11 +269,11 @@ TEST(STGTranslation, TranslatesCase) {
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::literalcase);
-    auto cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literalcase);
+    auto cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->expr.get())->value), 'a');
     ASSERT_EQ(cAsE->alts.size(), 2);
@@ -267,50 +283,50 @@ TEST(STGTranslation, TranslatesCase) {
     EXPECT_EQ(std::get<char>(cAsE->alts[1].first.value), 'b');
     ASSERT_EQ(cAsE->alts[1].second->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->alts[1].second.get())->value), '1');
-    EXPECT_EQ(cAsE->default_var, "");
+    EXPECT_EQ(cAsE->default_var, Symbol(""));
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, Symbol("case_error"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = case 'a' of { k@'a' -> k ; 'b' -> '1' }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_CHAR(translated->bindings.at(".0"), 'a');
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::literalcase);
-    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_CHAR(translated->bindings.at(Symbol(".0")), 'a');
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literalcase);
+    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, ".0");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, Symbol(".0"));
     ASSERT_EQ(cAsE->alts.size(), 2);
     EXPECT_EQ(std::get<char>(cAsE->alts[0].first.value), 'a');
     ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, ".0");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, Symbol(".0"));
     EXPECT_EQ(std::get<char>(cAsE->alts[1].first.value), 'b');
     ASSERT_EQ(cAsE->alts[1].second->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->alts[1].second.get())->value), '1');
-    EXPECT_EQ(cAsE->default_var, "");
+    EXPECT_EQ(cAsE->default_var, Symbol(""));
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, Symbol("case_error"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude("main = case 'a' of { 'a' -> k ; _ -> '1' }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("k"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::literalcase);
-    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("k")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literalcase);
+    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->expr.get())->value), 'a');
     ASSERT_EQ(cAsE->alts.size(), 1);
     EXPECT_EQ(std::get<char>(cAsE->alts[0].first.value), 'a');
     ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, "k");
-    EXPECT_EQ(cAsE->default_var, "");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, Symbol("k"));
+    EXPECT_EQ(cAsE->default_var, Symbol(""));
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->default_expr.get())->value), '1');
 
@@ -319,21 +335,21 @@ TEST(STGTranslation, TranslatesCase) {
     result = parse_string_no_prelude("main = case 'a' of { 'a' -> k ; k -> k }", program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.count("k"), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::literalcase);
-    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.count(Symbol("k")), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::literalcase);
+    cAsE = dynamic_cast<STGLiteralCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(cAsE->expr.get())->value), 'a');
     ASSERT_EQ(cAsE->alts.size(), 1);
     EXPECT_EQ(std::get<char>(cAsE->alts[0].first.value), 'a');
     ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, "k");
-    EXPECT_EQ(cAsE->default_var, "k");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, Symbol("k"));
+    EXPECT_EQ(cAsE->default_var, Symbol("k"));
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, "k");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, Symbol("k"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -341,25 +357,25 @@ TEST(STGTranslation, TranslatesCase) {
             program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->updatable, true);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::algebraiccase);
-    auto CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, true);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::algebraiccase);
+    auto CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(CaSe->expr.get())->value), 'a');
     ASSERT_EQ(CaSe->alts.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Nil");
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Nil"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 0);
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(CaSe->alts[0].second.get())->value), 'a');
-    EXPECT_EQ(CaSe->alts[1].first.constructor_name, "Nill");
+    EXPECT_EQ(CaSe->alts[1].first.constructor_name, Symbol("Nill"));
     EXPECT_EQ(CaSe->alts[1].first.variables.size(), 0);
     ASSERT_EQ(CaSe->alts[1].second->get_form(), stgform::literal);
     EXPECT_EQ(std::get<char>(dynamic_cast<STGLiteral*>(CaSe->alts[1].second.get())->value), 'b');
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -367,24 +383,24 @@ TEST(STGTranslation, TranslatesCase) {
             program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::algebraiccase);
-    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::algebraiccase);
+    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".0");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".0"));
     ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Cons");
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".1");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".2");
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".1"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".2"));
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, ".1");
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, Symbol(".1"));
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -392,40 +408,40 @@ TEST(STGTranslation, TranslatesCase) {
             program.get());
     ASSERT_EQ(result, 0);
     translated = translate(program);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::algebraiccase);
-    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::algebraiccase);
+    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".0");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".0"));
     ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Cons");
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".1");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".2");
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".1"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".2"));
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::algebraiccase);
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
     CaSe = dynamic_cast<STGAlgebraicCase*>(CaSe->alts[0].second.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".2");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".2"));
     ASSERT_EQ(CaSe->alts.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Cons");
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".3");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".4");
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".3"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".4"));
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, ".3");
-    EXPECT_EQ(CaSe->alts[1].first.constructor_name, "Nil");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, Symbol(".3"));
+    EXPECT_EQ(CaSe->alts[1].first.constructor_name, Symbol("Nil"));
     EXPECT_EQ(CaSe->alts[1].first.variables.size(), 0);
     ASSERT_EQ(CaSe->alts[1].second->get_form(), stgform::literal);
     EXPECT_EQ(std::get<int>(dynamic_cast<STGLiteral*>(CaSe->alts[1].second.get())->value), 1);
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
 
     program = std::make_unique<Program>();
     result = parse_string_no_prelude(
@@ -436,86 +452,279 @@ TEST(STGTranslation, TranslatesCase) {
     ASSERT_EQ(result, 0);
     translated = translate(program);
     EXPECT_EQ(translated->bindings.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->free_variables.size(), 0);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables.size(), 1);
-    EXPECT_EQ(translated->bindings.at("main")->argument_variables[0], ".0");
-    EXPECT_EQ(translated->bindings.at("main")->updatable, false);
-    ASSERT_EQ(translated->bindings.at("main")->expr->get_form(), stgform::algebraiccase);
-    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at("main")->expr.get());
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->free_variables.size(), 0);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->argument_variables[0], Symbol(".0"));
+    EXPECT_EQ(translated->bindings.at(Symbol("main"))->updatable, false);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::algebraiccase);
+    CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".0");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".0"));
     ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Pair");
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Pair"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".1");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".2");
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".1"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".2"));
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::algebraiccase);
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
+    // Each of the fields is tested once, and the second only where the first does not decide the alternative.
     CaSe = dynamic_cast<STGAlgebraicCase*>(CaSe->alts[0].second.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".1");
-    ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Nil");
-    EXPECT_EQ(CaSe->alts[0].first.variables.size(), 0);
-    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, ".2");
-    EXPECT_EQ(CaSe->default_var, "");
-    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::algebraiccase);
-    CaSe = dynamic_cast<STGAlgebraicCase*>(CaSe->default_expr.get());
-    ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".2");
-    ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Nil");
-    EXPECT_EQ(CaSe->alts[0].first.variables.size(), 0);
-    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[0].second.get())->name, ".1");
-    EXPECT_EQ(CaSe->default_var, "");
-    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::algebraiccase);
-    CaSe = dynamic_cast<STGAlgebraicCase*>(CaSe->default_expr.get());
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".1"));
+    ASSERT_EQ(CaSe->alts.size(), 2);
+    EXPECT_EQ(CaSe->alts[1].first.constructor_name, Symbol("Nil"));
+    EXPECT_EQ(CaSe->alts[1].first.variables.size(), 0);
+    ASSERT_EQ(CaSe->alts[1].second->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[1].second.get())->name, Symbol(".2"));
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
+    EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".3"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".4"));
+    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::algebraiccase);
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
+    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
+    CaSe = dynamic_cast<STGAlgebraicCase*>(CaSe->alts[0].second.get());
     ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".1");
-    ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Cons");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".2"));
+    ASSERT_EQ(CaSe->alts.size(), 2);
+    EXPECT_EQ(CaSe->alts[1].first.constructor_name, Symbol("Nil"));
+    EXPECT_EQ(CaSe->alts[1].first.variables.size(), 0);
+    ASSERT_EQ(CaSe->alts[1].second->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->alts[1].second.get())->name, Symbol(".1"));
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
     EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".3");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".4");
+    EXPECT_EQ(CaSe->alts[0].first.variables[0], Symbol(".5"));
+    EXPECT_EQ(CaSe->alts[0].first.variables[1], Symbol(".6"));
     ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::literalcase);
-    EXPECT_EQ(CaSe->default_var, "");
+    EXPECT_EQ(CaSe->default_var, Symbol(""));
     ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, Symbol("case_error"));
     cAsE = dynamic_cast<STGLiteralCase*>(CaSe->alts[0].second.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, ".3");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, Symbol(".3"));
     ASSERT_EQ(cAsE->alts.size(), 1);
     EXPECT_EQ(std::get<int>(cAsE->alts[0].first.value), 1);
-    ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::algebraiccase);
-    EXPECT_EQ(cAsE->default_var, "");
+    ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::literalcase);
+    EXPECT_EQ(cAsE->default_var, Symbol(""));
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, "case_error");
-    CaSe = dynamic_cast<STGAlgebraicCase*>(cAsE->alts[0].second.get());
-    ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, ".2");
-    ASSERT_EQ(CaSe->alts.size(), 1);
-    EXPECT_EQ(CaSe->alts[0].first.constructor_name, "Cons");
-    EXPECT_EQ(CaSe->alts[0].first.variables.size(), 2);
-    EXPECT_EQ(CaSe->alts[0].first.variables[0], ".5");
-    EXPECT_EQ(CaSe->alts[0].first.variables[1], ".6");
-    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::literalcase);
-    EXPECT_EQ(CaSe->default_var, "");
-    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->default_expr.get())->name, "case_error");
-    cAsE = dynamic_cast<STGLiteralCase*>(CaSe->alts[0].second.get());
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, Symbol("case_error"));
+    cAsE = dynamic_cast<STGLiteralCase*>(cAsE->alts[0].second.get());
     ASSERT_EQ(cAsE->expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, ".5");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->expr.get())->name, Symbol(".5"));
     ASSERT_EQ(cAsE->alts.size(), 1);
     EXPECT_EQ(std::get<int>(cAsE->alts[0].first.value), 2);
     ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, ".4");
-    EXPECT_EQ(cAsE->default_var, "");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, Symbol(".4"));
+    EXPECT_EQ(cAsE->default_var, Symbol(""));
+    ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, Symbol("case_error"));
+}
+
+TEST(STGTranslation, SharesFallThroughWithJoinPoints) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data List = Cons Int List | Nil;"
+            "data Pair = Pair List List;"
+            "main p = case p of { Pair (Cons 1 xs) ys -> xs ; Pair xs (Cons 2 ys) -> ys ; Pair _ _ -> Nil }",
+            program.get());
+    ASSERT_EQ(result, 0);
+    auto translated = translate(program);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::algebraiccase);
+    auto CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
+    ASSERT_EQ(CaSe->alts.size(), 1);
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Pair"));
+
+    // The last alternative is chosen wherever neither field matches, and the second wherever the first field does
+    // not, so each is translated once as a join point. The second takes the variables its pattern binds, xs and ys.
+    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::letnoescape);
+    auto join_point = dynamic_cast<STGLetNoEscape*>(CaSe->alts[0].second.get());
+    ASSERT_EQ(join_point->arguments.size(), 2);
+    ASSERT_EQ(join_point->rhs->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(join_point->rhs.get())->name, join_point->arguments[1]);
+    ASSERT_EQ(join_point->expr->get_form(), stgform::letnoescape);
+    auto last_join_point = dynamic_cast<STGLetNoEscape*>(join_point->expr.get());
+    EXPECT_EQ(last_join_point->arguments.size(), 0);
+    ASSERT_EQ(last_join_point->rhs->get_form(), stgform::constructor);
+    EXPECT_EQ(dynamic_cast<STGConstructor*>(last_join_point->rhs.get())->constructor_name, Symbol("Nil"));
+
+    // The first field is tested once, and the second once on each branch that needs it.
+    ASSERT_EQ(last_join_point->expr->get_form(), stgform::algebraiccase);
+    CaSe = dynamic_cast<STGAlgebraicCase*>(last_join_point->expr.get());
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, Symbol(".1"));
+    ASSERT_EQ(CaSe->alts.size(), 1);
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("Cons"));
+    ASSERT_EQ(CaSe->alts[0].second->get_form(), stgform::literalcase);
+    auto cAsE = dynamic_cast<STGLiteralCase*>(CaSe->alts[0].second.get());
+    ASSERT_EQ(cAsE->alts.size(), 1);
+    ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->alts[0].second.get())->name, CaSe->alts[0].first.variables[1]);
+    ASSERT_EQ(cAsE->default_expr->get_form(), stgform::algebraiccase);
+    auto second_field = dynamic_cast<STGAlgebraicCase*>(cAsE->default_expr.get());
+    EXPECT_EQ(dynamic_cast<STGVariable*>(second_field->expr.get())->name, Symbol(".2"));
+    ASSERT_EQ(second_field->default_expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(second_field->default_expr.get())->name, last_join_point->name);
+
+    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::algebraiccase);
+    second_field = dynamic_cast<STGAlgebraicCase*>(CaSe->default_expr.get());
+    EXPECT_EQ(dynamic_cast<STGVariable*>(second_field->expr.get())->name, Symbol(".2"));
+    ASSERT_EQ(second_field->alts.size(), 1);
+    ASSERT_EQ(second_field->alts[0].second->get_form(), stgform::literalcase);
+    cAsE = dynamic_cast<STGLiteralCase*>(second_field->alts[0].second.get());
+    ASSERT_EQ(cAsE->alts[0].second->get_form(), stgform::application);
+    auto jump = dynamic_cast<STGApplication*>(cAsE->alts[0].second.get());
+    EXPECT_EQ(jump->lhs, join_point->name);
+    ASSERT_EQ(jump->arguments.size(), 2);
+    EXPECT_EQ(jump->arguments[0], Symbol(".1"));
+    EXPECT_EQ(jump->arguments[1], second_field->alts[0].first.variables[1]);
     ASSERT_EQ(cAsE->default_expr->get_form(), stgform::variable);
-    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, "case_error");
+    EXPECT_EQ(dynamic_cast<STGVariable*>(cAsE->default_expr.get())->name, last_join_point->name);
+}
+
+// Counts the expressions in an expression, along with those in the lambda forms it binds.
+size_t count_expressions(const STGExpression *expr) {
+    switch (expr->get_form()) {
+        case stgform::let: {
+            size_t count = 1 + count_expressions(dynamic_cast<const STGLet*>(expr)->expr.get());
+            for (const auto &[_, lambda_form]: dynamic_cast<const STGLet*>(expr)->bindings) {
+                count += count_expressions(lambda_form->expr.get());
+            }
+            return count;
+        }
+        case stgform::letnoescape:
+            return 1 + count_expressions(dynamic_cast<const STGLetNoEscape*>(expr)->rhs.get()) +
+                   count_expressions(dynamic_cast<const STGLetNoEscape*>(expr)->expr.get());
+        case stgform::literalcase: {
+            auto cAsE = dynamic_cast<const STGLiteralCase*>(expr);
+            size_t count = 1 + count_expressions(cAsE->expr.get()) + count_expressions(cAsE->default_expr.get());
+            for (const auto &[_, alt_expr]: cAsE->alts) {
+                count += count_expressions(alt_expr.get());
+            }
+            return count;
+        }
+        case stgform::algebraiccase: {
+            auto cAsE = dynamic_cast<const STGAlgebraicCase*>(expr);
+            size_t count = 1 + count_expressions(cAsE->expr.get()) + count_expressions(cAsE->default_expr.get());
+            for (const auto &[_, alt_expr]: cAsE->alts) {
+                count += count_expressions(alt_expr.get());
+            }
+            return count;
+        }
+        default:
+            return 1;
+    }
+}
+
+// The first case in expr, under any join points bound around it.
+const STGExpression *first_case(const STGExpression *expr) {
+    while (expr->get_form() == stgform::letnoescape) {
+        expr = dynamic_cast<const STGLetNoEscape*>(expr)->expr.get();
+    }
+    return expr;
+}
+
+TEST(STGTranslation, TestsNeededColumnsFirst) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data List = Cons Int List | Nil;"
+            "data Pair = Pair List List;"
+            "main p = case p of { Pair (Cons 1 xs) Nil -> xs ; Pair xs (Cons 2 ys) -> ys ; Pair _ Nil -> Nil }",
+            program.get());
+    ASSERT_EQ(result, 0);
+
+    // Every alternative needs the second field, and it is evaluated whichever alternative is chosen, as the first one
+    // only fails on the first field when the second one is about to be tested. So the second field is tested first.
+    for (auto column_heuristic: {ColumnHeuristic::needed, ColumnHeuristic::leftmost}) {
+        auto translated = translate(program, nullptr, column_heuristic);
+        auto CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
+        ASSERT_NE(CaSe, nullptr);
+        auto inner = dynamic_cast<const STGAlgebraicCase*>(first_case(CaSe->alts[0].second.get()));
+        ASSERT_NE(inner, nullptr);
+        size_t tested = column_heuristic == ColumnHeuristic::needed ? 1 : 0;
+        EXPECT_EQ(dynamic_cast<STGVariable*>(inner->expr.get())->name, CaSe->alts[0].first.variables[tested]);
+    }
+}
+
+TEST(STGTranslation, TestsOnlyColumnsThatAreEvaluated) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data AB = A | B;"
+            "data P = P AB AB;"
+            "main p = case p of { P A A -> 1 ; P B _ -> 2 ; P _ A -> 3 ; P _ B -> 4 }",
+            program.get());
+    ASSERT_EQ(result, 0);
+
+    // Most alternatives need the second field, but P B undefined selects the second alternative without evaluating
+    // it. So the first field is tested first, and when it is B the second alternative is selected straight away.
+    auto translated = translate(program);
+    auto CaSe = dynamic_cast<STGAlgebraicCase*>(translated->bindings.at(Symbol("main"))->expr.get());
+    ASSERT_NE(CaSe, nullptr);
+    auto inner = dynamic_cast<const STGAlgebraicCase*>(first_case(CaSe->alts[0].second.get()));
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(inner->expr.get())->name, CaSe->alts[0].first.variables[0]);
+    ASSERT_EQ(inner->alts.size(), 2);
+    EXPECT_EQ(inner->alts[1].first.constructor_name, Symbol("B"));
+    ASSERT_EQ(inner->alts[1].second->get_form(), stgform::literal);
+    EXPECT_EQ(std::get<int>(dynamic_cast<STGLiteral*>(inner->alts[1].second.get())->value), 2);
+}
+
+TEST(STGTranslation, TestsLiteralsInsideConstructors) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data M = J Int | N;"
+            "main m = case m of { J 1 -> 'a' ; J 2 -> 'b' ; _ -> 'c' }",
+            program.get());
+    ASSERT_EQ(result, 0);
+
+    // The field of J is tested by its literal, and a literal test always needs a default.
+    auto translated = translate(program);
+    auto CaSe = dynamic_cast<const STGAlgebraicCase*>(first_case(translated->bindings.at(Symbol("main"))->expr.get()));
+    ASSERT_NE(CaSe, nullptr);
+    ASSERT_EQ(CaSe->alts.size(), 1);
+    EXPECT_EQ(CaSe->alts[0].first.constructor_name, Symbol("J"));
+    auto inner = dynamic_cast<const STGLiteralCase*>(first_case(CaSe->alts[0].second.get()));
+    ASSERT_NE(inner, nullptr);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(inner->expr.get())->name, CaSe->alts[0].first.variables[0]);
+    ASSERT_EQ(inner->alts.size(), 2);
+    EXPECT_EQ(std::get<int>(inner->alts[0].first.value), 1);
+    EXPECT_EQ(std::get<int>(inner->alts[1].first.value), 2);
+    EXPECT_NE(inner->default_expr, nullptr);
+}
+
+TEST(STGTranslation, BoundsDecisionTreeSize) {
+    // Alternatives that take turns testing the first and second fields copy the ones that test the second into each
+    // branch of the test of the first, so a single decision tree for them grows with the square of their number.
+    std::string alts;
+    size_t number = 200;
+    for (size_t i = 0; i < number; i++) {
+        alts += i % 2 == 0
+                ? "T (C " + std::to_string(i) + ") _ -> " + std::to_string(i) + " ; "
+                : "T _ (C " + std::to_string(i) + ") -> " + std::to_string(i) + " ; ";
+    }
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            ("data D = C Int | E;data T = T D D;main t = case t of { " + alts + "_ -> 0 }").c_str(),
+            program.get());
+    ASSERT_EQ(result, 0);
+
+    auto translated = translate(program);
+    EXPECT_LT(count_expressions(translated->bindings.at(Symbol("main"))->expr.get()), 16 * number);
+}
+
+TEST(STGTranslation, TranslatesLongLists) {
+    std::string elements = "c";
+    for (int i = 1; i < 100000; i++) {
+        elements += ", c";
+    }
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string(("f c = [" + elements + "]\n;main = f 'a'").c_str(), program.get());
+    ASSERT_EQ(result, 0);
+    auto translated = translate(program);
+    EXPECT_EQ(translated->bindings.at(Symbol("f"))->argument_variables.size(), 1);
+    EXPECT_EQ(translated->bindings.at(Symbol("f"))->expr->get_form(), stgform::let);
+    EXPECT_EQ(translated->data_constructors.count(Symbol(":")), 1);
 }
 
 TEST(STGTranslation, GeneratesDataConstructorTags) {
@@ -525,12 +734,290 @@ TEST(STGTranslation, GeneratesDataConstructorTags) {
             program.get());
     ASSERT_EQ(result, 0);
     auto translated = translate(program);
-    EXPECT_EQ(translated->data_constructors.at("A").tag, 0);
-    EXPECT_EQ(translated->data_constructors.at("B").tag, 1);
-    EXPECT_EQ(translated->data_constructors.at("C").tag, 0);
-    EXPECT_EQ(translated->data_constructors.at("D").tag, 1);
-    EXPECT_EQ(translated->data_constructors.at("[]").tag, 0);
-    EXPECT_EQ(translated->data_constructors.at(":").tag, 1);
-    EXPECT_EQ(translated->data_constructors.at("False").tag, 0);
-    EXPECT_EQ(translated->data_constructors.at("True").tag, 1);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("A")).tag, 0);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("B")).tag, 1);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("C")).tag, 0);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("D")).tag, 1);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("[]")).tag, 0);
+    EXPECT_EQ(translated->data_constructors.at(Symbol(":")).tag, 1);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("False")).tag, 0);
+    EXPECT_EQ(translated->data_constructors.at(Symbol("True")).tag, 1);
+}
+
+TEST(STGTranslation, CarriesTypes) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string("main = h \"ab\";h xs = case xs of { (y:ys) -> y ; [] -> 'a' }", program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+
+    auto character = make_type_constructor(Symbol("Char"));
+    auto string = make_type_application(make_type_constructor(Symbol("[]")), character);
+    EXPECT_TRUE(same_type(translated->bindings.at(Symbol("main"))->type.get(), character.get()));
+    const auto &h = translated->bindings.at(Symbol("h"));
+    EXPECT_TRUE(same_type(h->type.get(), make_function_type(string, character).get()));
+    ASSERT_EQ(h->argument_variables.size(), 1);
+    ASSERT_EQ(h->expr->get_form(), stgform::algebraiccase);
+    const auto &pattern = static_cast<STGAlgebraicCase*>(h->expr.get())->alts.at(0).first;
+    ASSERT_EQ(pattern.variable_types.size(), 2);
+    EXPECT_EQ(pattern.variable_types[0], character);
+    EXPECT_EQ(pattern.variable_types[1], string);
+}
+
+TEST(STGSimplification, InlinesFunctionsAndSelectsKnownAlternatives) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data List = Cons Int List | Nil;"
+            "first xs = case xs of { Cons y ys -> y ; Nil -> 0 };"
+            "main x = first (Cons x Nil)",
+            program.get());
+    ASSERT_EQ(result, 0);
+    auto translated = translate(program);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::let);
+
+    // The list is only scrutinised by the inlined case, so once its alternative is selected it is no longer built.
+    simplify(translated, program->module_name);
+    const auto &main = translated->bindings.at(Symbol("main"));
+    ASSERT_EQ(main->argument_variables.size(), 1);
+    EXPECT_EQ(main->free_variables.size(), 0);
+    ASSERT_EQ(main->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(main->expr.get())->name, main->argument_variables[0]);
+
+    // Functions larger than the threshold are called rather than inlined.
+    translated = translate(program);
+    simplify(translated, program->module_name, 0);
+    ASSERT_EQ(translated->bindings.at(Symbol("main"))->expr->get_form(), stgform::let);
+    auto let = dynamic_cast<STGLet*>(translated->bindings.at(Symbol("main"))->expr.get());
+    ASSERT_EQ(let->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(let->expr.get())->lhs, Symbol("first"));
+}
+
+TEST(STGSimplification, EvaluatesThunksScrutinisedOnceInPlace) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "loop n = loop n;"
+            "main x = let { y = loop x } in case y of { 1 -> 'a' ; _ -> 'b' }",
+            program.get());
+    ASSERT_EQ(result, 0);
+    auto translated = translate(program);
+    simplify(translated, program->module_name);
+
+    // loop is recursive, so it is not inlined.
+    const auto &main = translated->bindings.at(Symbol("main"));
+    ASSERT_EQ(main->expr->get_form(), stgform::literalcase);
+    auto CaSe = dynamic_cast<STGLiteralCase*>(main->expr.get());
+    ASSERT_EQ(CaSe->expr->get_form(), stgform::application);
+    auto application = dynamic_cast<STGApplication*>(CaSe->expr.get());
+    EXPECT_EQ(application->lhs, Symbol("loop"));
+    EXPECT_EQ(application->arguments, main->argument_variables);
+    EXPECT_EQ(CaSe->alts.size(), 1);
+}
+
+TEST(STGSimplification, SimplifiesLongLists) {
+    std::string elements = "c";
+    for (int i = 1; i < 100000; i++) {
+        elements += ", c";
+    }
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string(("f c = [" + elements + "]\n;main = f 'a'").c_str(), program.get());
+    ASSERT_EQ(result, 0);
+    auto translated = translate(program);
+    simplify(translated, program->module_name);
+    const auto &f = translated->bindings.at(Symbol("f"));
+    ASSERT_EQ(f->expr->get_form(), stgform::let);
+    EXPECT_EQ(f->free_variables.size(), 0);
+    auto let = dynamic_cast<STGLet*>(f->expr.get());
+    ASSERT_EQ(let->bindings.size(), 1);
+    EXPECT_EQ(let->bindings.begin()->second->free_variables.size(), 2);
+}
+
+TEST(STGStrictness, EvaluatesThunksForStrictArguments) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "data N = Z | S N;"
+            "isz n = case n of { Z -> 'y' ; S m -> 'n' };"
+            "loop n = loop n;"
+            "main y = isz (loop y)",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+    evaluate_strict_thunks(translated);
+
+    EXPECT_EQ(translated->bindings.at(Symbol("isz"))->strict_arguments, std::vector<bool>({true}));
+    EXPECT_EQ(translated->bindings.at(Symbol("loop"))->strict_arguments, std::vector<bool>({true}));
+    const auto &main = translated->bindings.at(Symbol("main"));
+    ASSERT_EQ(main->expr->get_form(), stgform::algebraiccase);
+    auto CaSe = dynamic_cast<STGAlgebraicCase*>(main->expr.get());
+    EXPECT_EQ(CaSe->alts.size(), 0);
+    ASSERT_EQ(CaSe->expr->get_form(), stgform::application);
+    EXPECT_EQ(dynamic_cast<STGApplication*>(CaSe->expr.get())->lhs, Symbol("loop"));
+    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::application);
+    auto application = dynamic_cast<STGApplication*>(CaSe->default_expr.get());
+    EXPECT_EQ(application->lhs, Symbol("isz"));
+    EXPECT_EQ(application->arguments, std::vector<Symbol>({CaSe->default_var}));
+}
+
+TEST(STGStrictness, LeavesLazyArgumentsAsThunks) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "second x y = case y of { 0 -> 'a' ; _ -> 'b' };"
+            "loop n = loop n;"
+            "main y = second (loop y) (loop y)",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+    evaluate_strict_thunks(translated);
+
+    EXPECT_EQ(translated->bindings.at(Symbol("second"))->strict_arguments, std::vector<bool>({false, true}));
+    // Only the second argument is evaluated by a literal case; the first is still allocated as a thunk.
+    const auto &main = translated->bindings.at(Symbol("main"));
+    ASSERT_EQ(main->expr->get_form(), stgform::literalcase);
+    auto CaSe = dynamic_cast<STGLiteralCase*>(main->expr.get());
+    EXPECT_EQ(CaSe->alts.size(), 0);
+    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::let);
+    auto let = dynamic_cast<STGLet*>(CaSe->default_expr.get());
+    ASSERT_EQ(let->bindings.size(), 1);
+    ASSERT_EQ(let->expr->get_form(), stgform::application);
+    auto application = dynamic_cast<STGApplication*>(let->expr.get());
+    EXPECT_EQ(application->arguments, std::vector<Symbol>({let->bindings.begin()->first,  CaSe->default_var}));
+}
+
+// The lambda forms bound by the lets in an expression, and whether it has a case that evaluates a call of function.
+bool evaluates_call_of(const STGExpression *expr, const Symbol &function, std::vector<const STGLambdaForm*> &bound) {
+    switch (expr->get_form()) {
+        case stgform::let: {
+            bool found = evaluates_call_of(dynamic_cast<const STGLet*>(expr)->expr.get(), function, bound);
+            for (const auto &[_, lambda_form]: dynamic_cast<const STGLet*>(expr)->bindings) {
+                bound.push_back(lambda_form.get());
+                found = evaluates_call_of(lambda_form->expr.get(), function, bound) || found;
+            }
+            return found;
+        }
+        case stgform::literalcase: {
+            auto cAsE = dynamic_cast<const STGLiteralCase*>(expr);
+            bool found = cAsE->expr->get_form() == stgform::application &&
+                         dynamic_cast<const STGApplication*>(cAsE->expr.get())->lhs == function;
+            found = evaluates_call_of(cAsE->default_expr.get(), function, bound) || found;
+            for (const auto &[_, alt_expr]: cAsE->alts) {
+                found = evaluates_call_of(alt_expr.get(), function, bound) || found;
+            }
+            return found;
+        }
+        case stgform::algebraiccase: {
+            auto cAsE = dynamic_cast<const STGAlgebraicCase*>(expr);
+            bool found = cAsE->expr->get_form() == stgform::application &&
+                         dynamic_cast<const STGApplication*>(cAsE->expr.get())->lhs == function;
+            found = evaluates_call_of(cAsE->default_expr.get(), function, bound) || found;
+            for (const auto &[_, alt_expr]: cAsE->alts) {
+                found = evaluates_call_of(alt_expr.get(), function, bound) || found;
+            }
+            return found;
+        }
+        default:
+            return false;
+    }
+}
+
+TEST(STGStrictness, AnalysesLocalRecursiveFunctions) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "loop n = loop n;"
+            "main n = let { g x y z = case x of { 0 -> case z of { 0 -> n ; _ -> 1 } ; _ -> g 0 z y } }"
+            " in g 1 n (loop n)",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+    evaluate_strict_thunks(translated);
+
+    // g swaps y and z when it calls itself, after which it evaluates neither, so it is only strict in x, and the thunk
+    // passed for z is not evaluated before the call.
+    std::vector<const STGLambdaForm*> bound;
+    EXPECT_FALSE(evaluates_call_of(translated->bindings.at(Symbol("main"))->expr.get(), Symbol("loop"), bound));
+    auto g = std::find_if(bound.begin(), bound.end(), [](const STGLambdaForm *lambda_form) {
+        return lambda_form->argument_variables.size() == 3;
+    });
+    ASSERT_NE(g, bound.end());
+    EXPECT_EQ((*g)->strict_arguments, std::vector<bool>({true, false, false}));
+}
+
+TEST(STGWorkerWrapper, CallsWorkersWithUnboxedArguments) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string_no_prelude(
+            "go n = case n of { 0 -> 'a' ; m -> go m };"
+            "main x = go x",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+    evaluate_strict_thunks(translated);
+    split_workers(translated, program->module_name);
+
+    // The wrapper evaluates its argument and calls the worker, boxing the result it returns.
+    const auto &go = translated->bindings.at(Symbol("go"));
+    EXPECT_TRUE(go->unboxed_arguments.empty());
+    EXPECT_FALSE(go->unboxed_result);
+    ASSERT_EQ(go->expr->get_form(), stgform::literalcase);
+    auto argument = dynamic_cast<STGLiteralCase*>(go->expr.get());
+    ASSERT_EQ(argument->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(argument->expr.get())->name, go->argument_variables[0]);
+    ASSERT_EQ(argument->default_expr->get_form(), stgform::literalcase);
+    auto boxed = dynamic_cast<STGLiteralCase*>(argument->default_expr.get());
+    ASSERT_EQ(boxed->expr->get_form(), stgform::application);
+    auto call = dynamic_cast<STGApplication*>(boxed->expr.get());
+    EXPECT_EQ(call->lhs, Symbol("go.worker"));
+    EXPECT_EQ(call->arguments, std::vector<Symbol>({argument->default_var}));
+
+    // The worker takes its argument unboxed under a new name, and calls itself with it, as it has nothing to box.
+    const auto &worker = translated->bindings.at(Symbol("go.worker"));
+    EXPECT_EQ(worker->unboxed_arguments, std::vector<bool>({true}));
+    EXPECT_TRUE(worker->unboxed_result);
+    EXPECT_NE(worker->argument_variables, go->argument_variables);
+    ASSERT_EQ(worker->expr->get_form(), stgform::literalcase);
+    auto CaSe = dynamic_cast<STGLiteralCase*>(worker->expr.get());
+    ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, worker->argument_variables[0]);
+    ASSERT_EQ(CaSe->default_expr->get_form(), stgform::application);
+    call = dynamic_cast<STGApplication*>(CaSe->default_expr.get());
+    EXPECT_EQ(call->lhs, Symbol("go.worker"));
+    EXPECT_EQ(call->arguments, worker->argument_variables);
+
+    // main is strict in its argument too, so its worker passes it on to go's worker as it is.
+    const auto &main_worker = translated->bindings.at(Symbol("main.worker"));
+    ASSERT_EQ(main_worker->expr->get_form(), stgform::application);
+    call = dynamic_cast<STGApplication*>(main_worker->expr.get());
+    EXPECT_EQ(call->lhs, Symbol("go.worker"));
+    EXPECT_EQ(call->arguments, main_worker->argument_variables);
+}
+
+TEST(STGWorkerWrapper, BoxesUnboxedArgumentsWhereNeeded) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    int result = parse_string(
+            "f n = case n of { 0 -> [] ; _ -> n : [] }\n;"
+            "main = f 3",
+            program.get());
+    ASSERT_EQ(result, 0);
+    type_check(program, false);
+    auto translated = translate(program);
+    evaluate_strict_thunks(translated);
+    split_workers(translated, program->module_name);
+
+    // The worker puts its argument in a constructor, so it binds the name its body has for it to a boxed copy first.
+    const auto &f = translated->bindings.at(Symbol("f"));
+    const auto &worker = translated->bindings.at(Symbol("f.worker"));
+    EXPECT_EQ(worker->unboxed_arguments, std::vector<bool>({true}));
+    EXPECT_FALSE(worker->unboxed_result);
+    ASSERT_EQ(worker->expr->get_form(), stgform::literalcase);
+    auto boxed = dynamic_cast<STGLiteralCase*>(worker->expr.get());
+    EXPECT_TRUE(boxed->alts.empty());
+    ASSERT_EQ(boxed->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(boxed->expr.get())->name, worker->argument_variables[0]);
+    EXPECT_EQ(boxed->default_var, f->argument_variables[0]);
+    EXPECT_NE(worker->argument_variables[0], f->argument_variables[0]);
+    ASSERT_EQ(boxed->default_expr->get_form(), stgform::literalcase);
+    auto CaSe = dynamic_cast<STGLiteralCase*>(boxed->default_expr.get());
+    ASSERT_EQ(CaSe->expr->get_form(), stgform::variable);
+    EXPECT_EQ(dynamic_cast<STGVariable*>(CaSe->expr.get())->name, worker->argument_variables[0]);
 }
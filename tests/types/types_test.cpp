@@ -1,33 +1,40 @@
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
 #include "test/test_utilities.hpp"
 #include "types/types.hpp"
 #include "parser/syntax.hpp"
 #include "types/type_check.hpp"
+#include "types/type_cache.hpp"
+#include "statistics/statistics.hpp"
 
 TEST(Types, TypeEquality) {
+    Arena arena;
     EXPECT_TRUE(same_type(
-            std::make_unique<TypeConstructor>("()").get(),
-            std::make_unique<TypeConstructor>("()").get()));
+            new (arena) TypeConstructor(Symbol("()")),
+            new (arena) TypeConstructor(Symbol("()"))));
     EXPECT_TRUE(same_type(
-            std::make_unique<UniversallyQuantifiedVariable>("a").get(),
-            std::make_unique<UniversallyQuantifiedVariable>("a").get()));
+            new (arena) UniversallyQuantifiedVariable(Symbol("a")),
+            new (arena) UniversallyQuantifiedVariable(Symbol("a"))));
     EXPECT_TRUE(same_type(
-            std::make_unique<TypeApplication>(new TypeConstructor("a"), new UniversallyQuantifiedVariable("b")).get(),
-            std::make_unique<TypeApplication>(new TypeConstructor("a"), new UniversallyQuantifiedVariable("b")).get()));
+            new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("a")), new (arena) UniversallyQuantifiedVariable(Symbol("b"))),
+            new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("a")), new (arena) UniversallyQuantifiedVariable(Symbol("b")))));
 
     EXPECT_FALSE(same_type(
-            std::make_unique<TypeConstructor>("()").get(),
-            std::make_unique<UniversallyQuantifiedVariable>("()").get()));
+            new (arena) TypeConstructor(Symbol("()")),
+            new (arena) UniversallyQuantifiedVariable(Symbol("()"))));
     EXPECT_FALSE(same_type(
-            std::make_unique<TypeConstructor>("()").get(),
-            std::make_unique<TypeConstructor>("[]").get()));
+            new (arena) TypeConstructor(Symbol("()")),
+            new (arena) TypeConstructor(Symbol("[]"))));
     EXPECT_FALSE(same_type(
-            std::make_unique<UniversallyQuantifiedVariable>("aa").get(),
-            std::make_unique<UniversallyQuantifiedVariable>("a").get()));
+            new (arena) UniversallyQuantifiedVariable(Symbol("aa")),
+            new (arena) UniversallyQuantifiedVariable(Symbol("a"))));
     EXPECT_FALSE(same_type(
-            std::make_unique<TypeApplication>(new TypeConstructor("a"), new UniversallyQuantifiedVariable("b")).get(),
-            std::make_unique<TypeApplication>(new TypeConstructor("c"), new UniversallyQuantifiedVariable("b")).get()));
+            new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("a")), new (arena) UniversallyQuantifiedVariable(Symbol("b"))),
+            new (arena) TypeApplication(new (arena) TypeConstructor(Symbol("c")), new (arena) UniversallyQuantifiedVariable(Symbol("b")))));
 }
 
 #define EXPECT_WELL_TYPED(str) {                                    \
@@ -177,6 +184,25 @@ TEST(Types, Lists) {
             "a = [1, True]");
 }
 
+TEST(Types, LongLists) {
+    std::string elements = "'a'";
+    for (int i = 1; i < 100000; i++) {
+        elements += ", 'a'";
+    }
+    EXPECT_WELL_TYPED(("a :: [Char];a = [" + elements + "]").c_str());
+    EXPECT_NOT_WELL_TYPED(("a = [" + elements + ", 1]").c_str());
+}
+
+TEST(Types, LongChainsOfBindings) {
+    std::string functions;
+    for (int i = 0; i < 1000; i++) {
+        functions += "f" + std::to_string(i) + " x y = case x of { 'a' -> y ; _ -> f" +
+                     std::to_string((i + 1) % 1000) + " y x }\n;";
+    }
+    EXPECT_WELL_TYPED((functions + "main = f0 'a' 'b' : []").c_str());
+    EXPECT_NOT_WELL_TYPED((functions + "main = f0 'a' 1 : []").c_str());
+}
+
 TEST(Types, Tuples) {
     EXPECT_WELL_TYPED(
             "x :: (Int, Char, Bool);"
@@ -218,6 +244,51 @@ TEST(Types, Let) {
             "f x = let { g :: Int -> b -> ([Int], b); g y z = ([x,y], z) } in g");
 }
 
+TEST(Types, Scopes) {
+    // Names bound by lambdas, case alternatives and lets shadow outer names inside them, and only there.
+    EXPECT_WELL_TYPED(
+            "f :: Char -> (Int, Char);"
+            "f x = (case 1 of { x -> x }, x)");
+    EXPECT_WELL_TYPED(
+            "f :: Char -> (Int, Char);"
+            "f x = (let { x = 1 } in x, x)");
+    EXPECT_WELL_TYPED(
+            "f :: Char -> (Int -> Int, Char);"
+            "f x = (\\x -> case x of { 1 -> x }, x)");
+    EXPECT_NOT_WELL_TYPED(
+            "f = (\\y -> y, y)");
+    EXPECT_NOT_WELL_TYPED(
+            "f = (case 'a' of { c -> c }, c)");
+}
+
+TEST(Types, SignedBindings) {
+    // Bindings with signatures are checked against them, with the variables of the signature standing for any type.
+    EXPECT_WELL_TYPED(
+            "apply :: (a -> b) -> a -> b;"
+            "apply f x = f x");
+    EXPECT_WELL_TYPED(
+            "twice :: (a -> a) -> a -> a;"
+            "twice = \\f x -> f (f x)");
+    EXPECT_WELL_TYPED(
+            "len :: [a] -> Int;"
+            "len xs = case xs of { [] -> 0 ; (y:ys) -> len ys }");
+    EXPECT_WELL_TYPED(
+            "f :: a -> a;"
+            "f x = let { g :: b -> b; g y = y } in g x");
+    EXPECT_NOT_WELL_TYPED(
+            "f :: a -> b;"
+            "f x = x");
+    EXPECT_NOT_WELL_TYPED(
+            "f :: a -> Char;"
+            "f x = let { y = x } in y");
+    EXPECT_NOT_WELL_TYPED(
+            "f :: a -> a;"
+            "f x = let { g :: b -> a; g y = x } in g x");
+    EXPECT_NOT_WELL_TYPED(
+            "f :: Int -> [Char];"
+            "f x = ['a', x]");
+}
+
 TEST(Types, Case) {
     EXPECT_NOT_WELL_TYPED(
             "data Tree a = Leaf | Node a (Tree a) (Tree a);"
@@ -275,3 +346,223 @@ TEST(Types, CheckForMain) {
     ASSERT_EQ(result, 0);
     EXPECT_THROW(type_check(program, true), TypeError);
 }
+
+TEST(Types, DependencyAnalysis) {
+    std::unordered_map<Symbol, std::set<Symbol, SpellingOrder>> dependencies = {
+            {Symbol("a"), {Symbol("b"), Symbol("c")}},
+            {Symbol("b"), {Symbol("a"), Symbol("error")}},
+            {Symbol("c"), {Symbol("d")}},
+            {Symbol("d"), {Symbol("d")}},
+            {Symbol("e"), {}}};
+    std::vector<std::vector<Symbol>> groups =
+            dependency_analysis({Symbol("a"), Symbol("b"), Symbol("c"), Symbol("d"), Symbol("e")}, dependencies);
+    ASSERT_EQ(groups.size(), 4);
+    EXPECT_EQ(groups[0], std::vector<Symbol>({Symbol("e")}));
+    EXPECT_EQ(groups[1], std::vector<Symbol>({Symbol("d")}));
+    EXPECT_EQ(groups[2], std::vector<Symbol>({Symbol("c")}));
+    std::set<Symbol> last(groups[3].begin(), groups[3].end());
+    EXPECT_EQ(last, std::set<Symbol>({Symbol("a"), Symbol("b")}));
+
+    // A chain as long as a large program, which is searched without recursion.
+    std::vector<Symbol> names;
+    dependencies.clear();
+    for (int i = 0; i < 100000; i++) {
+        names.emplace_back("f" + std::to_string(i));
+        dependencies[names.back()] = {"f" + std::to_string(i + 1)};
+    }
+    groups = dependency_analysis(names, dependencies);
+    ASSERT_EQ(groups.size(), 100000);
+    EXPECT_EQ(groups.front(), std::vector<Symbol>({Symbol("f99999")}));
+    EXPECT_EQ(groups.back(), std::vector<Symbol>({Symbol("f0")}));
+}
+
+TEST(Types, ParallelInference) {
+    // Groups that do not depend on each other are inferred on different threads, which should not change the result.
+    std::string source = "data Pair a b = P a b\n";
+    for (int i = 0; i < 200; i++) {
+        std::string n = std::to_string(i);
+        source += ";pair" + n + " x y = P y x\n;swap" + n + " p = case p of { P x y -> pair" + n + " x y }\n";
+        if (i > 0) {
+            source += ";use" + n + " = swap" + n + " (swap" + std::to_string(i - 1) + " (P 'a' " + n + "))\n";
+        }
+    }
+    std::unique_ptr<Program> first;
+    for (int run = 0; run < 5; run++) {
+        std::unique_ptr<Program> program = std::make_unique<Program>();
+        ASSERT_EQ(parse_string(source.c_str(), program.get()), 0);
+        type_check(program, false);
+        if (run == 0) {
+            first = std::move(program);
+            continue;
+        }
+        for (const auto &[name, type]: first->types) {
+            EXPECT_TRUE(same_type(type.get(), program->types.at(name).get()));
+        }
+    }
+
+    // When several bindings are ill typed, the error is the one that inferring them in order would find first.
+    std::string message;
+    for (int run = 0; run < 5; run++) {
+        std::unique_ptr<Program> program = std::make_unique<Program>();
+        ASSERT_EQ(parse_string((source + ";bad1 = case 'a' of { 1 -> 'b' }\n;bad2 = case 1 of { 'a' -> 2 }").c_str(), program.get()), 0);
+        try {
+            type_check(program, false);
+            FAIL();
+        } catch (const TypeError &e) {
+            if (run == 0) {
+                message = e.what();
+            }
+            EXPECT_EQ(e.what(), message);
+        }
+    }
+}
+
+TEST(Types, HashConsing) {
+    std::shared_ptr<Type> int_to_int = make_function_type(make_type_constructor(Symbol("Int")), make_type_constructor(Symbol("Int")));
+    EXPECT_EQ(int_to_int, make_function_type(make_type_constructor(Symbol("Int")), make_type_constructor(Symbol("Int"))));
+    EXPECT_NE(int_to_int, make_function_type(make_type_constructor(Symbol("Int")), make_type_constructor(Symbol("Char"))));
+
+    // Types with variables are not shared, but the parts without them are.
+    auto a = make_universally_quantified_variable(Symbol("a"));
+    auto first = make_function_type(a, int_to_int);
+    auto second = make_function_type(a, int_to_int);
+    EXPECT_NE(first, second);
+    EXPECT_EQ(static_cast<TypeApplication*>(first.get())->right, static_cast<TypeApplication*>(second.get())->right);
+
+    // Inferred types and types from signatures share their parts without variables.
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    ASSERT_EQ(parse_string("f :: Int -> Int;f x = x;g y = f y;h z = (z, f)", program.get()), 0);
+    type_check(program, false);
+    EXPECT_EQ(hash_cons(program->types.at(Symbol("f"))), int_to_int);
+    EXPECT_EQ(hash_cons(program->types.at(Symbol("g"))), int_to_int);
+    auto h = hash_cons(program->types.at(Symbol("h")));
+    EXPECT_EQ(static_cast<TypeApplication*>(h.get())->right->get_form(), typeform::application);
+    auto pair = static_cast<TypeApplication*>(static_cast<TypeApplication*>(h.get())->right.get());
+    EXPECT_EQ(pair->right, int_to_int);
+}
+
+static std::unique_ptr<Program> type_check_with_cache(const char *source, TypeCache &cache) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    EXPECT_EQ(parse_string(source, program.get()), 0);
+    type_check(program, false, &cache);
+    return program;
+}
+
+TEST(Types, RecordsTypes) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    ASSERT_EQ(parse_string(
+            "f :: a -> [a] -> a;f x ys = case ys of { (y:_) -> y ; [] -> x };g c = case c of { 'a' -> 1 ; _ -> 2 }",
+            program.get()), 0);
+    type_check(program, false);
+
+    // Bindings checked against signatures record the variables of the signature.
+    auto a = make_universally_quantified_variable(Symbol("a"));
+    auto list_of_a = make_type_application(make_type_constructor(Symbol("[]")), a);
+    const auto &f = program->bindings.at(Symbol("f"));
+    ASSERT_NE(f->type, nullptr);
+    EXPECT_TRUE(same_type(f->type.get(), make_function_type(a, make_function_type(list_of_a, a)).get()));
+    ASSERT_EQ(f->get_form(), expform::abstraction);
+    auto f_case = static_cast<Case*>(static_cast<Abstraction*>(f.get())->body.get());
+    EXPECT_TRUE(same_type(f_case->exp->type.get(), list_of_a.get()));
+    EXPECT_TRUE(same_type(f_case->alts[0].first->type.get(), list_of_a.get()));
+    auto cons = static_cast<ConstructorPattern*>(f_case->alts[0].first.get());
+    EXPECT_TRUE(same_type(cons->args[0]->type.get(), a.get()));
+    EXPECT_TRUE(same_type(f_case->alts[1].second->type.get(), a.get()));
+
+    // Inferred types are recorded with their type variables replaced by what they were unified with.
+    auto char_to_int = make_function_type(make_type_constructor(Symbol("Char")), make_type_constructor(Symbol("Int")));
+    const auto &g = program->bindings.at(Symbol("g"));
+    EXPECT_EQ(g->type, char_to_int);
+    auto g_case = static_cast<Case*>(static_cast<Abstraction*>(g.get())->body.get());
+    EXPECT_EQ(g_case->exp->type, make_type_constructor(Symbol("Char")));
+    EXPECT_EQ(g_case->alts[0].first->type, make_type_constructor(Symbol("Char")));
+    EXPECT_EQ(g_case->alts[1].second->type, make_type_constructor(Symbol("Int")));
+}
+
+TEST(Types, CompileStatistics) {
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    ASSERT_EQ(parse_string("f x = (x, 'a');g :: Int -> Int;g y = y;main = \"a\"", program.get()), 0);
+    CompileStatistics statistics;
+    type_check(program, true, nullptr, &statistics);
+
+    // Bindings that are inferred and bindings that are checked against signatures are both counted.
+    ASSERT_EQ(statistics.bindings.count(Symbol("f")), 1);
+    EXPECT_GT(statistics.bindings.at(Symbol("f")).unifications, 0);
+    EXPECT_GT(statistics.bindings.at(Symbol("f")).type_variables, 0);
+    ASSERT_EQ(statistics.bindings.count(Symbol("g")), 1);
+    EXPECT_GT(statistics.bindings.at(Symbol("g")).unifications, 0);
+
+    std::stringstream json;
+    statistics.write_json(json);
+    EXPECT_NE(json.str().find("\"f\": {\"inference_milliseconds\": "), std::string::npos);
+}
+
+TEST(Types, TypeCache) {
+    char directory[] = "/tmp/picohaskell_type_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(directory), nullptr);
+    const char *source =
+            "data Pair a b = P a b;"
+            "swap p = case p of { P x y -> P y x };"
+            "twice f x = f (f x);"
+            "same :: Pair a a -> Pair a a;"
+            "same p = twice swap p";
+
+    TypeCache first(directory);
+    std::unique_ptr<Program> inferred = type_check_with_cache(source, first);
+    EXPECT_EQ(first.hits, 0);
+    EXPECT_EQ(first.misses, 3);
+
+    TypeCache second(directory);
+    std::unique_ptr<Program> loaded = type_check_with_cache(source, second);
+    EXPECT_EQ(second.hits, 3);
+    EXPECT_EQ(second.misses, 0);
+    for (const auto &[name, type]: inferred->types) {
+        EXPECT_TRUE(same_type(type.get(), loaded->types.at(name).get()));
+    }
+
+    // Changing the definition of twice without changing its type only makes it miss, but a change to its type makes
+    // same, which uses it, miss as well.
+    TypeCache third(directory);
+    type_check_with_cache(
+            "data Pair a b = P a b;"
+            "swap p = case p of { P x y -> P y x };"
+            "twice f x = let { y = f x } in f y;"
+            "same :: Pair a a -> Pair a a;"
+            "same p = twice swap p",
+            third);
+    EXPECT_EQ(third.hits, 2);
+    EXPECT_EQ(third.misses, 1);
+
+    TypeCache fourth(directory);
+    std::unique_ptr<Program> program = std::make_unique<Program>();
+    ASSERT_EQ(parse_string(
+            "data Pair a b = P a b;"
+            "swap p = case p of { P x y -> P y x };"
+            "twice f x = f 'a';"
+            "same :: Pair a a -> Pair a a;"
+            "same p = twice swap p",
+            program.get()), 0);
+    EXPECT_THROW(type_check(program, false, &fourth), TypeError);
+    EXPECT_EQ(fourth.hits, 1);
+    EXPECT_EQ(fourth.misses, 2);
+
+    // Two descriptions can hash to the same file name, so a file stored for another description is not used. The
+    // collision is made by copying the file stored for one description to the name of another.
+    auto file_name = [&](std::string_view description) {
+        uint64_t hash = 14695981039346656037ull;
+        for (const char &c: description) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+        return std::string(directory) + "/" + name + ".types";
+    };
+    TypeCache fifth(directory);
+    fifth.store("one", {Symbol("x")}, {make_type_constructor(Symbol("Int"))});
+    std::filesystem::copy_file(file_name("one"), file_name("other"));
+    EXPECT_FALSE(fifth.load("other", {Symbol("x")}).has_value());
+    EXPECT_TRUE(fifth.load("one", {Symbol("x")}).has_value());
+
+    std::filesystem::remove_all(directory);
+}
@@ -1,9 +1,18 @@
 #ifndef PICOHASKELL_TEST_UTILITIES_HPP
 #define PICOHASKELL_TEST_UTILITIES_HPP
 
+#include <memory>
+#include <vector>
 #include "parser/parser.hpp"
+#include "lexer/source_buffer.hpp"
 
-std::vector<yy::parser::symbol_type> lex_string(const char* str);
+// Identifier and string tokens are views into their source, so the source is kept alongside them.
+struct LexedTokens : public std::vector<yy::parser::symbol_type> {
+    std::unique_ptr<SourceBuffer> source;
+};
+
+LexedTokens lex_source(std::unique_ptr<SourceBuffer> source);
+LexedTokens lex_string(const char* str);
 int parse_string(const char* str, Program *program);
 int parse_string_no_prelude(const char* str, Program *program);
 
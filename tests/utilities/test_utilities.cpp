@@ -6,44 +6,40 @@
 #include "prelude/prelude.hpp"
 
 
-std::vector<yy::parser::symbol_type> lex_string(const char* str) {
-    std::vector<yy::parser::symbol_type> result;
+LexedTokens lex_source(std::unique_ptr<SourceBuffer> source) {
+    LexedTokens result;
     yy::location loc;
-    YY_BUFFER_STATE buffer = yy_scan_string(str);
-    yy_switch_to_buffer(buffer);
-    reset_start_condition();
-    while (true) {
-        result.push_back(yylex(loc));
-        if (result.back().kind() == yy::parser::symbol_kind_type::S_YYEOF) {
-            result.pop_back();
-            break;
+    yyscan_t scanner;
+    yylex_init(&scanner);
+    yy_scan_buffer(source->data(), source->size() + 2, scanner);
+    result.source = std::move(source);
+    try {
+        while (true) {
+            result.push_back(yylex(scanner, loc));
+            if (result.back().kind() == yy::parser::symbol_kind_type::S_YYEOF) {
+                result.pop_back();
+                break;
+            }
         }
+    } catch (...) {
+        yylex_destroy(scanner);
+        throw;
     }
-    yy_delete_buffer(buffer);
+    yylex_destroy(scanner);
     return result;
 }
 
+LexedTokens lex_string(const char* str) {
+    return lex_source(SourceBuffer::copy_string(str));
+}
+
 int parse_string(const char* str, Program *program) {
     add_prelude(program);
-    yy::location loc;
-    YY_BUFFER_STATE buffer = yy_scan_string(str);
-    yy_switch_to_buffer(buffer);
-    reset_start_condition();
-    yy::parser parse(loc, program);
-    int result = parse();
-    yy_delete_buffer(buffer);
-    return result;
+    return parse_program(str, program);
 }
 
 int parse_string_no_prelude(const char* str, Program *program) {
-    yy::location loc;
-    YY_BUFFER_STATE buffer = yy_scan_string(str);
-    yy_switch_to_buffer(buffer);
-    reset_start_condition();
-    yy::parser parse(loc, program);
-    int result = parse();
-    yy_delete_buffer(buffer);
-    return result;
+    return parse_program(str, program);
 }
 
 bool same_type(const Type *a, const Type *b) {
@@ -52,16 +48,16 @@ bool same_type(const Type *a, const Type *b) {
     }
     switch (a->get_form()) {
         case typeform::universallyquantifiedvariable:
-            return dynamic_cast<const UniversallyQuantifiedVariable*>(a)->id ==
-                   dynamic_cast<const UniversallyQuantifiedVariable*>(b)->id;
+            return static_cast<const UniversallyQuantifiedVariable*>(a)->id ==
+                   static_cast<const UniversallyQuantifiedVariable*>(b)->id;
         case typeform::constructor:
-            return dynamic_cast<const TypeConstructor*>(a)->id == dynamic_cast<const TypeConstructor*>(b)->id;
+            return static_cast<const TypeConstructor*>(a)->id == static_cast<const TypeConstructor*>(b)->id;
         case typeform::application:
             return same_type(
-                    dynamic_cast<const TypeApplication*>(a)->left.get(),
-                    dynamic_cast<const TypeApplication*>(b)->left.get()) &&
+                    static_cast<const TypeApplication*>(a)->left.get(),
+                    static_cast<const TypeApplication*>(b)->left.get()) &&
                    same_type(
-                           dynamic_cast<const TypeApplication*>(a)->right.get(),
-                           dynamic_cast<const TypeApplication*>(b)->right.get());
+                           static_cast<const TypeApplication*>(a)->right.get(),
+                           static_cast<const TypeApplication*>(b)->right.get());
     }
 }